@@ -26,6 +26,7 @@
 // File: voglbench.cpp
 #include "vogl_common.h"
 #include "vogl_gl_replayer.h"
+#include "vogl_replay_bytecode.h"
 #include "vogl_texture_format.h"
 #include "vogl_trace_file_writer.h"
 
@@ -80,6 +81,7 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "loop_frame", 1, false, "Replay: loop mode's start frame" },
         { "loop_len", 1, false, "Replay: loop mode's loop length" },
         { "loop_count", 1, false, "Replay: loop mode's loop count" },
+        { "bytecode_cache", 1, false, "Replay: Replay from this bytecode file, first compiling it from the trace if it's missing or was compiled from another trace" },
         { "logfile", 1, false, "Create logfile" },
         { "logfile_append", 1, false, "Append output to logfile" },
         { "help", 0, false, "Display this help" },
@@ -408,6 +410,29 @@ static bool tool_replay_mode()
         return false;
     }
 
+    // The bytecode file only needs to be compiled by the first run.
+    vogl_replay_bytecode bytecode;
+    vogl_replay_bytecode *pBytecode = NULL;
+    dynamic_string bytecode_filename(g_command_line_params().get_value_as_string_or_empty("bytecode_cache"));
+    if (!bytecode_filename.is_empty())
+    {
+        if (!bytecode.open(bytecode_filename.get_ptr(), pTrace_reader->get_sof_packet()))
+        {
+            timer compile_tm;
+            compile_tm.start();
+
+            if ((!vogl_replay_bytecode::compile(*pTrace_reader, bytecode_filename.get_ptr())) || (!bytecode.open(bytecode_filename.get_ptr(), pTrace_reader->get_sof_packet())))
+            {
+                vogl_error_printf("%s: Failed compiling replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, bytecode_filename.get_ptr());
+                return false;
+            }
+
+            vogl_printf("Compiled replay bytecode file %s in %.3f secs\n", bytecode_filename.get_ptr(), compile_tm.get_elapsed_secs());
+        }
+
+        pBytecode = &bytecode;
+    }
+
     // Disable all glGetError() calls in vogl_utils.cpp.
     vogl_disable_gl_get_error();
 
@@ -541,8 +566,8 @@ static bool tool_replay_mode()
                 {
                     vogl_printf("Snapshot succeeded\n");
 
-                    snapshot_loop_start_frame = pTrace_reader->get_cur_frame();
-                    snapshot_loop_end_frame = pTrace_reader->get_cur_frame() + loop_len;
+                    snapshot_loop_start_frame = pBytecode ? pBytecode->get_cur_frame() : pTrace_reader->get_cur_frame();
+                    snapshot_loop_end_frame = snapshot_loop_start_frame + loop_len;
 
                     vogl_debug_printf("%s: Loop start: %" PRIi64 " Loop end: %" PRIi64 "\n", VOGL_FUNCTION_INFO_CSTR, snapshot_loop_start_frame, snapshot_loop_end_frame);
                 }
@@ -559,7 +584,7 @@ static bool tool_replay_mode()
         {
             for (;;)
             {
-                status = replayer.process_next_packet(*pTrace_reader);
+                status = pBytecode ? pBytecode->process_next_cmd(replayer) : replayer.process_next_packet(*pTrace_reader);
 
                 if ((status == vogl_gl_replayer::cStatusNextFrame) ||
                     (status == vogl_gl_replayer::cStatusResizeWindow) ||
@@ -582,13 +607,16 @@ static bool tool_replay_mode()
         if (replayer.get_at_frame_boundary() &&
                 pSnapshot && 
                 (loop_count > 0) &&
-                ((pTrace_reader->get_cur_frame() == snapshot_loop_end_frame) || (status == vogl_gl_replayer::cStatusAtEOF)))
+                (((pBytecode ? pBytecode->get_cur_frame() : pTrace_reader->get_cur_frame()) == snapshot_loop_end_frame) || (status == vogl_gl_replayer::cStatusAtEOF)))
         {
             status = replayer.begin_applying_snapshot(pSnapshot, false);
             if ((status != vogl_gl_replayer::cStatusOK) && (status != vogl_gl_replayer::cStatusResizeWindow))
                 goto error_exit;
 
-            pTrace_reader->seek_to_frame(static_cast<uint>(snapshot_loop_start_frame));
+            if (pBytecode)
+                pBytecode->seek_to_frame(static_cast<uint>(snapshot_loop_start_frame));
+            else
+                pTrace_reader->seek_to_frame(static_cast<uint>(snapshot_loop_start_frame));
 
             vogl_debug_printf("%s: Applying snapshot and seeking back to frame %" PRIi64 "\n", VOGL_FUNCTION_INFO_CSTR, snapshot_loop_start_frame);
             loop_count--;
@@ -599,7 +627,15 @@ static bool tool_replay_mode()
                     ((replayer.get_at_frame_boundary()) && ((replayer.get_frame_index() % 100) == 0));
             if (print_progress)
             {
-                if (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER)
+                if (pBytecode)
+                {
+                    vogl_printf("Replay now at frame index %u, bytecode command %u, GL call counter %" PRIu64 ", %3.2f%% percent complete\n",
+                               replayer.get_frame_index(),
+                               pBytecode->get_cur_cmd_index(),
+                               replayer.get_last_parsed_call_counter(),
+                               pBytecode->get_num_cmds() ? (pBytecode->get_cur_cmd_index() * 100.0f) / pBytecode->get_num_cmds() : 0);
+                }
+                else if (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER)
                 {
                     vogl_binary_trace_file_reader &binary_trace_reader = *static_cast<vogl_binary_trace_file_reader *>(pTrace_reader.get());
 
@@ -618,6 +654,12 @@ static bool tool_replay_mode()
                     double time_since_start = tm.get_elapsed_secs();
 
                     vogl_printf("%u total swaps, %.3f secs, %3.3f avg fps\n", replayer.get_total_swaps(), time_since_start, replayer.get_frame_index() / time_since_start);
+
+                    if (pBytecode)
+                    {
+                        vogl_printf("%" PRIu64 " bytecode commands replayed, %" PRIu64 " through the fast path\n",
+                                   pBytecode->get_total_cmds_replayed(), pBytecode->get_total_fast_cmds_replayed());
+                    }
                     break;
                 }
 
@@ -625,7 +667,7 @@ static bool tool_replay_mode()
 
                 replayer.reset_state();
 
-                if (!pTrace_reader->seek_to_frame(0))
+                if (!(pBytecode ? pBytecode->seek_to_frame(0) : pTrace_reader->seek_to_frame(0)))
                 {
                     vogl_error_printf("%s: Failed rewinding trace reader!\n", VOGL_FUNCTION_INFO_CSTR);
                     goto error_exit;
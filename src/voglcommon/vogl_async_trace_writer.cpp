@@ -0,0 +1,665 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_async_trace_writer.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_async_trace_writer.h"
+#include "vogl_console.h"
+
+// Max packets written per writer mutex acquisition, so app threads which need the mutex aren't starved.
+#define VOGL_ASYNC_WRITER_MAX_PACKETS_PER_DRAIN 256
+
+namespace
+{
+    // Producer pending call counter states (any other value is an in-flight call counter)
+    const int64_t cPendingIdle = -1;
+    // The producer is allocating a call counter but hasn't published it yet
+    const int64_t cPendingReserving = -2;
+
+    struct async_record_header
+    {
+        uint64_t m_call_counter;
+        // Non-NULL if the packet was too large to fit in the producer's ring
+        uint8_t *m_pExternal_data;
+        uint32_t m_generation;
+        uint32_t m_flags;
+        uint32_t m_packet_size;
+        uint32_t m_unused;
+    };
+
+    inline int64_t load_pending(const atomic64_t volatile *pSrc)
+    {
+        return atomic_compare_exchange64(const_cast<atomic64_t volatile *>(pSrc), 0, 0);
+    }
+
+    inline void store_pending(atomic64_t volatile *pDest, int64_t val)
+    {
+        for (;;)
+        {
+            int64_t cur = load_pending(pDest);
+            if (atomic_compare_exchange64(pDest, val, cur) == cur)
+                break;
+        }
+    }
+
+    // Copies the packet if it's already been serialized to pPacket_buf, otherwise serializes it directly into pDst.
+    inline bool serialize_packet(uint8_t *pDst, const vogl_trace_packet &packet, const uint8_t *pPacket_buf, uint32_t packet_size)
+    {
+        if (pPacket_buf)
+        {
+            memcpy(pDst, pPacket_buf, packet_size);
+            return true;
+        }
+
+        return packet.serialize_to_buffer(pDst, packet_size);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::producer
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_async_trace_writer::producer
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(producer);
+
+public:
+    producer()
+        : m_pending_call_counter(cPendingIdle),
+          m_retired(false),
+          m_was_empty(false),
+          m_total_stalls(0),
+          m_total_stall_ticks(0)
+    {
+    }
+
+    spsc_ring_buffer m_ring;
+
+    atomic64_t m_pending_call_counter;
+    atomic32_t m_retired;
+
+    // Writer owned
+    bool m_was_empty;
+
+    // Owning thread
+    uint64_t m_total_stalls;
+    timer_ticks m_total_stall_ticks;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::vogl_async_trace_writer
+//----------------------------------------------------------------------------------------------------------------------
+vogl_async_trace_writer::vogl_async_trace_writer()
+    : m_pWriter(NULL),
+      m_pWriter_mutex(NULL),
+      m_ring_size(0),
+      m_max_pending_bytes(0),
+      m_exit_flag(false),
+      m_generation(0),
+      m_external_bytes(0),
+      m_blocked_call_counter(0),
+      m_blocked_start_ticks(0),
+      m_total_packets(0),
+      m_total_bytes(0),
+      m_total_external_packets(0),
+      m_total_external_bytes(0),
+      m_total_order_timeouts(0),
+      m_total_discarded_packets(0),
+      m_total_stalls(0),
+      m_total_stall_ticks(0),
+      m_max_ring_bytes_used(0)
+{
+    VOGL_FUNC_TRACER
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::~vogl_async_trace_writer
+//----------------------------------------------------------------------------------------------------------------------
+vogl_async_trace_writer::~vogl_async_trace_writer()
+{
+    VOGL_FUNC_TRACER
+
+    deinit();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::init
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_async_trace_writer::init(vogl_trace_file_writer *pWriter, mutex *pWriter_mutex, uint32_t ring_size, uint64_t max_pending_bytes)
+{
+    VOGL_FUNC_TRACER
+
+    deinit();
+
+    if ((!pWriter) || (!pWriter_mutex))
+        return false;
+
+    m_pWriter = pWriter;
+    m_pWriter_mutex = pWriter_mutex;
+    m_ring_size = ring_size;
+    m_max_pending_bytes = max_pending_bytes;
+
+    if (!m_thread_pool.init(1))
+    {
+        vogl_error_printf("%s: Failed creating trace writer thread\n", VOGL_FUNCTION_INFO_CSTR);
+        m_pWriter = NULL;
+        m_pWriter_mutex = NULL;
+        return false;
+    }
+
+    m_thread_pool.queue_object_task(this, &vogl_async_trace_writer::writer_thread_func);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::deinit
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::deinit()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pWriter)
+        return;
+
+    atomic_exchange32(&m_exit_flag, true);
+    m_thread_pool.deinit();
+    atomic_exchange32(&m_exit_flag, false);
+
+    flush(true);
+
+    {
+        scoped_mutex lock(*m_pWriter_mutex);
+
+        for (uint32_t i = 0; i < m_producers.size(); i++)
+            vogl_delete(m_producers[i]);
+        m_producers.clear();
+    }
+
+    m_pWriter = NULL;
+    m_pWriter_mutex = NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::create_producer
+//----------------------------------------------------------------------------------------------------------------------
+vogl_async_trace_writer::producer *vogl_async_trace_writer::create_producer()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pWriter)
+        return NULL;
+
+    producer *pProducer = vogl_new(producer);
+    if (!pProducer->m_ring.init(m_ring_size))
+    {
+        vogl_error_printf("%s: Failed allocating %u byte trace packet ring\n", VOGL_FUNCTION_INFO_CSTR, m_ring_size);
+        vogl_delete(pProducer);
+        return NULL;
+    }
+
+    scoped_mutex lock(*m_pWriter_mutex);
+    m_producers.push_back(pProducer);
+
+    return pProducer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::release_producer
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::release_producer(producer *pProducer)
+{
+    VOGL_FUNC_TRACER
+
+    // deinit() has already freed all producers
+    if ((!m_pWriter) || (!pProducer))
+        return;
+
+    store_pending(&pProducer->m_pending_call_counter, cPendingIdle);
+    atomic_exchange32(&pProducer->m_retired, true);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::get_next_gl_call_counter
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t vogl_async_trace_writer::get_next_gl_call_counter(producer *pProducer)
+{
+    VOGL_FUNC_TRACER
+
+    // Publish the reservation before allocating the counter, so the writer can never see a later counter in some
+    // other ring without also seeing that this producer is about to own an earlier one.
+    store_pending(&pProducer->m_pending_call_counter, cPendingReserving);
+
+    uint64_t call_counter = m_pWriter->get_next_gl_call_counter();
+
+    store_pending(&pProducer->m_pending_call_counter, static_cast<int64_t>(call_counter));
+
+    return call_counter;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::cancel_gl_call_counter
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::cancel_gl_call_counter(producer *pProducer, uint64_t call_counter)
+{
+    VOGL_FUNC_TRACER
+
+    atomic_compare_exchange64(&pProducer->m_pending_call_counter, cPendingIdle, static_cast<int64_t>(call_counter));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::help_drain
+// Called by a producer which is out of ring space or pending byte budget.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::help_drain()
+{
+    VOGL_FUNC_TRACER
+
+    uint32_t total_processed;
+    {
+        scoped_mutex lock(*m_pWriter_mutex);
+        total_processed = drain(false, VOGL_ASYNC_WRITER_MAX_PACKETS_PER_DRAIN);
+    }
+
+    if (!total_processed)
+        vogl_sleep(1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::write_packet
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_async_trace_writer::write_packet(producer *pProducer, const vogl_trace_packet &packet, uint32_t write_flags)
+{
+    VOGL_FUNC_TRACER
+
+    const int64_t call_counter = static_cast<int64_t>(packet.get_call_counter());
+
+    bool success = false;
+    uint8_t *pExternal_data = NULL;
+
+    // Deduplicated packets are staged in the packet's buffer, everything else is serialized directly into the ring
+    // (or the heap block queued in its place).
+    const uint8_t *pPacket_buf = NULL;
+    uint32_t packet_size;
+    if (m_pWriter->should_dedup_packet(packet))
+    {
+        // Client memory deduplication uses the trace archive, which is guarded by the writer mutex. It's only held
+        // while the archive is touched, not while payloads are hashed or compressed.
+        packet_size = m_pWriter->serialize_packet_dedup(packet, m_pWriter_mutex) ? packet.get_packet_buf().size() : 0;
+        pPacket_buf = packet.get_packet_buf().get_ptr();
+    }
+    else
+    {
+        packet_size = packet.get_serialize_size();
+    }
+
+    if (packet_size)
+    {
+
+        uint32_t record_size = sizeof(async_record_header) + packet_size;
+        const bool is_external = record_size > pProducer->m_ring.get_max_record_size();
+
+        timer_ticks stall_start_ticks = 0;
+        bool stalled = false;
+
+        if (is_external)
+        {
+            // Too large for the ring - copy to the heap and only queue the header. Allow at least one of these
+            // through even if it's larger than the entire budget.
+            for (;;)
+            {
+                int64_t external_bytes = atomic_exchange_add64(&m_external_bytes, 0);
+                if ((!external_bytes) || ((static_cast<uint64_t>(external_bytes) + packet_size) <= m_max_pending_bytes))
+                    break;
+
+                if (!stalled)
+                {
+                    stalled = true;
+                    stall_start_ticks = timer::get_ticks();
+                }
+                help_drain();
+            }
+
+            pExternal_data = static_cast<uint8_t *>(vogl_malloc(packet_size));
+            if (pExternal_data)
+            {
+                if (!serialize_packet(pExternal_data, packet, pPacket_buf, packet_size))
+                {
+                    vogl_free(pExternal_data);
+                    pExternal_data = NULL;
+                }
+                else
+                {
+                    atomic_exchange_add64(&m_external_bytes, packet_size);
+                }
+            }
+
+            record_size = sizeof(async_record_header);
+        }
+
+        if ((is_external) && (!pExternal_data))
+        {
+            vogl_error_printf("%s: Failed allocating or serializing %u bytes for trace packet\n", VOGL_FUNCTION_INFO_CSTR, packet_size);
+        }
+        else
+        {
+            void *pDst;
+            while ((pDst = pProducer->m_ring.begin_write(record_size)) == NULL)
+            {
+                if (!stalled)
+                {
+                    stalled = true;
+                    stall_start_ticks = timer::get_ticks();
+                }
+                help_drain();
+            }
+
+            async_record_header *pHeader = static_cast<async_record_header *>(pDst);
+            pHeader->m_call_counter = call_counter;
+            pHeader->m_pExternal_data = pExternal_data;
+            pHeader->m_generation = static_cast<uint32_t>(atomic_load32(&m_generation));
+            pHeader->m_flags = write_flags;
+            pHeader->m_packet_size = packet_size;
+            pHeader->m_unused = 0;
+
+            success = true;
+            if ((!pExternal_data) && (!serialize_packet(reinterpret_cast<uint8_t *>(pHeader + 1), packet, pPacket_buf, packet_size)))
+            {
+                // The space is already claimed, so queue the record but have the writer discard it.
+                pHeader->m_packet_size = 0;
+                success = false;
+            }
+
+            pProducer->m_ring.end_write();
+        }
+
+        if (stalled)
+        {
+            pProducer->m_total_stalls++;
+            pProducer->m_total_stall_ticks += timer::get_ticks() - stall_start_ticks;
+        }
+    }
+
+    // The packet is visible in the ring now (or will never be), so stop holding back later call counters.
+    atomic_compare_exchange64(&pProducer->m_pending_call_counter, cPendingIdle, call_counter);
+
+    return success;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::flush
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::flush(bool closing)
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pWriter)
+        return;
+
+    scoped_mutex lock(*m_pWriter_mutex);
+
+    drain(true, cUINT32_MAX);
+
+    if (closing)
+        atomic_increment32(&m_generation);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::writer_thread_func
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::writer_thread_func(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_NOTE_UNUSED(data);
+    VOGL_NOTE_UNUSED(pData_ptr);
+
+    while (!atomic_load32(&m_exit_flag))
+    {
+        uint32_t total_processed;
+        {
+            scoped_mutex lock(*m_pWriter_mutex);
+            total_processed = drain(false, VOGL_ASYNC_WRITER_MAX_PACKETS_PER_DRAIN);
+        }
+
+        if (!total_processed)
+            vogl_sleep(1);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::drain
+// Writes queued packets in call counter order. Unless force is true, a packet isn't written while another producer
+// has an earlier call counter in flight (up to cOrderTimeoutMS). Caller must hold the writer mutex.
+// Returns the number of packets consumed.
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_async_trace_writer::drain(bool force, uint32_t max_packets)
+{
+    VOGL_FUNC_TRACER
+
+    uint32_t total_processed = 0;
+
+    while (total_processed < max_packets)
+    {
+        producer *pBest = NULL;
+        uint64_t best_call_counter = 0;
+        bool any_empty = false;
+
+        for (uint32_t i = 0; i < m_producers.size(); i++)
+        {
+            producer *pProducer = m_producers[i];
+
+            m_max_ring_bytes_used = math::maximum(m_max_ring_bytes_used, pProducer->m_ring.get_bytes_used());
+
+            uint32_t record_size;
+            const async_record_header *pHeader = static_cast<const async_record_header *>(pProducer->m_ring.begin_read(record_size));
+
+            pProducer->m_was_empty = (pHeader == NULL);
+            if (!pHeader)
+            {
+                any_empty = true;
+                continue;
+            }
+
+            pProducer->m_ring.cancel_read();
+
+            if ((!pBest) || (pHeader->m_call_counter < best_call_counter))
+            {
+                pBest = pProducer;
+                best_call_counter = pHeader->m_call_counter;
+            }
+        }
+
+        if (!pBest)
+            break;
+
+        if (!force)
+        {
+            atomic_memory_barrier();
+
+            bool blocked = false;
+            for (uint32_t i = 0; i < m_producers.size(); i++)
+            {
+                if (m_producers[i] == pBest)
+                    continue;
+
+                int64_t pending = load_pending(&m_producers[i]->m_pending_call_counter);
+                if ((pending == cPendingReserving) || ((pending >= 0) && (static_cast<uint64_t>(pending) < best_call_counter)))
+                {
+                    blocked = true;
+                    break;
+                }
+            }
+
+            if ((!blocked) && (any_empty))
+            {
+                // A producer may have published an earlier packet and gone idle after we looked at its ring.
+                atomic_memory_barrier();
+
+                bool rescan = false;
+                for (uint32_t i = 0; i < m_producers.size(); i++)
+                {
+                    if ((m_producers[i]->m_was_empty) && (!m_producers[i]->m_ring.is_empty()))
+                    {
+                        rescan = true;
+                        break;
+                    }
+                }
+
+                if (rescan)
+                    continue;
+            }
+
+            if (blocked)
+            {
+                timer_ticks cur_ticks = timer::get_ticks();
+                if ((m_blocked_call_counter != best_call_counter) || (!m_blocked_start_ticks))
+                {
+                    m_blocked_call_counter = best_call_counter;
+                    m_blocked_start_ticks = cur_ticks;
+                    break;
+                }
+
+                if (timer::ticks_to_ms(cur_ticks - m_blocked_start_ticks) < cOrderTimeoutMS)
+                    break;
+
+                // Whoever holds the earlier counter is stuck (or the call will never be written), give up on strict ordering.
+                m_total_order_timeouts++;
+            }
+        }
+
+        m_blocked_start_ticks = 0;
+
+        uint32_t record_size;
+        const void *pRecord = pBest->m_ring.begin_read(record_size);
+        VOGL_ASSERT(pRecord);
+
+        write_record(pRecord, record_size);
+
+        pBest->m_ring.end_read();
+
+        total_processed++;
+    }
+
+    free_retired_producers();
+
+    return total_processed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::write_record
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::write_record(const void *pRecord, uint32_t record_size)
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_NOTE_UNUSED(record_size);
+    VOGL_ASSERT(record_size >= sizeof(async_record_header));
+
+    const async_record_header &header = *static_cast<const async_record_header *>(pRecord);
+    const uint8_t *pPacket_data = header.m_pExternal_data ? header.m_pExternal_data : reinterpret_cast<const uint8_t *>(&header + 1);
+
+    // Packets queued before the last close belong to a trace that's gone. Empty packets failed to serialize.
+    if ((header.m_generation != static_cast<uint32_t>(atomic_load32(&m_generation))) || (!m_pWriter->is_opened()) || (!header.m_packet_size))
+    {
+        m_total_discarded_packets++;
+    }
+    else
+    {
+        if (!m_pWriter->write_packet(pPacket_data, header.m_packet_size, (header.m_flags & cWriteFlagSwap) != 0))
+        {
+            vogl_error_printf("%s: Failed writing to trace file! Exiting app.\n", VOGL_FUNCTION_INFO_CSTR);
+
+            exit(EXIT_FAILURE);
+        }
+
+        if (header.m_flags & cWriteFlagFlushAfter)
+            m_pWriter->flush();
+
+        m_total_packets++;
+        m_total_bytes += header.m_packet_size;
+
+        if (header.m_pExternal_data)
+        {
+            m_total_external_packets++;
+            m_total_external_bytes += header.m_packet_size;
+        }
+    }
+
+    if (header.m_pExternal_data)
+    {
+        vogl_free(header.m_pExternal_data);
+        atomic_exchange_add64(&m_external_bytes, -static_cast<int64_t>(header.m_packet_size));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::free_retired_producers
+// Caller must hold the writer mutex.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::free_retired_producers()
+{
+    VOGL_FUNC_TRACER
+
+    for (uint32_t i = 0; i < m_producers.size(); i++)
+    {
+        producer *pProducer = m_producers[i];
+        if ((!atomic_load32(&pProducer->m_retired)) || (!pProducer->m_ring.is_empty()))
+            continue;
+
+        m_total_stalls += pProducer->m_total_stalls;
+        m_total_stall_ticks += pProducer->m_total_stall_ticks;
+
+        vogl_delete(pProducer);
+        m_producers.erase_unordered(i);
+        i--;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer::dump_stats
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_async_trace_writer::dump_stats() const
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pWriter)
+        return;
+
+    scoped_mutex lock(*m_pWriter_mutex);
+
+    uint64_t total_stalls = m_total_stalls;
+    timer_ticks total_stall_ticks = m_total_stall_ticks;
+    for (uint32_t i = 0; i < m_producers.size(); i++)
+    {
+        total_stalls += m_producers[i]->m_total_stalls;
+        total_stall_ticks += m_producers[i]->m_total_stall_ticks;
+    }
+
+    vogl_message_printf("Async trace writer: %" PRIu64 " packets, %" PRIu64 " bytes, %" PRIu64 " external packets (%" PRIu64 " bytes), %u active producers, ring size %u, ring high water %u bytes\n",
+                        m_total_packets, m_total_bytes, m_total_external_packets, m_total_external_bytes, m_producers.size(), m_ring_size, m_max_ring_bytes_used);
+    vogl_message_printf("Async trace writer: %" PRIu64 " producer stalls (%.3f ms total), %" PRIu64 " call counter order timeouts, %" PRIu64 " discarded packets\n",
+                        total_stalls, timer::ticks_to_ms(total_stall_ticks), m_total_order_timeouts, m_total_discarded_packets);
+}
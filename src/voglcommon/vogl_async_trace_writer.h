@@ -0,0 +1,136 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_async_trace_writer.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_ASYNC_TRACE_WRITER_H
+#define VOGL_ASYNC_TRACE_WRITER_H
+
+#include "vogl_common.h"
+#include "vogl_trace_file_writer.h"
+#include "vogl_spsc_ring_buffer.h"
+#include "vogl_threading.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_async_trace_writer
+// Each tracing thread owns a producer with a private lock-free ring. Serialized packets are appended to the ring, and
+// a background thread (or a producer which runs out of ring space) merges the rings into the trace file writer in
+// call counter order. All writes to the trace file writer happen while holding the writer mutex.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_async_trace_writer
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_async_trace_writer);
+
+public:
+    enum
+    {
+        cDefaultRingSize = 4 * 1024 * 1024,
+        cDefaultMaxPendingBytes = 256 * 1024 * 1024,
+        cOrderTimeoutMS = 500,
+    };
+
+    enum write_flags_t
+    {
+        cWriteFlagSwap = 1,
+        cWriteFlagFlushAfter = 2
+    };
+
+    class producer;
+
+    vogl_async_trace_writer();
+    ~vogl_async_trace_writer();
+
+    // pWriter_mutex must be the mutex that guards all other writes to pWriter.
+    bool init(vogl_trace_file_writer *pWriter, mutex *pWriter_mutex, uint32_t ring_size = cDefaultRingSize, uint64_t max_pending_bytes = cDefaultMaxPendingBytes);
+    void deinit();
+
+    inline bool is_initialized() const
+    {
+        return m_pWriter != NULL;
+    }
+
+    // Producers are owned by the async writer. release_producer() may be called from any thread, the producer is
+    // freed once its ring has been drained.
+    producer *create_producer();
+    void release_producer(producer *pProducer);
+
+    // Allocates the next call counter from the trace file writer, and marks it as in-flight on this producer so the
+    // writer thread doesn't write packets with higher counters until it's been written.
+    uint64_t get_next_gl_call_counter(producer *pProducer);
+
+    // Retires a call counter returned by get_next_gl_call_counter() whose packet will never be written (e.g. calls
+    // made while compiling a display list), so the writer thread stops waiting for it.
+    void cancel_gl_call_counter(producer *pProducer, uint64_t call_counter);
+
+    // Serializes packet and queues it. Blocks (and helps drain) if the producer's ring or the pending byte budget is
+    // exhausted. write_flags is a combination of write_flags_t.
+    bool write_packet(producer *pProducer, const vogl_trace_packet &packet, uint32_t write_flags);
+
+    // Synchronously writes everything that has been queued so far, ignoring in-flight call counters. If closing is
+    // true, any packets queued after this call returns are discarded (the trace is about to be closed).
+    void flush(bool closing);
+
+    void dump_stats() const;
+
+private:
+    vogl_trace_file_writer *m_pWriter;
+    mutex *m_pWriter_mutex;
+
+    uint32_t m_ring_size;
+    uint64_t m_max_pending_bytes;
+
+    // Guarded by m_pWriter_mutex
+    vogl::vector<producer *> m_producers;
+
+    task_pool m_thread_pool;
+    atomic32_t m_exit_flag;
+    atomic32_t m_generation;
+
+    atomic64_t m_external_bytes;
+
+    // Writer state, guarded by m_pWriter_mutex
+    uint64_t m_blocked_call_counter;
+    timer_ticks m_blocked_start_ticks;
+
+    uint64_t m_total_packets;
+    uint64_t m_total_bytes;
+    uint64_t m_total_external_packets;
+    uint64_t m_total_external_bytes;
+    uint64_t m_total_order_timeouts;
+    uint64_t m_total_discarded_packets;
+    uint64_t m_total_stalls;
+    timer_ticks m_total_stall_ticks;
+    uint32_t m_max_ring_bytes_used;
+
+    void writer_thread_func(uint64_t data, void *pData_ptr);
+
+    uint32_t drain(bool force, uint32_t max_packets);
+    void write_record(const void *pRecord, uint32_t record_size);
+    void help_drain();
+    void free_retired_producers();
+};
+
+#endif // VOGL_ASYNC_TRACE_WRITER_H
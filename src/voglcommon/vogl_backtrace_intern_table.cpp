@@ -0,0 +1,566 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_backtrace_intern_table.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_backtrace_intern_table.h"
+#include "vogl_threading.h"
+
+namespace
+{
+    const atomic32_t cSlotBusy = -1;
+    const atomic32_t cSlotFull = -2;
+
+    const atomic32_t cResetFlag = 0x40000000;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::vogl_backtrace_intern_table
+//----------------------------------------------------------------------------------------------------------------------
+vogl_backtrace_intern_table::vogl_backtrace_intern_table()
+    : m_pSlots(NULL),
+      m_pEntries(NULL),
+      m_slot_mask(0),
+      m_max_entries(0),
+      m_num_entries(0),
+      m_guard(0),
+      m_generation(1),
+      m_pThread_caches(NULL)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::~vogl_backtrace_intern_table
+//----------------------------------------------------------------------------------------------------------------------
+vogl_backtrace_intern_table::~vogl_backtrace_intern_table()
+{
+    deinit();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::init
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_backtrace_intern_table::init(uint32_t max_entries)
+{
+    deinit();
+
+    if ((!max_entries) || (max_entries > 0x10000000))
+        return false;
+
+    // Keep the slot array at most half full so probe sequences stay short.
+    uint32_t num_slots = math::next_pow2(max_entries * 2U);
+
+    m_pSlots = static_cast<slot *>(vogl_malloc(sizeof(slot) * num_slots));
+    m_pEntries = static_cast<entry *>(vogl_malloc(sizeof(entry) * max_entries));
+    if ((!m_pSlots) || (!m_pEntries))
+    {
+        deinit();
+        return false;
+    }
+
+    memset(m_pSlots, 0, sizeof(slot) * num_slots);
+    for (uint32_t i = 0; i < max_entries; i++)
+        m_pEntries[i].m_ready = 0;
+
+    m_slot_mask = num_slots - 1;
+    m_max_entries = max_entries;
+    m_num_entries = 0;
+    m_guard = 0;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::deinit
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::deinit()
+{
+    unregister_all_thread_caches();
+
+    if (m_pSlots)
+    {
+        vogl_free(m_pSlots);
+        m_pSlots = NULL;
+    }
+
+    if (m_pEntries)
+    {
+        vogl_free(m_pEntries);
+        m_pEntries = NULL;
+    }
+
+    m_slot_mask = 0;
+    m_max_entries = 0;
+    m_num_entries = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::enter
+//----------------------------------------------------------------------------------------------------------------------
+inline bool vogl_backtrace_intern_table::enter()
+{
+    if (atomic_increment32(&m_guard) & cResetFlag)
+    {
+        atomic_decrement32(&m_guard);
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::leave
+//----------------------------------------------------------------------------------------------------------------------
+inline void vogl_backtrace_intern_table::leave()
+{
+    atomic_decrement32(&m_guard);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::find_or_insert
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_backtrace_intern_table::find_or_insert(uint32_t &index, const vogl_backtrace_addrs &addrs, uint32_t hash)
+{
+    uint32_t slot_index = hash & m_slot_mask;
+
+    for (uint32_t num_probes = 0; num_probes <= m_slot_mask;)
+    {
+        slot &s = m_pSlots[slot_index];
+
+        atomic32_t state = atomic_load32(&s.m_state);
+        if (!state)
+        {
+            if (atomic_compare_exchange32(&s.m_state, cSlotBusy, 0) != 0)
+                continue;
+
+            uint32_t entry_index = static_cast<uint32_t>(atomic_exchange_add32(&m_num_entries, 1));
+            if (entry_index >= m_max_entries)
+            {
+                atomic_store32(&s.m_state, cSlotFull);
+                return false;
+            }
+
+            entry &e = m_pEntries[entry_index];
+            memcpy(&e.m_addrs, &addrs, sizeof(addrs));
+            e.m_count = 1;
+            s.m_hash = hash;
+
+            atomic_store32(&e.m_ready, 1);
+            atomic_store32(&s.m_state, entry_index + 1);
+
+            index = entry_index;
+            return true;
+        }
+        else if (state == cSlotBusy)
+        {
+            // Another thread is writing this slot's key, it'll be published shortly.
+            vogl_yield_processor();
+            continue;
+        }
+        else if ((state != cSlotFull) && (s.m_hash == hash))
+        {
+            uint32_t entry_index = static_cast<uint32_t>(state - 1);
+            entry &e = m_pEntries[entry_index];
+            if (e.m_addrs == addrs)
+            {
+                atomic_exchange_add64(&e.m_count, 1);
+
+                index = entry_index;
+                return true;
+            }
+        }
+
+        slot_index = (slot_index + 1) & m_slot_mask;
+        num_probes++;
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::publish_pending
+// Caller must be inside enter()/leave().
+//----------------------------------------------------------------------------------------------------------------------
+inline void vogl_backtrace_intern_table::publish_pending(thread_cache::cached_entry &cached)
+{
+    if ((cached.m_pending_count) && (cached.m_generation == static_cast<uint32_t>(m_generation)))
+        atomic_exchange_add64(&m_pEntries[cached.m_index].m_count, cached.m_pending_count);
+
+    cached.m_pending_count = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::register_thread_cache
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::register_thread_cache(thread_cache &cache)
+{
+    scoped_mutex lock(m_thread_caches_mutex);
+
+    if (cache.m_pTable)
+        return;
+
+    cache.m_pTable = this;
+    cache.m_pPrev = NULL;
+    cache.m_pNext = m_pThread_caches;
+    if (m_pThread_caches)
+        m_pThread_caches->m_pPrev = &cache;
+    m_pThread_caches = &cache;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::release_thread_cache
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::release_thread_cache(thread_cache &cache)
+{
+    flush_thread_cache(cache);
+
+    scoped_mutex lock(m_thread_caches_mutex);
+
+    if (cache.m_pTable != this)
+        return;
+
+    if (cache.m_pPrev)
+        cache.m_pPrev->m_pNext = cache.m_pNext;
+    else
+        m_pThread_caches = cache.m_pNext;
+    if (cache.m_pNext)
+        cache.m_pNext->m_pPrev = cache.m_pPrev;
+
+    cache.m_pTable = NULL;
+    cache.m_pPrev = NULL;
+    cache.m_pNext = NULL;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::unregister_all_thread_caches
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::unregister_all_thread_caches()
+{
+    scoped_mutex lock(m_thread_caches_mutex);
+
+    while (m_pThread_caches)
+    {
+        thread_cache *pCache = m_pThread_caches;
+        m_pThread_caches = pCache->m_pNext;
+
+        pCache->m_pTable = NULL;
+        pCache->m_pPrev = NULL;
+        pCache->m_pNext = NULL;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::intern
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_backtrace_intern_table::intern(uint32_t &index, const vogl_backtrace_addrs &addrs, thread_cache *pCache)
+{
+    index = 0;
+
+    if (!is_initialized())
+        return false;
+
+    // Must happen before taking the cache's lock, flush_all_thread_caches() locks caches while holding the list mutex.
+    if ((pCache) && (!pCache->m_pTable))
+        register_thread_cache(*pCache);
+
+    if (!enter())
+        return false;
+
+    if (pCache)
+        pCache->m_lock.lock();
+
+    uint32_t hash = addrs.get_hash();
+    uint32_t generation = static_cast<uint32_t>(m_generation);
+
+    thread_cache::cached_entry *pCached = pCache ? &pCache->m_entries[hash & (cThreadCacheSize - 1)] : NULL;
+    if ((pCached) && (pCached->m_generation == generation) && (pCached->m_hash == hash) && (m_pEntries[pCached->m_index].m_addrs == addrs))
+    {
+        index = pCached->m_index;
+
+        if (++pCached->m_pending_count >= cCountBatchSize)
+            publish_pending(*pCached);
+
+        pCache->m_lock.unlock();
+        leave();
+        return true;
+    }
+
+    bool success = find_or_insert(index, addrs, hash);
+
+    if ((success) && (pCached))
+    {
+        publish_pending(*pCached);
+
+        pCached->m_hash = hash;
+        pCached->m_index = index;
+        pCached->m_generation = generation;
+    }
+
+    if (pCache)
+        pCache->m_lock.unlock();
+    leave();
+    return success;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::flush_thread_cache
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::flush_thread_cache(thread_cache &cache)
+{
+    if ((!is_initialized()) || (!enter()))
+        return;
+
+    flush_thread_cache_locked(cache);
+
+    leave();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::flush_thread_cache_locked
+// Caller must be inside enter()/leave().
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::flush_thread_cache_locked(thread_cache &cache)
+{
+    scoped_spinlock lock(cache.m_lock);
+
+    for (uint32_t i = 0; i < cThreadCacheSize; i++)
+        publish_pending(cache.m_entries[i]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::flush_all_thread_caches
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::flush_all_thread_caches()
+{
+    if ((!is_initialized()) || (!enter()))
+        return;
+
+    scoped_mutex lock(m_thread_caches_mutex);
+
+    for (thread_cache *pCache = m_pThread_caches; pCache; pCache = pCache->m_pNext)
+        flush_thread_cache_locked(*pCache);
+
+    leave();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::get_size
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_backtrace_intern_table::get_size() const
+{
+    return math::minimum<uint32_t>(static_cast<uint32_t>(atomic_load32(&m_num_entries)), m_max_entries);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::get_entry
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_backtrace_intern_table::get_entry(uint32_t index, vogl_backtrace_addrs &addrs, uint64_t &count) const
+{
+    if (index >= get_size())
+        return false;
+
+    const entry &e = m_pEntries[index];
+    if (!atomic_load32(&e.m_ready))
+        return false;
+
+    memcpy(&addrs, &e.m_addrs, sizeof(addrs));
+    count = static_cast<uint64_t>(e.m_count);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table::reset
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_backtrace_intern_table::reset()
+{
+    if (!is_initialized())
+        return;
+
+    // Only one reset may run at a time, new intern() calls fail until it's done.
+    for (;;)
+    {
+        atomic32_t guard = atomic_load32(&m_guard);
+        if ((!(guard & cResetFlag)) && (atomic_compare_exchange32(&m_guard, guard | cResetFlag, guard) == guard))
+            break;
+        vogl_sleep(0);
+    }
+
+    while (atomic_load32(&m_guard) != cResetFlag)
+        vogl_yield_processor();
+
+    uint32_t num_entries = get_size();
+    for (uint32_t i = 0; i < num_entries; i++)
+        m_pEntries[i].m_ready = 0;
+
+    memset(m_pSlots, 0, sizeof(slot) * (m_slot_mask + 1));
+
+    m_num_entries = 0;
+    atomic_increment32(&m_generation);
+
+    atomic_add32(&m_guard, -cResetFlag);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// backtrace_intern_table_test
+// Several threads intern an overlapping set of backtraces through their own caches. Every thread must see the same
+// index for each backtrace, and once all caches are flushed the counts must match the number of intern() calls.
+//----------------------------------------------------------------------------------------------------------------------
+namespace
+{
+    enum
+    {
+        cTestNumThreads = 4,
+        cTestNumBacktraces = 96,
+        cTestIterations = 20000
+    };
+
+    struct backtrace_intern_test_state
+    {
+        vogl_backtrace_intern_table *m_pTable;
+        vogl_backtrace_intern_table::thread_cache m_cache;
+        uint32_t m_seed;
+        uint32_t m_indices[cTestNumBacktraces];
+        uint32_t m_counts[cTestNumBacktraces];
+        uint32_t m_num_errors;
+    };
+
+    void get_test_backtrace(vogl_backtrace_addrs &addrs, uint32_t backtrace_index)
+    {
+        addrs.clear();
+        addrs.m_num_addrs = 1 + (backtrace_index % 8);
+        for (uint32_t i = 0; i < addrs.m_num_addrs; i++)
+            addrs.m_addrs[i] = 0x400000 + backtrace_index * 0x100 + i * 8;
+    }
+
+    void backtrace_intern_test_task(uint64_t data, void *pData_ptr)
+    {
+        VOGL_NOTE_UNUSED(data);
+
+        backtrace_intern_test_state &state = *static_cast<backtrace_intern_test_state *>(pData_ptr);
+
+        vogl_backtrace_addrs addrs;
+
+        for (uint32_t i = 0; i < cTestIterations; i++)
+        {
+            state.m_seed ^= state.m_seed << 13;
+            state.m_seed ^= state.m_seed >> 17;
+            state.m_seed ^= state.m_seed << 5;
+
+            // Favor the low backtraces so some stay hot in the cache while the rest keep evicting each other.
+            uint32_t r = state.m_seed % cTestNumBacktraces;
+            uint32_t backtrace_index = (state.m_seed & 0x10000) ? (r * r) / cTestNumBacktraces : r;
+
+            get_test_backtrace(addrs, backtrace_index);
+
+            uint32_t index;
+            if (!state.m_pTable->intern(index, addrs, &state.m_cache))
+            {
+                state.m_num_errors++;
+                continue;
+            }
+
+            if (state.m_indices[backtrace_index] == cUINT32_MAX)
+                state.m_indices[backtrace_index] = index;
+            else if (state.m_indices[backtrace_index] != index)
+                state.m_num_errors++;
+
+            state.m_counts[backtrace_index]++;
+        }
+    }
+}
+
+bool backtrace_intern_table_test()
+{
+    vogl_backtrace_intern_table table;
+    if (!table.init(1024))
+        return false;
+
+    backtrace_intern_test_state states[cTestNumThreads];
+
+    for (uint32_t i = 0; i < cTestNumThreads; i++)
+    {
+        backtrace_intern_test_state &state = states[i];
+        state.m_pTable = &table;
+        state.m_seed = 0x9E3779B9U * (i + 1);
+        for (uint32_t j = 0; j < cTestNumBacktraces; j++)
+        {
+            state.m_indices[j] = cUINT32_MAX;
+            state.m_counts[j] = 0;
+        }
+        state.m_num_errors = 0;
+    }
+
+    task_pool pool;
+    if (!pool.init(cTestNumThreads))
+        return false;
+
+    for (uint32_t i = 0; i < cTestNumThreads; i++)
+        pool.queue_task(backtrace_intern_test_task, 0, &states[i]);
+    pool.join();
+    pool.deinit();
+
+    // The worker threads are gone but their caches still hold pending counts, as they would at the end of a capture.
+    table.flush_all_thread_caches();
+
+    uint32_t num_errors = 0;
+    for (uint32_t i = 0; i < cTestNumThreads; i++)
+        num_errors += states[i].m_num_errors;
+
+    if (table.get_size() != cTestNumBacktraces)
+    {
+        printf("backtrace_intern_table_test: expected %u entries, got %u\n", cTestNumBacktraces, table.get_size());
+        num_errors++;
+    }
+
+    vogl_backtrace_addrs expected_addrs, addrs;
+    for (uint32_t b = 0; b < cTestNumBacktraces; b++)
+    {
+        uint32_t index = cUINT32_MAX;
+        uint64_t expected_count = 0;
+        for (uint32_t i = 0; i < cTestNumThreads; i++)
+        {
+            expected_count += states[i].m_counts[b];
+            if (states[i].m_indices[b] == cUINT32_MAX)
+                continue;
+            if ((index != cUINT32_MAX) && (states[i].m_indices[b] != index))
+                num_errors++;
+            index = states[i].m_indices[b];
+        }
+
+        uint64_t count;
+        get_test_backtrace(expected_addrs, b);
+        if ((index == cUINT32_MAX) || (!table.get_entry(index, addrs, count)) || (addrs != expected_addrs) || (count != expected_count))
+        {
+            printf("backtrace_intern_table_test: backtrace %u has a bad entry (index %u, expected count %" PRIu64 ")\n", b, index, expected_count);
+            num_errors++;
+        }
+    }
+
+    table.reset();
+    if (table.get_size())
+        num_errors++;
+
+    return !num_errors;
+}
@@ -0,0 +1,167 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_backtrace_intern_table.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_BACKTRACE_INTERN_TABLE_H
+#define VOGL_BACKTRACE_INTERN_TABLE_H
+
+#include "vogl_common.h"
+#include "vogl_threading.h"
+#include "vogl_trace_stream_types.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_backtrace_intern_table
+// Fixed capacity set which maps backtrace address vectors to small stable indices. Lookups and inserts are lock-free:
+// keys live in an open addressing slot array (linear probing), and entries are bump allocated so indices are dense.
+// Hit counts are accumulated in each thread's cache and published to the shared entry in batches. Caches register
+// themselves with the table on first use, so flush_all_thread_caches() can publish every thread's pending counts.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_backtrace_intern_table
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_backtrace_intern_table);
+
+public:
+    enum
+    {
+        cThreadCacheSize = 64,
+        cCountBatchSize = 64
+    };
+
+    // Per-thread, direct mapped cache of recently interned backtraces. Must only be used by one thread at a time, other
+    // than by flush_all_thread_caches(). Its spinlock is only contended while that's running.
+    class thread_cache
+    {
+        friend class vogl_backtrace_intern_table;
+
+    public:
+        thread_cache()
+            : m_pTable(NULL),
+              m_pPrev(NULL),
+              m_pNext(NULL)
+        {
+            utils::zero_object(m_entries);
+        }
+
+        ~thread_cache()
+        {
+            if (m_pTable)
+                m_pTable->release_thread_cache(*this);
+        }
+
+    private:
+        struct cached_entry
+        {
+            uint32_t m_hash;
+            uint32_t m_index;
+            uint32_t m_generation;
+            uint32_t m_pending_count;
+        };
+
+        cached_entry m_entries[cThreadCacheSize];
+        spinlock m_lock;
+
+        // Set while registered with a table, the links are guarded by the table's m_thread_caches_mutex.
+        vogl_backtrace_intern_table *m_pTable;
+        thread_cache *m_pPrev;
+        thread_cache *m_pNext;
+    };
+
+    vogl_backtrace_intern_table();
+    ~vogl_backtrace_intern_table();
+
+    bool init(uint32_t max_entries);
+    void deinit();
+
+    inline bool is_initialized() const
+    {
+        return m_pSlots != NULL;
+    }
+
+    // Returns false if the table is full or is being reset. pCache may be NULL.
+    bool intern(uint32_t &index, const vogl_backtrace_addrs &addrs, thread_cache *pCache);
+
+    // Publishes any hit counts still held in pCache.
+    void flush_thread_cache(thread_cache &cache);
+
+    // Publishes the hit counts held in every registered thread cache. Call before reading the final counts.
+    void flush_all_thread_caches();
+
+    // Flushes cache and unregisters it from the table. Called by the cache's destructor, so only needed if the table
+    // may be destroyed first.
+    void release_thread_cache(thread_cache &cache);
+
+    // Entries [0, get_size()) may be visited concurrently with intern(), but entries which are still being written are
+    // skipped. Counts don't include hits still pending in other threads' caches.
+    uint32_t get_size() const;
+    bool get_entry(uint32_t index, vogl_backtrace_addrs &addrs, uint64_t &count) const;
+
+    // Waits for in-flight intern() calls to finish, then empties the table. Cached indices are invalidated.
+    void reset();
+
+private:
+    struct slot
+    {
+        // 0 if empty, cSlotBusy while being claimed, cSlotFull if claimed when the table was out of entries, otherwise the entry index + 1
+        atomic32_t m_state;
+        uint32_t m_hash;
+    };
+
+    struct entry
+    {
+        atomic64_t m_count;
+        atomic32_t m_ready;
+        vogl_backtrace_addrs m_addrs;
+    };
+
+    slot *m_pSlots;
+    entry *m_pEntries;
+    uint32_t m_slot_mask;
+    uint32_t m_max_entries;
+
+    atomic32_t m_num_entries;
+
+    // Number of threads inside intern()/flush_thread_cache(), with cResetFlag set while reset() is running.
+    atomic32_t m_guard;
+    atomic32_t m_generation;
+
+    mutex m_thread_caches_mutex;
+    thread_cache *m_pThread_caches;
+
+    bool enter();
+    void leave();
+
+    void register_thread_cache(thread_cache &cache);
+    void unregister_all_thread_caches();
+    void flush_thread_cache_locked(thread_cache &cache);
+
+    bool find_or_insert(uint32_t &index, const vogl_backtrace_addrs &addrs, uint32_t hash);
+    void publish_pending(thread_cache::cached_entry &cached);
+};
+
+bool backtrace_intern_table_test();
+
+#endif // VOGL_BACKTRACE_INTERN_TABLE_H
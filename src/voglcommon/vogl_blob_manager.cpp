@@ -463,6 +463,8 @@ bool vogl_loose_file_blob_manager::deinit()
 {
     VOGL_FUNC_TRACER
 
+    m_added_blobs.clear();
+
     return vogl_blob_manager::deinit();
 }
 
@@ -480,6 +482,16 @@ dynamic_string vogl_loose_file_blob_manager::add_buf_using_id(const void *pData,
     if (actual_id.is_empty())
         actual_id = compute_unique_id(pData, size);
 
+    scoped_mutex lock(m_mutex);
+
+    added_blob_map::const_iterator it(m_added_blobs.find(actual_id));
+    if (it != m_added_blobs.end())
+    {
+        if (it->second != size)
+            vogl_error_printf("%s: Not overwriting already added blob %s desired size %u, but it was added with a different size (%u bytes)!\n", VOGL_FUNCTION_INFO_CSTR, actual_id.get_ptr(), size, it->second);
+        return actual_id;
+    }
+
     dynamic_string filename(get_filename(actual_id));
 
     if (does_exist(filename))
@@ -489,6 +501,8 @@ dynamic_string vogl_loose_file_blob_manager::add_buf_using_id(const void *pData,
             vogl_error_printf("%s: Not overwrite already existing blob %s desired size %u, but it has the wrong size on disk (%" PRIu64 " bytes)!\n", VOGL_FUNCTION_INFO_CSTR, filename.get_ptr(), size, cur_size);
         else
             vogl_message_printf("%s: Not overwriting already existing blob %s size %u\n", VOGL_FUNCTION_INFO_CSTR, filename.get_ptr(), size);
+
+        m_added_blobs.insert(actual_id, size);
         return actual_id;
     }
 
@@ -522,6 +536,8 @@ dynamic_string vogl_loose_file_blob_manager::add_buf_using_id(const void *pData,
         return "";
     }
 
+    m_added_blobs.insert(actual_id, size);
+
     return actual_id;
 }
 
@@ -990,6 +1006,59 @@ vogl::dynamic_string vogl_archive_blob_manager::add_buf_using_id(const void *pDa
 {
     VOGL_FUNC_TRACER
 
+    dynamic_string actual_id(id);
+    if (actual_id.is_empty())
+        actual_id = compute_unique_id(pData, size);
+
+    // TODO: Allow caller to control whether files are compressed
+    return add_mem(actual_id, pData, size, MZ_BEST_SPEED, 0, 0);
+}
+
+bool vogl_archive_blob_manager::compress_buf(const void *pData, uint32_t size, uint8_vec &comp_data, uint32_t &crc32)
+{
+    VOGL_FUNC_TRACER
+
+    crc32 = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, static_cast<const uint8_t *>(pData), size));
+
+    // Raw deflate, with the same flags mz_zip_writer_add_mem() uses at MZ_BEST_SPEED.
+    if ((!size) || (!comp_data.try_resize(size)))
+    {
+        comp_data.clear();
+        return false;
+    }
+
+    uint32_t comp_flags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+    size_t comp_size = tdefl_compress_mem_to_mem(comp_data.get_ptr(), comp_data.size(), pData, size, comp_flags);
+    if ((!comp_size) || (comp_size >= size))
+    {
+        comp_data.clear();
+        return false;
+    }
+
+    comp_data.resize(static_cast<uint32_t>(comp_size));
+    return true;
+}
+
+vogl::dynamic_string vogl_archive_blob_manager::add_compressed_buf_using_id(const void *pData, uint32_t size, const uint8_vec &comp_data, uint32_t crc32, const vogl::dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
+
+    if (id.is_empty())
+    {
+        VOGL_ASSERT(0);
+        return "";
+    }
+
+    if (comp_data.is_empty())
+        return add_mem(id, pData, size, 0, 0, 0);
+
+    return add_mem(id, comp_data.get_ptr(), comp_data.size(), MZ_BEST_SPEED | MZ_ZIP_FLAG_COMPRESSED_DATA, size, crc32);
+}
+
+vogl::dynamic_string vogl_archive_blob_manager::add_mem(const vogl::dynamic_string &id, const void *pBuf, size_t buf_size, uint32_t level_and_flags, uint32_t size, uint32_t crc32)
+{
+    VOGL_FUNC_TRACER
+
     if (!is_initialized() || !is_writable())
     {
         VOGL_ASSERT(0);
@@ -999,35 +1068,30 @@ vogl::dynamic_string vogl_archive_blob_manager::add_buf_using_id(const void *pDa
     if (mz_zip_get_mode(&m_zip) != MZ_ZIP_MODE_WRITING)
         return "";
 
-    dynamic_string actual_id(id);
-    if (actual_id.is_empty())
-        actual_id = compute_unique_id(pData, size);
-
     // We don't support overwriting files already in the archive - it's up to the caller to not try adding redundant files into the archive.
     // We could support orphaning the previous copy of the file and updating the archive to point to the latest version, though.
-    if (m_blobs.contains(actual_id))
+    if (m_blobs.contains(id))
     {
-        vogl_debug_printf("%s: Archive already contains blob id \"%s\"! Not replacing file.\n", VOGL_FUNCTION_INFO_CSTR, actual_id.get_ptr());
-        return actual_id;
+        vogl_debug_printf("%s: Archive already contains blob id \"%s\"! Not replacing file.\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+        return id;
     }
 
     uint32_t file_index = mz_zip_get_num_files(&m_zip);
 
-    // TODO: Allow caller to control whether files are compressed
-    if (!mz_zip_writer_add_mem(&m_zip, actual_id.get_ptr(), pData, size, MZ_BEST_SPEED))
-    //if (!mz_zip_writer_add_mem(&m_zip, actual_id.get_ptr(), pData, size, 0))
+    if (!mz_zip_writer_add_mem_ex(&m_zip, id.get_ptr(), pBuf, buf_size, NULL, 0, level_and_flags, size, crc32))
     {
         mz_zip_error mz_err = mz_zip_get_last_error(&m_zip);
-        vogl_error_printf("%s: mz_zip_writer_add_mem() failed adding blob \"%s\" size %u, error 0x%X (%s)\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr(), size, mz_err, mz_zip_get_error_string(mz_err));
+        vogl_error_printf("%s: mz_zip_writer_add_mem_ex() failed adding blob \"%s\" size %u, error 0x%X (%s)\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr(), static_cast<uint32_t>(buf_size), mz_err, mz_zip_get_error_string(mz_err));
 
         return "";
     }
 
-    bool success = m_blobs.insert(actual_id, blob(actual_id, file_index, size)).second;
+    uint64_t blob_size = (level_and_flags & MZ_ZIP_FLAG_COMPRESSED_DATA) ? size : buf_size;
+    bool success = m_blobs.insert(id, blob(id, file_index, blob_size)).second;
     VOGL_NOTE_UNUSED(success);
     VOGL_ASSERT(success);
 
-    return actual_id;
+    return id;
 }
 
 vogl::data_stream *vogl_archive_blob_manager::open(const vogl::dynamic_string &id) const
@@ -1046,6 +1110,8 @@ vogl::data_stream *vogl_archive_blob_manager::open(const vogl::dynamic_string &i
 
     // TODO: Add some sort of streaming decompression support to miniz and this class.
 
+    scoped_mutex lock(m_mutex);
+
     mz_zip_clear_last_error(&m_zip);
 
     size_t size;
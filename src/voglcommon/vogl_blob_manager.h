@@ -29,6 +29,7 @@
 
 #include "vogl_map.h"
 #include "vogl_data_stream.h"
+#include "vogl_threading.h"
 #include "vogl_miniz_zip.h"
 
 enum vogl_blob_manager_type_t
@@ -283,6 +284,13 @@ private:
     vogl::dynamic_string get_filename(const vogl::dynamic_string &id) const;
 
     dynamic_string m_path;
+
+    // Adds may come from several threads (e.g. a multithreaded --dump). The mutex is held for the whole add so a blob
+    // is completely written before any thread gets its id back, and m_added_blobs lets repeated blobs skip the disk.
+    typedef vogl::map<vogl::dynamic_string, uint32_t, vogl::dynamic_string_less_than_case_sensitive, vogl::dynamic_string_equal_to_case_sensitive> added_blob_map;
+
+    vogl::mutex m_mutex;
+    added_blob_map m_added_blobs;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -325,6 +333,13 @@ public:
 
     virtual vogl::dynamic_string add_buf_using_id(const void *pData, uint32_t size, const vogl::dynamic_string &id);
 
+    // Compresses a blob the same way add_buf_using_id() would, so callers can do the expensive part without holding
+    // whatever lock guards the archive. Thread safe. Returns false (and clears comp_data) if the data doesn't compress.
+    static bool compress_buf(const void *pData, uint32_t size, uint8_vec &comp_data, uint32_t &crc32);
+
+    // Adds a blob previously passed to compress_buf(). If comp_data is empty the blob is stored uncompressed.
+    vogl::dynamic_string add_compressed_buf_using_id(const void *pData, uint32_t size, const uint8_vec &comp_data, uint32_t crc32, const vogl::dynamic_string &id);
+
     virtual vogl::data_stream *open(const vogl::dynamic_string &id) const;
     virtual void close(vogl::data_stream *pStream) const;
 
@@ -338,6 +353,10 @@ private:
     mutable mz_zip_archive m_zip;
     dynamic_string m_archive_filename;
 
+    // Blobs may be read from several threads at once (e.g. the replayer's read ahead thread resolving client memory
+    // while the replay thread loads a snapshot), and miniz's reader isn't reentrant.
+    mutable vogl::mutex m_mutex;
+
     struct blob
     {
         vogl::dynamic_string m_id;
@@ -358,6 +377,7 @@ private:
 
     vogl::dynamic_string get_filename(const vogl::dynamic_string &id) const;
     bool populate_blob_map();
+    vogl::dynamic_string add_mem(const vogl::dynamic_string &id, const void *pBuf, size_t buf_size, uint32_t level_and_flags, uint32_t size, uint32_t crc32);
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -100,10 +100,8 @@ bool vogl_display_list::serialize(json_node &node, vogl_blob_manager &blob_manag
         json_node &packets_array = node.add_array("packets");
         for (uint32_t i = 0; i < m_packets.size(); i++)
         {
-            const uint8_vec &packet_buf = m_packets.get_packet_buf(i);
-
             vogl_trace_packet packet(pCtypes);
-            if (!packet.deserialize(packet_buf.get_ptr(), packet_buf.size(), true))
+            if (!packet.deserialize(m_packets.get_packet_ptr(i), m_packets.get_packet_size(i), true))
                 return false;
 
             if (!packet.json_serialize(packets_array.add_object(), params))
@@ -141,8 +139,9 @@ bool vogl_display_list::deserialize(const json_node &node, const vogl_blob_manag
         }
 
         vogl_trace_packet packet(pCtypes);
+        uint8_vec packet_buf;
 
-        m_packets.resize(pPackets_array->size());
+        m_packets.reserve(pPackets_array->size());
         for (uint32_t i = 0; i < pPackets_array->size(); i++)
         {
             if (!packet.json_deserialize(*pPackets_array->get_child(i), "<display_list>", &blob_manager))
@@ -151,7 +150,13 @@ bool vogl_display_list::deserialize(const json_node &node, const vogl_blob_manag
                 return false;
             }
 
-            if (!packet.serialize(m_packets.get_packet_buf(i)))
+            if (!packet.serialize(packet_buf))
+            {
+                clear();
+                return false;
+            }
+
+            if (!m_packets.push_back(packet_buf))
             {
                 clear();
                 return false;
@@ -398,7 +403,12 @@ bool vogl_display_list_state::add_packet_to_list(GLuint handle, gl_entrypoint_id
         return false;
     }
 
-    pList->get_packets().push_back(buf);
+    if (!pList->get_packets().push_back(buf))
+    {
+        vogl_error_printf("%s: Out of memory adding trace packet to display list shadow! List handle %u.\n", VOGL_FUNCTION_INFO_CSTR, handle);
+        return false;
+    }
+
     return true;
 }
 
@@ -443,7 +453,7 @@ bool vogl_display_list_state::parse_list_and_update_shadows(GLuint handle, pBind
                 continue;
         }
 
-        if (!trace_packet.deserialize(packets.get_packet_buf(packet_index), false))
+        if (!trace_packet.deserialize(packets.get_packet_ptr(packet_index), packets.get_packet_size(packet_index), false))
         {
             vogl_error_printf("%s: Failed parsing GL entrypoint packet in display list %u\n", VOGL_FUNCTION_INFO_CSTR, handle);
             VOGL_ASSERT_ALWAYS;
@@ -0,0 +1,390 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_entrypoint_stats.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_entrypoint_stats.h"
+
+namespace
+{
+    // A very hot entrypoint could keep a snapshot retrying forever, after this many attempts the last copy is used.
+    const uint32_t cMaxSnapshotAttempts = 64;
+    const uint32_t cSnapshotSpinAttempts = 8;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::counters::clear
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::counters::clear()
+{
+    utils::zero_this(this);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::counters::merge
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::counters::merge(const counters &other)
+{
+    m_num_calls += other.m_num_calls;
+    m_pre_ticks += other.m_pre_ticks;
+    m_driver_ticks += other.m_driver_ticks;
+    m_post_ticks += other.m_post_ticks;
+    m_max_overhead_ticks = math::maximum(m_max_overhead_ticks, other.m_max_overhead_ticks);
+
+    for (uint32_t i = 0; i < cHistogramBuckets; i++)
+    {
+        m_driver_histogram[i] += other.m_driver_histogram[i];
+        m_overhead_histogram[i] += other.m_overhead_histogram[i];
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::thread_counters::thread_counters
+//----------------------------------------------------------------------------------------------------------------------
+vogl_entrypoint_stats::thread_counters::thread_counters(vogl_entrypoint_stats *pOwner)
+    : m_pOwner(pOwner),
+      m_generation(pOwner->m_generation)
+{
+    utils::zero_object(m_pBlocks);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::thread_counters::clear_blocks
+// Called by the owning thread when it notices a reset().
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::thread_counters::clear_blocks(atomic32_t generation)
+{
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+    {
+        counter_block *pBlock = m_pBlocks[i];
+        if (!pBlock)
+            continue;
+
+        atomic_increment32(&pBlock->m_seq);
+        pBlock->m_counters.clear();
+        pBlock->m_generation = generation;
+        atomic_increment32(&pBlock->m_seq);
+    }
+
+    m_generation = generation;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::vogl_entrypoint_stats
+//----------------------------------------------------------------------------------------------------------------------
+vogl_entrypoint_stats::vogl_entrypoint_stats()
+    : m_mutex(0, true),
+      m_generation(0)
+{
+    m_retired.resize(VOGL_NUM_ENTRYPOINTS);
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+        m_retired[i].clear();
+
+    m_start_rdtsc = utils::RDTSC();
+    m_start_timer.start();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::~vogl_entrypoint_stats
+//----------------------------------------------------------------------------------------------------------------------
+vogl_entrypoint_stats::~vogl_entrypoint_stats()
+{
+    scoped_mutex lock(m_mutex);
+
+    while (m_threads.size())
+        release_thread_counters(m_threads.back());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::create_thread_counters
+//----------------------------------------------------------------------------------------------------------------------
+vogl_entrypoint_stats::thread_counters *vogl_entrypoint_stats::create_thread_counters()
+{
+    scoped_mutex lock(m_mutex);
+
+    thread_counters *pThread_counters = vogl_new(thread_counters, this);
+    if (!pThread_counters)
+        return NULL;
+
+    m_threads.push_back(pThread_counters);
+
+    return pThread_counters;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::release_thread_counters
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::release_thread_counters(thread_counters *pThread_counters)
+{
+    if (!pThread_counters)
+        return;
+
+    scoped_mutex lock(m_mutex);
+
+    int index = m_threads.find(pThread_counters);
+    VOGL_ASSERT(index >= 0);
+    if (index >= 0)
+        m_threads.erase_unordered(index);
+
+    // Called on the owning thread (or after it's gone), so the counters are stable.
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+    {
+        thread_counters::counter_block *pBlock = pThread_counters->m_pBlocks[i];
+        if (pBlock)
+        {
+            if (pBlock->m_generation == m_generation)
+                m_retired[i].merge(pBlock->m_counters);
+            vogl_delete(pBlock);
+        }
+    }
+
+    vogl_delete(pThread_counters);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::alloc_block
+// Called by the owning thread. Done under the mutex so readers never see a half initialized block.
+//----------------------------------------------------------------------------------------------------------------------
+vogl_entrypoint_stats::thread_counters::counter_block *vogl_entrypoint_stats::alloc_block(thread_counters &thread_counters, gl_entrypoint_id_t id)
+{
+    thread_counters::counter_block *pBlock = vogl_new(thread_counters::counter_block);
+    if (!pBlock)
+        return NULL;
+
+    pBlock->m_seq = 0;
+    pBlock->m_generation = thread_counters.m_generation;
+    pBlock->m_counters.clear();
+
+    scoped_mutex lock(m_mutex);
+    thread_counters.m_pBlocks[id] = pBlock;
+
+    return pBlock;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::reset
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::reset()
+{
+    scoped_mutex lock(m_mutex);
+
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+        m_retired[i].clear();
+
+    // Other threads may be updating their counters right now, so leave clearing them to their owners.
+    atomic_increment32(&m_generation);
+
+    m_start_rdtsc = utils::RDTSC();
+    m_start_timer.start();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::get_totals
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::get_totals(vogl::vector<counters> &totals) const
+{
+    scoped_mutex lock(m_mutex);
+
+    totals = m_retired;
+
+    counters snapshot;
+
+    for (uint32_t t = 0; t < m_threads.size(); t++)
+    {
+        for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+        {
+            const thread_counters::counter_block *pBlock = m_threads[t]->m_pBlocks[i];
+            if ((pBlock) && (get_block_snapshot(*pBlock, snapshot)))
+                totals[i].merge(snapshot);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::get_block_snapshot
+// Copies the block's counters, retrying if the owner updated them during the copy. Caller must hold m_mutex.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_entrypoint_stats::get_block_snapshot(const thread_counters::counter_block &block, counters &snapshot) const
+{
+    for (uint32_t attempts = 1;; attempts++)
+    {
+        atomic32_t seq = atomic_load32(&block.m_seq);
+
+        snapshot = block.m_counters;
+        atomic32_t generation = block.m_generation;
+
+        atomic_memory_barrier();
+
+        if (((!(seq & 1)) && (atomic_load32(&block.m_seq) == seq)) || (attempts >= cMaxSnapshotAttempts))
+            return generation == m_generation;
+
+        // The owner may have been preempted mid-update, so stop spinning and let it run.
+        if (attempts < cSnapshotSpinAttempts)
+            vogl_yield_processor();
+        else
+            vogl_sleep(1);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::get_ticks_per_sec
+// RDTSC() may be the TSC or a nanosecond clock, so its rate is measured over the lifetime of the stats.
+//----------------------------------------------------------------------------------------------------------------------
+double vogl_entrypoint_stats::get_ticks_per_sec() const
+{
+    double secs = m_start_timer.get_elapsed_secs();
+    uint64_t ticks = utils::RDTSC() - m_start_rdtsc;
+
+    if ((secs <= 0.0) || (!ticks))
+        return 1000000000.0;
+
+    return static_cast<double>(ticks) / secs;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::get_sorted_totals
+//----------------------------------------------------------------------------------------------------------------------
+namespace
+{
+    struct overhead_sorter
+    {
+        const vogl::vector<vogl_entrypoint_stats::counters> *m_pTotals;
+
+        bool operator()(uint32_t lhs, uint32_t rhs) const
+        {
+            uint64_t lhs_overhead = (*m_pTotals)[lhs].get_overhead_ticks();
+            uint64_t rhs_overhead = (*m_pTotals)[rhs].get_overhead_ticks();
+            if (lhs_overhead != rhs_overhead)
+                return lhs_overhead > rhs_overhead;
+            return lhs < rhs;
+        }
+    };
+}
+
+void vogl_entrypoint_stats::get_sorted_totals(vogl::vector<counters> &totals, vogl::vector<uint32_t> &sorted_ids) const
+{
+    get_totals(totals);
+
+    sorted_ids.resize(0);
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+        if (totals[i].m_num_calls)
+            sorted_ids.push_back(i);
+
+    overhead_sorter sorter;
+    sorter.m_pTotals = &totals;
+    sorted_ids.sort(sorter);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::get_json
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_entrypoint_stats::get_json(json_node &node) const
+{
+    vogl::vector<counters> totals;
+    vogl::vector<uint32_t> sorted_ids;
+    get_sorted_totals(totals, sorted_ids);
+
+    node.add_key_value("ticks_per_sec", get_ticks_per_sec());
+    node.add_key_value("histogram_buckets", static_cast<uint32_t>(cHistogramBuckets));
+
+    json_node &entrypoints_node = node.add_array("entrypoints");
+    for (uint32_t i = 0; i < sorted_ids.size(); i++)
+    {
+        const counters &c = totals[sorted_ids[i]];
+
+        json_node &entrypoint_node = entrypoints_node.add_object();
+        entrypoint_node.add_key_value("name", g_vogl_entrypoint_descs[sorted_ids[i]].m_pName);
+        entrypoint_node.add_key_value("calls", c.m_num_calls);
+        entrypoint_node.add_key_value("pre_ticks", c.m_pre_ticks);
+        entrypoint_node.add_key_value("driver_ticks", c.m_driver_ticks);
+        entrypoint_node.add_key_value("post_ticks", c.m_post_ticks);
+        entrypoint_node.add_key_value("max_overhead_ticks", c.m_max_overhead_ticks);
+
+        json_node &driver_histogram_node = entrypoint_node.add_array("driver_histogram");
+        json_node &overhead_histogram_node = entrypoint_node.add_array("overhead_histogram");
+        for (uint32_t b = 0; b < cHistogramBuckets; b++)
+        {
+            driver_histogram_node.add_value(c.m_driver_histogram[b]);
+            overhead_histogram_node.add_value(c.m_overhead_histogram[b]);
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats::print_table
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_entrypoint_stats::print_table(uint32_t max_rows) const
+{
+    vogl::vector<counters> totals;
+    vogl::vector<uint32_t> sorted_ids;
+    get_sorted_totals(totals, sorted_ids);
+
+    const double ms_per_tick = 1000.0 / get_ticks_per_sec();
+
+    counters grand_total;
+    grand_total.clear();
+    for (uint32_t i = 0; i < sorted_ids.size(); i++)
+        grand_total.merge(totals[sorted_ids[i]]);
+
+    vogl_message_printf("Tracer overhead by entrypoint: %" PRIu64 " calls, %.3f ms in the driver, %.3f ms tracer overhead (%.3f ms before, %.3f ms after the driver call)\n",
+                        grand_total.m_num_calls, grand_total.m_driver_ticks * ms_per_tick, grand_total.get_overhead_ticks() * ms_per_tick,
+                        grand_total.m_pre_ticks * ms_per_tick, grand_total.m_post_ticks * ms_per_tick);
+
+    vogl_message_printf("%-40s %12s %12s %12s %12s %8s %10s %10s %10s\n",
+                        "Entrypoint", "Calls", "Driver ms", "Pre ms", "Post ms", "Ovhd %", "Avg us", "P99 us", "Max us");
+
+    for (uint32_t i = 0; i < math::minimum<uint32_t>(max_rows, sorted_ids.size()); i++)
+    {
+        const counters &c = totals[sorted_ids[i]];
+
+        uint64_t overhead_ticks = c.get_overhead_ticks();
+        uint64_t total_ticks = overhead_ticks + c.m_driver_ticks;
+
+        // Upper bound of the histogram bucket holding the 99th percentile call.
+        uint64_t p99_threshold = c.m_num_calls - c.m_num_calls / 100U;
+        uint64_t num_seen = 0;
+        uint32_t p99_bucket = 0;
+        for (; p99_bucket < cHistogramBuckets - 1; p99_bucket++)
+        {
+            num_seen += c.m_overhead_histogram[p99_bucket];
+            if (num_seen >= p99_threshold)
+                break;
+        }
+
+        vogl_message_printf("%-40s %12" PRIu64 " %12.3f %12.3f %12.3f %8.2f %10.3f %10.3f %10.3f\n",
+                            g_vogl_entrypoint_descs[sorted_ids[i]].m_pName, c.m_num_calls,
+                            c.m_driver_ticks * ms_per_tick, c.m_pre_ticks * ms_per_tick, c.m_post_ticks * ms_per_tick,
+                            total_ticks ? (overhead_ticks * 100.0 / total_ticks) : 0.0,
+                            (overhead_ticks * ms_per_tick * 1000.0) / c.m_num_calls,
+                            (1ULL << (p99_bucket + 1)) * ms_per_tick * 1000.0,
+                            c.m_max_overhead_ticks * ms_per_tick * 1000.0);
+    }
+
+    if (sorted_ids.size() > max_rows)
+        vogl_message_printf("(%u more entrypoints omitted, see the trace archive's %s)\n", sorted_ids.size() - max_rows, VOGL_TRACE_ARCHIVE_ENTRYPOINT_STATS_FILENAME);
+}
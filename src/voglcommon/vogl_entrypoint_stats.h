@@ -0,0 +1,201 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_entrypoint_stats.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_ENTRYPOINT_STATS_H
+#define VOGL_ENTRYPOINT_STATS_H
+
+#include "vogl_common.h"
+#include "vogl_trace_stream_types.h"
+#include "vogl_threading.h"
+#include "vogl_json.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_entrypoint_stats
+// Per-entrypoint tracer timing: call counts, time spent in the driver, and the tracer's own overhead before and after
+// the driver call, with log2 histograms of the driver and overhead times. Each tracing thread updates its own
+// counters without locking, bracketed by a per-entrypoint sequence count so readers can take consistent snapshots.
+// Only the owning thread ever writes its counters, reset() just bumps a generation which the owner picks up on its
+// next call. Totals are gathered from all live threads plus the threads which have already exited.
+// All times are in the units of utils::RDTSC().
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_entrypoint_stats
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_entrypoint_stats);
+
+public:
+    enum
+    {
+        // Bucket i counts calls which took [2^i, 2^(i+1)) ticks, bucket 0 also counts 0 tick calls.
+        cHistogramBuckets = 40
+    };
+
+    struct counters
+    {
+        uint64_t m_num_calls;
+        uint64_t m_pre_ticks;
+        uint64_t m_driver_ticks;
+        uint64_t m_post_ticks;
+        uint64_t m_max_overhead_ticks;
+        uint32_t m_driver_histogram[cHistogramBuckets];
+        uint32_t m_overhead_histogram[cHistogramBuckets];
+
+        void clear();
+        void merge(const counters &other);
+
+        inline uint64_t get_overhead_ticks() const
+        {
+            return m_pre_ticks + m_post_ticks;
+        }
+    };
+
+    class thread_counters
+    {
+        friend class vogl_entrypoint_stats;
+
+    public:
+        // Use vogl_entrypoint_stats::create_thread_counters().
+        explicit thread_counters(vogl_entrypoint_stats *pOwner);
+
+        // begin is the packet's begin timestamp, gl_begin/gl_end bracket the driver call, end is taken after the
+        // packet has been written. Packets without usable driver timestamps are counted as all overhead.
+        inline void record(gl_entrypoint_id_t id, uint64_t begin, uint64_t gl_begin, uint64_t gl_end, uint64_t end)
+        {
+            if (id >= VOGL_NUM_ENTRYPOINTS)
+                return;
+
+            atomic32_t generation = m_pOwner->m_generation;
+            if (m_generation != generation)
+                clear_blocks(generation);
+
+            counter_block *pBlock = m_pBlocks[id];
+            if (!pBlock)
+            {
+                pBlock = m_pOwner->alloc_block(*this, id);
+                if (!pBlock)
+                    return;
+            }
+
+            // Timestamps can be missing (zero) or out of order if a packet was built outside of the usual wrappers.
+            if ((gl_begin < begin) || (gl_end < gl_begin) || (end < gl_end))
+            {
+                gl_begin = begin;
+                gl_end = begin;
+                if (end < begin)
+                    end = begin;
+            }
+
+            uint64_t driver_ticks = gl_end - gl_begin;
+            uint64_t overhead_ticks = (gl_begin - begin) + (end - gl_end);
+
+            atomic_increment32(&pBlock->m_seq);
+
+            counters *pCounters = &pBlock->m_counters;
+            pCounters->m_num_calls++;
+            pCounters->m_pre_ticks += gl_begin - begin;
+            pCounters->m_driver_ticks += driver_ticks;
+            pCounters->m_post_ticks += end - gl_end;
+            pCounters->m_max_overhead_ticks = math::maximum(pCounters->m_max_overhead_ticks, overhead_ticks);
+            pCounters->m_driver_histogram[get_bucket(driver_ticks)]++;
+            pCounters->m_overhead_histogram[get_bucket(overhead_ticks)]++;
+
+            atomic_increment32(&pBlock->m_seq);
+        }
+
+    private:
+        struct counter_block
+        {
+            // Odd while the owning thread is updating m_counters.
+            atomic32_t m_seq;
+
+            // The owner's generation when m_counters was last cleared, counters from older generations are ignored.
+            atomic32_t m_generation;
+
+            counters m_counters;
+        };
+
+        vogl_entrypoint_stats *m_pOwner;
+
+        // The owner's generation when all of this thread's blocks were last cleared.
+        atomic32_t m_generation;
+
+        // Allocated on the first call to each entrypoint, most apps only use a small fraction of them.
+        counter_block *m_pBlocks[VOGL_NUM_ENTRYPOINTS];
+
+        static inline uint32_t get_bucket(uint64_t ticks)
+        {
+            uint32_t bucket = 0;
+            while ((ticks >>= 1) != 0)
+                bucket++;
+            return math::minimum<uint32_t>(bucket, cHistogramBuckets - 1);
+        }
+
+        void clear_blocks(atomic32_t generation);
+    };
+
+    vogl_entrypoint_stats();
+    ~vogl_entrypoint_stats();
+
+    // Returns NULL on allocation failure. release_thread_counters() must be called before the owning thread exits.
+    thread_counters *create_thread_counters();
+    void release_thread_counters(thread_counters *pThread_counters);
+
+    // Zeros all counters and restarts the tick rate measurement, call when a capture begins. Live threads clear their
+    // own counters on their next call, until then they're left out of the totals.
+    void reset();
+
+    // Counters still being updated by other threads may be a few calls behind.
+    void get_totals(vogl::vector<counters> &totals) const;
+
+    // Entrypoints are sorted by descending tracer overhead.
+    bool get_json(json_node &node) const;
+    void print_table(uint32_t max_rows) const;
+
+private:
+    mutable mutex m_mutex;
+
+    vogl::vector<thread_counters *> m_threads;
+
+    // Totals from threads which have already exited
+    vogl::vector<counters> m_retired;
+
+    // Incremented by reset(), only written with m_mutex held.
+    atomic32_t m_generation;
+
+    uint64_t m_start_rdtsc;
+    timer m_start_timer;
+
+    thread_counters::counter_block *alloc_block(thread_counters &thread_counters, gl_entrypoint_id_t id);
+
+    // Returns false if the block hasn't been updated since the last reset().
+    bool get_block_snapshot(const thread_counters::counter_block &block, counters &snapshot) const;
+
+    double get_ticks_per_sec() const;
+    void get_sorted_totals(vogl::vector<counters> &totals, vogl::vector<uint32_t> &sorted_ids) const;
+};
+
+#endif // VOGL_ENTRYPOINT_STATS_H
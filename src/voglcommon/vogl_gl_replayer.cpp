@@ -147,6 +147,7 @@ vogl_gl_replayer::vogl_gl_replayer()
       m_pBlob_manager(NULL),
       m_pPending_snapshot(NULL),
       m_delete_pending_snapshot_after_applying(false),
+      m_pSnapshot_cache(&m_snapshot_cache),
       m_replay_to_trace_remapper(*this)
 {
     VOGL_FUNC_TRACER
@@ -246,10 +247,8 @@ void vogl_gl_replayer::deinit()
     destroy_pending_snapshot();
     destroy_contexts();
 
-    // TODO: Make a 1st class snapshot cache class
-    for (uint32_t i = 0; i < m_snapshots.size(); i++)
-        vogl_delete(m_snapshots[i].m_pSnapshot);
-    m_snapshots.clear();
+    m_snapshot_cache.clear();
+    m_pSnapshot_cache = &m_snapshot_cache;
 
     m_ctypes_packet.reset();
 
@@ -341,6 +340,38 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_next_packet(vogl_trace_file
     VOGL_FUNC_TRACER
 
     vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+    if (read_status != vogl_trace_file_reader::cOK)
+        return process_read_packet(read_status, cTSPTEOF, m_temp_gl_packet);
+
+    vogl_trace_stream_packet_types_t packet_type = trace_reader.get_packet_type();
+    if (packet_type == cTSPTGLEntrypoint)
+        m_temp_gl_packet.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), false);
+
+    return process_read_packet(read_status, packet_type, m_temp_gl_packet);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::process_next_packet
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_gl_replayer::process_next_packet(vogl_trace_packet_prefetcher &packet_prefetcher)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_trace_file_reader::trace_file_reader_status_t read_status = packet_prefetcher.read_next_packet();
+    if (read_status != vogl_trace_file_reader::cOK)
+        return process_read_packet(read_status, cTSPTEOF, m_temp_gl_packet);
+
+    return process_read_packet(read_status, packet_prefetcher.get_packet_type(), packet_prefetcher.get_gl_packet());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::process_read_packet
+// gl_packet must already be deserialized if packet_type is cTSPTGLEntrypoint, it's not valid if that failed.
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_gl_replayer::process_read_packet(vogl_trace_file_reader::trace_file_reader_status_t read_status, vogl_trace_stream_packet_types_t packet_type, vogl_trace_packet &gl_packet)
+{
+    VOGL_FUNC_TRACER
+
     if (read_status == vogl_trace_file_reader::cEOF)
     {
         vogl_message_printf("At trace file EOF\n");
@@ -354,7 +385,7 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_next_packet(vogl_trace_file
 
     status_t status = cStatusOK;
 
-    switch (trace_reader.get_packet_type())
+    switch (packet_type)
     {
         case cTSPTSOF:
         {
@@ -363,14 +394,14 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_next_packet(vogl_trace_file
         }
         case cTSPTGLEntrypoint:
         {
-            if (!m_temp_gl_packet.deserialize(trace_reader.get_packet_buf().get_ptr(), trace_reader.get_packet_buf().size(), false))
+            if (!gl_packet.is_valid())
             {
                 vogl_error_printf("Failed deserializing GL entrypoint packet\n");
                 status = cStatusHardFailure;
                 break;
             }
 
-            status = process_next_packet(m_temp_gl_packet);
+            status = process_next_packet(gl_packet);
 
             break;
         }
@@ -447,6 +478,25 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_frame(vogl_trace_file_reade
     return status;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::process_frame
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_gl_replayer::process_frame(vogl_trace_packet_prefetcher &packet_prefetcher)
+{
+    VOGL_FUNC_TRACER
+
+    status_t status = cStatusOK;
+
+    for (;;)
+    {
+        status = process_next_packet(packet_prefetcher);
+        if ((status == cStatusNextFrame) || (status == cStatusResizeWindow) || (status == cStatusAtEOF) || (status == cStatusHardFailure))
+            break;
+    }
+
+    return status;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_replayer::process_event
 //----------------------------------------------------------------------------------------------------------------------
@@ -607,15 +657,7 @@ void vogl_gl_replayer::destroy_pending_snapshot()
         if (m_delete_pending_snapshot_after_applying)
         {
             // Ensure the snapshot cache can't be pointing to the snapshot, just to be safe.
-            // TODO: Make this a real class damn it.
-            for (uint32_t i = 0; i < m_snapshots.size(); i++)
-            {
-                if (m_snapshots[i].m_pSnapshot == m_pPending_snapshot)
-                {
-                    m_snapshots.erase(i);
-                    break;
-                }
-            }
+            m_pSnapshot_cache->release(m_pPending_snapshot);
 
             vogl_delete(const_cast<vogl_gl_state_snapshot *>(m_pPending_snapshot));
         }
@@ -2031,84 +2073,23 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_internal_trace_command(cons
 
                 dynamic_string id_to_use(text_id.is_empty() ? binary_id : text_id);
 
-                // TODO: Make a 1st class snapshot cache class
                 // TODO: This could fail if the user hand modifies the snapshot in some way - add an option to disable caching.
-                vogl_gl_state_snapshot *pSnapshot = NULL;
-                if (m_flags & cGLReplayerSnapshotCaching)
+                if (!m_pBlob_manager)
                 {
-                    for (uint32_t snapshot_index = 0; snapshot_index < m_snapshots.size(); snapshot_index++)
-                    {
-                        if (!m_snapshots[snapshot_index].m_name.compare(id_to_use, false))
-                        {
-                            pSnapshot = m_snapshots[snapshot_index].m_pSnapshot;
-                            if (snapshot_index)
-                            {
-                                snapshot_cache_entry cache_entry(m_snapshots[snapshot_index]);
-                                m_snapshots.erase(snapshot_index);
-                                m_snapshots.insert(0, cache_entry);
-                            }
-                            break;
-                        }
-                    }
+                    process_entrypoint_error("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
+                    return cStatusHardFailure;
                 }
 
+                vogl_gl_state_snapshot *pSnapshot;
+                if (m_flags & cGLReplayerSnapshotCaching)
+                    pSnapshot = m_pSnapshot_cache->get_or_load(id_to_use, id_to_use != text_id, *m_pBlob_manager, &m_trace_gl_ctypes);
+                else
+                    pSnapshot = vogl_gl_state_snapshot_cache::load(id_to_use, id_to_use != text_id, *m_pBlob_manager, &m_trace_gl_ctypes);
+
                 if (!pSnapshot)
                 {
-                    timed_scope ts("Deserialize snapshot time");
-
-                    if (!m_pBlob_manager)
-                    {
-                        process_entrypoint_error("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
-                        return cStatusHardFailure;
-                    }
-
-                    uint8_vec snapshot_data;
-
-                    if (!m_pBlob_manager->get(id_to_use, snapshot_data) || (snapshot_data.is_empty()))
-                    {
-                        process_entrypoint_error("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
-                        return cStatusHardFailure;
-                    }
-
-                    vogl_message_printf("%s: Deserializing state snapshot \"%s\", %u bytes\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr(), snapshot_data.size());
-
-                    json_document doc;
-
-                    bool success;
-                    if (id_to_use == text_id)
-                        success = doc.deserialize(reinterpret_cast<const char *>(snapshot_data.get_ptr()), snapshot_data.size());
-                    else
-                        success = doc.binary_deserialize(snapshot_data);
-                    if (!success || (!doc.get_root()))
-                    {
-                        process_entrypoint_error("%s: Failed deserializing JSON snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
-                        return cStatusHardFailure;
-                    }
-
-                    pSnapshot = vogl_new(vogl_gl_state_snapshot);
-                    if (!pSnapshot->deserialize(*doc.get_root(), *m_pBlob_manager, &m_trace_gl_ctypes))
-                    {
-                        vogl_delete(pSnapshot);
-                        pSnapshot = NULL;
-
-                        process_entrypoint_error("%s: Failed deserializing snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
-                        return cStatusHardFailure;
-                    }
-
-                    if (m_flags & cGLReplayerSnapshotCaching)
-                    {
-                        snapshot_cache_entry new_cache_entry;
-                        new_cache_entry.m_name = id_to_use;
-                        new_cache_entry.m_pSnapshot = pSnapshot;
-                        m_snapshots.insert(0, new_cache_entry);
-
-                        // FIXME: Even 3-4 snapshots in memory may be too much in 32-bit mode for some large apps.
-                        while (m_snapshots.size() > 3)
-                        {
-                            vogl_delete(m_snapshots.back().m_pSnapshot);
-                            m_snapshots.resize(m_snapshots.size() - 1);
-                        }
-                    }
+                    process_entrypoint_error("%s: Failed deserializing snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
+                    return cStatusHardFailure;
                 }
 
                 status = begin_applying_snapshot(pSnapshot, (m_flags & cGLReplayerSnapshotCaching) ? false : true);
@@ -2117,16 +2098,9 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_internal_trace_command(cons
                 {
                     if (m_flags & cGLReplayerSnapshotCaching)
                     {
-                        VOGL_ASSERT(m_snapshots[0].m_pSnapshot == pSnapshot);
-
-                        vogl_delete(m_snapshots[0].m_pSnapshot);
-                        m_snapshots.erase(0U);
-                    }
-
-                    if (m_flags & cGLReplayerSnapshotCaching)
-                    {
-                        vogl_delete(pSnapshot);
-                        pSnapshot = NULL;
+                        // The pending snapshot may still point to it.
+                        destroy_pending_snapshot();
+                        m_pSnapshot_cache->erase(id_to_use);
                     }
 
                     process_entrypoint_error("%s: Failed applying GL snapshot from blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id_to_use.get_ptr());
@@ -2959,9 +2933,9 @@ bool vogl_gl_replayer::dump_framebuffer(
     uint32_t trace_read_framebuffer = 0;
     if (read_framebuffer)
     {
-        gl_handle_hash_map::const_iterator it = get_context_state()->m_framebuffers.search_table_for_value(read_framebuffer);
+        gl_handle_hash_map::const_iterator it = get_context_state()->m_framebuffers.find_key(read_framebuffer);
         if (it != get_context_state()->m_framebuffers.end())
-            trace_read_framebuffer = it->second;
+            trace_read_framebuffer = it->first;
     }
 
     uint32_t trace_texture = replay_texture;
@@ -3599,6 +3573,48 @@ void vogl_gl_replayer::display_list_bind_callback(vogl_namespace_t handle_namesp
     else                                                        \
         GL_ENTRYPOINT(e2)(__VA_ARGS__);
 
+//----------------------------------------------------------------------------------------------------------------------
+// Simple auto-generated replay funcs - voglgen creates this inc file from the funcs in gl_glx_simple_replay_funcs.txt
+// These simple GL entrypoints only take value params that don't require handle remapping, or simple pointers to client memory
+// (typically pointers to fixed size buffers, or params directly controlling the size of buffers).
+// Each returns false if the GL entrypoint is NULL.
+//----------------------------------------------------------------------------------------------------------------------
+#define VOGL_SIMPLE_REPLAY_FUNC_BEGIN(name, num_params)                    \
+    static bool vogl_simple_replay_##name(vogl_trace_packet &trace_packet) \
+    {                                                                      \
+        if (!GL_ENTRYPOINT(name))                                          \
+            return false;                                                  \
+        GL_ENTRYPOINT(name)(
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE(type, index) trace_packet.get_param_value<type>(index)
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR ,
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY(type, index) trace_packet.get_param_client_memory<type>(index)
+#define VOGL_SIMPLE_REPLAY_FUNC_END(name) ); \
+    return true;                             \
+    }
+#include "gl_glx_wgl_simple_replay_funcs.inc"
+#undef VOGL_SIMPLE_REPLAY_FUNC_BEGIN
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY
+#undef VOGL_SIMPLE_REPLAY_FUNC_END
+
+//----------------------------------------------------------------------------------------------------------------------
+// Per-entrypoint replay dispatch table, indexed by gl_entrypoint_id_t - voglgen creates this inc file in entrypoint ID order.
+// NULL entries are handled by the switch in process_gl_entrypoint_packet_internal().
+//----------------------------------------------------------------------------------------------------------------------
+typedef bool (*vogl_simple_replay_func_t)(vogl_trace_packet &trace_packet);
+
+static const vogl_simple_replay_func_t g_vogl_replay_dispatch_table[] =
+    {
+#define VOGL_REPLAY_DISPATCH_SIMPLE(name) vogl_simple_replay_##name,
+#define VOGL_REPLAY_DISPATCH_CUSTOM(name) NULL,
+#include "gl_glx_wgl_replay_dispatch_table.inc"
+#undef VOGL_REPLAY_DISPATCH_SIMPLE
+#undef VOGL_REPLAY_DISPATCH_CUSTOM
+    };
+
+VOGL_ASSUME(VOGL_ARRAY_SIZE(g_vogl_replay_dispatch_table) == VOGL_NUM_ENTRYPOINTS);
+
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_replayer::process_gl_entrypoint_packet
 // This will be called during replaying, or when building display lists during state restoring.
@@ -3650,14 +3666,18 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
     const vogl_trace_gl_entrypoint_packet &gl_entrypoint_packet = trace_packet.get_entrypoint_packet();
     const gl_entrypoint_id_t entrypoint_id = trace_packet.get_entrypoint_id();
 
-    if (m_flags & cGLReplayerDebugMode)
-        dump_trace_gl_packet_debug_info(gl_entrypoint_packet);
-
-    if (m_flags & cGLReplayerDebugMode)
-        dump_packet_as_func_call(trace_packet);
+    // One test of the flags on the common path.
+    if (m_flags & (cGLReplayerDebugMode | cGLReplayerDumpAllPackets))
+    {
+        if (m_flags & cGLReplayerDebugMode)
+        {
+            dump_trace_gl_packet_debug_info(gl_entrypoint_packet);
+            dump_packet_as_func_call(trace_packet);
+        }
 
-    if (m_flags & cGLReplayerDumpAllPackets)
-        print_detailed_context(cDebugConsoleMessage);
+        if (m_flags & cGLReplayerDumpAllPackets)
+            print_detailed_context(cDebugConsoleMessage);
+    }
 
     if (entrypoint_id == VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
         return process_internal_trace_command(gl_entrypoint_packet);
@@ -4166,28 +4186,18 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
         }
     }
 
-    switch (entrypoint_id)
+    // The many simple pass-through entrypoints are dispatched through the table, which keeps them out of the switch.
+    vogl_simple_replay_func_t pSimple_replay_func = g_vogl_replay_dispatch_table[entrypoint_id];
+    if (pSimple_replay_func)
     {
-// ----- Create simple auto-generated replay funcs - voglgen creates this inc file from the funcs in gl_glx_simple_replay_funcs.txt
-// These simple GL entrypoints only take value params that don't require handle remapping, or simple pointers to client memory
-// (typically pointers to fixed size buffers, or params directly controlling the size of buffers).
-#define VOGL_SIMPLE_REPLAY_FUNC_BEGIN(name, num_params) \
-    case VOGL_ENTRYPOINT_##name:                        \
-    { if (!GL_ENTRYPOINT(name)) { process_entrypoint_error("vogl_gl_replayer::process_gl_entrypoint_packet_internal: Can't call NULL GL entrypoint %s (maybe a missing extension?)\n", #name); } else \
-    GL_ENTRYPOINT(name)(
-#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE(type, index) trace_packet.get_param_value<type>(index)
-#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR ,
-#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY(type, index) trace_packet.get_param_client_memory<type>(index)
-#define VOGL_SIMPLE_REPLAY_FUNC_END(name) ); \
-    break;                                  \
+        if (!pSimple_replay_func(trace_packet))
+            process_entrypoint_error("%s: Can't call NULL GL entrypoint %s (maybe a missing extension?)\n", VOGL_FUNCTION_INFO_CSTR, g_vogl_entrypoint_descs[entrypoint_id].m_pName);
+
+        return end_gl_entrypoint_packet(entrypoint_id, trace_packet.get_call_counter());
     }
-#include "gl_glx_wgl_simple_replay_funcs.inc"
-#undef VOGL_SIMPLE_REPLAY_FUNC_BEGIN
-#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE
-#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR
-#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY
-#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_END
-        // -----
+
+    switch (entrypoint_id)
+    {
         case VOGL_ENTRYPOINT_glXUseXFont:
         {
             #if (VOGL_PLATFORM_HAS_GLX)
@@ -7336,6 +7346,10 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
                 return cStatusHardFailure;
             }
 
+            // The tracer only recorded the modified parts of this map, so the rest of the range must be preserved.
+            if (trace_packet.get_key_value_map().get_bool(string_hash("dirty_tracking")))
+                access &= ~(GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
             // FIXME - must call GL even if !pTrace_result
             if (trace_result_ptr_value)
             {
@@ -7420,6 +7434,7 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
                 if (writable_map)
                 {
                     const key_value_map &unmap_data = trace_packet.get_key_value_map();
+                    int num_dirty_ranges = 0;
 
                     if (explicit_bit)
                     {
@@ -7450,6 +7465,27 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
                             GL_ENTRYPOINT(glFlushMappedBufferRange)(target, static_cast<GLintptr>(ofs), pData->size());
                         }
                     }
+                    else if (unmap_data.get_int_if_found(string_hash("dirty_ranges"), num_dirty_ranges))
+                    {
+                        for (int i = 0; i < num_dirty_ranges; i++)
+                        {
+                            int64_t ofs = unmap_data.get_int64(i * 4 + 0);
+                            const uint8_vec *pData = unmap_data.get_blob(i * 4 + 2);
+                            if (!pData)
+                            {
+                                process_entrypoint_error("%s: Failed finding dirty range data in key value map\n", VOGL_FUNCTION_INFO_CSTR);
+                                return cStatusHardFailure;
+                            }
+
+                            if ((ofs < 0) || ((ofs + pData->size()) > static_cast<int64_t>(map_desc.m_length)))
+                            {
+                                process_entrypoint_error("%s: Dirty range (ofs: %" PRIi64 " size: %u) is outside of the mapped range\n", VOGL_FUNCTION_INFO_CSTR, ofs, pData->size());
+                                return cStatusHardFailure;
+                            }
+
+                            memcpy(static_cast<uint8_t *>(map_desc.m_pPtr) + ofs, pData->get_ptr(), pData->size());
+                        }
+                    }
                     else
                     {
                         int64_t ofs = unmap_data.get_int64(0);
@@ -9533,7 +9569,16 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
         }
     }
 
-    m_last_processed_call_counter = trace_packet.get_call_counter();
+    return end_gl_entrypoint_packet(entrypoint_id, trace_packet.get_call_counter());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::end_gl_entrypoint_packet
+// Common work after each GL call is replayed.
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_gl_replayer::end_gl_entrypoint_packet(gl_entrypoint_id_t entrypoint_id, uint64_t call_counter)
+{
+    m_last_processed_call_counter = call_counter;
 
     if (!m_pCur_context_state->m_inside_gl_begin)
     {
@@ -9543,13 +9588,52 @@ vogl_gl_replayer::status_t vogl_gl_replayer::process_gl_entrypoint_packet_intern
 
     if (vogl_is_draw_entrypoint(entrypoint_id) || vogl_is_clear_entrypoint(entrypoint_id) || (entrypoint_id == VOGL_ENTRYPOINT_glBitmap))
     {
-        if ((status = post_draw_call()) != cStatusOK)
+        status_t status = post_draw_call();
+        if (status != cStatusOK)
             return status;
     }
 
     return cStatusOK;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::begin_simple_call
+// Returns false if the call must go through process_next_packet() instead: something is pending, the call is on
+// another context, packets are being dumped, or a display list is being composed (which needs the packet).
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_gl_replayer::begin_simple_call(vogl_trace_context_ptr_value trace_context, uint64_t call_counter)
+{
+    if ((m_pPending_snapshot) || (m_pending_make_current_packet.is_valid()))
+        return false;
+
+    if (m_flags & (cGLReplayerDebugMode | cGLReplayerDumpAllPackets))
+        return false;
+
+    if ((trace_context != m_cur_trace_context) || (!m_cur_replay_context))
+        return false;
+
+    VOGL_ASSERT(m_pCur_context_state);
+    if (m_pCur_context_state->is_composing_display_list())
+        return false;
+
+    m_at_frame_boundary = false;
+    m_last_parsed_call_counter = call_counter;
+    m_pCur_context_state->m_last_call_counter = call_counter;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replayer::end_simple_call
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_gl_replayer::end_simple_call(gl_entrypoint_id_t entrypoint_id, uint64_t call_counter)
+{
+    status_t status = end_gl_entrypoint_packet(entrypoint_id, call_counter);
+    if (status < 0)
+        vogl_error_printf("%s: %s failure processing GL entrypoint %s\n", VOGL_FUNCTION_INFO_CSTR, (status == cStatusHardFailure) ? "Hard" : "Soft", g_vogl_entrypoint_descs[entrypoint_id].m_pName);
+    return status;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_gl_replayer::snapshot_backbuffer
 //----------------------------------------------------------------------------------------------------------------------
@@ -9645,12 +9729,12 @@ bool vogl_gl_replayer::replay_to_trace_handle_remapper::is_valid_handle(vogl_nam
         case VOGL_NAMESPACE_VERTEX_ARRAYS:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return (m_replayer.get_context_state()->m_vertex_array_objects.search_table_for_value_get_count(replay_handle32) != 0);
+            return (m_replayer.get_context_state()->m_vertex_array_objects.contains_value(replay_handle32));
         }
         case VOGL_NAMESPACE_FRAMEBUFFERS:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return (m_replayer.get_context_state()->m_framebuffers.search_table_for_value_get_count(replay_handle32) != 0);
+            return (m_replayer.get_context_state()->m_framebuffers.contains_value(replay_handle32));
         }
         case VOGL_NAMESPACE_TEXTURES:
         {
@@ -9665,12 +9749,12 @@ bool vogl_gl_replayer::replay_to_trace_handle_remapper::is_valid_handle(vogl_nam
         case VOGL_NAMESPACE_QUERIES:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return (m_replayer.get_shared_state()->m_queries.search_table_for_value_get_count(replay_handle32) != 0);
+            return (m_replayer.get_shared_state()->m_queries.contains_value(replay_handle32));
         }
         case VOGL_NAMESPACE_SAMPLERS:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return (m_replayer.get_shared_state()->m_sampler_objects.search_table_for_value_get_count(replay_handle32) != 0);
+            return (m_replayer.get_shared_state()->m_sampler_objects.contains_value(replay_handle32));
         }
         case VOGL_NAMESPACE_PROGRAMS:
         {
@@ -9685,17 +9769,17 @@ bool vogl_gl_replayer::replay_to_trace_handle_remapper::is_valid_handle(vogl_nam
         case VOGL_NAMESPACE_BUFFERS:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return m_replayer.get_shared_state()->m_buffers.search_table_for_value_get_count(replay_handle32);
+            return m_replayer.get_shared_state()->m_buffers.contains_value(replay_handle32);
         }
         case VOGL_NAMESPACE_SYNCS:
         {
             GLsync replay_sync = vogl_handle_to_sync(replay_handle);
-            return m_replayer.get_shared_state()->m_syncs.search_table_for_value_get_count(replay_sync) != 0;
+            return m_replayer.get_shared_state()->m_syncs.contains_value(replay_sync);
         }
         case VOGL_NAMESPACE_PROGRAM_ARB:
         {
             VOGL_ASSERT(replay_handle32 == replay_handle);
-            return m_replayer.get_shared_state()->m_arb_programs.search_table_for_value_get_count(replay_handle32) != 0;
+            return m_replayer.get_shared_state()->m_arb_programs.contains_value(replay_handle32);
         }
         default:
             break;
@@ -9796,7 +9880,7 @@ uint64_t vogl_gl_replayer::replay_to_trace_handle_remapper::remap_handle(vogl_na
         {
             GLsync replay_sync = vogl_handle_to_sync(replay_handle);
 
-            gl_sync_hash_map::const_iterator it(m_replayer.get_shared_state()->m_syncs.search_table_for_value(replay_sync));
+            gl_sync_hash_map::const_iterator it(m_replayer.get_shared_state()->m_syncs.find_key(replay_sync));
             if (it != m_replayer.get_shared_state()->m_syncs.end())
             {
                 VOGL_ASSERT(it->second == replay_sync);
@@ -9843,7 +9927,7 @@ int32_t vogl_gl_replayer::replay_to_trace_handle_remapper::remap_location(uint32
     {
         const glsl_program_state &state = it->second;
 
-        uniform_location_hash_map::const_iterator loc_it(state.m_uniform_locations.search_table_for_value(replay_location));
+        uniform_location_hash_map::const_iterator loc_it(state.m_uniform_locations.find_key(replay_location));
         if (loc_it != state.m_uniform_locations.end())
             return loc_it->first;
     }
@@ -9948,10 +10032,8 @@ bool vogl_gl_replayer::determine_used_program_handles(const vogl_trace_packet_ar
         if (trim_packets.get_packet_type(packet_index) != cTSPTGLEntrypoint)
             continue;
 
-        const uint8_vec &packet_buf = trim_packets.get_packet_buf(packet_index);
-
         // Important note: This purposesly doesn't process ctype packets, because they don't really do anything and I'm going to be redesigning the ctype/entrypoint stuff anyway so they are always processed after SOF.
-        if (!m_temp2_gl_packet.deserialize(packet_buf.get_ptr(), packet_buf.size(), true))
+        if (!m_temp2_gl_packet.deserialize(trim_packets.get_packet_ptr(packet_index), trim_packets.get_packet_size(packet_index), true))
             return false;
 
         GLuint trace_handle = 0;
@@ -10094,7 +10176,7 @@ vogl_gl_state_snapshot *vogl_gl_replayer::snapshot_state(const vogl_trace_packet
                     GLuint trace_handle = buf_it->first;
                     GLuint replay_handle = buf_it->second;
 
-                    gl_handle_hash_map::const_iterator target_it = get_shared_state()->m_buffer_targets.find(trace_handle);
+                    vogl_handle_hash_map::const_iterator target_it = get_shared_state()->m_buffer_targets.find(trace_handle);
                     if (target_it == get_shared_state()->m_buffer_targets.end())
                     {
                         vogl_error_printf("%s: Unable to find buffer trace handle 0x%X GL handle 0x%X in buffer target map! This should not happen!\n", VOGL_FUNCTION_INFO_CSTR, trace_handle, replay_handle);
@@ -10141,7 +10223,7 @@ vogl_gl_state_snapshot *vogl_gl_replayer::snapshot_state(const vogl_trace_packet
 
                 // ARB program targets
                 pShadow_state->m_arb_program_targets.reset();
-                for (gl_handle_hash_map::const_iterator arb_prog_it = get_shared_state()->m_arb_program_targets.begin(); arb_prog_it != get_shared_state()->m_arb_program_targets.end(); ++arb_prog_it)
+                for (vogl_handle_hash_map::const_iterator arb_prog_it = get_shared_state()->m_arb_program_targets.begin(); arb_prog_it != get_shared_state()->m_arb_program_targets.end(); ++arb_prog_it)
                 {
                     GLuint trace_handle = arb_prog_it->first;
                     GLuint replay_handle = get_shared_state()->m_arb_programs.value(trace_handle);
@@ -11068,9 +11150,7 @@ vogl_gl_replayer::status_t vogl_gl_replayer::restore_display_lists(vogl_handle_r
                         continue;
                     }
 
-                    const uint8_vec &packet_buf = packets.get_packet_buf(packet_index);
-
-                    if (!m_temp2_gl_packet.deserialize(packet_buf, true))
+                    if (!m_temp2_gl_packet.deserialize(packets.get_packet_ptr(packet_index), packets.get_packet_size(packet_index), true))
                     {
                         vogl_error_printf("%s: Failed deserializing display list at packet index %u, can't fully recreate trace display list %u!\n", VOGL_FUNCTION_INFO_CSTR, packet_index, trace_handle);
                         continue;
@@ -11723,13 +11803,11 @@ bool vogl_gl_replayer::write_trim_file_internal(vogl_trace_packet_array &trim_pa
         if (packet_type != cTSPTGLEntrypoint)
             continue;
 
-        const uint8_vec &packet_buf = trim_packets.get_packet_buf(packet_index);
-
         const vogl_trace_gl_entrypoint_packet *pGL_packet = &trim_packets.get_packet<vogl_trace_gl_entrypoint_packet>(packet_index);
         if (pGL_packet->m_entrypoint_id != VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
             continue;
 
-        if (!trace_packet.deserialize(packet_buf.get_ptr(), packet_buf.size(), true))
+        if (!trace_packet.deserialize(trim_packets.get_packet_ptr(packet_index), trim_packets.get_packet_size(packet_index), true))
         {
             console::error("%s: Failed parsing glInternalTraceCommandRAD packet\n", VOGL_FUNCTION_INFO_CSTR);
             return false;
@@ -11869,9 +11947,10 @@ bool vogl_gl_replayer::write_trim_file_internal(vogl_trace_packet_array &trim_pa
             return false;
         }
 
+        bool inserted;
         if (demarcation_packet_index >= 0)
         {
-            trim_packets.insert(demarcation_packet_index, snapshot_stream.get_buf());
+            inserted = trim_packets.insert(demarcation_packet_index, snapshot_stream.get_buf());
             demarcation_packet_index++;
         }
         else
@@ -11880,15 +11959,21 @@ bool vogl_gl_replayer::write_trim_file_internal(vogl_trace_packet_array &trim_pa
             vogl_write_glInternalTraceCommandRAD(demarcation_stream, &trace_gl_ctypes, cITCRDemarcation, 0, NULL);
 
             // Screw the ctypes packet, it's only used for debugging right now anyway.
-            trim_packets.insert(0, snapshot_stream.get_buf());
-            trim_packets.insert(1, demarcation_stream.get_buf());
+            inserted = trim_packets.insert(0, snapshot_stream.get_buf()) && trim_packets.insert(1, demarcation_stream.get_buf());
+        }
+
+        if (!inserted)
+        {
+            console::error("%s: Out of memory adding the state snapshot to the trim packets\n", VOGL_FUNCTION_INFO_CSTR);
+
+            trace_writer.close();
+            file_utils::delete_file(trim_filename.get_ptr());
+            return false;
         }
     }
 
     for (uint32_t packet_index = 0; packet_index < trim_packets.size(); packet_index++)
     {
-        const uint8_vec &packet_buf = trim_packets.get_packet_buf(packet_index);
-
         const bool is_swap = trim_packets.is_swap_buffers_packet(packet_index);
 
         const vogl_trace_stream_packet_types_t packet_type = trim_packets.get_packet_type(packet_index);
@@ -11899,7 +11984,7 @@ bool vogl_gl_replayer::write_trim_file_internal(vogl_trace_packet_array &trim_pa
             VOGL_ASSERT_ALWAYS;
         }
 
-        if (!trace_writer.write_packet(packet_buf.get_ptr(), packet_buf.size(), is_swap))
+        if (!trace_writer.write_packet(trim_packets.get_packet_ptr(packet_index), trim_packets.get_packet_size(packet_index), is_swap))
         {
             console::error("%s: Failed writing trace packet to output trace file \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, trim_filename.get_ptr());
             trace_writer.close();
@@ -11981,13 +12066,11 @@ bool vogl_gl_replayer::write_trim_file(uint32_t flags, const dynamic_string &tri
                     if (packet_type != cTSPTGLEntrypoint)
                         break;
 
-                    const uint8_vec &packet_buf = trim_packets.get_packet_buf(packet_index);
-
                     const vogl_trace_gl_entrypoint_packet *pGL_packet = &trim_packets.get_packet<vogl_trace_gl_entrypoint_packet>(packet_index);
                     if (pGL_packet->m_entrypoint_id != VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
                         break;
 
-                    if (!trace_packet.deserialize(packet_buf.get_ptr(), packet_buf.size(), true))
+                    if (!trace_packet.deserialize(trim_packets.get_packet_ptr(packet_index), trim_packets.get_packet_size(packet_index), true))
                     {
                         console::error("%s: Failed parsing glInternalTraceCommandRAD packet\n", VOGL_FUNCTION_INFO_CSTR);
                         return false;
@@ -11995,7 +12078,11 @@ bool vogl_gl_replayer::write_trim_file(uint32_t flags, const dynamic_string &tri
 
                     GLuint cmd = trace_packet.get_param_value<GLuint>(0);
 
-                    new_trim_packets.push_back(packet_buf);
+                    if (!new_trim_packets.push_back(trim_packets.get_packet_ptr(packet_index), trim_packets.get_packet_size(packet_index)))
+                    {
+                        console::error("%s: Out of memory copying trim packets\n", VOGL_FUNCTION_INFO_CSTR);
+                        return false;
+                    }
 
                     if (cmd == cITCRDemarcation)
                         break;
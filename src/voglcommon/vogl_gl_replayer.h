@@ -28,15 +28,19 @@
 #define VOGL_GL_REPLAYER_H
 
 #include "vogl_unique_ptr.h"
+#include "vogl_bidi_hash_map.h"
+#include "vogl_hybrid_hash_map.h"
 
 #include "vogl_common.h"
 #include "vogl_trace_stream_types.h"
 #include "vogl_trace_packet.h"
 #include "vogl_trace_file_reader.h"
+#include "vogl_trace_packet_prefetcher.h"
 #include "vogl_context_info.h"
 
 #include "vogl_replay_window.h"
 #include "vogl_gl_state_snapshot.h"
+#include "vogl_gl_state_snapshot_cache.h"
 #include "vogl_blob_manager.h"
 
 // TODO: Make this a command line param
@@ -49,7 +53,7 @@ bool vogl_process_internal_trace_command_ctypes_packet(const key_value_map &kvm,
 //----------------------------------------------------------------------------------------------------------------------
 enum vogl_gl_replayer_flags
 {
-    cGLReplayerSnapshotCaching = 0x00000001, // cache last X state snapshots
+    cGLReplayerSnapshotCaching = 0x00000001, // cache deserialized state snapshots, see vogl_gl_state_snapshot_cache
     cGLReplayerBenchmarkMode = 0x00000002,   // disable all glGetError()'s (*excluding* calls to glGetError in vogl_utils.cpp), disable all divergence checks
     cGLReplayerVerboseMode = 0x00000004,
     cGLReplayerForceDebugContexts = 0x00000008,
@@ -188,9 +192,16 @@ public:
     // Processes the next packet in the trace file.
     status_t process_next_packet(const vogl_trace_packet &gl_packet);
     status_t process_next_packet(vogl_trace_file_reader &trace_reader);
+    status_t process_next_packet(vogl_trace_packet_prefetcher &packet_prefetcher);
+
+    // Fast path for simple pass-through calls replayed without a packet (see vogl_replay_bytecode). If begin_simple_call()
+    // returns true, make the GL call then call end_simple_call(), otherwise replay the call's packet with process_next_packet().
+    bool begin_simple_call(vogl_trace_context_ptr_value trace_context, uint64_t call_counter);
+    status_t end_simple_call(gl_entrypoint_id_t entrypoint_id, uint64_t call_counter);
 
     // process_frame() calls process_next_packet() in a loop until the window must be resized, or until the next frame, or until the EOF or an error occurs.
     status_t process_frame(vogl_trace_file_reader &trace_reader);
+    status_t process_frame(vogl_trace_packet_prefetcher &packet_prefetcher);
 
     // Resets the replayer's state: kills all contexts, the pending snapshot, etc.
     void reset_state();
@@ -249,6 +260,17 @@ public:
         return m_pPending_snapshot;
     }
 
+    // The cache used for state snapshots when cGLReplayerSnapshotCaching is set. set_snapshot_cache() lets several
+    // replays share one cache, pCache must stay valid until deinit(). NULL selects the replayer's own cache.
+    vogl_gl_state_snapshot_cache &get_snapshot_cache() const
+    {
+        return *m_pSnapshot_cache;
+    }
+    void set_snapshot_cache(vogl_gl_state_snapshot_cache *pCache)
+    {
+        m_pSnapshot_cache = pCache ? pCache : &m_snapshot_cache;
+    }
+
     void set_frame_draw_counter_kill_threshold(uint64_t thresh)
     {
         m_frame_draw_counter_kill_threshold = thresh;
@@ -336,10 +358,12 @@ private:
 
     bool m_at_frame_boundary;
 
-    typedef vogl::hash_map<GLuint, GLuint> gl_handle_hash_map;
-    typedef vogl::hash_map<vogl_sync_ptr_value, GLsync, bit_hasher<vogl_sync_ptr_value> > gl_sync_hash_map;
+    // Trace to replay handle maps, which also index replay back to trace handles (for snapshotting).
+    // Trace handles are mostly small and dense, so the forward direction (hit by nearly every call) is mostly an array.
+    typedef vogl::bidi_hash_map<GLuint, GLuint, hasher<GLuint>, equal_to<GLuint>, hasher<GLuint>, equal_to<GLuint>, vogl::hybrid_hash_map<GLuint, GLuint> > gl_handle_hash_map;
+    typedef vogl::bidi_hash_map<vogl_sync_ptr_value, GLsync, bit_hasher<vogl_sync_ptr_value> > gl_sync_hash_map;
 
-    typedef vogl::hash_map<GLint, GLint> uniform_location_hash_map;
+    typedef vogl::bidi_hash_map<GLint, GLint> uniform_location_hash_map;
     struct glsl_program_state
     {
         // maps trace program locations to replay program locations
@@ -414,7 +438,7 @@ private:
         gl_handle_hash_map m_queries;
         gl_handle_hash_map m_sampler_objects;
         gl_handle_hash_map m_buffers;
-        gl_handle_hash_map m_buffer_targets; // maps trace handles to buffer targets
+        vogl_handle_hash_map m_buffer_targets; // maps trace handles to buffer targets
         gl_handle_hash_map m_vertex_array_objects;
 
         gl_handle_hash_map m_lists;
@@ -428,7 +452,7 @@ private:
         vogl_handle_hash_map m_query_targets;
 
         gl_handle_hash_map m_arb_programs;        // ARB_vertex_program/ARB_fragment_program, maps trace to replay handles
-        gl_handle_hash_map m_arb_program_targets; // maps trace programs to targets
+        vogl_handle_hash_map m_arb_program_targets; // maps trace programs to targets
 
         GLuint m_cur_replay_program;
         GLuint m_cur_trace_program;
@@ -483,25 +507,17 @@ private:
     const vogl_gl_state_snapshot *m_pPending_snapshot;
     bool m_delete_pending_snapshot_after_applying;
 
-    // TODO: Make a 1st class snapshot cache class
-    struct snapshot_cache_entry
-    {
-        snapshot_cache_entry()
-            : m_pSnapshot(NULL)
-        {
-        }
-
-        dynamic_string m_name;
-        vogl_gl_state_snapshot *m_pSnapshot;
-    };
-    typedef vogl::vector<snapshot_cache_entry> snapshot_vec;
-    snapshot_vec m_snapshots;
+    // Used when cGLReplayerSnapshotCaching is set. m_pSnapshot_cache points to m_snapshot_cache unless the caller
+    // supplied its own cache.
+    vogl_gl_state_snapshot_cache m_snapshot_cache;
+    vogl_gl_state_snapshot_cache *m_pSnapshot_cache;
 
     void dump_packet_as_func_call(const vogl_trace_packet &trace_packet);
     void dump_trace_gl_packet_debug_info(const vogl_trace_gl_entrypoint_packet &gl_packet);
 
     status_t trigger_pending_window_resize(uint32_t win_width, uint32_t win_height);
     void clear_pending_window_resize();
+    status_t process_read_packet(vogl_trace_file_reader::trace_file_reader_status_t read_status, vogl_trace_stream_packet_types_t packet_type, vogl_trace_packet &gl_packet);
     status_t process_frame_check_for_pending_window_resize();
 
     void destroy_pending_snapshot();
@@ -519,12 +535,9 @@ private:
     {
         vogl_gl_replayer &m_replayer;
 
-        // TODO: This searches the entire hash map! Slow!
         bool remap_replay_to_trace_handle(const gl_handle_hash_map &hash_map, GLuint &handle) const
         {
-            VOGL_ASSERT(hash_map.search_table_for_value_get_count(handle) <= 1);
-
-            gl_handle_hash_map::const_iterator it(hash_map.search_table_for_value(handle));
+            gl_handle_hash_map::const_iterator it(hash_map.find_key(handle));
             if (it != hash_map.end())
             {
                 VOGL_ASSERT(it->second == handle);
@@ -626,13 +639,9 @@ private:
         }
         else
         {
-            gl_handle_hash_map::insert_result result(handle_hash_map.insert(trace_handle, replay_handle));
-            if (!result.second)
+            if (!handle_hash_map.update(trace_handle, replay_handle))
             {
                 process_entrypoint_error("%s: Replacing genned GL handle %u trace handle %u in handle hash map (this indicates a handle shadowing error)\n", VOGL_FUNCTION_INFO_CSTR, replay_handle, trace_handle);
-
-                gl_handle_hash_map::iterator it = result.first;
-                it->second = replay_handle;
             }
         }
 
@@ -664,13 +673,9 @@ private:
             if (pReplay_handles)
                 pReplay_handles[i] = replay_id;
 
-            gl_handle_hash_map::insert_result result(handle_hash_map.insert(pTrace_ids[i], replay_id));
-            if (!result.second)
+            if (!handle_hash_map.update(pTrace_ids[i], replay_id))
             {
                 process_entrypoint_error("%s: TODO: Replacing genned GL handle %u trace handle %u in handle hash map (this indicates a handle shadowing error)\n", VOGL_FUNCTION_INFO_CSTR, replay_id, pTrace_ids[i]);
-
-                gl_handle_hash_map::iterator it = result.first;
-                it->second = replay_id;
             }
         }
 
@@ -1342,6 +1347,7 @@ private:
     // DO NOT make these methods public
     status_t process_gl_entrypoint_packet(vogl_trace_packet& trace_packet);
     status_t process_gl_entrypoint_packet_internal(vogl_trace_packet &trace_packet);
+    status_t end_gl_entrypoint_packet(gl_entrypoint_id_t entrypoint_id, uint64_t call_counter);
 };
 
 #endif // VOGL_GL_REPLAYER_H
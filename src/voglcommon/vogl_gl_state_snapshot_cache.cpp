@@ -0,0 +1,735 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_gl_state_snapshot_cache.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_gl_state_snapshot_cache.h"
+#include "vogl_console.h"
+#include "vogl_json.h"
+#include "vogl_miniz.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_recording_blob_manager
+// Read only pass-through to another blob manager, which totals the size of every blob opened through it. If
+// pRecorded_blobs isn't NULL each blob is copied into it the first time it's opened, and served from the copy.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_recording_blob_manager : public vogl_blob_manager
+{
+public:
+    vogl_recording_blob_manager(const vogl_blob_manager &blob_manager, vogl_memory_blob_manager *pRecorded_blobs)
+        : vogl_blob_manager(),
+          m_blob_manager(blob_manager),
+          m_pRecorded_blobs(pRecorded_blobs),
+          m_total_size(0)
+    {
+        vogl_blob_manager::init(cBMFReadable);
+        m_initialized = true;
+    }
+
+    virtual ~vogl_recording_blob_manager()
+    {
+    }
+
+    uint64_t get_total_size() const
+    {
+        return m_total_size;
+    }
+
+    virtual vogl_blob_manager_type_t get_type() const
+    {
+        return m_blob_manager.get_type();
+    }
+
+    virtual vogl::dynamic_string add_buf_using_id(const void *pData, uint32_t size, const vogl::dynamic_string &id)
+    {
+        VOGL_NOTE_UNUSED(pData);
+        VOGL_NOTE_UNUSED(size);
+        VOGL_NOTE_UNUSED(id);
+        return "";
+    }
+
+    virtual vogl::data_stream *open(const dynamic_string &id) const
+    {
+        vogl::data_stream *pStream;
+        if (m_pRecorded_blobs)
+        {
+            if (!m_pRecorded_blobs->does_exist(id))
+            {
+                uint8_vec data;
+                if (!m_blob_manager.get(id, data))
+                    return NULL;
+
+                m_pRecorded_blobs->add_buf_using_id(data.get_ptr(), data.size(), id);
+            }
+
+            pStream = m_pRecorded_blobs->open(id);
+        }
+        else
+        {
+            pStream = m_blob_manager.open(id);
+        }
+
+        if (pStream)
+            m_total_size += pStream->get_size();
+        return pStream;
+    }
+
+    virtual void close(vogl::data_stream *pStream) const
+    {
+        if (m_pRecorded_blobs)
+            m_pRecorded_blobs->close(pStream);
+        else
+            m_blob_manager.close(pStream);
+    }
+
+    virtual bool does_exist(const vogl::dynamic_string &id) const
+    {
+        return m_blob_manager.does_exist(id);
+    }
+
+    virtual uint64_t get_size(const vogl::dynamic_string &id) const
+    {
+        return m_blob_manager.get_size(id);
+    }
+
+    virtual vogl::dynamic_string_array enumerate() const
+    {
+        return m_blob_manager.enumerate();
+    }
+
+private:
+    const vogl_blob_manager &m_blob_manager;
+    vogl_memory_blob_manager *m_pRecorded_blobs;
+    mutable uint64_t m_total_size;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_deserialize_snapshot_blob
+//----------------------------------------------------------------------------------------------------------------------
+static vogl_gl_state_snapshot *vogl_deserialize_snapshot_blob(const dynamic_string &id, const uint8_vec &blob_data, bool is_binary, const vogl_blob_manager &blob_manager, const vogl_ctypes *pCtypes,
+                                                              uint64_t *pEstimated_size, vogl_memory_blob_manager *pRecorded_blobs)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_message_printf("%s: Deserializing state snapshot \"%s\", %u bytes\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr(), blob_data.size());
+
+    json_document doc;
+
+    bool success;
+    if (is_binary)
+        success = doc.binary_deserialize(blob_data);
+    else
+        success = doc.deserialize(reinterpret_cast<const char *>(blob_data.get_ptr()), blob_data.size());
+    if (!success || (!doc.get_root()))
+    {
+        vogl_error_printf("%s: Failed deserializing JSON snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+        return NULL;
+    }
+
+    vogl_recording_blob_manager recording_blob_manager(blob_manager, pRecorded_blobs);
+
+    vogl_gl_state_snapshot *pSnapshot = vogl_new(vogl_gl_state_snapshot);
+    if (!pSnapshot->deserialize(*doc.get_root(), recording_blob_manager, pCtypes))
+    {
+        vogl_delete(pSnapshot);
+
+        vogl_error_printf("%s: Failed deserializing snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+        return NULL;
+    }
+
+    if (pEstimated_size)
+        *pEstimated_size = blob_data.size() + recording_blob_manager.get_total_size();
+
+    return pSnapshot;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::vogl_gl_state_snapshot_cache
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot_cache::vogl_gl_state_snapshot_cache()
+    : m_max_size(cDefaultMaxSize),
+      m_size(0),
+      m_max_compressed_size(0),
+      m_compressed_size(0),
+      m_use_counter(0),
+      m_total_hits(0),
+      m_total_compressed_hits(0),
+      m_total_misses(0),
+      m_total_evictions(0)
+{
+    VOGL_FUNC_TRACER
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::~vogl_gl_state_snapshot_cache
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot_cache::~vogl_gl_state_snapshot_cache()
+{
+    VOGL_FUNC_TRACER
+
+    clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::set_max_size
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::set_max_size(uint64_t max_size)
+{
+    VOGL_FUNC_TRACER
+
+    m_max_size = max_size;
+    evict(NULL);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::set_max_compressed_size
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::set_max_compressed_size(uint64_t max_compressed_size)
+{
+    VOGL_FUNC_TRACER
+
+    m_max_compressed_size = max_compressed_size;
+    evict_compressed_snapshots(NULL);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::find
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot *vogl_gl_state_snapshot_cache::find(const dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
+
+    snapshot_entry *pEntry = m_snapshots.find_value(id);
+    if (!pEntry)
+        return NULL;
+
+    pEntry->m_last_used = ++m_use_counter;
+    return pEntry->m_pSnapshot;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::get_or_load
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot *vogl_gl_state_snapshot_cache::get_or_load(const dynamic_string &id, bool is_binary, const vogl_blob_manager &blob_manager, const vogl_ctypes *pCtypes)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_gl_state_snapshot *pSnapshot = find(id);
+    if (pSnapshot)
+    {
+        m_total_hits++;
+        return pSnapshot;
+    }
+
+    // The compressed tier holds the snapshot's blob and every blob it references, so a hit never touches blob_manager.
+    vogl_memory_blob_manager blobs;
+    blobs.init(cBMFReadWrite);
+
+    bool blobs_are_binary = is_binary;
+    if (get_compressed_snapshot(id, blobs, blobs_are_binary))
+    {
+        m_total_compressed_hits++;
+
+        uint64_t estimated_size = 0;
+        pSnapshot = load(id, blobs_are_binary, blobs, pCtypes, &estimated_size);
+        if (!pSnapshot)
+            return NULL;
+
+        insert(id, pSnapshot, estimated_size);
+        return pSnapshot;
+    }
+
+    m_total_misses++;
+
+    uint64_t estimated_size = 0;
+    pSnapshot = load(id, is_binary, blob_manager, pCtypes, &estimated_size, m_max_compressed_size ? &blobs : NULL);
+    if (!pSnapshot)
+        return NULL;
+
+    insert(id, pSnapshot, estimated_size, m_max_compressed_size ? &blobs : NULL, is_binary);
+    return pSnapshot;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::insert
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::insert(const dynamic_string &id, vogl_gl_state_snapshot *pSnapshot, uint64_t estimated_size, const vogl_memory_blob_manager *pBlobs, bool is_binary)
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_ASSERT(pSnapshot);
+
+    snapshot_entry new_entry;
+    new_entry.m_pSnapshot = pSnapshot;
+    new_entry.m_size = estimated_size;
+    new_entry.m_last_used = ++m_use_counter;
+
+    snapshot_hash_map::insert_result res(m_snapshots.insert(id, new_entry));
+    if (!res.second)
+    {
+        snapshot_entry &entry = res.first->second;
+        if (entry.m_pSnapshot != pSnapshot)
+            vogl_delete(entry.m_pSnapshot);
+
+        m_size -= entry.m_size;
+        entry = new_entry;
+    }
+    m_size += estimated_size;
+
+    if ((pBlobs) && (m_max_compressed_size))
+        add_compressed_snapshot(id, *pBlobs, is_binary);
+
+    evict(&id);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::release
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot *vogl_gl_state_snapshot_cache::release(const dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
+
+    snapshot_entry *pEntry = m_snapshots.find_value(id);
+    if (!pEntry)
+        return NULL;
+
+    vogl_gl_state_snapshot *pSnapshot = pEntry->m_pSnapshot;
+    m_size -= pEntry->m_size;
+    m_snapshots.erase(id);
+
+    return pSnapshot;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::release
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_gl_state_snapshot_cache::release(const vogl_gl_state_snapshot *pSnapshot)
+{
+    VOGL_FUNC_TRACER
+
+    for (snapshot_hash_map::iterator it = m_snapshots.begin(); it != m_snapshots.end(); ++it)
+    {
+        if (it->second.m_pSnapshot == pSnapshot)
+        {
+            m_size -= it->second.m_size;
+            m_snapshots.erase(dynamic_string(it->first));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::erase
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_gl_state_snapshot_cache::erase(const dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
+
+    erase_compressed_snapshot(id);
+
+    vogl_gl_state_snapshot *pSnapshot = release(id);
+    if (!pSnapshot)
+        return false;
+
+    vogl_delete(pSnapshot);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::clear
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::clear()
+{
+    VOGL_FUNC_TRACER
+
+    for (snapshot_hash_map::iterator it = m_snapshots.begin(); it != m_snapshots.end(); ++it)
+        vogl_delete(it->second.m_pSnapshot);
+
+    m_snapshots.clear();
+    m_size = 0;
+
+    m_compressed_snapshots.clear();
+    m_compressed_size = 0;
+    m_comp_buf.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::reset_stats
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::reset_stats()
+{
+    m_total_hits = 0;
+    m_total_compressed_hits = 0;
+    m_total_misses = 0;
+    m_total_evictions = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::print_stats
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::print_stats() const
+{
+    vogl_message_printf("Snapshot cache: %" PRIu64 " hits, %" PRIu64 " compressed hits, %" PRIu64 " misses, %" PRIu64 " evictions\n",
+                        m_total_hits, m_total_compressed_hits, m_total_misses, m_total_evictions);
+    vogl_message_printf("Snapshot cache: %u snapshots, %" PRIu64 " of %" PRIu64 " bytes, %u compressed snapshots, %" PRIu64 " of %" PRIu64 " bytes\n",
+                        m_snapshots.size(), m_size, m_max_size, m_compressed_snapshots.size(), m_compressed_size, m_max_compressed_size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::load
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_state_snapshot *vogl_gl_state_snapshot_cache::load(const dynamic_string &id, bool is_binary, const vogl_blob_manager &blob_manager, const vogl_ctypes *pCtypes,
+                                                           uint64_t *pEstimated_size, vogl_memory_blob_manager *pBlobs)
+{
+    VOGL_FUNC_TRACER
+
+    timed_scope ts("Deserialize snapshot time");
+
+    uint8_vec blob_data;
+    if (!blob_manager.get(id, blob_data) || (blob_data.is_empty()))
+    {
+        vogl_error_printf("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+        return NULL;
+    }
+
+    if (pBlobs)
+        pBlobs->add_buf_using_id(blob_data.get_ptr(), blob_data.size(), id);
+
+    return vogl_deserialize_snapshot_blob(id, blob_data, is_binary, blob_manager, pCtypes, pEstimated_size, pBlobs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::add_compressed_snapshot
+// Deflates every blob in blobs (the snapshot's own blob and the ones it referenced). Blobs which don't compress are kept
+// as is. The snapshot isn't kept at all if it doesn't fit in the compressed budget on its own.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::add_compressed_snapshot(const dynamic_string &id, const vogl_memory_blob_manager &blobs, bool is_binary)
+{
+    VOGL_FUNC_TRACER
+
+    if ((m_compressed_snapshots.contains(id)) || (!blobs.does_exist(id)))
+        return;
+
+    dynamic_string_array blob_ids(blobs.enumerate());
+
+    compressed_snapshot_entry &new_entry = m_compressed_snapshots.insert(id).first->second;
+    new_entry.m_blobs.resize(blob_ids.size());
+    new_entry.m_total_size = 0;
+    new_entry.m_is_binary = is_binary;
+    new_entry.m_last_used = ++m_use_counter;
+
+    uint8_vec blob_data;
+    for (uint32_t i = 0; i < blob_ids.size(); i++)
+    {
+        if (!blobs.get(blob_ids[i], blob_data))
+        {
+            m_compressed_snapshots.erase(id);
+            return;
+        }
+
+        compressed_blob &blob = new_entry.m_blobs[i];
+        blob.m_id = blob_ids[i];
+        blob.m_size = blob_data.size();
+
+        size_t comp_size = 0;
+        if ((blob_data.size() > 1) && (m_comp_buf.try_resize(blob_data.size() - 1)))
+            comp_size = tdefl_compress_mem_to_mem(m_comp_buf.get_ptr(), m_comp_buf.size(), blob_data.get_ptr(), blob_data.size(), TDEFL_DEFAULT_MAX_PROBES);
+
+        if (comp_size)
+            blob.m_data.append(m_comp_buf.get_ptr(), static_cast<uint32_t>(comp_size));
+        else
+            blob.m_data.swap(blob_data);
+
+        new_entry.m_total_size += blob.m_data.size();
+        if (new_entry.m_total_size > m_max_compressed_size)
+        {
+            m_compressed_snapshots.erase(id);
+            return;
+        }
+    }
+
+    m_compressed_size += new_entry.m_total_size;
+
+    evict_compressed_snapshots(&id);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::get_compressed_snapshot
+// Adds the snapshot's blobs to blobs, which must be writable.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_gl_state_snapshot_cache::get_compressed_snapshot(const dynamic_string &id, vogl_memory_blob_manager &blobs, bool &is_binary)
+{
+    VOGL_FUNC_TRACER
+
+    compressed_snapshot_entry *pEntry = m_compressed_snapshots.find_value(id);
+    if (!pEntry)
+        return false;
+
+    uint8_vec blob_data;
+    for (uint32_t i = 0; i < pEntry->m_blobs.size(); i++)
+    {
+        const compressed_blob &blob = pEntry->m_blobs[i];
+
+        // Stored as is.
+        if (blob.m_data.size() == blob.m_size)
+        {
+            blobs.add_buf_using_id(blob.m_data.get_ptr(), blob.m_size, blob.m_id);
+            continue;
+        }
+
+        if (!blob_data.try_resize(blob.m_size))
+            return false;
+
+        size_t size = tinfl_decompress_mem_to_mem(blob_data.get_ptr(), blob_data.size(), blob.m_data.get_ptr(), blob.m_data.size(), TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+        if (size != blob.m_size)
+        {
+            vogl_warning_printf("%s: Failed decompressing blob \"%s\" of cached snapshot \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, blob.m_id.get_ptr(), id.get_ptr());
+
+            erase_compressed_snapshot(id);
+            return false;
+        }
+
+        blobs.add_buf_using_id(blob_data.get_ptr(), blob_data.size(), blob.m_id);
+    }
+
+    pEntry->m_last_used = ++m_use_counter;
+    is_binary = pEntry->m_is_binary;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::erase_compressed_snapshot
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_gl_state_snapshot_cache::erase_compressed_snapshot(const dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
+
+    compressed_snapshot_entry *pEntry = m_compressed_snapshots.find_value(id);
+    if (!pEntry)
+        return false;
+
+    m_compressed_size -= pEntry->m_total_size;
+    m_compressed_snapshots.erase(id);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::evict
+// Deletes the least recently used snapshots until the cache is within budget, but never pKeep_id or the last snapshot.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::evict(const dynamic_string *pKeep_id)
+{
+    VOGL_FUNC_TRACER
+
+    while ((m_size > m_max_size) && (m_snapshots.size() > 1))
+    {
+        snapshot_hash_map::iterator lru_it(m_snapshots.end());
+        for (snapshot_hash_map::iterator it = m_snapshots.begin(); it != m_snapshots.end(); ++it)
+        {
+            if ((pKeep_id) && (it->first == *pKeep_id))
+                continue;
+            if ((lru_it == m_snapshots.end()) || (it->second.m_last_used < lru_it->second.m_last_used))
+                lru_it = it;
+        }
+
+        if (lru_it == m_snapshots.end())
+            break;
+
+        vogl_debug_printf("%s: Evicting state snapshot \"%s\", %" PRIu64 " bytes\n", VOGL_FUNCTION_INFO_CSTR, lru_it->first.get_ptr(), lru_it->second.m_size);
+
+        vogl_delete(lru_it->second.m_pSnapshot);
+        m_size -= lru_it->second.m_size;
+        m_snapshots.erase(dynamic_string(lru_it->first));
+
+        m_total_evictions++;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache::evict_compressed_snapshots
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_gl_state_snapshot_cache::evict_compressed_snapshots(const dynamic_string *pKeep_id)
+{
+    VOGL_FUNC_TRACER
+
+    while ((m_compressed_size > m_max_compressed_size) && (!m_compressed_snapshots.is_empty()))
+    {
+        compressed_snapshot_hash_map::iterator lru_it(m_compressed_snapshots.end());
+        for (compressed_snapshot_hash_map::iterator it = m_compressed_snapshots.begin(); it != m_compressed_snapshots.end(); ++it)
+        {
+            if ((pKeep_id) && (it->first == *pKeep_id))
+                continue;
+            if ((lru_it == m_compressed_snapshots.end()) || (it->second.m_last_used < lru_it->second.m_last_used))
+                lru_it = it;
+        }
+
+        if (lru_it == m_compressed_snapshots.end())
+            break;
+
+        m_compressed_size -= lru_it->second.m_total_size;
+        m_compressed_snapshots.erase(dynamic_string(lru_it->first));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// gl_state_snapshot_cache_test
+// LRU eviction against the byte budget, ownership transfer, hit/miss counting, and reloading evicted snapshots from
+// the compressed tier after their documents and the blobs they reference are gone from the blob manager.
+//----------------------------------------------------------------------------------------------------------------------
+static dynamic_string gl_state_snapshot_cache_test_add_blob(vogl_blob_manager &blob_manager, const char *pId, uint32_t frame_index)
+{
+    // A referenced blob: an ARB program string, which won't compress for odd frames.
+    vogl::random rm;
+    rm.seed(frame_index);
+
+    uint8_vec program_string(4096);
+    for (uint32_t i = 0; i < program_string.size(); i++)
+        program_string[i] = (frame_index & 1) ? rm.urand8() : static_cast<uint8_t>('A' + (i & 7));
+
+    dynamic_string program_string_id(blob_manager.add_buf_using_id(program_string.get_ptr(), program_string.size(), dynamic_string(cVarArg, "%s_program", pId)));
+
+    json_document doc;
+    json_node &root = *doc.get_root();
+    root.add_key_value("window_width", 64);
+    root.add_key_value("window_height", 64);
+    root.add_key_value("frame_index", frame_index);
+    root.add_array("client_side_vertex_attrib_ptrs");
+    root.add_array("client_side_array_ptrs");
+    root.add_array("client_side_texcoord_ptrs");
+
+    json_node &context_node = root.add_array("context_snapshots").add_object();
+    context_node.add_object("context_desc").add_array("attribs").add_value(0);
+    context_node.add_object("general_state").add_array("states");
+
+    json_node &program_node = context_node.add_object("state_objects").add_array(get_gl_object_state_type_str(cGLSTARBProgram)).add_object();
+    program_node.add_key_value("snapshot_handle", 1);
+    program_node.add_key_value("target", "GL_VERTEX_PROGRAM_ARB");
+    program_node.add_key_value("program_string", program_string_id);
+
+    // Something worth compressing.
+    dynamic_string padding;
+    for (uint32_t i = 0; i < 1000; i++)
+        padding.format_append("padding %u ", i & 15);
+    root.add_key_value("padding", padding);
+
+    uint8_vec data;
+    doc.binary_serialize(data);
+    return blob_manager.add_buf_using_id(data.get_ptr(), data.size(), pId);
+}
+
+bool gl_state_snapshot_cache_test()
+{
+    // LRU order and the byte budget.
+    {
+        vogl_gl_state_snapshot_cache cache;
+        cache.set_max_size(300);
+
+        vogl_gl_state_snapshot *pA = vogl_new(vogl_gl_state_snapshot);
+        vogl_gl_state_snapshot *pB = vogl_new(vogl_gl_state_snapshot);
+        vogl_gl_state_snapshot *pC = vogl_new(vogl_gl_state_snapshot);
+        cache.insert("a", pA, 100);
+        cache.insert("b", pB, 100);
+        cache.insert("c", pC, 100);
+        if ((cache.get_num_snapshots() != 3) || (cache.get_size() != 300) || (cache.find("a") != pA))
+            return false;
+
+        // "b" is now the least recently used.
+        cache.insert("d", vogl_new(vogl_gl_state_snapshot), 50);
+        if ((cache.find("b")) || (!cache.find("a")) || (!cache.find("c")) || (cache.get_size() != 250) || (cache.get_total_evictions() != 1))
+            return false;
+
+        // The most recently used snapshot is kept even if it's over budget on its own.
+        vogl_gl_state_snapshot *pBig = vogl_new(vogl_gl_state_snapshot);
+        cache.insert("big", pBig, 1000);
+        if ((cache.get_num_snapshots() != 1) || (cache.find("big") != pBig) || (cache.get_size() != 1000))
+            return false;
+
+        if ((!cache.release(pBig)) || (cache.get_num_snapshots()) || (cache.get_size()))
+            return false;
+        vogl_delete(pBig);
+
+        cache.insert("e", vogl_new(vogl_gl_state_snapshot), 10);
+        cache.insert("e", vogl_new(vogl_gl_state_snapshot), 20);
+        if ((cache.get_num_snapshots() != 1) || (cache.get_size() != 20) || (!cache.erase("e")) || (cache.erase("e")) || (cache.get_size()))
+            return false;
+    }
+
+    vogl_ctypes ctypes;
+    ctypes.init();
+
+    vogl_memory_blob_manager blob_manager;
+    blob_manager.init(cBMFReadWrite);
+
+    dynamic_string id1(gl_state_snapshot_cache_test_add_blob(blob_manager, "snapshot1", 1));
+    dynamic_string id2(gl_state_snapshot_cache_test_add_blob(blob_manager, "snapshot2", 2));
+
+    vogl_gl_state_snapshot_cache cache;
+    cache.set_max_compressed_size(1024 * 1024);
+
+    // Snapshot 1's program string doesn't compress, so its compressed copy is a little over the program string's size.
+    vogl_gl_state_snapshot *pSnapshot1 = cache.get_or_load(id1, true, blob_manager, &ctypes);
+    if ((!pSnapshot1) || (pSnapshot1->get_frame_index() != 1) || (cache.get_total_misses() != 1) || (cache.get_num_compressed_snapshots() != 1) ||
+        (cache.get_size() < blob_manager.get_size(id1) + 4096) || (cache.get_compressed_size() <= 4096) ||
+        (cache.get_compressed_size() >= blob_manager.get_size(id1) + 4096))
+        return false;
+
+    if ((cache.get_or_load(id1, true, blob_manager, &ctypes) != pSnapshot1) || (cache.get_total_hits() != 1))
+        return false;
+
+    // Only room for one snapshot, so loading the second evicts the first.
+    cache.set_max_size(1);
+    vogl_gl_state_snapshot *pSnapshot2 = cache.get_or_load(id2, true, blob_manager, &ctypes);
+    if ((!pSnapshot2) || (pSnapshot2->get_frame_index() != 2) || (cache.get_num_snapshots() != 1) || (cache.find(id1)))
+        return false;
+
+    // Both snapshots, including their program strings, now come from the compressed tier, not the (empty) blob manager.
+    vogl_memory_blob_manager empty_blob_manager;
+    empty_blob_manager.init(cBMFReadable);
+
+    pSnapshot1 = cache.get_or_load(id1, true, empty_blob_manager, &ctypes);
+    if ((!pSnapshot1) || (pSnapshot1->get_frame_index() != 1) || (pSnapshot1->get_contexts().size() != 1) ||
+        (cache.get_total_compressed_hits() != 1) || (cache.get_total_misses() != 2) || (cache.get_size() < blob_manager.get_size(id1) + 4096))
+        return false;
+
+    pSnapshot2 = cache.get_or_load(id2, true, empty_blob_manager, &ctypes);
+    if ((!pSnapshot2) || (pSnapshot2->get_frame_index() != 2) || (cache.get_total_compressed_hits() != 2) || (cache.find(id1)))
+        return false;
+
+    // Erasing drops the compressed copy too.
+    if ((!cache.erase(id2)) || (cache.get_num_compressed_snapshots() != 1) || (cache.get_or_load(id2, true, empty_blob_manager, &ctypes)))
+        return false;
+
+    // A snapshot which doesn't fit in the compressed budget isn't kept.
+    cache.clear();
+    cache.set_max_compressed_size(4096);
+    if ((!cache.get_or_load(id1, true, blob_manager, &ctypes)) || (cache.get_num_compressed_snapshots()) || (cache.get_compressed_size()))
+        return false;
+
+    return true;
+}
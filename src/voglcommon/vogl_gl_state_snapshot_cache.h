@@ -0,0 +1,188 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_gl_state_snapshot_cache.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_GL_STATE_SNAPSHOT_CACHE_H
+#define VOGL_GL_STATE_SNAPSHOT_CACHE_H
+
+#include "vogl_common.h"
+#include "vogl_gl_state_snapshot.h"
+#include "vogl_blob_manager.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_gl_state_snapshot_cache
+// LRU cache of deserialized state snapshots, keyed by the ID of the blob they were deserialized from, and limited to a
+// byte budget using each snapshot's estimated size (its blob plus all the blobs it read while deserializing).
+// The optional compressed tier keeps deflated copies of each snapshot's full blob set in memory: its top level blob (the
+// JSON document) and every blob the document refers to (texture, buffer and shader data, etc.). A snapshot which was
+// evicted from the cache is deserialized again from a memory blob manager rebuilt from these copies, without reading
+// anything from the blob manager passed to get_or_load().
+// The cache owns its snapshots. Pointers it returns are valid until the snapshot is evicted by a later insert(),
+// get_or_load() or set_max_size(), or is removed.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_gl_state_snapshot_cache
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_gl_state_snapshot_cache);
+
+public:
+#if VOGL_64BIT_POINTERS
+    static const uint64_t cDefaultMaxSize = 2048ULL * 1024U * 1024U;
+#else
+    static const uint64_t cDefaultMaxSize = 512U * 1024U * 1024U;
+#endif
+
+    vogl_gl_state_snapshot_cache();
+    ~vogl_gl_state_snapshot_cache();
+
+    // The most recently used snapshot is always kept, even if it's over budget on its own.
+    void set_max_size(uint64_t max_size);
+    uint64_t get_max_size() const
+    {
+        return m_max_size;
+    }
+
+    // 0 (the default) disables the compressed tier.
+    void set_max_compressed_size(uint64_t max_compressed_size);
+    uint64_t get_max_compressed_size() const
+    {
+        return m_max_compressed_size;
+    }
+
+    uint32_t get_num_snapshots() const
+    {
+        return m_snapshots.size();
+    }
+    uint64_t get_size() const
+    {
+        return m_size;
+    }
+    uint32_t get_num_compressed_snapshots() const
+    {
+        return m_compressed_snapshots.size();
+    }
+    uint64_t get_compressed_size() const
+    {
+        return m_compressed_size;
+    }
+
+    // Returns NULL if the snapshot isn't cached. Doesn't count towards the hit/miss statistics.
+    vogl_gl_state_snapshot *find(const dynamic_string &id);
+
+    // Returns the cached snapshot, or deserializes it (from the compressed tier if it's there, otherwise from
+    // blob_manager) and caches it. is_binary selects binary or text JSON blobs. Returns NULL on failure.
+    vogl_gl_state_snapshot *get_or_load(const dynamic_string &id, bool is_binary, const vogl_blob_manager &blob_manager, const vogl_ctypes *pCtypes);
+
+    // Takes ownership of pSnapshot. pBlobs, if any, holds the snapshot's blob and every blob it references (see load()),
+    // for the compressed tier.
+    void insert(const dynamic_string &id, vogl_gl_state_snapshot *pSnapshot, uint64_t estimated_size, const vogl_memory_blob_manager *pBlobs = NULL, bool is_binary = true);
+
+    // Removes a snapshot without deleting it, the caller takes ownership. Its compressed copy is kept.
+    vogl_gl_state_snapshot *release(const dynamic_string &id);
+    bool release(const vogl_gl_state_snapshot *pSnapshot);
+
+    // Removes and deletes a snapshot, and its compressed copy.
+    bool erase(const dynamic_string &id);
+
+    void clear();
+
+    uint64_t get_total_hits() const
+    {
+        return m_total_hits;
+    }
+    uint64_t get_total_compressed_hits() const
+    {
+        return m_total_compressed_hits;
+    }
+    uint64_t get_total_misses() const
+    {
+        return m_total_misses;
+    }
+    uint64_t get_total_evictions() const
+    {
+        return m_total_evictions;
+    }
+    void reset_stats();
+    void print_stats() const;
+
+    // Reads and deserializes a snapshot blob, without caching it. If pEstimated_size isn't NULL it's set to the
+    // snapshot's estimated size. If pBlobs isn't NULL (it must be writable) it receives copies of the snapshot's blob
+    // and of every blob the snapshot read while deserializing.
+    static vogl_gl_state_snapshot *load(const dynamic_string &id, bool is_binary, const vogl_blob_manager &blob_manager, const vogl_ctypes *pCtypes,
+                                        uint64_t *pEstimated_size = NULL, vogl_memory_blob_manager *pBlobs = NULL);
+
+private:
+    struct snapshot_entry
+    {
+        vogl_gl_state_snapshot *m_pSnapshot;
+        uint64_t m_size;
+        uint64_t m_last_used;
+    };
+    typedef vogl::hash_map<dynamic_string, snapshot_entry> snapshot_hash_map;
+
+    // m_data is deflated, unless it's m_size bytes (the blob didn't compress).
+    struct compressed_blob
+    {
+        dynamic_string m_id;
+        uint8_vec m_data;
+        uint32_t m_size;
+    };
+
+    struct compressed_snapshot_entry
+    {
+        vogl::vector<compressed_blob> m_blobs;
+        uint64_t m_total_size;
+        bool m_is_binary;
+        uint64_t m_last_used;
+    };
+    typedef vogl::hash_map<dynamic_string, compressed_snapshot_entry> compressed_snapshot_hash_map;
+
+    snapshot_hash_map m_snapshots;
+    compressed_snapshot_hash_map m_compressed_snapshots;
+    uint8_vec m_comp_buf;
+
+    uint64_t m_max_size;
+    uint64_t m_size;
+    uint64_t m_max_compressed_size;
+    uint64_t m_compressed_size;
+
+    uint64_t m_use_counter;
+
+    uint64_t m_total_hits;
+    uint64_t m_total_compressed_hits;
+    uint64_t m_total_misses;
+    uint64_t m_total_evictions;
+
+    void add_compressed_snapshot(const dynamic_string &id, const vogl_memory_blob_manager &blobs, bool is_binary);
+    bool get_compressed_snapshot(const dynamic_string &id, vogl_memory_blob_manager &blobs, bool &is_binary);
+    bool erase_compressed_snapshot(const dynamic_string &id);
+    void evict(const dynamic_string *pKeep_id);
+    void evict_compressed_snapshots(const dynamic_string *pKeep_id);
+};
+
+bool gl_state_snapshot_cache_test();
+
+#endif // VOGL_GL_STATE_SNAPSHOT_CACHE_H
@@ -0,0 +1,529 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_replay_bytecode.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_replay_bytecode.h"
+#include "vogl_console.h"
+#include "vogl_cfile_stream.h"
+
+// Param value of pointer params with no client memory.
+static const uint64_t cNullClientMemory = cUINT64_MAX;
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode_call
+// A simple command's params, with the vogl_trace_packet accessors the simple replay funcs use.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_replay_bytecode_call
+{
+public:
+    inline vogl_replay_bytecode_call(const uint64_t *pParams, const uint8_t *pData)
+        : m_pParams(pParams),
+          m_pData(pData)
+    {
+    }
+
+    template <typename T>
+    inline T get_param_value(uint32_t param_index) const
+    {
+        return *reinterpret_cast<const T *>(&m_pParams[param_index]);
+    }
+
+    // Only calls with input params are compiled as simple, so GL never writes through these.
+    template <typename T>
+    inline T *get_param_client_memory(uint32_t param_index) const
+    {
+        uint64_t ofs = m_pParams[param_index];
+        if (ofs == cNullClientMemory)
+            return NULL;
+        return static_cast<T *>(static_cast<void *>(const_cast<uint8_t *>(m_pData + ofs)));
+    }
+
+private:
+    const uint64_t *m_pParams;
+    const uint8_t *m_pData;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// Simple auto-generated replay funcs, instantiated for vogl_replay_bytecode_call instead of vogl_trace_packet
+// (see vogl_gl_replayer.cpp). Each returns false if the GL entrypoint is NULL.
+//----------------------------------------------------------------------------------------------------------------------
+#define VOGL_SIMPLE_REPLAY_FUNC_BEGIN(name, num_params)                                      \
+    static bool vogl_bytecode_replay_##name(const vogl_replay_bytecode_call &trace_packet) \
+    {                                                                                        \
+        if (!GL_ENTRYPOINT(name))                                                            \
+            return false;                                                                    \
+        GL_ENTRYPOINT(name)(
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE(type, index) trace_packet.get_param_value<type>(index)
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR ,
+#define VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY(type, index) trace_packet.get_param_client_memory<type>(index)
+#define VOGL_SIMPLE_REPLAY_FUNC_END(name) ); \
+    return true;                             \
+    }
+#include "gl_glx_wgl_simple_replay_funcs.inc"
+#undef VOGL_SIMPLE_REPLAY_FUNC_BEGIN
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_VALUE
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_SEPERATOR
+#undef VOGL_SIMPLE_REPLAY_FUNC_PARAM_CLIENT_MEMORY
+#undef VOGL_SIMPLE_REPLAY_FUNC_END
+
+typedef bool (*vogl_bytecode_replay_func_t)(const vogl_replay_bytecode_call &trace_packet);
+
+static const vogl_bytecode_replay_func_t g_vogl_bytecode_replay_funcs[] =
+    {
+#define VOGL_REPLAY_DISPATCH_SIMPLE(name) vogl_bytecode_replay_##name,
+#define VOGL_REPLAY_DISPATCH_CUSTOM(name) NULL,
+#include "gl_glx_wgl_replay_dispatch_table.inc"
+#undef VOGL_REPLAY_DISPATCH_SIMPLE
+#undef VOGL_REPLAY_DISPATCH_CUSTOM
+    };
+
+VOGL_ASSUME(VOGL_ARRAY_SIZE(g_vogl_bytecode_replay_funcs) == VOGL_NUM_ENTRYPOINTS);
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_is_bytecode_simple_entrypoint
+// Draws are left to the replayer, post_draw_call() needs the packet. Client memory is replayed from the read only
+// mapping, so calls with output params are too.
+//----------------------------------------------------------------------------------------------------------------------
+static bool vogl_is_bytecode_simple_entrypoint(gl_entrypoint_id_t entrypoint_id)
+{
+    if (!g_vogl_bytecode_replay_funcs[entrypoint_id])
+        return false;
+
+    if (vogl_is_draw_entrypoint(entrypoint_id) || vogl_is_clear_entrypoint(entrypoint_id) || (entrypoint_id == VOGL_ENTRYPOINT_glBitmap))
+        return false;
+
+    for (uint32_t i = 0; i < g_vogl_entrypoint_descs[entrypoint_id].m_num_params; i++)
+        if (!g_vogl_entrypoint_param_descs[entrypoint_id][i].m_input)
+            return false;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode_write_aligned
+// Pads the stream to alignment, then writes the data. ofs is the stream's offset, the data's offset is returned in it.
+//----------------------------------------------------------------------------------------------------------------------
+static bool vogl_replay_bytecode_write_aligned(data_stream &stream, const void *pData, uint64_t size, uint32_t alignment, uint64_t &ofs)
+{
+    static const uint8_t s_zeros[16] = { 0 };
+
+    uint32_t pad = static_cast<uint32_t>(math::align_up_value(ofs, alignment) - ofs);
+    VOGL_ASSERT(pad <= sizeof(s_zeros));
+    if ((pad) && (stream.write(s_zeros, pad) != pad))
+        return false;
+    ofs += pad;
+
+    const uint8_t *pSrc = static_cast<const uint8_t *>(pData);
+    uint64_t bytes_left = size;
+    while (bytes_left)
+    {
+        uint32_t n = static_cast<uint32_t>(math::minimum<uint64_t>(bytes_left, 64 * 1024 * 1024));
+        if (stream.write(pSrc, n) != n)
+            return false;
+        pSrc += n;
+        bytes_left -= n;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::vogl_replay_bytecode
+//----------------------------------------------------------------------------------------------------------------------
+vogl_replay_bytecode::vogl_replay_bytecode()
+    : m_pFile_data(NULL),
+      m_file_size(0),
+      m_pHeader(NULL),
+      m_pData(NULL),
+      m_pCmds(NULL),
+      m_pParams(NULL),
+      m_pFrames(NULL),
+      m_cur_cmd(0),
+      m_cur_frame(0),
+      m_packet(NULL),
+      m_total_cmds_replayed(0),
+      m_total_fast_cmds_replayed(0)
+{
+    VOGL_FUNC_TRACER
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::~vogl_replay_bytecode
+//----------------------------------------------------------------------------------------------------------------------
+vogl_replay_bytecode::~vogl_replay_bytecode()
+{
+    VOGL_FUNC_TRACER
+
+    close();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::compile
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_replay_bytecode::compile(vogl_trace_file_reader &trace_reader, const char *pFilename)
+{
+    VOGL_FUNC_TRACER
+
+    const vogl_trace_stream_start_of_file_packet &sof_packet = trace_reader.get_sof_packet();
+
+    cfile_stream out_stream;
+    if (!out_stream.open(pFilename, cDataStreamWritable | cDataStreamSeekable))
+    {
+        vogl_error_printf("%s: Failed creating replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        return false;
+    }
+
+    // The real header is written last, so a partially written file is never valid.
+    vogl_replay_bytecode_header header;
+    utils::zero_object(header);
+
+    uint64_t file_ofs = 0;
+    if (!vogl_replay_bytecode_write_aligned(out_stream, &header, sizeof(header), 1, file_ofs))
+    {
+        vogl_error_printf("%s: Failed writing to replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        return false;
+    }
+    file_ofs += sizeof(header);
+
+    header.m_data_ofs = math::align_up_value<uint64_t>(file_ofs, 16);
+
+    vogl_ctypes trace_ctypes(sof_packet.m_pointer_sizes);
+    vogl_trace_packet trace_packet(&trace_ctypes);
+
+    vogl::vector<vogl_replay_bytecode_cmd> cmds;
+    vogl::vector<uint64_t> params;
+    vogl::vector<uint32_t> frames;
+    frames.push_back(0);
+
+    for (;;)
+    {
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+        if (read_status == vogl_trace_file_reader::cEOF)
+            break;
+        else if (read_status != vogl_trace_file_reader::cOK)
+        {
+            vogl_error_printf("%s: Failed reading from trace file\n", VOGL_FUNCTION_INFO_CSTR);
+            return false;
+        }
+
+        const vogl_trace_stream_packet_types_t packet_type = trace_reader.get_packet_type();
+        if (packet_type == cTSPTEOF)
+            break;
+        else if (packet_type != cTSPTGLEntrypoint)
+            continue;
+
+        if (!trace_packet.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), true))
+        {
+            vogl_error_printf("%s: Failed deserializing GL entrypoint packet %u\n", VOGL_FUNCTION_INFO_CSTR, cmds.size());
+            return false;
+        }
+
+        const gl_entrypoint_id_t entrypoint_id = trace_packet.get_entrypoint_id();
+
+        vogl_replay_bytecode_cmd cmd;
+        utils::zero_object(cmd);
+        cmd.m_entrypoint_id = static_cast<uint16_t>(entrypoint_id);
+        cmd.m_context_handle = trace_packet.get_context_handle();
+        cmd.m_call_counter = trace_packet.get_call_counter();
+        cmd.m_packet_size = trace_reader.get_packet_size();
+
+        if (!vogl_replay_bytecode_write_aligned(out_stream, trace_reader.get_packet_ptr(), cmd.m_packet_size, 8, file_ofs))
+        {
+            vogl_error_printf("%s: Failed writing to replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+            return false;
+        }
+        cmd.m_packet_ofs = file_ofs - header.m_data_ofs;
+        file_ofs += cmd.m_packet_size;
+
+        if (vogl_is_swap_buffers_entrypoint(entrypoint_id))
+            cmd.m_flags |= vogl_replay_bytecode_cmd::cFlagSwap;
+
+        if (vogl_is_bytecode_simple_entrypoint(entrypoint_id))
+        {
+            cmd.m_flags |= vogl_replay_bytecode_cmd::cFlagSimple;
+            cmd.m_first_param = params.size();
+
+            for (uint32_t i = 0; i < g_vogl_entrypoint_descs[entrypoint_id].m_num_params; i++)
+            {
+                if (!trace_packet.get_param_ctype_desc(i).m_is_pointer)
+                {
+                    params.push_back(trace_packet.get_param_data(i));
+                    continue;
+                }
+
+                const void *pClient_memory = trace_packet.get_param_client_memory_ptr(i);
+                if (!pClient_memory)
+                {
+                    params.push_back(cNullClientMemory);
+                    continue;
+                }
+
+                uint32_t size = trace_packet.get_param_client_memory_data_size(i);
+                if (!vogl_replay_bytecode_write_aligned(out_stream, pClient_memory, size, 16, file_ofs))
+                {
+                    vogl_error_printf("%s: Failed writing to replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+                    return false;
+                }
+                params.push_back(file_ofs - header.m_data_ofs);
+                file_ofs += size;
+            }
+
+            header.m_num_simple_cmds++;
+        }
+
+        cmds.push_back(cmd);
+
+        if (cmd.m_flags & vogl_replay_bytecode_cmd::cFlagSwap)
+            frames.push_back(cmds.size());
+    }
+
+    header.m_data_size = file_ofs - header.m_data_ofs;
+
+    bool success = vogl_replay_bytecode_write_aligned(out_stream, cmds.get_ptr(), cmds.size_in_bytes(), 16, file_ofs);
+    header.m_cmds_ofs = file_ofs;
+    file_ofs += cmds.size_in_bytes();
+
+    success = success && vogl_replay_bytecode_write_aligned(out_stream, params.get_ptr(), params.size_in_bytes(), 16, file_ofs);
+    header.m_params_ofs = file_ofs;
+    file_ofs += params.size_in_bytes();
+
+    success = success && vogl_replay_bytecode_write_aligned(out_stream, frames.get_ptr(), frames.size_in_bytes(), 16, file_ofs);
+    header.m_frames_ofs = file_ofs;
+    file_ofs += frames.size_in_bytes();
+
+    header.m_magic = vogl_replay_bytecode_header::cMagic;
+    header.m_version = vogl_replay_bytecode_header::cVersion;
+    header.m_pointer_sizes = sof_packet.m_pointer_sizes;
+    memcpy(header.m_trace_uuid, sof_packet.m_uuid, sizeof(header.m_trace_uuid));
+    header.m_num_cmds = cmds.size();
+    header.m_num_params = params.size();
+    header.m_num_frames = frames.size();
+
+    success = success && out_stream.seek(0, false) && (out_stream.write(&header, sizeof(header)) == sizeof(header));
+    success = out_stream.close() && success;
+
+    if (!success)
+    {
+        vogl_error_printf("%s: Failed writing to replay bytecode file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        return false;
+    }
+
+    vogl_message_printf("Wrote replay bytecode file \"%s\": %u calls (%u simple), %u frames, %" PRIu64 " bytes\n",
+                        pFilename, header.m_num_cmds, header.m_num_simple_cmds, header.m_num_frames - 1, file_ofs);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::open
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_replay_bytecode::open(const char *pFilename, const vogl_trace_stream_start_of_file_packet &sof_packet)
+{
+    VOGL_FUNC_TRACER
+
+    close();
+
+    uint64_t file_size = 0;
+    const uint8_t *pFile_data = static_cast<const uint8_t *>(plat_map_file_readonly(pFilename, &file_size));
+    if (!pFile_data)
+        return false;
+
+    m_pFile_data = pFile_data;
+    m_file_size = file_size;
+
+    if (file_size < sizeof(vogl_replay_bytecode_header))
+    {
+        vogl_warning_printf("%s: Replay bytecode file \"%s\" is too small\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        close();
+        return false;
+    }
+
+    const vogl_replay_bytecode_header &header = *reinterpret_cast<const vogl_replay_bytecode_header *>(pFile_data);
+    if ((header.m_magic != vogl_replay_bytecode_header::cMagic) || (header.m_version != vogl_replay_bytecode_header::cVersion))
+    {
+        vogl_warning_printf("%s: \"%s\" isn't a replay bytecode file, or it's from another version\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        close();
+        return false;
+    }
+
+    if ((header.m_pointer_sizes != sof_packet.m_pointer_sizes) || (memcmp(header.m_trace_uuid, sof_packet.m_uuid, sizeof(header.m_trace_uuid)) != 0))
+    {
+        vogl_message_printf("Replay bytecode file \"%s\" was compiled from a different trace\n", pFilename);
+        close();
+        return false;
+    }
+
+    if ((header.m_data_ofs > file_size) || (header.m_data_size > (file_size - header.m_data_ofs)) ||
+        (header.m_cmds_ofs > file_size) || (header.m_num_cmds > ((file_size - header.m_cmds_ofs) / sizeof(vogl_replay_bytecode_cmd))) ||
+        (header.m_params_ofs > file_size) || (header.m_num_params > ((file_size - header.m_params_ofs) / sizeof(uint64_t))) ||
+        (header.m_frames_ofs > file_size) || (header.m_num_frames > ((file_size - header.m_frames_ofs) / sizeof(uint32_t))) ||
+        (!header.m_num_frames) || ((header.m_cmds_ofs | header.m_params_ofs | header.m_frames_ofs) & 7))
+    {
+        vogl_warning_printf("%s: Replay bytecode file \"%s\" is corrupted\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
+        close();
+        return false;
+    }
+
+    m_pHeader = &header;
+    m_pData = pFile_data + header.m_data_ofs;
+    m_pCmds = reinterpret_cast<const vogl_replay_bytecode_cmd *>(pFile_data + header.m_cmds_ofs);
+    m_pParams = reinterpret_cast<const uint64_t *>(pFile_data + header.m_params_ofs);
+    m_pFrames = reinterpret_cast<const uint32_t *>(pFile_data + header.m_frames_ofs);
+
+    // Cheap next to replaying, and keeps a damaged file from sending the replayer or GL off into the weeds.
+    for (uint32_t i = 0; i < header.m_num_cmds; i++)
+    {
+        const vogl_replay_bytecode_cmd &cmd = m_pCmds[i];
+
+        bool valid = (cmd.m_entrypoint_id < VOGL_NUM_ENTRYPOINTS) &&
+                     (cmd.m_packet_ofs <= header.m_data_size) && (cmd.m_packet_size <= (header.m_data_size - cmd.m_packet_ofs));
+
+        if ((valid) && (cmd.m_flags & vogl_replay_bytecode_cmd::cFlagSimple))
+        {
+            const gl_entrypoint_id_t entrypoint_id = static_cast<gl_entrypoint_id_t>(cmd.m_entrypoint_id);
+            const uint32_t num_params = g_vogl_entrypoint_descs[entrypoint_id].m_num_params;
+
+            valid = (vogl_is_bytecode_simple_entrypoint(entrypoint_id)) &&
+                    (cmd.m_first_param <= header.m_num_params) && (num_params <= (header.m_num_params - cmd.m_first_param));
+
+            for (uint32_t j = 0; (valid) && (j < num_params); j++)
+            {
+                uint64_t param = m_pParams[cmd.m_first_param + j];
+                if (get_vogl_process_gl_ctypes()[g_vogl_entrypoint_param_descs[entrypoint_id][j].m_ctype].m_is_pointer)
+                    valid = (param == cNullClientMemory) || (param <= header.m_data_size);
+            }
+        }
+
+        if (!valid)
+        {
+            vogl_warning_printf("%s: Replay bytecode file \"%s\" is corrupted (command %u)\n", VOGL_FUNCTION_INFO_CSTR, pFilename, i);
+            close();
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.m_num_frames; i++)
+    {
+        if ((m_pFrames[i] > header.m_num_cmds) || ((i) && (m_pFrames[i] < m_pFrames[i - 1])))
+        {
+            vogl_warning_printf("%s: Replay bytecode file \"%s\" is corrupted (frame %u)\n", VOGL_FUNCTION_INFO_CSTR, pFilename, i);
+            close();
+            return false;
+        }
+    }
+
+    plat_advise_mapped_file(m_pData, header.m_data_size, PLAT_ADVISE_SEQUENTIAL);
+
+    m_cur_cmd = 0;
+    m_cur_frame = 0;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::close
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_replay_bytecode::close()
+{
+    VOGL_FUNC_TRACER
+
+    if (m_pFile_data)
+        plat_unmap_file(m_pFile_data, m_file_size);
+
+    m_pFile_data = NULL;
+    m_file_size = 0;
+    m_pHeader = NULL;
+    m_pData = NULL;
+    m_pCmds = NULL;
+    m_pParams = NULL;
+    m_pFrames = NULL;
+    m_cur_cmd = 0;
+    m_cur_frame = 0;
+    m_packet.reset();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::seek_to_frame
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_replay_bytecode::seek_to_frame(uint32_t frame_index)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!m_pHeader) || (frame_index >= m_pHeader->m_num_frames))
+        return false;
+
+    m_cur_cmd = m_pFrames[frame_index];
+    m_cur_frame = frame_index;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode::process_next_cmd
+//----------------------------------------------------------------------------------------------------------------------
+vogl_gl_replayer::status_t vogl_replay_bytecode::process_next_cmd(vogl_gl_replayer &replayer)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!m_pHeader) || (m_cur_cmd >= m_pHeader->m_num_cmds))
+    {
+        vogl_message_printf("At replay bytecode EOF\n");
+        return vogl_gl_replayer::cStatusAtEOF;
+    }
+
+    const vogl_replay_bytecode_cmd &cmd = m_pCmds[m_cur_cmd++];
+    const gl_entrypoint_id_t entrypoint_id = static_cast<gl_entrypoint_id_t>(cmd.m_entrypoint_id);
+
+    if (cmd.m_flags & vogl_replay_bytecode_cmd::cFlagSwap)
+        m_cur_frame++;
+
+    m_total_cmds_replayed++;
+
+    if ((cmd.m_flags & vogl_replay_bytecode_cmd::cFlagSimple) && (replayer.begin_simple_call(cmd.m_context_handle, cmd.m_call_counter)))
+    {
+        // A NULL GL entrypoint falls through to the replayer, which reports it.
+        if (g_vogl_bytecode_replay_funcs[entrypoint_id](vogl_replay_bytecode_call(m_pParams + cmd.m_first_param, m_pData)))
+        {
+            m_total_fast_cmds_replayed++;
+            return replayer.end_simple_call(entrypoint_id, cmd.m_call_counter);
+        }
+    }
+
+    // Already validated when the file was compiled.
+    m_packet.set_ctypes(&replayer.get_trace_gl_ctypes());
+    if (!m_packet.deserialize(m_pData + cmd.m_packet_ofs, cmd.m_packet_size, false))
+    {
+        vogl_error_printf("%s: Failed deserializing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR);
+        return vogl_gl_replayer::cStatusHardFailure;
+    }
+
+    vogl_gl_replayer::status_t status = replayer.process_next_packet(m_packet);
+    if (status < 0)
+        vogl_error_printf("%s: %s failure processing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR, (status == vogl_gl_replayer::cStatusHardFailure) ? "Hard" : "Soft");
+
+    return status;
+}
@@ -0,0 +1,169 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_replay_bytecode.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_REPLAY_BYTECODE_H
+#define VOGL_REPLAY_BYTECODE_H
+
+#include "vogl_common.h"
+#include "vogl_trace_file_reader.h"
+#include "vogl_trace_packet.h"
+#include "vogl_gl_replayer.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Replay bytecode files
+// A trace lowered once into a compact, pre-validated command stream, for replaying the same trace over and over (e.g.
+// benchmarking). Each GL call becomes a fixed size command holding its entrypoint ID and its already validated packet.
+// Simple pass-through calls (see gl_glx_simple_replay_funcs.txt) also get their params decoded up front, with client
+// memory in the file's data segment. They're replayed straight from the mapped file, without deserializing a packet.
+// All other calls, and simple calls the replayer can't take its fast path for right now, are replayed through
+// vogl_gl_replayer::process_next_packet().
+// Layout: header, data segment (packets and client memory), commands, params, frame table. The file is tied to the
+// trace it was compiled from by the UUID in the trace's SOF packet.
+//----------------------------------------------------------------------------------------------------------------------
+#pragma pack(push)
+#pragma pack(1)
+struct vogl_replay_bytecode_header
+{
+    enum
+    {
+        cMagic = 0x43425256, // 'VRBC'
+        cVersion = 1
+    };
+
+    uint32_t m_magic;
+    uint16_t m_version;
+    uint8_t m_pointer_sizes;
+    uint8_t m_unused;
+    uint32_t m_trace_uuid[vogl_trace_stream_start_of_file_packet::cUUIDSize];
+
+    uint32_t m_num_cmds;
+    uint32_t m_num_simple_cmds;
+    uint32_t m_num_params;
+    uint32_t m_num_frames; // entries in the frame table
+
+    uint64_t m_data_ofs;
+    uint64_t m_data_size;
+    uint64_t m_cmds_ofs;
+    uint64_t m_params_ofs;
+    uint64_t m_frames_ofs;
+};
+
+struct vogl_replay_bytecode_cmd
+{
+    enum
+    {
+        cFlagSimple = 1,
+        cFlagSwap = 2
+    };
+
+    uint16_t m_entrypoint_id;
+    uint16_t m_flags;
+    uint32_t m_first_param; // simple calls only, index into the param array
+    uint64_t m_context_handle;
+    uint64_t m_call_counter;
+    uint64_t m_packet_ofs; // from the start of the data segment
+    uint32_t m_packet_size;
+    uint32_t m_unused;
+};
+#pragma pack(pop)
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_replay_bytecode
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_replay_bytecode
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_replay_bytecode);
+
+public:
+    vogl_replay_bytecode();
+    ~vogl_replay_bytecode();
+
+    // Reads the rest of the trace and writes it out as a bytecode file.
+    static bool compile(vogl_trace_file_reader &trace_reader, const char *pFilename);
+
+    // Maps a bytecode file. Fails if it's not a valid bytecode file, or it wasn't compiled from the trace with this SOF
+    // packet (so it needs to be recompiled).
+    bool open(const char *pFilename, const vogl_trace_stream_start_of_file_packet &sof_packet);
+    void close();
+
+    inline bool is_open() const
+    {
+        return m_pHeader != NULL;
+    }
+
+    inline uint32_t get_num_cmds() const
+    {
+        return m_pHeader ? m_pHeader->m_num_cmds : 0;
+    }
+
+    inline uint32_t get_cur_cmd_index() const
+    {
+        return m_cur_cmd;
+    }
+
+    // Frame index just after the last command replayed, like vogl_trace_file_reader::get_cur_frame().
+    inline uint32_t get_cur_frame() const
+    {
+        return m_cur_frame;
+    }
+
+    bool seek_to_frame(uint32_t frame_index);
+
+    // Replays the next command, returns the same statuses as vogl_gl_replayer::process_next_packet().
+    vogl_gl_replayer::status_t process_next_cmd(vogl_gl_replayer &replayer);
+
+    inline uint64_t get_total_cmds_replayed() const
+    {
+        return m_total_cmds_replayed;
+    }
+
+    inline uint64_t get_total_fast_cmds_replayed() const
+    {
+        return m_total_fast_cmds_replayed;
+    }
+
+private:
+    const uint8_t *m_pFile_data;
+    uint64_t m_file_size;
+
+    const vogl_replay_bytecode_header *m_pHeader;
+    const uint8_t *m_pData;
+    const vogl_replay_bytecode_cmd *m_pCmds;
+    const uint64_t *m_pParams;
+    const uint32_t *m_pFrames;
+
+    uint32_t m_cur_cmd;
+    uint32_t m_cur_frame;
+
+    vogl_trace_packet m_packet;
+
+    uint64_t m_total_cmds_replayed;
+    uint64_t m_total_fast_cmds_replayed;
+};
+
+#endif // VOGL_REPLAY_BYTECODE_H
@@ -0,0 +1,705 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_block_stream.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_trace_block_stream.h"
+#include "vogl_miniz.h"
+#include "vogl_dynamic_stream.h"
+#include "vogl_rand.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_compress_trace_block
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_compress_trace_block(vogl_trace_block_codec_t codec, const uint8_t *pSrc, uint32_t src_size, uint8_vec &dst_buf, vogl_trace_stream_block_header &header)
+{
+    VOGL_FUNC_TRACER
+
+    utils::zero_object(header);
+    header.m_prefix = vogl_trace_stream_block_header::cBlockPrefix;
+    header.m_uncompressed_size = src_size;
+    header.m_codec = cTraceBlockCodecNone;
+
+    if (codec == cTraceBlockCodecDeflate)
+    {
+        // Only keep the compressed data if it saves at least 1/16th, otherwise the block is stored.
+        uint32_t max_comp_size = src_size - (src_size >> 4);
+        if ((max_comp_size) && (dst_buf.try_resize(max_comp_size)))
+        {
+            // 1 probe + greedy parsing selects tdefl's fast LZ path
+            size_t comp_size = tdefl_compress_mem_to_mem(dst_buf.get_ptr(), max_comp_size, pSrc, src_size, TDEFL_GREEDY_PARSING_FLAG | 1);
+            if (comp_size)
+            {
+                dst_buf.resize(static_cast<uint32_t>(comp_size));
+                header.m_codec = cTraceBlockCodecDeflate;
+            }
+        }
+    }
+
+    if (header.m_codec == cTraceBlockCodecNone)
+    {
+        if (!dst_buf.try_resize(src_size))
+            return false;
+        memcpy(dst_buf.get_ptr(), pSrc, src_size);
+    }
+
+    header.m_compressed_size = dst_buf.size();
+    header.m_crc = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, dst_buf.get_ptr(), dst_buf.size()));
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_decompress_trace_block
+// pDst must be at least header.m_uncompressed_size bytes.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_decompress_trace_block(const vogl_trace_stream_block_header &header, const uint8_t *pSrc, uint8_t *pDst)
+{
+    VOGL_FUNC_TRACER
+
+    if (!header.basic_validation())
+        return false;
+
+    if (static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, pSrc, header.m_compressed_size)) != header.m_crc)
+        return false;
+
+    switch (header.m_codec)
+    {
+        case cTraceBlockCodecNone:
+        {
+            memcpy(pDst, pSrc, header.m_uncompressed_size);
+            return true;
+        }
+        case cTraceBlockCodecDeflate:
+        {
+            size_t size = tinfl_decompress_mem_to_mem(pDst, header.m_uncompressed_size, pSrc, header.m_compressed_size, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+            return size == header.m_uncompressed_size;
+        }
+        default:
+            break;
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_block_writer_stream
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_block_writer_stream::vogl_trace_block_writer_stream()
+    : data_stream(),
+      m_pFile(NULL),
+      m_codec(cTraceBlockCodecNone),
+      m_block_size(0),
+      m_ofs(0),
+      m_total_compressed_bytes(0),
+      m_cur_block_stream_ofs(0),
+      m_reserved_size(0),
+      m_last_block_end_ticks(0),
+      m_job_pending(false)
+{
+    VOGL_FUNC_TRACER
+}
+
+vogl_trace_block_writer_stream::~vogl_trace_block_writer_stream()
+{
+    VOGL_FUNC_TRACER
+
+    close();
+}
+
+bool vogl_trace_block_writer_stream::open(data_stream *pFile, vogl_trace_block_codec_t codec, uint32_t block_size)
+{
+    VOGL_FUNC_TRACER
+
+    close();
+
+    if ((!pFile) || (!pFile->is_opened()) || (!block_size))
+        return false;
+
+    if (!m_task_pool.init(1))
+        return false;
+
+    m_pFile = pFile;
+    m_codec = codec;
+    m_block_size = block_size;
+    m_ofs = pFile->get_ofs();
+    m_cur_block_stream_ofs = m_ofs;
+    m_reserved_size = 0;
+    m_last_block_end_ticks = timer::get_ticks();
+    m_total_compressed_bytes = 0;
+
+    m_cur_block.reserve(block_size);
+    m_block_index.resize(0);
+
+    set_name(pFile->get_name().get_ptr());
+    m_attribs = cDataStreamWritable;
+    m_opened = true;
+    clear_error();
+
+    return true;
+}
+
+bool vogl_trace_block_writer_stream::close()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_opened)
+        return true;
+
+    bool success = end_block() && finish_pending_job() && m_pFile->flush() && !get_error();
+
+    m_task_pool.deinit();
+
+    m_pFile = NULL;
+    m_cur_block.clear();
+    m_job.m_uncomp_buf.clear();
+    m_job.m_comp_buf.clear();
+    m_job_pending = false;
+
+    data_stream::close();
+
+    return success;
+}
+
+uint32_t vogl_trace_block_writer_stream::write(const void *pBuf, uint32_t len)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!m_opened) || (get_error()))
+        return 0;
+
+    VOGL_ASSERT(!m_reserved_size);
+
+    const uint8_t *pSrc = static_cast<const uint8_t *>(pBuf);
+    uint32_t bytes_remaining = len;
+
+    while (bytes_remaining)
+    {
+        uint32_t n = math::minimum(bytes_remaining, m_block_size - m_cur_block.size());
+
+        memcpy(m_cur_block.enlarge(n), pSrc, n);
+        pSrc += n;
+        bytes_remaining -= n;
+        m_ofs += n;
+
+        if (m_cur_block.size() == m_block_size)
+        {
+            if (!end_block())
+            {
+                set_error();
+                return len - bytes_remaining;
+            }
+        }
+    }
+
+    return len;
+}
+
+void *vogl_trace_block_writer_stream::reserve_write(uint32_t len)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!m_opened) || (get_error()) || (m_reserved_size) || (!len))
+        return NULL;
+
+    uint8_t *pDst = m_cur_block.try_enlarge(len);
+    if (!pDst)
+        return NULL;
+
+    m_reserved_size = len;
+    return pDst;
+}
+
+bool vogl_trace_block_writer_stream::commit_write(uint32_t len)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!m_opened) || (len > m_reserved_size))
+        return false;
+
+    m_cur_block.resize(m_cur_block.size() - (m_reserved_size - len));
+    m_reserved_size = 0;
+    m_ofs += len;
+
+    if (m_cur_block.size() >= m_block_size)
+    {
+        if (!end_block())
+        {
+            set_error();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool vogl_trace_block_writer_stream::flush()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_opened)
+        return false;
+
+    bool end_cur_block = timer::ticks_to_ms(timer::get_ticks() - m_last_block_end_ticks) >= cMinFlushIntervalMS;
+
+    if ((end_cur_block && !end_block()) || (!finish_pending_job()))
+    {
+        set_error();
+        return false;
+    }
+
+    return m_pFile->flush();
+}
+
+void vogl_trace_block_writer_stream::compress_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_NOTE_UNUSED(data);
+    VOGL_NOTE_UNUSED(pData_ptr);
+
+    if (!vogl_compress_trace_block(m_codec, m_job.m_uncomp_buf.get_ptr(), m_job.m_uncomp_buf.size(), m_job.m_comp_buf, m_job.m_header))
+    {
+        // Leaves a header which fails validation, finish_pending_job() checks for this
+        utils::zero_object(m_job.m_header);
+    }
+}
+
+// Hands the current block off to the worker thread (after writing the previous one).
+bool vogl_trace_block_writer_stream::end_block()
+{
+    VOGL_FUNC_TRACER
+
+    if (m_cur_block.is_empty())
+        return true;
+
+    if (!finish_pending_job())
+        return false;
+
+    m_job.m_uncomp_buf.swap(m_cur_block);
+    m_job.m_stream_ofs = m_cur_block_stream_ofs;
+    m_job_pending = true;
+
+    m_cur_block.resize(0);
+    m_cur_block.reserve(m_block_size);
+    m_cur_block_stream_ofs = m_ofs;
+    m_last_block_end_ticks = timer::get_ticks();
+
+    if (!m_task_pool.queue_object_task(this, &vogl_trace_block_writer_stream::compress_task))
+        compress_task(0, NULL);
+
+    return true;
+}
+
+// Waits for the block being compressed and writes it to the file.
+bool vogl_trace_block_writer_stream::finish_pending_job()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_job_pending)
+        return true;
+
+    m_task_pool.join();
+    m_job_pending = false;
+
+    if (!m_job.m_header.basic_validation())
+    {
+        vogl_error_printf("%s: Failed compressing trace block\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    vogl_trace_stream_block_index_entry *pEntry = m_block_index.enlarge(1);
+    pEntry->m_file_ofs = m_pFile->get_ofs();
+    pEntry->m_stream_ofs = m_job.m_stream_ofs;
+    pEntry->m_compressed_size = m_job.m_header.m_compressed_size;
+    pEntry->m_uncompressed_size = m_job.m_header.m_uncompressed_size;
+
+    if (m_pFile->write(&m_job.m_header, sizeof(m_job.m_header)) != sizeof(m_job.m_header))
+        return false;
+
+    if (m_pFile->write(m_job.m_comp_buf.get_ptr(), m_job.m_comp_buf.size()) != m_job.m_comp_buf.size())
+        return false;
+
+    m_total_compressed_bytes += sizeof(m_job.m_header) + m_job.m_comp_buf.size();
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_block_reader_stream
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_block_reader_stream::vogl_trace_block_reader_stream()
+    : data_stream(),
+      m_pFile(NULL),
+      m_first_stream_ofs(0),
+      m_size(0),
+      m_ofs(0),
+      m_cur_block_index(-1)
+{
+    VOGL_FUNC_TRACER
+}
+
+vogl_trace_block_reader_stream::~vogl_trace_block_reader_stream()
+{
+    VOGL_FUNC_TRACER
+
+    close();
+}
+
+bool vogl_trace_block_reader_stream::open(data_stream *pFile, uint64_t first_block_file_ofs, uint64_t first_stream_ofs, uint64_t end_file_ofs, const vogl_trace_block_index *pBlock_index)
+{
+    VOGL_FUNC_TRACER
+
+    close();
+
+    if ((!pFile) || (!pFile->is_opened()))
+        return false;
+
+    m_pFile = pFile;
+    m_first_stream_ofs = first_stream_ofs;
+
+    bool index_is_valid = (pBlock_index != NULL) && (pBlock_index->size() > 0);
+    if (index_is_valid)
+    {
+        uint64_t expected_stream_ofs = first_stream_ofs;
+        for (uint32_t i = 0; i < pBlock_index->size(); i++)
+        {
+            const vogl_trace_stream_block_index_entry &entry = (*pBlock_index)[i];
+            if ((entry.m_stream_ofs != expected_stream_ofs) || (!entry.m_uncompressed_size) || ((entry.m_file_ofs + sizeof(vogl_trace_stream_block_header) + entry.m_compressed_size) > end_file_ofs))
+            {
+                index_is_valid = false;
+                break;
+            }
+            expected_stream_ofs += entry.m_uncompressed_size;
+        }
+
+        if (!index_is_valid)
+            vogl_warning_printf("%s: Trace block index is invalid, rebuilding it from the block headers\n", VOGL_FUNCTION_INFO_CSTR);
+    }
+
+    if (index_is_valid)
+        m_block_index = *pBlock_index;
+    else
+        scan_block_headers(first_block_file_ofs, first_stream_ofs, end_file_ofs);
+
+    m_size = m_block_index.size() ? (m_block_index.back().m_stream_ofs + m_block_index.back().m_uncompressed_size) : first_stream_ofs;
+    m_ofs = first_stream_ofs;
+    m_cur_block_index = -1;
+
+    set_name(pFile->get_name().get_ptr());
+    m_attribs = cDataStreamReadable | cDataStreamSeekable;
+    m_opened = true;
+    clear_error();
+
+    return true;
+}
+
+bool vogl_trace_block_reader_stream::close()
+{
+    VOGL_FUNC_TRACER
+
+    m_pFile = NULL;
+    m_block_index.clear();
+    m_first_stream_ofs = 0;
+    m_size = 0;
+    m_ofs = 0;
+    m_cur_block_index = -1;
+    m_cur_block.clear();
+    m_comp_buf.clear();
+
+    return data_stream::close();
+}
+
+// Used when the trace has no block index (it wasn't closed properly). Stops at the first invalid or truncated block.
+bool vogl_trace_block_reader_stream::scan_block_headers(uint64_t first_block_file_ofs, uint64_t first_stream_ofs, uint64_t end_file_ofs)
+{
+    VOGL_FUNC_TRACER
+
+    m_block_index.resize(0);
+
+    uint64_t file_ofs = first_block_file_ofs;
+    uint64_t stream_ofs = first_stream_ofs;
+
+    while ((file_ofs + sizeof(vogl_trace_stream_block_header)) <= end_file_ofs)
+    {
+        vogl_trace_stream_block_header header;
+        if ((!m_pFile->seek(file_ofs, false)) || (m_pFile->read(&header, sizeof(header)) != sizeof(header)))
+            break;
+
+        if (!header.basic_validation())
+            break;
+
+        if ((file_ofs + sizeof(header) + header.m_compressed_size) > end_file_ofs)
+            break;
+
+        vogl_trace_stream_block_index_entry *pEntry = m_block_index.enlarge(1);
+        pEntry->m_file_ofs = file_ofs;
+        pEntry->m_stream_ofs = stream_ofs;
+        pEntry->m_compressed_size = header.m_compressed_size;
+        pEntry->m_uncompressed_size = header.m_uncompressed_size;
+
+        file_ofs += sizeof(header) + header.m_compressed_size;
+        stream_ofs += header.m_uncompressed_size;
+    }
+
+    return file_ofs == end_file_ofs;
+}
+
+int vogl_trace_block_reader_stream::find_block(uint64_t stream_ofs) const
+{
+    VOGL_FUNC_TRACER
+
+    int l = 0, h = static_cast<int>(m_block_index.size()) - 1;
+    while (l <= h)
+    {
+        int m = l + ((h - l) >> 1);
+
+        const vogl_trace_stream_block_index_entry &entry = m_block_index[m];
+        if (stream_ofs < entry.m_stream_ofs)
+            h = m - 1;
+        else if (stream_ofs >= (entry.m_stream_ofs + entry.m_uncompressed_size))
+            l = m + 1;
+        else
+            return m;
+    }
+
+    return -1;
+}
+
+bool vogl_trace_block_reader_stream::load_block(int block_index)
+{
+    VOGL_FUNC_TRACER
+
+    m_cur_block_index = -1;
+
+    const vogl_trace_stream_block_index_entry &entry = m_block_index[block_index];
+
+    vogl_trace_stream_block_header header;
+    if ((!m_pFile->seek(entry.m_file_ofs, false)) || (m_pFile->read(&header, sizeof(header)) != sizeof(header)))
+        return false;
+
+    if ((!header.basic_validation()) || (header.m_compressed_size != entry.m_compressed_size) || (header.m_uncompressed_size != entry.m_uncompressed_size))
+    {
+        vogl_error_printf("%s: Trace block %i has an invalid header, trace file is probably corrupted\n", VOGL_FUNCTION_INFO_CSTR, block_index);
+        return false;
+    }
+
+    if ((!m_comp_buf.try_resize(header.m_compressed_size)) || (!m_cur_block.try_resize(header.m_uncompressed_size)))
+        return false;
+
+    if (m_pFile->read(m_comp_buf.get_ptr(), header.m_compressed_size) != header.m_compressed_size)
+        return false;
+
+    if (!vogl_decompress_trace_block(header, m_comp_buf.get_ptr(), m_cur_block.get_ptr()))
+    {
+        vogl_error_printf("%s: Failed decompressing trace block %i, trace file is probably corrupted\n", VOGL_FUNCTION_INFO_CSTR, block_index);
+        return false;
+    }
+
+    m_cur_block_index = block_index;
+
+    return true;
+}
+
+uint32_t vogl_trace_block_reader_stream::read(void *pBuf, uint32_t len)
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_opened)
+        return 0;
+
+    uint8_t *pDst = static_cast<uint8_t *>(pBuf);
+    uint32_t total_bytes_read = 0;
+
+    while ((len) && (m_ofs < m_size))
+    {
+        if ((m_cur_block_index < 0) ||
+            (m_ofs < m_block_index[m_cur_block_index].m_stream_ofs) ||
+            (m_ofs >= (m_block_index[m_cur_block_index].m_stream_ofs + m_block_index[m_cur_block_index].m_uncompressed_size)))
+        {
+            int block_index = find_block(m_ofs);
+            if ((block_index < 0) || (!load_block(block_index)))
+            {
+                set_error();
+                break;
+            }
+        }
+
+        const vogl_trace_stream_block_index_entry &entry = m_block_index[m_cur_block_index];
+
+        uint32_t block_ofs = static_cast<uint32_t>(m_ofs - entry.m_stream_ofs);
+        uint32_t n = math::minimum(len, entry.m_uncompressed_size - block_ofs);
+
+        memcpy(pDst, m_cur_block.get_ptr() + block_ofs, n);
+
+        pDst += n;
+        len -= n;
+        m_ofs += n;
+        total_bytes_read += n;
+    }
+
+    return total_bytes_read;
+}
+
+bool vogl_trace_block_reader_stream::seek(int64_t ofs, bool relative)
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_opened)
+        return false;
+
+    int64_t new_ofs = relative ? (static_cast<int64_t>(m_ofs) + ofs) : ofs;
+    if ((new_ofs < static_cast<int64_t>(m_first_stream_ofs)) || (new_ofs > static_cast<int64_t>(m_size)))
+        return false;
+
+    m_ofs = static_cast<uint64_t>(new_ofs);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// trace_block_stream_test
+//----------------------------------------------------------------------------------------------------------------------
+static bool trace_block_stream_test_codec(const uint8_vec &src, bool expect_compressed)
+{
+    uint8_vec comp_buf;
+    vogl_trace_stream_block_header header;
+    if (!vogl_compress_trace_block(cTraceBlockCodecDeflate, src.get_ptr(), src.size(), comp_buf, header))
+        return false;
+
+    if ((!header.basic_validation()) || (header.m_uncompressed_size != src.size()) || (header.m_compressed_size != comp_buf.size()))
+        return false;
+
+    // Blocks which don't compress are stored.
+    if ((header.m_codec == cTraceBlockCodecDeflate) != expect_compressed)
+        return false;
+
+    uint8_vec dst(src.size());
+    if (!vogl_decompress_trace_block(header, comp_buf.get_ptr(), dst.get_ptr()))
+        return false;
+
+    return dst == src;
+}
+
+bool trace_block_stream_test()
+{
+    vogl::random rm;
+    rm.seed(3);
+
+    uint8_vec compressible(300000), incompressible(70000);
+    for (uint32_t i = 0; i < compressible.size(); i++)
+        compressible[i] = static_cast<uint8_t>((i * 7) ^ (i >> 9));
+    for (uint32_t i = 0; i < incompressible.size(); i++)
+        incompressible[i] = rm.urand8();
+
+    if ((!trace_block_stream_test_codec(compressible, true)) || (!trace_block_stream_test_codec(incompressible, false)))
+    {
+        vogl_error_printf("%s: Block codec round trip failed\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    // Write a stream of variable sized records, some larger than a block, flushing after each one like the tracer
+    // does with --vogl_flush_files_after_each_call.
+    const uint32_t cBlockSize = 16384;
+    const uint32_t cHeaderSize = 13;
+
+    uint8_vec expected;
+    dynamic_stream file;
+    file.open();
+    file.write("header bytes!", cHeaderSize);
+
+    vogl_trace_block_writer_stream writer;
+    if (!writer.open(&file, cTraceBlockCodecDeflate, cBlockSize))
+        return false;
+
+    const uint32_t cTotalRecords = 2000;
+    for (uint32_t i = 0; i < cTotalRecords; i++)
+    {
+        uint32_t size = rm.irand(1, (rm.irand(0, 50) == 0) ? 40000 : 200);
+        const uint8_t *pSrc = ((i & 1) ? incompressible.get_ptr() : compressible.get_ptr()) + rm.irand(0, 20000);
+
+        if (rm.irand(0, 2))
+        {
+            if (writer.write(pSrc, size) != size)
+                return false;
+        }
+        else
+        {
+            void *pDst = writer.reserve_write(size + 16);
+            if (!pDst)
+                return false;
+            memcpy(pDst, pSrc, size);
+            if (!writer.commit_write(size))
+                return false;
+        }
+        expected.append(pSrc, size);
+
+        if (!writer.flush())
+            return false;
+    }
+
+    if ((!writer.close()) || (writer.get_size() != cHeaderSize + expected.size()))
+        return false;
+
+    // A flush per record must not give every record its own block.
+    const vogl_trace_block_index block_index(writer.get_block_index());
+    if (block_index.size() >= cTotalRecords / 4)
+    {
+        vogl_error_printf("%s: Flushing created %u blocks for %u records\n", VOGL_FUNCTION_INFO_CSTR, block_index.size(), cTotalRecords);
+        return false;
+    }
+
+    // Read it back, using the writer's block index and by scanning the block headers.
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        vogl_trace_block_reader_stream reader;
+        if (!reader.open(&file, cHeaderSize, cHeaderSize, file.get_size(), pass ? NULL : &block_index))
+            return false;
+
+        if ((reader.get_size() != cHeaderSize + expected.size()) || (reader.get_block_index().size() != block_index.size()))
+            return false;
+
+        uint8_vec buf(expected.size());
+        if ((!reader.seek(cHeaderSize, false)) || (reader.read(buf.get_ptr(), buf.size()) != buf.size()) || (buf != expected))
+        {
+            vogl_error_printf("%s: Sequential read back failed\n", VOGL_FUNCTION_INFO_CSTR);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < 200; i++)
+        {
+            uint32_t ofs = rm.irand(0, expected.size());
+            uint32_t size = math::minimum<uint32_t>(rm.irand(1, cBlockSize * 3), expected.size() - ofs);
+            if ((!reader.seek(cHeaderSize + ofs, false)) || (reader.read(buf.get_ptr(), size) != size) || (memcmp(buf.get_ptr(), expected.get_ptr() + ofs, size) != 0))
+            {
+                vogl_error_printf("%s: Random read back failed at offset %u\n", VOGL_FUNCTION_INFO_CSTR, ofs);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
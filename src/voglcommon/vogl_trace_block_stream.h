@@ -0,0 +1,223 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_block_stream.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_TRACE_BLOCK_STREAM_H
+#define VOGL_TRACE_BLOCK_STREAM_H
+
+#include "vogl_common.h"
+#include "vogl_trace_stream_types.h"
+#include "vogl_threading.h"
+
+typedef vogl::vector<vogl_trace_stream_block_index_entry> vogl_trace_block_index;
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_block_writer_stream
+// Write-only stream which groups everything written to it into independently compressed blocks, which are written
+// to the underlying file stream. Blocks are compressed on a worker thread while the next block is being filled.
+// Stream offsets are uncompressed offsets, starting at the file's offset when the stream was opened.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_trace_block_writer_stream : public data_stream
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_trace_block_writer_stream);
+
+public:
+    enum
+    {
+        cDefaultBlockSize = 1024 * 1024,
+        cMinFlushIntervalMS = 250
+    };
+
+    vogl_trace_block_writer_stream();
+    virtual ~vogl_trace_block_writer_stream();
+
+    // pFile must remain valid until close() is called. It's not closed by this object.
+    bool open(data_stream *pFile, vogl_trace_block_codec_t codec, uint32_t block_size = cDefaultBlockSize);
+
+    // Writes out the final block, but doesn't close the file.
+    virtual bool close();
+
+    virtual uint32_t read(void *pBuf, uint32_t len)
+    {
+        VOGL_NOTE_UNUSED(pBuf);
+        VOGL_NOTE_UNUSED(len);
+        return 0;
+    }
+
+    virtual uint32_t write(const void *pBuf, uint32_t len);
+
+    // Reserves space in the current block, which is allowed to grow past the block size so the reservation is never
+    // split across blocks.
+    virtual void *reserve_write(uint32_t len);
+    virtual bool commit_write(uint32_t len);
+
+    // Writes any finished blocks to the file. The current block is also ended early if it's been at least
+    // cMinFlushIntervalMS since a block was last ended, so flushing after every packet doesn't give each packet its
+    // own block. close() always writes everything.
+    virtual bool flush();
+
+    virtual uint64_t get_size() const
+    {
+        return m_ofs;
+    }
+    virtual uint64_t get_remaining() const
+    {
+        return 0;
+    }
+    virtual uint64_t get_ofs() const
+    {
+        return m_ofs;
+    }
+
+    // Not seekable
+    virtual bool seek(int64_t ofs, bool relative)
+    {
+        VOGL_NOTE_UNUSED(ofs);
+        VOGL_NOTE_UNUSED(relative);
+        return false;
+    }
+
+    const vogl_trace_block_index &get_block_index() const
+    {
+        return m_block_index;
+    }
+
+    uint64_t get_total_compressed_bytes() const
+    {
+        return m_total_compressed_bytes;
+    }
+
+private:
+    struct block_job
+    {
+        uint8_vec m_uncomp_buf;
+        uint8_vec m_comp_buf;
+        uint64_t m_stream_ofs;
+        vogl_trace_stream_block_header m_header;
+    };
+
+    data_stream *m_pFile;
+    vogl_trace_block_codec_t m_codec;
+    uint32_t m_block_size;
+
+    uint64_t m_ofs;
+    uint64_t m_total_compressed_bytes;
+
+    uint8_vec m_cur_block;
+    uint64_t m_cur_block_stream_ofs;
+    uint32_t m_reserved_size;
+    timer_ticks m_last_block_end_ticks;
+
+    // At most one block is being compressed at a time
+    task_pool m_task_pool;
+    block_job m_job;
+    bool m_job_pending;
+
+    vogl_trace_block_index m_block_index;
+
+    bool end_block();
+    bool finish_pending_job();
+    void compress_task(uint64_t data, void *pData_ptr);
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_block_reader_stream
+// Read-only view of the uncompressed packet stream of a block compressed trace. Seeking uses the block index, which
+// is either supplied by the caller (from the trace archive) or rebuilt by scanning the block headers.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_trace_block_reader_stream : public data_stream
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_trace_block_reader_stream);
+
+public:
+    vogl_trace_block_reader_stream();
+    virtual ~vogl_trace_block_reader_stream();
+
+    // Blocks are expected between first_block_file_ofs and end_file_ofs. first_stream_ofs is the stream offset of
+    // the first block. pBlock_index may be NULL. pFile must remain valid until close() is called.
+    bool open(data_stream *pFile, uint64_t first_block_file_ofs, uint64_t first_stream_ofs, uint64_t end_file_ofs, const vogl_trace_block_index *pBlock_index);
+
+    virtual bool close();
+
+    virtual uint32_t read(void *pBuf, uint32_t len);
+
+    virtual uint32_t write(const void *pBuf, uint32_t len)
+    {
+        VOGL_NOTE_UNUSED(pBuf);
+        VOGL_NOTE_UNUSED(len);
+        return 0;
+    }
+
+    virtual bool flush()
+    {
+        return true;
+    }
+
+    virtual uint64_t get_size() const
+    {
+        return m_size;
+    }
+    virtual uint64_t get_remaining() const
+    {
+        return (m_ofs < m_size) ? (m_size - m_ofs) : 0;
+    }
+    virtual uint64_t get_ofs() const
+    {
+        return m_ofs;
+    }
+
+    virtual bool seek(int64_t ofs, bool relative);
+
+    const vogl_trace_block_index &get_block_index() const
+    {
+        return m_block_index;
+    }
+
+private:
+    data_stream *m_pFile;
+
+    vogl_trace_block_index m_block_index;
+
+    uint64_t m_first_stream_ofs;
+    uint64_t m_size;
+    uint64_t m_ofs;
+
+    int m_cur_block_index;
+    uint8_vec m_cur_block;
+    uint8_vec m_comp_buf;
+
+    bool scan_block_headers(uint64_t first_block_file_ofs, uint64_t first_stream_ofs, uint64_t end_file_ofs);
+    int find_block(uint64_t stream_ofs) const;
+    bool load_block(int block_index);
+};
+
+bool vogl_compress_trace_block(vogl_trace_block_codec_t codec, const uint8_t *pSrc, uint32_t src_size, uint8_vec &dst_buf, vogl_trace_stream_block_header &header);
+bool vogl_decompress_trace_block(const vogl_trace_stream_block_header &header, const uint8_t *pSrc, uint8_t *pDst);
+
+bool trace_block_stream_test();
+
+#endif // VOGL_TRACE_BLOCK_STREAM_H
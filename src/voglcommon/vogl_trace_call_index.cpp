@@ -0,0 +1,464 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_call_index.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_trace_call_index.h"
+#include "vogl_checksum.h"
+
+namespace
+{
+    inline void put_varint(uint8_vec &buf, uint64_t val)
+    {
+        while (val >= 0x80)
+        {
+            buf.push_back(static_cast<uint8_t>(val | 0x80));
+            val >>= 7;
+        }
+        buf.push_back(static_cast<uint8_t>(val));
+    }
+
+    inline uint64_t zigzag_encode(int64_t val)
+    {
+        return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+    }
+
+    inline int64_t zigzag_decode(uint64_t val)
+    {
+        return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+    }
+
+    class varint_reader
+    {
+    public:
+        varint_reader(const uint8_t *pData, uint32_t size)
+            : m_pCur(pData), m_pEnd(pData + size), m_failed(false)
+        {
+        }
+
+        inline uint64_t get()
+        {
+            uint64_t val = 0;
+            for (uint32_t shift = 0; shift < 64; shift += 7)
+            {
+                if (m_pCur == m_pEnd)
+                    break;
+
+                uint8_t c = *m_pCur++;
+                val |= static_cast<uint64_t>(c & 0x7F) << shift;
+                if (!(c & 0x80))
+                    return val;
+            }
+
+            m_failed = true;
+            return 0;
+        }
+
+        bool failed() const
+        {
+            return m_failed;
+        }
+        bool at_end() const
+        {
+            return m_pCur == m_pEnd;
+        }
+
+    private:
+        const uint8_t *m_pCur;
+        const uint8_t *m_pEnd;
+        bool m_failed;
+    };
+
+    struct sorted_call_compare
+    {
+        const uint64_vec *m_pCall_counters;
+
+        sorted_call_compare(const uint64_vec &call_counters)
+            : m_pCall_counters(&call_counters)
+        {
+        }
+
+        inline bool operator()(uint32_t a, uint32_t b) const
+        {
+            uint64_t counter_a = (*m_pCall_counters)[a], counter_b = (*m_pCall_counters)[b];
+            return (counter_a < counter_b) || ((counter_a == counter_b) && (a < b));
+        }
+    };
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder::vogl_trace_call_index_builder
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_call_index_builder::vogl_trace_call_index_builder()
+{
+    clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder::clear
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_call_index_builder::clear()
+{
+    m_call_data.clear();
+    m_entrypoint_ids.clear();
+    m_frame_call_counts.clear();
+
+    m_prev_call_counter = static_cast<uint64_t>(-1);
+    m_prev_file_ofs = 0;
+    m_cur_frame_calls = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder::add_call
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_call_index_builder::add_call(uint64_t call_counter, uint64_t file_ofs, gl_entrypoint_id_t id)
+{
+    VOGL_ASSERT(file_ofs >= m_prev_file_ofs);
+
+    put_varint(m_call_data, zigzag_encode(static_cast<int64_t>(call_counter - m_prev_call_counter - 1)));
+    put_varint(m_call_data, file_ofs - m_prev_file_ofs);
+
+    m_entrypoint_ids.push_back(static_cast<uint16_t>(id));
+
+    m_prev_call_counter = call_counter;
+    m_prev_file_ofs = file_ofs;
+    m_cur_frame_calls++;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder::end_frame
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_call_index_builder::end_frame()
+{
+    m_frame_call_counts.push_back(m_cur_frame_calls);
+    m_cur_frame_calls = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder::serialize
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_call_index_builder::serialize(uint8_vec &buf, const uint32_t *pTrace_uuid) const
+{
+    VOGL_FUNC_TRACER
+
+    buf.resize(sizeof(vogl_trace_call_index_header));
+    buf.append(m_call_data);
+
+    uint32_t frame_data_ofs = buf.size();
+    for (uint32_t i = 0; i < m_frame_call_counts.size(); i++)
+        put_varint(buf, m_frame_call_counts[i]);
+    put_varint(buf, m_cur_frame_calls);
+
+    // Counting sort of the calls by entrypoint, which keeps each posting list in file order.
+    uint32_vec entrypoint_call_counts(VOGL_NUM_ENTRYPOINTS);
+    for (uint32_t i = 0; i < m_entrypoint_ids.size(); i++)
+        if (m_entrypoint_ids[i] < VOGL_NUM_ENTRYPOINTS)
+            entrypoint_call_counts[m_entrypoint_ids[i]]++;
+
+    uint32_vec entrypoint_first_posting(VOGL_NUM_ENTRYPOINTS + 1);
+    uint32_t total_posting_lists = 0;
+    for (uint32_t id = 0; id < VOGL_NUM_ENTRYPOINTS; id++)
+    {
+        entrypoint_first_posting[id + 1] = entrypoint_first_posting[id] + entrypoint_call_counts[id];
+        total_posting_lists += (entrypoint_call_counts[id] != 0);
+    }
+
+    uint32_vec postings(entrypoint_first_posting[VOGL_NUM_ENTRYPOINTS]);
+    uint32_vec next_posting(entrypoint_first_posting);
+    for (uint32_t i = 0; i < m_entrypoint_ids.size(); i++)
+        if (m_entrypoint_ids[i] < VOGL_NUM_ENTRYPOINTS)
+            postings[next_posting[m_entrypoint_ids[i]]++] = i;
+
+    uint32_t posting_data_ofs = buf.size();
+    for (uint32_t id = 0; id < VOGL_NUM_ENTRYPOINTS; id++)
+    {
+        if (!entrypoint_call_counts[id])
+            continue;
+
+        put_varint(buf, id);
+        put_varint(buf, entrypoint_call_counts[id]);
+
+        uint32_t prev_call_index = 0;
+        for (uint32_t i = entrypoint_first_posting[id]; i < entrypoint_first_posting[id + 1]; i++)
+        {
+            put_varint(buf, postings[i] - prev_call_index);
+            prev_call_index = postings[i];
+        }
+    }
+
+    vogl_trace_call_index_header &hdr = *reinterpret_cast<vogl_trace_call_index_header *>(buf.get_ptr());
+    utils::zero_object(hdr);
+    hdr.m_magic = vogl_trace_call_index_header::cMagic;
+    hdr.m_version = vogl_trace_call_index_header::cVersion;
+    if (pTrace_uuid)
+        memcpy(hdr.m_trace_uuid, pTrace_uuid, sizeof(hdr.m_trace_uuid));
+    hdr.m_total_calls = m_entrypoint_ids.size();
+    hdr.m_total_frames = m_frame_call_counts.size() + 1;
+    hdr.m_total_posting_lists = total_posting_lists;
+    hdr.m_call_data_size = m_call_data.size();
+    hdr.m_frame_data_size = posting_data_ofs - frame_data_ofs;
+    hdr.m_posting_data_size = buf.size() - posting_data_ofs;
+    hdr.m_crc = calc_crc32(cInitCRC32, buf.get_ptr() + sizeof(hdr), buf.size() - sizeof(hdr));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::vogl_trace_call_index
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_call_index::vogl_trace_call_index()
+    : m_call_counters_in_file_order(true),
+      m_is_valid(false)
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::clear
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_call_index::clear()
+{
+    m_call_counters.clear();
+    m_call_file_ofs.clear();
+    m_call_entrypoint_ids.clear();
+    m_frame_first_call.clear();
+    m_entrypoint_calls.clear();
+    m_call_counters_in_file_order = true;
+    m_sorted_calls.clear();
+    m_sorted_suffix_min_call.clear();
+    m_is_valid = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::deserialize
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_call_index::deserialize(const uint8_t *pData, uint32_t data_size, const uint32_t *pTrace_uuid)
+{
+    VOGL_FUNC_TRACER
+
+    clear();
+
+    if (data_size < sizeof(vogl_trace_call_index_header))
+        return false;
+
+    vogl_trace_call_index_header hdr;
+    memcpy(&hdr, pData, sizeof(hdr));
+
+    if ((hdr.m_magic != vogl_trace_call_index_header::cMagic) || (hdr.m_version != vogl_trace_call_index_header::cVersion))
+    {
+        vogl_warning_printf("%s: Call index has an unsupported version\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    if ((pTrace_uuid) && (memcmp(hdr.m_trace_uuid, pTrace_uuid, sizeof(hdr.m_trace_uuid)) != 0))
+    {
+        vogl_warning_printf("%s: Call index was built from a different trace\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    uint64_t total_data_size = static_cast<uint64_t>(hdr.m_call_data_size) + hdr.m_frame_data_size + hdr.m_posting_data_size;
+    if ((total_data_size != data_size - sizeof(hdr)) || (!hdr.m_total_frames) ||
+        (hdr.m_crc != calc_crc32(cInitCRC32, pData + sizeof(hdr), data_size - sizeof(hdr))))
+    {
+        vogl_warning_printf("%s: Call index is corrupted\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    const uint8_t *pCall_data = pData + sizeof(hdr);
+    const uint8_t *pFrame_data = pCall_data + hdr.m_call_data_size;
+    const uint8_t *pPosting_data = pFrame_data + hdr.m_frame_data_size;
+
+    bool success = true;
+
+    m_call_counters.resize(hdr.m_total_calls);
+    m_call_file_ofs.resize(hdr.m_total_calls);
+    m_call_entrypoint_ids.resize(hdr.m_total_calls);
+
+    varint_reader call_reader(pCall_data, hdr.m_call_data_size);
+    uint64_t call_counter = static_cast<uint64_t>(-1), file_ofs = 0;
+    for (uint32_t i = 0; i < hdr.m_total_calls; i++)
+    {
+        call_counter += static_cast<uint64_t>(zigzag_decode(call_reader.get())) + 1;
+        file_ofs += call_reader.get();
+
+        m_call_counters[i] = call_counter;
+        m_call_file_ofs[i] = file_ofs;
+
+        if ((i) && (call_counter < m_call_counters[i - 1]))
+            m_call_counters_in_file_order = false;
+    }
+    success = success && !call_reader.failed() && call_reader.at_end();
+
+    m_frame_first_call.resize(hdr.m_total_frames + 1);
+    varint_reader frame_reader(pFrame_data, hdr.m_frame_data_size);
+    for (uint32_t i = 0; i < hdr.m_total_frames; i++)
+        m_frame_first_call[i + 1] = m_frame_first_call[i] + static_cast<uint32_t>(frame_reader.get());
+    success = success && !frame_reader.failed() && frame_reader.at_end() && (m_frame_first_call.back() == hdr.m_total_calls);
+
+    m_entrypoint_calls.resize(VOGL_NUM_ENTRYPOINTS);
+    varint_reader posting_reader(pPosting_data, hdr.m_posting_data_size);
+    for (uint32_t i = 0; (success) && (i < hdr.m_total_posting_lists); i++)
+    {
+        uint64_t id = posting_reader.get();
+        uint64_t total_calls = posting_reader.get();
+        if ((posting_reader.failed()) || (id >= VOGL_NUM_ENTRYPOINTS) || (total_calls > hdr.m_total_calls))
+        {
+            success = false;
+            break;
+        }
+
+        uint32_vec &calls = m_entrypoint_calls[static_cast<uint32_t>(id)];
+        calls.resize(static_cast<uint32_t>(total_calls));
+
+        uint64_t call_index = 0;
+        for (uint32_t j = 0; j < calls.size(); j++)
+        {
+            call_index += posting_reader.get();
+            if (call_index >= hdr.m_total_calls)
+            {
+                success = false;
+                break;
+            }
+
+            calls[j] = static_cast<uint32_t>(call_index);
+            m_call_entrypoint_ids[calls[j]] = static_cast<uint16_t>(id);
+        }
+    }
+    success = success && !posting_reader.failed() && posting_reader.at_end();
+
+    if (!success)
+    {
+        vogl_warning_printf("%s: Call index is corrupted\n", VOGL_FUNCTION_INFO_CSTR);
+        clear();
+        return false;
+    }
+
+    if (!m_call_counters_in_file_order)
+    {
+        m_sorted_calls.resize(hdr.m_total_calls);
+        for (uint32_t i = 0; i < hdr.m_total_calls; i++)
+            m_sorted_calls[i] = i;
+        m_sorted_calls.sort(sorted_call_compare(m_call_counters));
+
+        m_sorted_suffix_min_call.resize(hdr.m_total_calls);
+        uint32_t min_call = cUINT32_MAX;
+        for (int i = hdr.m_total_calls - 1; i >= 0; i--)
+        {
+            min_call = math::minimum(min_call, m_sorted_calls[i]);
+            m_sorted_suffix_min_call[i] = min_call;
+        }
+    }
+
+    m_is_valid = true;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::get_call_frame
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_trace_call_index::get_call_frame(uint32_t call_index) const
+{
+    VOGL_ASSERT(call_index < get_total_calls());
+
+    // Last frame whose first call is <= call_index, empty frames share their first call with the following frame.
+    uint32_t lo = 0, hi = get_total_frames();
+    while ((hi - lo) > 1)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (m_frame_first_call[mid] <= call_index)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::lower_bound_sorted
+// Position of the first call in counter order with a counter >= call_counter.
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_trace_call_index::lower_bound_sorted(uint64_t call_counter) const
+{
+    uint32_t lo = 0, hi = get_total_calls();
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t call_index = m_call_counters_in_file_order ? mid : m_sorted_calls[mid];
+        if (m_call_counters[call_index] < call_counter)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::find_call
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_call_index::find_call(uint64_t call_counter, uint32_t &call_index) const
+{
+    uint32_t pos = lower_bound_sorted(call_counter);
+    if (pos >= get_total_calls())
+        return false;
+
+    uint32_t found_call_index = m_call_counters_in_file_order ? pos : m_sorted_calls[pos];
+    if (m_call_counters[found_call_index] != call_counter)
+        return false;
+
+    call_index = found_call_index;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::find_first_call_at_or_after
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_call_index::find_first_call_at_or_after(uint64_t call_counter, uint32_t &call_index) const
+{
+    uint32_t pos = lower_bound_sorted(call_counter);
+    if (pos >= get_total_calls())
+        return false;
+
+    call_index = m_call_counters_in_file_order ? pos : m_sorted_suffix_min_call[pos];
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::get_entrypoint_calls
+//----------------------------------------------------------------------------------------------------------------------
+const uint32_vec &vogl_trace_call_index::get_entrypoint_calls(gl_entrypoint_id_t id) const
+{
+    static const uint32_vec s_no_calls;
+
+    if (static_cast<uint32_t>(id) >= m_entrypoint_calls.size())
+        return s_no_calls;
+
+    return m_entrypoint_calls[id];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index::get_sidecar_filename
+//----------------------------------------------------------------------------------------------------------------------
+dynamic_string vogl_trace_call_index::get_sidecar_filename(const char *pTrace_filename)
+{
+    return dynamic_string(cVarArg, "%s.idx", pTrace_filename);
+}
@@ -0,0 +1,193 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_call_index.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_TRACE_CALL_INDEX_H
+#define VOGL_TRACE_CALL_INDEX_H
+
+#include "vogl_common.h"
+#include "vogl_trace_stream_types.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Call index file layout
+// A header followed by three sections of LEB128 varints:
+//  calls:    per GL call in file order - zigzag(call counter - previous call counter - 1), packet stream offset - previous offset
+//  frames:   per frame - number of calls in the frame (the last frame is the one still open when the trace ended)
+//  postings: per entrypoint that was called - entrypoint id, number of calls, then call index deltas in file order
+// Offsets are packet stream offsets, like the frame file offsets, so they also work on block compressed traces.
+//----------------------------------------------------------------------------------------------------------------------
+#pragma pack(push)
+#pragma pack(1)
+struct vogl_trace_call_index_header
+{
+    enum
+    {
+        cMagic = 0x58444943, // "CIDX"
+        cVersion = 1
+    };
+
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_crc; // CRC32 of everything following the header
+
+    // UUID of the trace this index was built from
+    uint32_t m_trace_uuid[vogl_trace_stream_start_of_file_packet::cUUIDSize];
+
+    uint32_t m_total_calls;
+    uint32_t m_total_frames;
+    uint32_t m_total_posting_lists;
+
+    uint32_t m_call_data_size;
+    uint32_t m_frame_data_size;
+    uint32_t m_posting_data_size;
+};
+#pragma pack(pop)
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index_builder
+// Accumulates the index while a trace is being written (or scanned), about 4-6 bytes per call.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_trace_call_index_builder
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_trace_call_index_builder);
+
+public:
+    vogl_trace_call_index_builder();
+
+    void clear();
+
+    // Calls must be added in file order.
+    void add_call(uint64_t call_counter, uint64_t file_ofs, gl_entrypoint_id_t id);
+
+    // Call after adding each swap call.
+    void end_frame();
+
+    uint32_t get_total_calls() const
+    {
+        return m_entrypoint_ids.size();
+    }
+
+    void serialize(uint8_vec &buf, const uint32_t *pTrace_uuid) const;
+
+private:
+    uint8_vec m_call_data;
+    vogl::vector<uint16_t> m_entrypoint_ids;
+    uint32_vec m_frame_call_counts;
+
+    uint64_t m_prev_call_counter;
+    uint64_t m_prev_file_ofs;
+    uint32_t m_cur_frame_calls;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_call_index
+// Decoded call index. Calls are identified by their index in file order.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_trace_call_index
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_trace_call_index);
+
+public:
+    vogl_trace_call_index();
+
+    void clear();
+
+    // pTrace_uuid may be NULL, otherwise the index must have been built from the trace with this UUID.
+    bool deserialize(const uint8_t *pData, uint32_t data_size, const uint32_t *pTrace_uuid);
+
+    bool is_valid() const
+    {
+        return m_is_valid;
+    }
+
+    uint32_t get_total_calls() const
+    {
+        return m_call_counters.size();
+    }
+    uint32_t get_total_frames() const
+    {
+        return m_frame_first_call.size() ? (m_frame_first_call.size() - 1) : 0;
+    }
+
+    uint64_t get_call_counter(uint32_t call_index) const
+    {
+        return m_call_counters[call_index];
+    }
+    uint64_t get_call_file_ofs(uint32_t call_index) const
+    {
+        return m_call_file_ofs[call_index];
+    }
+    gl_entrypoint_id_t get_call_entrypoint_id(uint32_t call_index) const
+    {
+        return static_cast<gl_entrypoint_id_t>(m_call_entrypoint_ids[call_index]);
+    }
+
+    // Frame containing the call, O(log frames).
+    uint32_t get_call_frame(uint32_t call_index) const;
+
+    uint32_t get_frame_first_call(uint32_t frame_index) const
+    {
+        return m_frame_first_call[frame_index];
+    }
+    uint32_t get_frame_total_calls(uint32_t frame_index) const
+    {
+        return m_frame_first_call[frame_index + 1] - m_frame_first_call[frame_index];
+    }
+
+    // O(log calls) lookups by call counter.
+    bool find_call(uint64_t call_counter, uint32_t &call_index) const;
+    // Earliest call in file order with a call counter >= call_counter.
+    bool find_first_call_at_or_after(uint64_t call_counter, uint32_t &call_index) const;
+
+    // Indices of every call to this entrypoint, in file order.
+    const uint32_vec &get_entrypoint_calls(gl_entrypoint_id_t id) const;
+
+    static dynamic_string get_sidecar_filename(const char *pTrace_filename);
+
+private:
+    uint64_vec m_call_counters;
+    uint64_vec m_call_file_ofs;
+    vogl::vector<uint16_t> m_call_entrypoint_ids;
+
+    // get_total_frames() + 1 entries, the last one is the total number of calls
+    uint32_vec m_frame_first_call;
+
+    vogl::vector<uint32_vec> m_entrypoint_calls;
+
+    // Call counters are allocated when a call begins but packets are written when it ends, so in multithreaded traces
+    // they aren't always in file order. In that case calls are also kept sorted by counter, along with the minimum
+    // file order index of each suffix of that order.
+    bool m_call_counters_in_file_order;
+    uint32_vec m_sorted_calls;
+    uint32_vec m_sorted_suffix_min_call;
+
+    bool m_is_valid;
+
+    uint32_t lower_bound_sorted(uint64_t call_counter) const;
+};
+
+#endif // VOGL_TRACE_CALL_INDEX_H
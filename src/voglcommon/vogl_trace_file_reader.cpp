@@ -27,6 +27,8 @@
 #include "vogl_trace_file_reader.h"
 #include "vogl_console.h"
 #include "vogl_file_utils.h"
+#include "vogl_port.h"
+#include "vogl_trace_file_writer.h"
 
 vogl_trace_file_reader::trace_file_reader_status_t vogl_trace_file_reader::read_frame_packets(uint32_t frame_index, uint32_t num_frames, vogl_trace_packet_array &packets, uint32_t &actual_frames_read)
 {
@@ -59,7 +61,39 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_trace_file_reader::read_
 
     uint32_t total_frames_read = 0;
 
-    packets.reserve(packets.size() + num_frames * 1000);
+    // Size the packet table and arena up front so the whole frame range is usually copied in without any reallocations.
+    // The frame offsets are exact for uncompressed traces and a lower bound for compressed ones.
+    uint32_t expected_packets = num_frames * 1000;
+    uint64_t expected_bytes = 0;
+
+    const vogl_trace_call_index *pCall_index = get_call_index();
+    if ((pCall_index) && (frame_index < pCall_index->get_total_frames()))
+    {
+        uint32_t end_frame = frame_index + math::minimum(num_frames, pCall_index->get_total_frames() - frame_index);
+        uint32_t end_call = (end_frame < pCall_index->get_total_frames()) ? pCall_index->get_frame_first_call(end_frame) : pCall_index->get_total_calls();
+
+        // Plus a few non-GL packets, such as the EOF packet
+        expected_packets = end_call - pCall_index->get_frame_first_call(frame_index) + 16;
+    }
+
+    if ((get_type() == cBINARY_TRACE_FILE_READER) && (can_quickly_seek_forward()))
+    {
+        vogl_binary_trace_file_reader &binary_reader = *static_cast<vogl_binary_trace_file_reader *>(this);
+        const vogl::vector<uint64_t> &frame_offsets = binary_reader.get_frame_file_offsets();
+
+        if (frame_index < frame_offsets.size())
+        {
+            uint64_t end_ofs = ((frame_index + static_cast<uint64_t>(num_frames)) < frame_offsets.size()) ? frame_offsets[frame_index + num_frames] : binary_reader.get_trace_file_size();
+            expected_bytes = end_ofs - frame_offsets[frame_index];
+        }
+    }
+
+    // Don't reserve crazy amounts up front for huge ranges, the arena can still grow past this.
+    const uint64_t cMaxArenaReserve = 512U * 1024U * 1024U;
+    expected_bytes = math::minimum<uint64_t>(expected_bytes + expected_packets * 8ULL, cMaxArenaReserve);
+
+    // Only a hint, the arena grows as needed.
+    packets.reserve(packets.size() + expected_packets, packets.get_arena_size() + expected_bytes);
 
     trace_file_reader_status_t status = cOK;
     for (;;)
@@ -71,7 +105,12 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_trace_file_reader::read_
             break;
         }
 
-        packets.push_back(get_packet_buf());
+        if (!packets.push_back(get_packet_ptr(), get_packet_size()))
+        {
+            vogl_error_printf("%s: Out of memory loading frame packets (%u packets, %" PRIu64 " bytes so far)\n", VOGL_FUNCTION_INFO_CSTR, packets.size(), packets.get_arena_size());
+            actual_frames_read = total_frames_read;
+            return cFailed;
+        }
 
         if (is_eof_packet())
             break;
@@ -95,6 +134,7 @@ void vogl_trace_file_reader::create_eof_packet()
     vogl_trace_stream_packet_base eof_packet;
     eof_packet.init(cTSPTEOF, sizeof(vogl_trace_stream_packet_base));
     eof_packet.finalize();
+    clear_packet_view();
     m_packet_buf.resize(0);
     m_packet_buf.append(reinterpret_cast<uint8_t *>(&eof_packet), sizeof(eof_packet));
 }
@@ -129,8 +169,13 @@ bool vogl_trace_file_reader::init_loose_file_blob_manager(const char *pTrace_fil
 vogl_binary_trace_file_reader::vogl_binary_trace_file_reader()
     : vogl_trace_file_reader(),
       m_trace_file_size(0),
+      m_pSource_stream(&m_trace_stream),
+      m_pPacket_stream(&m_trace_stream),
       m_cur_frame_index(0),
       m_max_frame_index(-1),
+      m_has_client_memory_refs(false),
+      m_resolve_client_memory_refs(true),
+      m_client_memory_ref_packet(&m_trace_ctypes),
       m_found_frame_file_offsets_packet(0)
 {
     VOGL_FUNC_TRACER
@@ -194,9 +239,16 @@ bool vogl_binary_trace_file_reader::open(const char *pFilename, const char *pLoo
         return false;
     }
 
-    m_trace_file_size = m_trace_stream.get_size();
+    if (!open_source_stream())
+    {
+        close();
+        return false;
+    }
+
+    m_pPacket_stream = m_pSource_stream;
+    m_trace_file_size = m_pSource_stream->get_size();
 
-    if (m_trace_stream.read(&m_sof_packet, sizeof(m_sof_packet)) != sizeof(m_sof_packet))
+    if (m_pSource_stream->read(&m_sof_packet, sizeof(m_sof_packet)) != sizeof(m_sof_packet))
     {
         close();
         return false;
@@ -229,9 +281,40 @@ bool vogl_binary_trace_file_reader::open(const char *pFilename, const char *pLoo
         }
     }
 
+    if (m_archive_blob_manager.is_initialized())
+    {
+        // Packets only need to be checked for client memory references if the writer actually deduplicated something.
+        dynamic_string_array blob_ids(m_archive_blob_manager.enumerate());
+        for (uint32_t i = 0; i < blob_ids.size(); i++)
+        {
+            if (m_archive_blob_manager.get_prefix(blob_ids[i]) == "client_memory")
+            {
+                m_has_client_memory_refs = true;
+                m_trace_ctypes.init(m_sof_packet.m_pointer_sizes);
+                break;
+            }
+        }
+    }
+
+    if (m_sof_packet.m_block_codec != cTraceBlockCodecNone)
+    {
+        if (m_sof_packet.m_block_codec >= cTraceBlockCodecTotal)
+        {
+            vogl_error_printf("%s: Trace file uses unsupported block codec %u!\n", VOGL_FUNCTION_INFO_CSTR, m_sof_packet.m_block_codec);
+            close();
+            return false;
+        }
+
+        if (!open_block_stream())
+        {
+            close();
+            return false;
+        }
+    }
+
     m_packet_buf.reserve(512 * 1024);
 
-    m_trace_stream.seek(m_sof_packet.m_first_packet_offset, false);
+    m_pPacket_stream->seek(m_sof_packet.m_first_packet_offset, false);
 
     if (!read_frame_file_offsets())
     {
@@ -239,6 +322,67 @@ bool vogl_binary_trace_file_reader::open(const char *pFilename, const char *pLoo
         m_frame_file_offsets.push_back(get_cur_file_ofs());
     }
 
+    read_call_index(pFilename);
+
+    return true;
+}
+
+bool vogl_binary_trace_file_reader::read_call_index(const char *pFilename)
+{
+    VOGL_FUNC_TRACER
+
+    m_call_index.clear();
+
+    uint8_vec call_index_data;
+    if ((m_archive_blob_manager.is_initialized()) && (m_archive_blob_manager.get(VOGL_TRACE_ARCHIVE_CALL_INDEX_FILENAME, call_index_data)))
+    {
+        if (m_call_index.deserialize(call_index_data.get_ptr(), call_index_data.size(), m_sof_packet.m_uuid))
+            return true;
+    }
+
+    dynamic_string sidecar_filename(vogl_trace_call_index::get_sidecar_filename(pFilename));
+    if ((file_utils::does_file_exist(sidecar_filename.get_ptr())) && (file_utils::read_file_to_vec(sidecar_filename.get_ptr(), call_index_data)))
+    {
+        if (m_call_index.deserialize(call_index_data.get_ptr(), call_index_data.size(), m_sof_packet.m_uuid))
+            return true;
+
+        vogl_warning_printf("%s: Ignoring call index file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, sidecar_filename.get_ptr());
+    }
+
+    vogl_debug_printf("%s: No call index found, seeking by call will be slow in this trace file\n", VOGL_FUNCTION_INFO_CSTR);
+    return false;
+}
+
+bool vogl_binary_trace_file_reader::open_block_stream()
+{
+    VOGL_FUNC_TRACER
+
+    // Blocks run from the first packet offset up to the archive (or the end of the file if it was never closed).
+    uint64_t end_file_ofs = m_sof_packet.m_archive_size ? m_sof_packet.m_archive_offset : m_pSource_stream->get_size();
+
+    vogl_trace_block_index block_index;
+
+    uint8_vec block_index_data;
+    if ((m_archive_blob_manager.is_initialized()) && (m_archive_blob_manager.get(VOGL_TRACE_ARCHIVE_BLOCK_INDEX_FILENAME, block_index_data)) &&
+        ((block_index_data.size() % sizeof(vogl_trace_stream_block_index_entry)) == 0))
+    {
+        block_index.resize(block_index_data.size() / sizeof(vogl_trace_stream_block_index_entry));
+        memcpy(block_index.get_ptr(), block_index_data.get_ptr(), block_index.size_in_bytes());
+    }
+    else
+    {
+        vogl_warning_printf("%s: Couldn't find trace block index in trace archive, scanning block headers\n", VOGL_FUNCTION_INFO_CSTR);
+    }
+
+    if (!m_block_stream.open(m_pSource_stream, m_sof_packet.m_first_packet_offset, m_sof_packet.m_first_packet_offset, end_file_ofs, block_index.size() ? &block_index : NULL))
+    {
+        vogl_error_printf("%s: Failed opening trace block stream!\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    m_pPacket_stream = &m_block_stream;
+    m_trace_file_size = m_block_stream.get_size();
+
     return true;
 }
 
@@ -262,6 +406,12 @@ void vogl_binary_trace_file_reader::close()
 
     vogl_trace_file_reader::close();
 
+    m_block_stream.close();
+    m_pSource_stream = &m_trace_stream;
+    m_pPacket_stream = &m_trace_stream;
+
+    m_has_client_memory_refs = false;
+
     m_trace_stream.close();
     m_trace_file_size = 0;
 
@@ -271,6 +421,8 @@ void vogl_binary_trace_file_reader::close()
 
     m_saved_location_stack.clear();
 
+    m_call_index.clear();
+
     m_found_frame_file_offsets_packet = false;
 }
 
@@ -278,7 +430,7 @@ bool vogl_binary_trace_file_reader::is_at_eof()
 {
     VOGL_FUNC_TRACER
 
-    return (m_trace_stream.get_remaining() < sizeof(vogl_trace_stream_packet_base));
+    return (m_pPacket_stream->get_remaining() < sizeof(vogl_trace_stream_packet_base));
 }
 
 bool vogl_binary_trace_file_reader::seek_to_frame(uint32_t frame_index)
@@ -334,6 +486,37 @@ bool vogl_binary_trace_file_reader::seek_to_frame(uint32_t frame_index)
     return true;
 }
 
+bool vogl_binary_trace_file_reader::seek_to_call(uint64_t call_counter)
+{
+    VOGL_FUNC_TRACER
+
+    uint32_t call_index;
+    if ((!m_call_index.is_valid()) || (!m_call_index.find_call(call_counter, call_index)))
+        return false;
+
+    return seek_to_call_index(call_index);
+}
+
+bool vogl_binary_trace_file_reader::seek_to_call_index(uint32_t call_index)
+{
+    VOGL_FUNC_TRACER
+
+    if ((!is_opened()) || (!m_call_index.is_valid()) || (call_index >= m_call_index.get_total_calls()))
+        return false;
+
+    uint32_t frame_index = m_call_index.get_call_frame(call_index);
+
+    // read_next_packet() extends the frame offset table as swaps are read, so it must already reach this frame.
+    if ((frame_index >= m_frame_file_offsets.size()) && (!seek_to_frame(frame_index)))
+        return false;
+
+    if (!seek(m_call_index.get_call_file_ofs(call_index)))
+        return false;
+
+    m_cur_frame_index = frame_index;
+    return true;
+}
+
 int64_t vogl_binary_trace_file_reader::get_max_frame_index()
 {
     VOGL_FUNC_TRACER
@@ -357,11 +540,12 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader
 {
     VOGL_FUNC_TRACER
 
+    clear_packet_view();
     m_packet_buf.resize(sizeof(vogl_trace_stream_packet_base));
 
     {
         vogl_trace_stream_packet_base &packet_base = *reinterpret_cast<vogl_trace_stream_packet_base *>(m_packet_buf.get_ptr());
-        uint32_t bytes_actually_read = m_trace_stream.read(&packet_base, sizeof(packet_base));
+        uint32_t bytes_actually_read = m_pPacket_stream->read(&packet_base, sizeof(packet_base));
         if (bytes_actually_read != sizeof(packet_base))
         {
             // Jam in a fake EOF packet in case the caller doesn't get the message that something is wrong
@@ -371,10 +555,7 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader
             if (bytes_actually_read)
                 return cFailed;
 
-            if (m_max_frame_index < 0)
-                m_max_frame_index = m_cur_frame_index;
-            else
-                VOGL_ASSERT(m_max_frame_index == m_cur_frame_index);
+            note_end_of_trace();
 
             return cEOF;
         }
@@ -396,7 +577,7 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader
     uint32_t num_bytes_remaining = packet_base.m_size - sizeof(vogl_trace_stream_packet_base);
     if (num_bytes_remaining)
     {
-        uint32_t actual_bytes_read = m_trace_stream.read(m_packet_buf.get_ptr() + sizeof(vogl_trace_stream_packet_base), num_bytes_remaining);
+        uint32_t actual_bytes_read = m_pPacket_stream->read(m_packet_buf.get_ptr() + sizeof(vogl_trace_stream_packet_base), num_bytes_remaining);
         if (actual_bytes_read != num_bytes_remaining)
         {
             console::error("%s: Failed reading variable size trace packet data (wanted %u bytes, got %u bytes), trace file is probably corrupted/invalid\n", VOGL_FUNCTION_INFO_CSTR, num_bytes_remaining, actual_bytes_read);
@@ -413,12 +594,41 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader
         return cFailed;
     }
 
+    return finish_packet();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_binary_trace_file_reader::note_end_of_trace
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_binary_trace_file_reader::note_end_of_trace()
+{
+    if (m_max_frame_index < 0)
+        m_max_frame_index = m_cur_frame_index;
+    else
+        VOGL_ASSERT(m_max_frame_index == m_cur_frame_index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_binary_trace_file_reader::finish_packet
+// Common processing for a packet that has been read and validated: resolves client memory refs (unless disabled) and
+// keeps the frame offset table up to date. The stream must be positioned just past the packet.
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader::finish_packet()
+{
+    VOGL_FUNC_TRACER
+
+    if ((m_has_client_memory_refs) && (m_resolve_client_memory_refs) && (get_packet_type() == cTSPTGLEntrypoint))
+    {
+        if (!resolve_client_memory_refs())
+        {
+            console::error("%s: Failed resolving deduplicated client memory in trace packet\n", VOGL_FUNCTION_INFO_CSTR);
+            return cFailed;
+        }
+    }
+
     if (is_eof_packet())
     {
-        if (m_max_frame_index < 0)
-            m_max_frame_index = m_cur_frame_index;
-        else
-            VOGL_ASSERT(m_max_frame_index == m_cur_frame_index);
+        note_end_of_trace();
     }
     else if (is_swap_buffers_packet())
     {
@@ -438,6 +648,45 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_binary_trace_file_reader
     return cOK;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_binary_trace_file_reader::resolve_client_memory_refs
+// Replaces the current packet with an equivalent packet containing the referenced client memory, so callers
+// never see deduplicated packets.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_binary_trace_file_reader::resolve_client_memory_refs()
+{
+    VOGL_FUNC_TRACER
+
+    // The references live in the key value map, which is always at the end of the packet, so packets without any
+    // references can be skipped without deserializing the whole packet.
+    uint32_t key_value_map_size = get_packet<vogl_trace_gl_entrypoint_packet>().m_name_value_map_size;
+    if (!key_value_map_size)
+        return true;
+
+    if (key_value_map_size > get_packet_size())
+        return false;
+
+    if (m_client_memory_ref_key_values.deserialize_from_buffer(get_packet_ptr() + get_packet_size() - key_value_map_size, key_value_map_size, true, false) < 0)
+        return false;
+
+    if (!m_client_memory_ref_key_values.get_blob(string_hash("client_memory_refs")))
+        return true;
+
+    if (!m_client_memory_ref_packet.deserialize(get_packet_ptr(), get_packet_size(), false))
+        return false;
+
+    if (!m_client_memory_ref_packet.resolve_client_memory_refs(&m_archive_blob_manager))
+        return false;
+
+    if (!m_client_memory_ref_packet.serialize_to_packet_buf())
+        return false;
+
+    clear_packet_view();
+    m_packet_buf = m_client_memory_ref_packet.get_packet_buf();
+
+    return true;
+}
+
 bool vogl_binary_trace_file_reader::push_location()
 {
     VOGL_FUNC_TRACER
@@ -447,7 +696,7 @@ bool vogl_binary_trace_file_reader::push_location()
 
     saved_location *p = m_saved_location_stack.enlarge(1);
     p->m_cur_frame_index = m_cur_frame_index;
-    p->m_cur_ofs = m_trace_stream.get_ofs();
+    p->m_cur_ofs = m_pPacket_stream->get_ofs();
 
     return true;
 }
@@ -463,7 +712,7 @@ bool vogl_binary_trace_file_reader::pop_location()
 
     bool success = true;
 
-    if (!m_trace_stream.seek(loc.m_cur_ofs, false))
+    if (!m_pPacket_stream->seek(loc.m_cur_ofs, false))
         success = false;
     else
         m_cur_frame_index = loc.m_cur_frame_index;
@@ -473,6 +722,172 @@ bool vogl_binary_trace_file_reader::pop_location()
     return success;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::vogl_mmap_trace_file_reader
+//----------------------------------------------------------------------------------------------------------------------
+vogl_mmap_trace_file_reader::vogl_mmap_trace_file_reader()
+    : vogl_binary_trace_file_reader(),
+      m_pMapping(NULL),
+      m_mapping_size(0),
+      m_read_ahead_begin(0),
+      m_read_ahead_end(0)
+{
+    VOGL_FUNC_TRACER
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::~vogl_mmap_trace_file_reader
+//----------------------------------------------------------------------------------------------------------------------
+vogl_mmap_trace_file_reader::~vogl_mmap_trace_file_reader()
+{
+    VOGL_FUNC_TRACER
+
+    close();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::open_source_stream
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_mmap_trace_file_reader::open_source_stream()
+{
+    VOGL_FUNC_TRACER
+
+    m_pMapping = static_cast<const uint8_t *>(plat_map_file_readonly(m_trace_stream.get_name().get_ptr(), &m_mapping_size));
+    if (!m_pMapping)
+    {
+        vogl_error_printf("%s: Failed memory mapping trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_trace_stream.get_name().get_ptr());
+        return false;
+    }
+
+    if (!m_mapping_stream.open(static_cast<const void *>(m_pMapping), static_cast<size_t>(m_mapping_size)))
+        return false;
+
+    plat_advise_mapped_file(m_pMapping, m_mapping_size, PLAT_ADVISE_SEQUENTIAL);
+
+    m_read_ahead_begin = 0;
+    m_read_ahead_end = 0;
+
+    m_pSource_stream = &m_mapping_stream;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::close
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_mmap_trace_file_reader::close()
+{
+    VOGL_FUNC_TRACER
+
+    vogl_binary_trace_file_reader::close();
+
+    m_mapping_stream.close();
+
+    if (m_pMapping)
+    {
+        plat_unmap_file(m_pMapping, m_mapping_size);
+        m_pMapping = NULL;
+    }
+    m_mapping_size = 0;
+
+    m_read_ahead_begin = 0;
+    m_read_ahead_end = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::update_read_ahead
+// Keeps a window of the file ahead of the current offset in flight, the sequential hint alone only reads ahead a few
+// pages at a time. A new window is requested once half of the current one has been consumed, or after a seek.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_mmap_trace_file_reader::update_read_ahead()
+{
+    uint64_t ofs = m_mapping_stream.get_ofs();
+
+    if ((ofs >= m_read_ahead_begin) && ((ofs + cReadAheadSize / 2) <= m_read_ahead_end))
+        return;
+
+    uint64_t end_ofs = math::minimum<uint64_t>(ofs + cReadAheadSize, m_mapping_size);
+    if (end_ofs > ofs)
+        plat_advise_mapped_file(m_pMapping + ofs, end_ofs - ofs, PLAT_ADVISE_WILLNEED);
+
+    m_read_ahead_begin = ofs;
+    m_read_ahead_end = ofs + cReadAheadSize;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_mmap_trace_file_reader::read_next_packet
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_file_reader::trace_file_reader_status_t vogl_mmap_trace_file_reader::read_next_packet()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pMapping)
+        return cFailed;
+
+    update_read_ahead();
+
+    // Block compressed packets have to be decompressed, so they can't be views.
+    if (m_pPacket_stream != &m_mapping_stream)
+        return vogl_binary_trace_file_reader::read_next_packet();
+
+    uint64_t packet_ofs = m_mapping_stream.get_ofs();
+    uint64_t bytes_remaining = m_mapping_stream.get_remaining();
+
+    if (bytes_remaining < sizeof(vogl_trace_stream_packet_base))
+    {
+        // Jam in a fake EOF packet in case the caller doesn't get the message that something is wrong
+        create_eof_packet();
+
+        // The could happen if the file was truncated, or the last packet didn't get entirely written.
+        if (bytes_remaining)
+        {
+            m_mapping_stream.seek(m_mapping_size, false);
+            return cFailed;
+        }
+
+        note_end_of_trace();
+
+        return cEOF;
+    }
+
+    const uint8_t *pPacket = m_pMapping + packet_ofs;
+    const vogl_trace_stream_packet_base &packet_base = *reinterpret_cast<const vogl_trace_stream_packet_base *>(pPacket);
+
+    if ((!packet_base.basic_validation()) || (packet_base.m_size >= 0x7FFFFFFFULL))
+    {
+        console::error("%s: Bad trace file - packet failed basic validation tests!\n", VOGL_FUNCTION_INFO_CSTR);
+
+        create_eof_packet();
+
+        return cFailed;
+    }
+
+    if (packet_base.m_size > bytes_remaining)
+    {
+        console::error("%s: Failed reading variable size trace packet data (wanted %u bytes, got %u bytes), trace file is probably corrupted/invalid\n", VOGL_FUNCTION_INFO_CSTR,
+                       static_cast<uint32_t>(packet_base.m_size - sizeof(vogl_trace_stream_packet_base)), static_cast<uint32_t>(bytes_remaining - sizeof(vogl_trace_stream_packet_base)));
+
+        create_eof_packet();
+
+        return cFailed;
+    }
+
+    if (!packet_base.check_crc(packet_base.m_size))
+    {
+        console::error("%s: Bad trace file - packet CRC32 is bad!\n", VOGL_FUNCTION_INFO_CSTR);
+
+        create_eof_packet();
+
+        return cFailed;
+    }
+
+    set_packet_view(pPacket, packet_base.m_size);
+
+    m_mapping_stream.seek(packet_ofs + packet_base.m_size, false);
+
+    return finish_packet();
+}
+
 //-----------------------------------------------------------------------------
 // vogl_json_trace_file_reader::vogl_json_trace_file_reader
 //-----------------------------------------------------------------------------
@@ -480,7 +895,8 @@ vogl_json_trace_file_reader::vogl_json_trace_file_reader()
     : vogl_trace_file_reader(),
       m_filename_exists(false),
       m_filename_is_in_multiframe_form(false),
-      m_cur_frame_index(0), m_max_frame_index(0), m_cur_packet_node_index(0), m_packet_node_size(0), m_doc_eof_key_value(false),
+      m_cur_frame_index(0), m_max_frame_index(0),
+      m_has_document(false), m_read_trailing_members(false), m_has_next_packet_node(false), m_cur_packet_node_index(0), m_doc_eof_key_value(false),
       m_at_eof(false),
       m_trace_packet(&m_trace_ctypes)
 {
@@ -577,7 +993,7 @@ bool vogl_json_trace_file_reader::is_opened()
 {
     VOGL_FUNC_TRACER
 
-    return m_pPackets_array != NULL;
+    return m_has_document;
 }
 
 const char *vogl_json_trace_file_reader::get_filename()
@@ -601,7 +1017,7 @@ bool vogl_json_trace_file_reader::open_first_document()
         return false;
     }
 
-    const json_node *pSOF_node = pRoot_node->find_child_object("sof");
+    const json_node *pSOF_node = find_doc_object("sof");
     if (!pSOF_node)
     {
         vogl_error_printf("%s: Failed finding SOF (start of file) packet in JSON file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
@@ -667,9 +1083,12 @@ bool vogl_json_trace_file_reader::read_document(const dynamic_string &filename)
     m_cur_frame_filename = filename;
 
     m_cur_packet_node_index = 0;
-    m_packet_node_size = 0;
     m_doc_eof_key_value = 0;
-    m_pPackets_array = NULL;
+    m_has_document = false;
+    m_read_trailing_members = false;
+    m_has_next_packet_node = false;
+    m_next_packet_node.set_value_to_null();
+    m_packet_stream.close();
     m_cur_doc.clear();
 
     bool deserialize_status = false;
@@ -684,42 +1103,38 @@ bool vogl_json_trace_file_reader::read_document(const dynamic_string &filename)
             return false;
         }
 
-        deserialize_status = m_cur_doc.deserialize_file(m_cur_frame_filename.get_ptr());
-
         m_trace_stream.close();
 
+        // Only the root members preceding the packets array are read here, the packets are streamed by read_next_packet().
+        deserialize_status = m_packet_stream.open(m_cur_frame_filename.get_ptr()) && m_packet_stream.begin_array("packets", *m_cur_doc.get_root());
         if (deserialize_status)
             break;
 
+        m_cur_doc.clear();
+
         // Sleep a while in case another app is writing to the file
         vogl_sleep(500);
     }
 
     if (!deserialize_status)
     {
-        if (m_cur_doc.get_error_msg().has_content())
-            vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\nError: %s Line: %u\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), m_cur_doc.get_error_msg().get_ptr(), m_cur_doc.get_error_line());
+        if (m_packet_stream.get_error_msg().has_content())
+            vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\nError: %s Line: %u\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), m_packet_stream.get_error_msg().get_ptr(), m_packet_stream.get_error_line());
         else
             vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
 
+        m_packet_stream.close();
         m_cur_doc.clear();
         return false;
     }
 
     vogl_message_printf("Processing JSON file \"%s\"\n", m_cur_frame_filename.get_ptr());
 
-    const json_node *pRoot_node = m_cur_doc.get_root();
-    if (!pRoot_node)
-    {
-        vogl_error_printf("%s: Couldn't find root node in JSON file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
-        m_cur_doc.clear();
-        return false;
-    }
-
-    const json_node *pMeta_node = pRoot_node->find_child("meta");
+    const json_node *pMeta_node = find_doc_object("meta");
     if (!pMeta_node)
     {
         vogl_error_printf("%s: Couldn't find meta node in JSON file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
+        m_packet_stream.close();
         m_cur_doc.clear();
         return false;
     }
@@ -728,20 +1143,13 @@ bool vogl_json_trace_file_reader::read_document(const dynamic_string &filename)
     if (meta_frame_index != m_cur_frame_index)
     {
         vogl_error_printf("%s: Invalid meta frame index in JSON file \"%s\" (expected %lli, got %lli)\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), static_cast<long long int>(m_cur_frame_index), static_cast<long long int>(meta_frame_index));
+        m_packet_stream.close();
         m_cur_doc.clear();
         return false;
     }
 
     m_doc_eof_key_value = pMeta_node->value_as_int("eof", 0);
 
-    m_pPackets_array = pRoot_node->find_child_array("packets");
-    if (!m_pPackets_array)
-    {
-        vogl_error_printf("%s: Couldn't find packets node in JSON file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
-        m_cur_doc.clear();
-        return false;
-    }
-
     const json_node *pUUID_array = pMeta_node->find_child_array("uuid");
     if (pUUID_array)
     {
@@ -761,11 +1169,98 @@ bool vogl_json_trace_file_reader::read_document(const dynamic_string &filename)
         }
     }
 
-    m_packet_node_size = m_pPackets_array->size();
+    m_has_document = true;
+
+    if (!read_next_packet_node())
+    {
+        m_has_document = false;
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// vogl_json_trace_file_reader::find_doc_object
+// Finds one of the current document's root objects. The writer puts them all
+// before the packets array, but hand edited files may not, so if it's missing
+// the rest of the file is scanned once.
+//-----------------------------------------------------------------------------
+const json_node *vogl_json_trace_file_reader::find_doc_object(const char *pKey)
+{
+    VOGL_FUNC_TRACER
+
+    json_node *pRoot_node = m_cur_doc.get_root();
+
+    const json_node *pNode = pRoot_node->find_child_object(pKey);
+    if ((!pNode) && (!m_read_trailing_members) && (m_packet_stream.is_opened()))
+    {
+        m_read_trailing_members = true;
+
+        if (m_packet_stream.read_trailing_members(*pRoot_node))
+            pNode = pRoot_node->find_child_object(pKey);
+    }
+
+    return pNode;
+}
+
+//-----------------------------------------------------------------------------
+// vogl_json_trace_file_reader::read_next_packet_node
+//-----------------------------------------------------------------------------
+bool vogl_json_trace_file_reader::read_next_packet_node()
+{
+    VOGL_FUNC_TRACER
+
+    m_has_next_packet_node = m_packet_stream.read_next_value(m_next_packet_node);
+    if (m_has_next_packet_node)
+        return true;
+
+    m_next_packet_node.set_value_to_null();
+
+    if (m_packet_stream.has_error())
+    {
+        vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\nError: %s Line: %u\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), m_packet_stream.get_error_msg().get_ptr(), m_packet_stream.get_error_line());
+        return false;
+    }
 
     return true;
 }
 
+//-----------------------------------------------------------------------------
+// vogl_json_trace_file_reader::seek_to_packet_node
+// Rereads the document when moving backwards.
+//-----------------------------------------------------------------------------
+bool vogl_json_trace_file_reader::seek_to_packet_node(uint32_t index)
+{
+    VOGL_FUNC_TRACER
+
+    if ((index < m_cur_packet_node_index) && (!read_document(m_cur_frame_filename)))
+        return false;
+
+    if (index == m_cur_packet_node_index)
+        return true;
+
+    if (!m_has_next_packet_node)
+        return false;
+
+    // Skip the node already read, and everything before index.
+    while ((m_cur_packet_node_index + 1) < index)
+    {
+        if (!m_packet_stream.skip_next_value())
+        {
+            m_next_packet_node.set_value_to_null();
+            m_has_next_packet_node = false;
+            return false;
+        }
+
+        m_cur_packet_node_index++;
+    }
+
+    m_cur_packet_node_index = index;
+
+    return read_next_packet_node();
+}
+
 void vogl_json_trace_file_reader::close()
 {
     VOGL_FUNC_TRACER
@@ -789,10 +1284,13 @@ void vogl_json_trace_file_reader::close()
     m_cur_frame_index = 0;
     m_max_frame_index = 0;
 
+    m_packet_stream.close();
     m_cur_doc.clear();
-    m_pPackets_array = NULL;
+    m_has_document = false;
+    m_read_trailing_members = false;
+    m_next_packet_node.set_value_to_null();
+    m_has_next_packet_node = false;
     m_cur_packet_node_index = 0;
-    m_packet_node_size = 0;
     m_doc_eof_key_value = 0;
 
     m_at_eof = false;
@@ -804,12 +1302,12 @@ bool vogl_json_trace_file_reader::is_at_eof()
 {
     VOGL_FUNC_TRACER
 
-    if (!m_cur_doc.get_root())
+    if (!m_has_document)
         return true;
 
     return (m_at_eof) ||
            (m_cur_frame_index > m_max_frame_index) ||
-           ((m_doc_eof_key_value > 0) && (m_cur_packet_node_index >= m_packet_node_size));
+           ((m_doc_eof_key_value > 0) && (!m_has_next_packet_node) && (!m_packet_stream.has_error()));
 }
 
 dynamic_string vogl_json_trace_file_reader::compose_frame_filename()
@@ -843,7 +1341,20 @@ bool vogl_json_trace_file_reader::seek_to_frame(uint32_t frame_index)
         if (!read_document(compose_frame_filename()))
             return false;
 
-        m_cur_packet_node_index = m_packet_node_size;
+        // Move past the last packet node, without building them.
+        while (m_has_next_packet_node)
+        {
+            m_cur_packet_node_index++;
+
+            if (!m_packet_stream.skip_next_value())
+            {
+                if (m_packet_stream.has_error())
+                    return false;
+
+                m_next_packet_node.set_value_to_null();
+                m_has_next_packet_node = false;
+            }
+        }
 
         m_at_eof = true;
 
@@ -869,7 +1380,7 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_json_trace_file_reader::
 {
     VOGL_FUNC_TRACER
 
-    if (!m_pPackets_array)
+    if (!m_has_document)
     {
         VOGL_ASSERT_ALWAYS;
         return cFailed;
@@ -883,8 +1394,11 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_json_trace_file_reader::
 
     for (;;)
     {
-        while (m_cur_packet_node_index >= m_packet_node_size)
+        while (!m_has_next_packet_node)
         {
+            if (m_packet_stream.has_error())
+                return cFailed;
+
             if (m_doc_eof_key_value > 0)
             {
                 create_eof_packet();
@@ -908,21 +1422,19 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_json_trace_file_reader::
                 return cFailed;
         }
 
-        const json_node *pGL_node = m_pPackets_array->get_value_as_object(m_cur_packet_node_index);
+        const json_node *pGL_node = m_next_packet_node.is_object() ? m_next_packet_node.get_node_ptr() : NULL;
         if (!pGL_node)
         {
-            vogl_warning_printf("%s: Ignoring invalid JSON key %s, file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_pPackets_array->get_path_to_item(m_cur_packet_node_index).get_ptr(), m_cur_frame_filename.get_ptr());
+            vogl_warning_printf("%s: Ignoring invalid JSON key /packets[%u] on line %u, file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_cur_packet_node_index, m_next_packet_node.get_line(), m_cur_frame_filename.get_ptr());
             m_cur_packet_node_index++;
+            read_next_packet_node();
             continue;
         }
 
         bool success = m_trace_packet.json_deserialize(*pGL_node, m_cur_frame_filename.get_ptr(), &m_multi_blob_manager);
         if (!success)
         {
-            if (m_cur_doc.get_error_msg().has_content())
-                vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\nError: %s Line: %u\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), m_cur_doc.get_error_msg().get_ptr(), m_cur_doc.get_error_line());
-            else
-                vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr());
+            vogl_error_printf("%s: Failed deserializing JSON file \"%s\"!\nError: Invalid packet Line: %u\n", VOGL_FUNCTION_INFO_CSTR, m_cur_frame_filename.get_ptr(), pGL_node->get_line());
             return cFailed;
         }
 
@@ -939,6 +1451,9 @@ vogl_trace_file_reader::trace_file_reader_status_t vogl_json_trace_file_reader::
 
         m_cur_packet_node_index++;
 
+        // A bad next node is reported now, but fails the next call, so this packet still gets returned.
+        read_next_packet_node();
+
         break;
     }
 
@@ -968,7 +1483,7 @@ bool vogl_json_trace_file_reader::push_location()
 {
     VOGL_FUNC_TRACER
 
-    if (!m_pPackets_array)
+    if (!m_has_document)
         return false;
 
     saved_location *p = m_saved_location_stack.enlarge(1);
@@ -984,7 +1499,7 @@ bool vogl_json_trace_file_reader::pop_location()
 {
     VOGL_FUNC_TRACER
 
-    if ((!m_pPackets_array) || (m_saved_location_stack.is_empty()))
+    if ((!m_has_document) || (m_saved_location_stack.is_empty()))
         return false;
 
     saved_location &loc = m_saved_location_stack.back();
@@ -1005,10 +1520,8 @@ bool vogl_json_trace_file_reader::pop_location()
 
         m_at_eof = loc.m_at_eof;
 
-        if (loc.m_cur_packet_node_index > m_pPackets_array->size())
+        if (!seek_to_packet_node(loc.m_cur_packet_node_index))
             success = false;
-        else
-            m_cur_packet_node_index = loc.m_cur_packet_node_index;
     }
 
     m_saved_location_stack.pop_back();
@@ -1098,13 +1611,15 @@ vogl_trace_file_reader_type_t vogl_determine_trace_file_type(const dynamic_strin
     return trace_reader_type;
 }
 
-vogl_trace_file_reader *vogl_create_trace_file_reader(vogl_trace_file_reader_type_t trace_type)
+vogl_trace_file_reader *vogl_create_trace_file_reader(vogl_trace_file_reader_type_t trace_type, bool memory_map)
 {
     VOGL_FUNC_TRACER
 
     switch (trace_type)
     {
         case cBINARY_TRACE_FILE_READER:
+            if (memory_map)
+                return vogl_new(vogl_mmap_trace_file_reader);
             return vogl_new(vogl_binary_trace_file_reader);
             break;
         case cJSON_TRACE_FILE_READER:
@@ -1120,7 +1635,7 @@ vogl_trace_file_reader *vogl_create_trace_file_reader(vogl_trace_file_reader_typ
     return NULL;
 }
 
-vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dynamic_string &actual_filename, const char *pLoose_file_path)
+vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dynamic_string &actual_filename, const char *pLoose_file_path, bool memory_map)
 {
     VOGL_FUNC_TRACER
 
@@ -1131,7 +1646,7 @@ vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dyna
         return NULL;
     }
 
-    vogl_trace_file_reader *pTrace_reader = vogl_create_trace_file_reader(trace_type);
+    vogl_trace_file_reader *pTrace_reader = vogl_create_trace_file_reader(trace_type, memory_map);
     if (!pTrace_reader)
     {
         vogl_error_printf("%s: Unable to determine file type of trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, orig_filename.get_ptr());
@@ -1147,3 +1662,122 @@ vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dyna
 
     return pTrace_reader;
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+// trace_file_version_compat_test
+// Version 0x0106 traces predate block compression. Their SOF packet's m_block_codec byte was always zero, so they must
+// open and read through the uncompressed path. Anything older than VOGL_TRACE_FILE_MINIMUM_COMPATIBLE_VERSION must not.
+//----------------------------------------------------------------------------------------------------------------------
+static bool trace_file_version_compat_test_set_version(const char *pFilename, uint16_t version)
+{
+    uint8_vec data;
+    if ((!file_utils::read_file_to_vec(pFilename, data)) || (data.size() < sizeof(vogl_trace_stream_start_of_file_packet)))
+        return false;
+
+    vogl_trace_stream_start_of_file_packet &sof_packet = *reinterpret_cast<vogl_trace_stream_start_of_file_packet *>(data.get_ptr());
+    if (sof_packet.m_block_codec != cTraceBlockCodecNone)
+        return false;
+
+    sof_packet.m_version = version;
+    sof_packet.finalize();
+
+    return file_utils::write_vec_to_file(pFilename, data);
+}
+
+bool trace_file_version_compat_test()
+{
+    const uint32_t cTotalFrames = 8;
+    const uint32_t cCallsPerFrame = 20;
+
+    dynamic_string filename(file_utils::generate_temp_filename("vogl_version_compat_test"));
+
+    bool success = true;
+    {
+        vogl_ctypes ctypes;
+        ctypes.init(sizeof(void *));
+
+        vogl_trace_file_writer writer(&ctypes);
+        writer.set_block_codec(cTraceBlockCodecNone);
+        if (!writer.open(filename.get_ptr()))
+            return false;
+
+        vogl_trace_packet packet(&ctypes);
+        uint64_t call_counter = 0;
+        for (uint32_t frame_index = 0; (frame_index < cTotalFrames) && (success); frame_index++)
+        {
+            for (uint32_t i = 0; (i < cCallsPerFrame) && (success); i++)
+            {
+                packet.begin_construction(VOGL_ENTRYPOINT_glFinish, 1, call_counter++, 1, 0);
+                packet.end_construction(0);
+                success = writer.write_packet(packet);
+            }
+
+            uint64_t handle = 0;
+            packet.begin_construction(VOGL_ENTRYPOINT_glXSwapBuffers, 1, call_counter++, 1, 0);
+            packet.set_param(0, VOGL_DISPLAY_PTR, &handle, sizeof(void *));
+            packet.set_param(1, VOGL_GLXDRAWABLE, &handle, sizeof(uint64_t));
+            packet.end_construction(0);
+            success = success && writer.write_packet(packet);
+        }
+
+        success = writer.close() && success;
+    }
+
+    success = success && trace_file_version_compat_test_set_version(filename.get_ptr(), 0x0106);
+
+    // Plain and memory mapped readers.
+    for (uint32_t pass = 0; (pass < 2) && (success); pass++)
+    {
+        vogl_unique_ptr<vogl_trace_file_reader> pReader(vogl_create_trace_file_reader(cBINARY_TRACE_FILE_READER, pass != 0));
+        if ((!pReader->open(filename.get_ptr(), NULL)) || (pReader->get_sof_packet().m_version != 0x0106) ||
+            (pReader->get_sof_packet().m_block_codec != cTraceBlockCodecNone))
+        {
+            vogl_error_printf("%s: Failed opening version 0x0106 trace\n", VOGL_FUNCTION_INFO_CSTR);
+            success = false;
+            break;
+        }
+
+        uint64_t expected_call_counter = 0;
+        for (;;)
+        {
+            if (pReader->read_next_packet() != vogl_trace_file_reader::cOK)
+            {
+                success = false;
+                break;
+            }
+
+            if (pReader->is_eof_packet())
+                break;
+            if (pReader->get_packet_type() != cTSPTGLEntrypoint)
+                continue;
+
+            const vogl_trace_gl_entrypoint_packet &gl_packet = pReader->get_packet<vogl_trace_gl_entrypoint_packet>();
+            if (gl_packet.m_entrypoint_id == VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
+                continue;
+
+            if (gl_packet.m_call_counter != expected_call_counter)
+            {
+                success = false;
+                break;
+            }
+            expected_call_counter++;
+        }
+
+        success = success && (expected_call_counter == cTotalFrames * (cCallsPerFrame + 1)) &&
+                  (pReader->get_max_frame_index() == cTotalFrames) && (pReader->seek_to_frame(cTotalFrames / 2)) &&
+                  (pReader->read_next_packet() == vogl_trace_file_reader::cOK) &&
+                  (pReader->get_packet<vogl_trace_gl_entrypoint_packet>().m_call_counter == (cTotalFrames / 2) * (cCallsPerFrame + 1));
+    }
+
+    // Older versions are still rejected.
+    success = success && trace_file_version_compat_test_set_version(filename.get_ptr(), VOGL_TRACE_FILE_MINIMUM_COMPATIBLE_VERSION - 1);
+    if (success)
+    {
+        vogl_binary_trace_file_reader reader;
+        success = !reader.open(filename.get_ptr(), NULL);
+    }
+
+    file_utils::delete_file(filename.get_ptr());
+
+    return success;
+}
@@ -30,15 +30,21 @@
 #include "vogl_common.h"
 #include "vogl_trace_stream_types.h"
 #include "vogl_trace_packet.h"
+#include "vogl_trace_block_stream.h"
+#include "vogl_trace_call_index.h"
 #include "vogl_cfile_stream.h"
+#include "vogl_buffer_stream.h"
 #include "vogl_dynamic_stream.h"
 #include "vogl_json.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 // class vogl_trace_packet_array
+// Packets are stored back to back in a byte arena, with a table of each packet's location and size in packet order.
+// Loading a frame costs a few arena reallocations instead of one heap block per packet. insert() appends the new
+// packet's bytes to the arena and only moves table entries, and erase() only removes the packet's table entry, its
+// bytes stay in the arena until clear(). The arena is split into chunks of up to cMaxChunkSize bytes, so its total
+// size isn't limited by 32-bit offsets (or by the largest single allocation).
 //----------------------------------------------------------------------------------------------------------------------
-typedef vogl::vector<uint8_vec> vogl_packet_buf_vec;
-
 class vogl_trace_packet_array
 {
 public:
@@ -49,15 +55,39 @@ public:
     void clear()
     {
         m_packets.clear();
+        m_chunks.clear();
     }
 
-    void resize(uint32_t new_size)
+    // Drops the packets but keeps the table and first chunk's memory, for reuse with similarly sized frames.
+    void reset()
     {
-        m_packets.resize(new_size);
+        m_packets.resize(0);
+        if (m_chunks.size() > 1)
+            m_chunks.resize(1);
+        if (m_chunks.size())
+            m_chunks[0].resize(0);
     }
-    void reserve(uint32_t new_capacity)
+
+    // Never shrinks, new_arena_capacity is in bytes. Only the current chunk is reserved, up to cMaxChunkSize bytes.
+    // Returns false if the memory couldn't be allocated.
+    bool reserve(uint32_t new_capacity, uint64_t new_arena_capacity = 0)
     {
-        m_packets.reserve(new_capacity);
+        if ((new_capacity > m_packets.capacity()) && (!m_packets.try_reserve(new_capacity)))
+            return false;
+
+        uint64_t arena_size = get_arena_size();
+        if (new_arena_capacity > arena_size)
+        {
+            if ((m_chunks.is_empty()) && (!m_chunks.try_enlarge(1)))
+                return false;
+
+            uint8_vec &chunk = m_chunks.back();
+            uint64_t chunk_capacity = math::minimum<uint64_t>(chunk.size() + (new_arena_capacity - arena_size), cMaxChunkSize);
+            if ((chunk_capacity > chunk.capacity()) && (!chunk.try_reserve(static_cast<uint32_t>(chunk_capacity))))
+                return false;
+        }
+
+        return true;
     }
 
     uint32_t size() const
@@ -69,49 +99,78 @@ public:
         return m_packets.is_empty();
     }
 
-    void push_back(const uint8_vec &packet)
+    // Total size of the arena, including the bytes of any erased packets and alignment padding.
+    uint64_t get_arena_size() const
     {
-        m_packets.push_back(packet);
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < m_chunks.size(); i++)
+            total += m_chunks[i].size();
+        return total;
     }
 
-    void insert(uint32_t index, const uint8_vec &packet)
+    // These return false (leaving the array unchanged) if the memory couldn't be allocated.
+    bool push_back(const uint8_vec &packet)
     {
-        m_packets.insert(index, packet);
+        return push_back(packet.get_ptr(), packet.size());
     }
 
-    void erase(uint32_t index)
+    bool push_back(const uint8_t *pPacket, uint32_t size)
     {
-        m_packets.erase(index);
+        if (!m_packets.try_reserve(m_packets.size() + 1))
+            return false;
+
+        packet_ref ref;
+        if (!append_to_arena(pPacket, size, ref))
+            return false;
+
+        m_packets.push_back(ref);
+        return true;
     }
 
-    void swap(vogl_trace_packet_array &other)
+    bool insert(uint32_t index, const uint8_vec &packet)
     {
-        m_packets.swap(other.m_packets);
+        return insert(index, packet.get_ptr(), packet.size());
     }
 
-    const vogl_packet_buf_vec &get_vec() const
+    bool insert(uint32_t index, const uint8_t *pPacket, uint32_t size)
     {
-        return m_packets;
+        if (!m_packets.try_reserve(m_packets.size() + 1))
+            return false;
+
+        packet_ref ref;
+        if (!append_to_arena(pPacket, size, ref))
+            return false;
+
+        m_packets.insert(index, ref);
+        return true;
+    }
+
+    void erase(uint32_t index)
+    {
+        m_packets.erase(index);
     }
-    vogl_packet_buf_vec &get_vec()
+
+    void swap(vogl_trace_packet_array &other)
     {
-        return m_packets;
+        m_packets.swap(other.m_packets);
+        m_chunks.swap(other.m_chunks);
     }
 
-    const uint8_vec &get_packet_buf(uint32_t index) const
+    inline const uint8_t *get_packet_ptr(uint32_t index) const
     {
-        return m_packets[index];
+        const packet_ref &ref = m_packets[index];
+        return m_chunks[ref.m_chunk].get_ptr() + ref.m_ofs;
     }
-    uint8_vec &get_packet_buf(uint32_t index)
+    inline uint32_t get_packet_size(uint32_t index) const
     {
-        return m_packets[index];
+        return m_packets[index].m_size;
     }
 
     template <typename T>
     inline const T &get_packet(uint32_t index) const
     {
-        VOGL_ASSERT(m_packets[index].size() >= sizeof(T));
-        return *reinterpret_cast<const T *>(m_packets[index].get_ptr());
+        VOGL_ASSERT(m_packets[index].m_size >= sizeof(T));
+        return *reinterpret_cast<const T *>(get_packet_ptr(index));
     }
 
     inline const vogl_trace_stream_packet_base &get_base_packet(uint32_t index) const
@@ -123,10 +182,6 @@ public:
     {
         return static_cast<vogl_trace_stream_packet_types_t>(get_base_packet(index).m_type);
     }
-    inline uint32_t get_packet_size(uint32_t index) const
-    {
-        return m_packets[index].size();
-    }
 
     inline bool is_eof_packet(uint32_t index) const
     {
@@ -148,7 +203,51 @@ public:
     }
 
 private:
-    vogl_packet_buf_vec m_packets;
+    enum
+    {
+        // Packets keep the alignment they'd have had in their own heap blocks.
+        cPacketAlignment = 8,
+
+        // A packet which would take the current chunk past this starts a new one. Larger packets get a chunk of
+        // their own.
+        cMaxChunkSize = 256 * 1024 * 1024
+    };
+
+    struct packet_ref
+    {
+        uint32_t m_chunk;
+        uint32_t m_ofs;
+        uint32_t m_size;
+    };
+
+    vogl::vector<packet_ref> m_packets;
+
+    // Only the last chunk is appended to.
+    vogl::vector<uint8_vec> m_chunks;
+
+    inline bool append_to_arena(const uint8_t *pPacket, uint32_t size, packet_ref &ref)
+    {
+        uint64_t ofs = m_chunks.size() ? math::align_up_value<uint64_t>(m_chunks.back().size(), cPacketAlignment) : 0;
+
+        if ((m_chunks.is_empty()) || ((ofs + size > cMaxChunkSize) && (m_chunks.back().size())))
+        {
+            if (!m_chunks.try_enlarge(1))
+                return false;
+            ofs = 0;
+        }
+
+        uint8_vec &chunk = m_chunks.back();
+        if (!chunk.try_resize(static_cast<uint32_t>(ofs) + size, true))
+            return false;
+
+        if (size)
+            memcpy(chunk.get_ptr() + ofs, pPacket, size);
+
+        ref.m_chunk = m_chunks.size() - 1;
+        ref.m_ofs = static_cast<uint32_t>(ofs);
+        ref.m_size = size;
+        return true;
+    }
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -171,6 +270,8 @@ class vogl_trace_file_reader
 
 public:
     vogl_trace_file_reader()
+        : m_pPacket_view(NULL),
+          m_packet_view_size(0)
     {
         VOGL_FUNC_TRACER
 
@@ -197,6 +298,7 @@ public:
 
         utils::zero_object(m_sof_packet);
         m_packet_buf.clear();
+        clear_packet_view();
         m_loose_file_blob_manager.deinit();
         m_archive_blob_manager.deinit();
     }
@@ -219,6 +321,27 @@ public:
 
     virtual int64_t get_max_frame_index() = 0;
 
+    // Returns NULL if the reader doesn't have a call index for this trace.
+    virtual const vogl_trace_call_index *get_call_index() const
+    {
+        return NULL;
+    }
+
+    // Seeks to the packet of the GL call with this call counter using the call index. Returns false if there's no call
+    // index or the call isn't in the trace, callers then have to scan for it.
+    virtual bool seek_to_call(uint64_t call_counter)
+    {
+        VOGL_NOTE_UNUSED(call_counter);
+        return false;
+    }
+
+    // call_index is an index into get_call_index()'s calls (file order), not a call counter.
+    virtual bool seek_to_call_index(uint32_t call_index)
+    {
+        VOGL_NOTE_UNUSED(call_index);
+        return false;
+    }
+
     virtual bool push_location() = 0;
     virtual bool pop_location() = 0;
 
@@ -241,16 +364,31 @@ public:
 
     // packet helpers
 
+    // The current packet's bytes. Memory mapped readers return a pointer into the mapping, so it's only valid until the
+    // next read, seek, or close.
+    inline const uint8_t *get_packet_ptr() const
+    {
+        return m_pPacket_view ? m_pPacket_view : m_packet_buf.get_ptr();
+    }
+
+    // Use get_packet_ptr()/get_packet_size() unless you need a vector, this copies the packet if the reader returned a view.
     const uint8_vec &get_packet_buf() const
     {
+        if (m_pPacket_view)
+        {
+            m_packet_buf.resize(0);
+            m_packet_buf.append(m_pPacket_view, m_packet_view_size);
+            m_pPacket_view = NULL;
+            m_packet_view_size = 0;
+        }
         return m_packet_buf;
     }
 
     template <typename T>
     inline const T &get_packet() const
     {
-        VOGL_ASSERT(m_packet_buf.size() >= sizeof(T));
-        return *reinterpret_cast<const T *>(m_packet_buf.get_ptr());
+        VOGL_ASSERT(get_packet_size() >= sizeof(T));
+        return *reinterpret_cast<const T *>(get_packet_ptr());
     }
 
     inline const vogl_trace_stream_packet_base &get_base_packet() const
@@ -264,7 +402,7 @@ public:
     }
     inline uint32_t get_packet_size() const
     {
-        return m_packet_buf.size();
+        return m_pPacket_view ? m_packet_view_size : m_packet_buf.size();
     }
 
     inline bool is_eof_packet() const
@@ -316,7 +454,10 @@ public:
 protected:
     vogl_trace_stream_start_of_file_packet m_sof_packet;
 
-    uint8_vec m_packet_buf;
+    // The current packet is either in m_packet_buf, or if m_pPacket_view is set, in memory owned by the reader.
+    mutable uint8_vec m_packet_buf;
+    mutable const uint8_t *m_pPacket_view;
+    mutable uint32_t m_packet_view_size;
 
     vogl_loose_file_blob_manager m_loose_file_blob_manager;
     vogl_archive_blob_manager m_archive_blob_manager;
@@ -324,6 +465,17 @@ protected:
 
     void create_eof_packet();
     bool init_loose_file_blob_manager(const char *pTrace_filename, const char *pLoose_file_path);
+
+    inline void set_packet_view(const uint8_t *pPacket, uint32_t size)
+    {
+        m_pPacket_view = pPacket;
+        m_packet_view_size = size;
+    }
+    inline void clear_packet_view()
+    {
+        m_pPacket_view = NULL;
+        m_packet_view_size = 0;
+    }
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -394,28 +546,63 @@ public:
 
     virtual int64_t get_max_frame_index();
 
+    virtual const vogl_trace_call_index *get_call_index() const
+    {
+        return m_call_index.is_valid() ? &m_call_index : NULL;
+    }
+
+    virtual bool seek_to_call(uint64_t call_counter);
+    virtual bool seek_to_call_index(uint32_t call_index);
+
     virtual bool push_location();
     virtual bool pop_location();
 
+    // For block compressed traces, the file size/offsets are packet stream (uncompressed) sizes/offsets.
     uint64_t get_trace_file_size() const
     {
         return m_trace_file_size;
     }
     inline uint64_t get_cur_file_ofs()
     {
-        return m_trace_stream.get_ofs();
+        return m_pPacket_stream->get_ofs();
+    }
+
+    // Entry i is the offset of frame i's first packet. Only covers the whole trace if can_quickly_seek_forward() is true,
+    // otherwise it's extended as frames are read.
+    const vogl::vector<uint64_t> &get_frame_file_offsets() const
+    {
+        return m_frame_file_offsets;
     }
     inline bool seek(uint64_t new_ofs)
     {
-        return m_trace_stream.seek(new_ofs, false);
+        return m_pPacket_stream->seek(new_ofs, false);
     }
 
     virtual trace_file_reader_status_t read_next_packet();
 
-private:
+    // Deduplicated client memory is resolved by default, so callers never see client memory refs. Readers which only
+    // look at the fixed size packet header can disable this to skip decoding and rebuilding each referencing packet;
+    // packets are then returned exactly as stored, with m_client_memory_size only counting the bytes in the packet.
+    void set_resolve_client_memory_refs(bool enabled)
+    {
+        m_resolve_client_memory_refs = enabled;
+    }
+    bool get_resolve_client_memory_refs() const
+    {
+        return m_resolve_client_memory_refs;
+    }
+
+protected:
     cfile_stream m_trace_stream;
     uint64_t m_trace_file_size;
 
+    // The stream the file's contents are read from, m_trace_stream unless a derived reader supplies another one.
+    data_stream *m_pSource_stream;
+
+    vogl_trace_block_reader_stream m_block_stream;
+    // Either m_pSource_stream or m_block_stream
+    data_stream *m_pPacket_stream;
+
     uint32_t m_cur_frame_index;
     int64_t m_max_frame_index;
     vogl::vector<uint64_t> m_frame_file_offsets;
@@ -428,11 +615,70 @@ private:
 
     vogl::vector<saved_location> m_saved_location_stack;
 
+    // From the trace archive, or the sidecar file written by voglreplay --index.
+    vogl_trace_call_index m_call_index;
+
+    // Only set if the trace archive contains deduplicated client memory blobs.
+    bool m_has_client_memory_refs;
+    bool m_resolve_client_memory_refs;
+    vogl_ctypes m_trace_ctypes;
+    vogl_trace_packet m_client_memory_ref_packet;
+    key_value_map m_client_memory_ref_key_values;
+
     bool read_frame_file_offsets();
+    bool read_call_index(const char *pFilename);
+    bool open_block_stream();
+    bool resolve_client_memory_refs();
+
+    // Called after m_trace_stream is opened, may point m_pSource_stream at something else.
+    virtual bool open_source_stream()
+    {
+        return true;
+    }
+
+    void note_end_of_trace();
+    trace_file_reader_status_t finish_packet();
 
     bool m_found_frame_file_offsets_packet;
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+// class vogl_mmap_trace_file_reader
+// Binary trace reader which maps the whole trace file read-only. Packets in uncompressed traces are returned as views
+// into the mapping (see get_packet_ptr()), and are only copied if the caller asks for get_packet_buf(). Block
+// compressed traces are decompressed straight from the mapping. Requires enough address space for the whole file.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_mmap_trace_file_reader : public vogl_binary_trace_file_reader
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_mmap_trace_file_reader);
+
+public:
+    vogl_mmap_trace_file_reader();
+    virtual ~vogl_mmap_trace_file_reader();
+
+    virtual void close();
+
+    virtual trace_file_reader_status_t read_next_packet();
+
+private:
+    enum
+    {
+        // How far ahead of the current offset the kernel is asked to read.
+        cReadAheadSize = 16 * 1024 * 1024
+    };
+
+    const uint8_t *m_pMapping;
+    uint64_t m_mapping_size;
+    buffer_stream m_mapping_stream;
+
+    uint64_t m_read_ahead_begin;
+    uint64_t m_read_ahead_end;
+
+    virtual bool open_source_stream();
+
+    void update_read_ahead();
+};
+
 //----------------------------------------------------------------------------------------------------------------------
 // class json_trace_file_reader
 //----------------------------------------------------------------------------------------------------------------------
@@ -499,10 +745,17 @@ private:
     uint32_t m_cur_frame_index;
     uint32_t m_max_frame_index;
 
+    // Each document's packets array is streamed, m_cur_doc only holds its other root members (meta, sof, etc.).
+    json_stream_reader m_packet_stream;
     json_document m_cur_doc;
-    const json_node *m_pPackets_array;
+    bool m_has_document;
+    bool m_read_trailing_members;
+
+    // The packets array is read one node ahead, so is_at_eof() knows when the last packet has been returned.
+    // m_cur_packet_node_index is the index of m_next_packet_node.
+    json_value m_next_packet_node;
+    bool m_has_next_packet_node;
     uint32_t m_cur_packet_node_index;
-    uint32_t m_packet_node_size;
     int m_doc_eof_key_value;
 
     bool m_at_eof;
@@ -523,12 +776,18 @@ private:
 
     dynamic_string compose_frame_filename();
     bool read_document(const dynamic_string &filename);
+    const json_node *find_doc_object(const char *pKey);
+    bool read_next_packet_node();
+    bool seek_to_packet_node(uint32_t index);
     bool open_first_document();
 };
 
 bool vogl_is_multiframe_json_trace_filename(const char *pFilename);
 vogl_trace_file_reader_type_t vogl_determine_trace_file_type(const dynamic_string &orig_filename, dynamic_string &filename_to_use);
-vogl_trace_file_reader *vogl_create_trace_file_reader(vogl_trace_file_reader_type_t trace_type);
-vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dynamic_string &actual_filename, const char *pLoose_file_path);
+// memory_map only affects binary traces, see vogl_mmap_trace_file_reader.
+vogl_trace_file_reader *vogl_create_trace_file_reader(vogl_trace_file_reader_type_t trace_type, bool memory_map = false);
+vogl_trace_file_reader *vogl_open_trace_file(dynamic_string &orig_filename, dynamic_string &actual_filename, const char *pLoose_file_path, bool memory_map = false);
+
+bool trace_file_version_compat_test();
 
 #endif // VOGL_TRACE_FILE_READER_H
@@ -30,6 +30,8 @@
 #include "vogl_console.h"
 #include "vogl_file_utils.h"
 #include "vogl_uuid.h"
+#include "vogl_trace_file_reader.h"
+#include "vogl_rand.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_trace_file_writer
@@ -37,8 +39,13 @@
 vogl_trace_file_writer::vogl_trace_file_writer(const vogl_ctypes *pCTypes)
     : m_gl_call_counter(0),
       m_pCTypes(pCTypes),
+      m_block_codec(cTraceBlockCodecNone),
+      m_pStream(&m_stream),
       m_pTrace_archive(NULL),
-      m_delete_archive(false)
+      m_delete_archive(false),
+      m_client_memory_dedup_threshold(0),
+      m_total_deduped_client_memory_bytes(0),
+      m_total_deduped_client_memory_refs(0)
 {
     VOGL_FUNC_TRACER
 }
@@ -72,6 +79,7 @@ bool vogl_trace_file_writer::open(const char *pFilename, vogl_archive_blob_manag
 
     m_sof_packet.init();
     m_sof_packet.m_pointer_sizes = pointer_sizes;
+    m_sof_packet.m_block_codec = static_cast<uint8_t>(m_block_codec);
     m_sof_packet.m_first_packet_offset = sizeof(m_sof_packet);
 
     md5_hash h(gen_uuid());
@@ -87,6 +95,19 @@ bool vogl_trace_file_writer::open(const char *pFilename, vogl_archive_blob_manag
         return false;
     }
 
+    m_pStream = &m_stream;
+    if (m_block_codec != cTraceBlockCodecNone)
+    {
+        // The packet stream starts right after the SOF packet, so stream offsets match an uncompressed trace.
+        if (!m_block_stream.open(&m_stream, m_block_codec))
+        {
+            vogl_error_printf("%s: Failed initializing trace block compression\n", VOGL_FUNCTION_INFO_CSTR);
+            m_stream.close();
+            return false;
+        }
+        m_pStream = &m_block_stream;
+    }
+
     if (pTrace_archive)
     {
         m_pTrace_archive.reset(pTrace_archive);
@@ -110,7 +131,12 @@ bool vogl_trace_file_writer::open(const char *pFilename, vogl_archive_blob_manag
     // TODO: The trace reader records the first offset right after SOF, I would like to do this after the demarcation packet.
     m_frame_file_offsets.reserve(10000);
     m_frame_file_offsets.resize(0);
-    m_frame_file_offsets.push_back(m_stream.get_ofs());
+    m_call_index.clear();
+
+    m_client_memory_seen.reset();
+    m_total_deduped_client_memory_bytes = 0;
+    m_total_deduped_client_memory_refs = 0;
+    m_frame_file_offsets.push_back(m_pStream->get_ofs());
 
     write_ctypes_packet();
 
@@ -118,7 +144,7 @@ bool vogl_trace_file_writer::open(const char *pFilename, vogl_archive_blob_manag
 
     if (write_demarcation_packet)
     {
-        vogl_write_glInternalTraceCommandRAD(m_stream, m_pCTypes, cITCRDemarcation, 0, NULL);
+        vogl_write_glInternalTraceCommandRAD(*m_pStream, m_pCTypes, cITCRDemarcation, 0, NULL);
     }
 
     vogl_message_printf("%s: Finished opening trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, pFilename);
@@ -146,11 +172,28 @@ bool vogl_trace_file_writer::close()
         vogl_error_printf("%s: Failed writing to trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_filename.get_ptr());
         success = false;
     }
+    else if ((m_pStream == &m_block_stream) && (!m_block_stream.close()))
+    {
+        vogl_error_printf("%s: Failed writing final trace block to trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, m_filename.get_ptr());
+        success = false;
+    }
     else if (m_pTrace_archive.get())
     {
         trace_archive_filename = m_pTrace_archive->get_archive_filename();
 
-        if ((!write_frame_file_offsets_to_archive()) || !m_pTrace_archive->deinit())
+        if (m_total_deduped_client_memory_refs)
+        {
+            vogl_message_printf("%s: Deduplicated %u client memory payloads (%" PRIu64 " bytes) into the trace archive\n", VOGL_FUNCTION_INFO_CSTR,
+                                m_total_deduped_client_memory_refs, m_total_deduped_client_memory_bytes);
+        }
+
+        if (m_pStream == &m_block_stream)
+        {
+            vogl_message_printf("%s: Compressed %" PRIu64 " bytes of trace packets to %" PRIu64 " bytes in %u blocks\n", VOGL_FUNCTION_INFO_CSTR,
+                                m_block_stream.get_size() - m_sof_packet.m_first_packet_offset, m_block_stream.get_total_compressed_bytes(), m_block_stream.get_block_index().size());
+        }
+
+        if ((!write_frame_file_offsets_to_archive()) || (!write_block_index_to_archive()) || (!write_call_index_to_archive()) || !m_pTrace_archive->deinit())
         {
             vogl_error_printf("%s: Failed closing trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, trace_archive_filename.get_ptr());
             success = false;
@@ -193,6 +236,9 @@ bool vogl_trace_file_writer::close()
 
     close_archive(trace_archive_filename.get_ptr());
 
+    m_block_stream.close();
+    m_pStream = &m_stream;
+
     uint64_t total_trace_file_size = m_stream.get_size();
 
     if (!m_stream.close())
@@ -212,6 +258,164 @@ bool vogl_trace_file_writer::close()
     return success;
 }
 
+// Serializes the packet directly into the output stream's buffer (only the block stream supports this), which
+// avoids staging it in the packet's own buffer first. Returns false if the caller should use packet.serialize().
+bool vogl_trace_file_writer::write_packet_in_place(const vogl_trace_packet &packet)
+{
+    VOGL_FUNC_TRACER
+
+    uint32_t packet_size = packet.get_serialize_size();
+    if (!packet_size)
+        return false;
+
+    void *pDst = m_pStream->reserve_write(packet_size);
+    if (!pDst)
+        return false;
+
+    if (!packet.serialize_to_buffer(static_cast<uint8_t *>(pDst), packet_size))
+    {
+        m_pStream->commit_write(0);
+        return false;
+    }
+
+    return m_pStream->commit_write(packet_size);
+}
+
+// A payload is only moved into the archive once it's been seen twice, so one-off uploads never pay for archive
+// compression.
+static inline const void *get_client_memory_ptr(const vogl_trace_packet &packet, uint32_t param_index)
+{
+    return (param_index == packet.total_params()) ? packet.get_return_client_memory_ptr() : packet.get_param_client_memory_ptr(param_index);
+}
+
+bool vogl_trace_file_writer::serialize_packet_dedup(const vogl_trace_packet &packet, vogl::mutex *pArchive_mutex)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_trace_packet::client_memory_ref_vec refs;
+
+    const uint32_t threshold = m_client_memory_dedup_threshold;
+    if (!threshold)
+        return packet.serialize_to_packet_buf(&refs);
+
+    // Hash the payloads first, no lock needed.
+    const uint32_t total_params = packet.total_params() + packet.has_return_value();
+    for (uint32_t param_index = 0; param_index < total_params; param_index++)
+    {
+        const bool is_return = (param_index == packet.total_params());
+        if (is_return ? !packet.has_return_client_memory() : !packet.has_param_client_memory(param_index))
+            continue;
+
+        uint32_t data_size = is_return ? packet.get_return_client_memory_data_size() : packet.get_param_client_memory_data_size(param_index);
+        if (data_size < threshold)
+            continue;
+
+        const void *pData = get_client_memory_ptr(packet, param_index);
+
+        vogl_trace_packet::client_memory_ref ref;
+        ref.m_param_index = param_index;
+        ref.m_data_size = data_size;
+        ref.m_crc64 = calc_crc64(CRC64_INIT, static_cast<const uint8_t *>(pData), data_size);
+        refs.push_back(ref);
+    }
+
+    // Payloads seen for the second time which need to be added to the archive.
+    vogl::vector<uint32_t> refs_to_add;
+
+    if (pArchive_mutex)
+        pArchive_mutex->lock();
+
+    vogl_archive_blob_manager *pArchive = m_pTrace_archive.get();
+    if ((pArchive) && (pArchive->is_initialized()))
+    {
+        uint32_t num_refs = 0;
+        for (uint32_t i = 0; i < refs.size(); i++)
+        {
+            const vogl_trace_packet::client_memory_ref &ref = refs[i];
+
+            if (!pArchive->does_exist(vogl_trace_packet::get_client_memory_ref_blob_id(*pArchive, ref.m_crc64, ref.m_data_size)))
+            {
+                // First time this payload has been seen - just remember it and write it inline.
+                vogl::hash_map<uint64_t, uint32_t>::insert_result res(m_client_memory_seen.insert(ref.m_crc64, ref.m_data_size));
+                if ((res.second) || (res.first->second != ref.m_data_size))
+                {
+                    res.first->second = ref.m_data_size;
+                    continue;
+                }
+
+                refs_to_add.push_back(num_refs);
+            }
+
+            refs[num_refs++] = ref;
+        }
+        refs.resize(num_refs);
+    }
+    else
+    {
+        refs.resize(0);
+    }
+
+    if (pArchive_mutex)
+        pArchive_mutex->unlock();
+
+    if (refs.size())
+    {
+        // Compress the new blobs outside of the lock.
+        vogl::vector<uint8_vec> comp_data(refs_to_add.size());
+        vogl::vector<uint32_t> crc32s(refs_to_add.size());
+        for (uint32_t i = 0; i < refs_to_add.size(); i++)
+        {
+            const vogl_trace_packet::client_memory_ref &ref = refs[refs_to_add[i]];
+            vogl_archive_blob_manager::compress_buf(get_client_memory_ptr(packet, ref.m_param_index), ref.m_data_size, comp_data[i], crc32s[i]);
+        }
+
+        if (pArchive_mutex)
+            pArchive_mutex->lock();
+
+        // The archive may have been closed while we weren't holding the lock.
+        pArchive = m_pTrace_archive.get();
+        if ((!pArchive) || (!pArchive->is_initialized()))
+            refs.resize(0);
+
+        for (uint32_t i = 0; (i < refs_to_add.size()) && (refs.size()); i++)
+        {
+            vogl_trace_packet::client_memory_ref &ref = refs[refs_to_add[i]];
+
+            // Another thread may have added the same payload while we were compressing.
+            dynamic_string id(vogl_trace_packet::get_client_memory_ref_blob_id(*pArchive, ref.m_crc64, ref.m_data_size));
+            if ((!pArchive->does_exist(id)) &&
+                (pArchive->add_compressed_buf_using_id(get_client_memory_ptr(packet, ref.m_param_index), ref.m_data_size, comp_data[i], crc32s[i], id).is_empty()))
+            {
+                vogl_warning_printf("%s: Failed adding client memory blob \"%s\" to trace archive\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+
+                // Leave it inline.
+                ref.m_data_size = 0;
+                continue;
+            }
+
+            m_client_memory_seen.erase(ref.m_crc64);
+        }
+
+        uint32_t num_refs = 0;
+        for (uint32_t i = 0; i < refs.size(); i++)
+        {
+            if (!refs[i].m_data_size)
+                continue;
+
+            m_total_deduped_client_memory_bytes += refs[i].m_data_size;
+            m_total_deduped_client_memory_refs++;
+
+            refs[num_refs++] = refs[i];
+        }
+        refs.resize(num_refs);
+
+        if (pArchive_mutex)
+            pArchive_mutex->unlock();
+    }
+
+    return packet.serialize_to_packet_buf(&refs);
+}
+
 void vogl_trace_file_writer::write_ctypes_packet()
 {
     VOGL_FUNC_TRACER
@@ -233,7 +437,7 @@ void vogl_trace_file_writer::write_ctypes_packet()
         typemap_key_values.insert(base_index++, desc.m_is_pointer_diff);
         typemap_key_values.insert(base_index++, desc.m_is_opaque_type);
     }
-    vogl_write_glInternalTraceCommandRAD(m_stream, m_pCTypes, cITCRKeyValueMap, sizeof(typemap_key_values), reinterpret_cast<const GLubyte *>(&typemap_key_values));
+    vogl_write_glInternalTraceCommandRAD(*m_pStream, m_pCTypes, cITCRKeyValueMap, sizeof(typemap_key_values), reinterpret_cast<const GLubyte *>(&typemap_key_values));
 }
 
 void vogl_trace_file_writer::write_entrypoints_packet()
@@ -249,7 +453,7 @@ void vogl_trace_file_writer::write_entrypoints_packet()
         entrypoint_key_values.insert(func_iter, desc.m_pName);
     }
 
-    vogl_write_glInternalTraceCommandRAD(m_stream, m_pCTypes, cITCRKeyValueMap, sizeof(entrypoint_key_values), reinterpret_cast<const GLubyte *>(&entrypoint_key_values));
+    vogl_write_glInternalTraceCommandRAD(*m_pStream, m_pCTypes, cITCRKeyValueMap, sizeof(entrypoint_key_values), reinterpret_cast<const GLubyte *>(&entrypoint_key_values));
 }
 
 bool vogl_trace_file_writer::write_eof_packet()
@@ -259,7 +463,7 @@ bool vogl_trace_file_writer::write_eof_packet()
     vogl_trace_stream_packet_base eof_packet;
     eof_packet.init(cTSPTEOF, sizeof(vogl_trace_stream_packet_base));
     eof_packet.finalize();
-    return m_stream.write(&eof_packet, sizeof(eof_packet));
+    return m_pStream->write(&eof_packet, sizeof(eof_packet)) == sizeof(eof_packet);
 }
 
 bool vogl_trace_file_writer::write_frame_file_offsets_to_archive()
@@ -275,6 +479,41 @@ bool vogl_trace_file_writer::write_frame_file_offsets_to_archive()
     return m_pTrace_archive->add_buf_using_id(m_frame_file_offsets.get_ptr(), m_frame_file_offsets.size_in_bytes(), VOGL_TRACE_ARCHIVE_FRAME_FILE_OFFSETS_FILENAME).has_content();
 }
 
+bool vogl_trace_file_writer::write_block_index_to_archive()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pTrace_archive.get())
+        return false;
+
+    const vogl_trace_block_index &block_index = m_block_stream.get_block_index();
+    if ((m_sof_packet.m_block_codec == cTraceBlockCodecNone) || (block_index.is_empty()))
+        return true;
+
+    return m_pTrace_archive->add_buf_using_id(block_index.get_ptr(), block_index.size_in_bytes(), VOGL_TRACE_ARCHIVE_BLOCK_INDEX_FILENAME).has_content();
+}
+
+bool vogl_trace_file_writer::write_call_index_to_archive()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pTrace_archive.get())
+        return false;
+
+    if (!m_call_index.get_total_calls())
+        return true;
+
+    uint8_vec call_index_data;
+    m_call_index.serialize(call_index_data, m_sof_packet.m_uuid);
+
+    vogl_message_printf("%s: Wrote %s byte call index for %s calls\n", VOGL_FUNCTION_INFO_CSTR,
+                        uint64_to_string_with_commas(call_index_data.size()).get_ptr(), uint64_to_string_with_commas(m_call_index.get_total_calls()).get_ptr());
+
+    m_call_index.clear();
+
+    return m_pTrace_archive->add_buf_using_id(call_index_data.get_ptr(), call_index_data.size(), VOGL_TRACE_ARCHIVE_CALL_INDEX_FILENAME).has_content();
+}
+
 void vogl_trace_file_writer::close_archive(const char *pArchive_filename)
 {
     VOGL_FUNC_TRACER
@@ -290,3 +529,138 @@ void vogl_trace_file_writer::close_archive(const char *pArchive_filename)
     }
     m_delete_archive = false;
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+// client_memory_dedup_test
+// Writes a trace with repeated large buffer uploads and checks that reading it back gives the original packets.
+//----------------------------------------------------------------------------------------------------------------------
+static bool client_memory_dedup_test_make_packet(vogl_trace_packet &packet, uint64_t call_counter, const uint8_vec &data, bool add_key_value)
+{
+    GLenum target = GL_ARRAY_BUFFER;
+    GLsizeiptr size = data.size();
+    GLenum usage = GL_STATIC_DRAW;
+    const void *pData = data.get_ptr();
+
+    // Built in a fresh packet and round tripped, so unused param bytes can't differ between packets.
+    vogl_trace_packet temp_packet(packet.get_ctypes());
+    temp_packet.begin_construction(VOGL_ENTRYPOINT_glBufferData, 1, call_counter, 1, 0);
+    temp_packet.set_param(0, VOGL_GLENUM, &target, sizeof(target));
+    temp_packet.set_param(1, VOGL_GLSIZEIPTR, &size, sizeof(size));
+    temp_packet.set_param(2, VOGL_CONST_GLVOID_PTR, &pData, sizeof(pData));
+    temp_packet.set_array_client_memory(2, VOGL_GLUBYTE, data.size(), pData, data.size());
+    temp_packet.set_param(3, VOGL_GLENUM, &usage, sizeof(usage));
+    if (add_key_value)
+        temp_packet.set_key_value("width", static_cast<int>(call_counter));
+    temp_packet.end_construction(0);
+
+    return temp_packet.serialize_to_packet_buf() && packet.deserialize(temp_packet.get_packet_buf(), false);
+}
+
+bool client_memory_dedup_test()
+{
+    const uint32_t cThreshold = 64 * 1024;
+
+    vogl::random rm;
+    rm.seed(4);
+
+    // Two compressible payloads, one which won't compress, and one under the threshold.
+    vogl::vector<uint8_vec> payloads(4);
+    payloads[0].resize(300000);
+    payloads[1].resize(cThreshold);
+    payloads[2].resize(100000);
+    payloads[3].resize(cThreshold - 1);
+    for (uint32_t p = 0; p < payloads.size(); p++)
+        for (uint32_t i = 0; i < payloads[p].size(); i++)
+            payloads[p][i] = (p == 2) ? rm.urand8() : static_cast<uint8_t>((i * (p + 3)) ^ (i >> 8));
+
+    const uint32_t cTotalPackets = 40;
+    uint64_t total_payload_bytes = 0;
+
+    dynamic_string filename(file_utils::generate_temp_filename("vogl_dedup_test"));
+
+    vogl_ctypes ctypes;
+    ctypes.init(sizeof(void *));
+
+    vogl_trace_file_writer writer(&ctypes);
+    writer.set_client_memory_dedup_threshold(cThreshold);
+    if (!writer.open(filename.get_ptr()))
+        return false;
+
+    bool success = true;
+
+    vogl_trace_packet packet(&ctypes);
+    vogl::mutex archive_mutex;
+    for (uint32_t i = 0; (i < cTotalPackets) && (success); i++)
+    {
+        const uint8_vec &data = payloads[i % payloads.size()];
+        success = client_memory_dedup_test_make_packet(packet, i, data, (i % 3) == 0);
+        total_payload_bytes += data.size();
+
+        // Deduplicate half the packets the way the async writer does, with the lock only held around archive updates.
+        if (i & 1)
+        {
+            vogl_trace_packet check_packet(&ctypes);
+            success = writer.serialize_packet_dedup(packet, &archive_mutex) &&
+                      check_packet.deserialize(packet.get_packet_buf(), true, writer.get_trace_archive()) &&
+                      check_packet.compare(packet, false);
+        }
+
+        success = success && writer.write_packet(packet);
+    }
+
+    success = writer.close() && success;
+
+    uint64_t file_size = 0;
+    if ((success) && ((!file_utils::get_file_size(filename.get_ptr(), file_size)) || (file_size >= total_payload_bytes / 2)))
+    {
+        vogl_error_printf("%s: Trace is %" PRIu64 " bytes, expected far less than %" PRIu64 " payload bytes\n", VOGL_FUNCTION_INFO_CSTR, file_size, total_payload_bytes);
+        success = false;
+    }
+
+    vogl_unique_ptr<vogl_trace_file_reader> pReader(vogl_create_trace_file_reader(cBINARY_TRACE_FILE_READER));
+    if ((success) && (!pReader->open(filename.get_ptr(), NULL)))
+        success = false;
+
+    uint32_t total_packets_read = 0;
+    vogl_trace_packet expected_packet(&ctypes);
+    while (success)
+    {
+        if (pReader->read_next_packet() != vogl_trace_file_reader::cOK)
+        {
+            success = false;
+            break;
+        }
+
+        if (pReader->get_packet_type() == cTSPTEOF)
+            break;
+        if (pReader->get_packet_type() != cTSPTGLEntrypoint)
+            continue;
+
+        if ((!packet.deserialize(pReader->get_packet_ptr(), pReader->get_packet_size(), true)) || (packet.has_client_memory_refs()))
+        {
+            success = false;
+            break;
+        }
+
+        // Skip the writer's demarcation packet.
+        if (packet.get_entrypoint_id() != VOGL_ENTRYPOINT_glBufferData)
+            continue;
+
+        uint32_t i = static_cast<uint32_t>(packet.get_call_counter());
+        if ((i != total_packets_read) ||
+            (!client_memory_dedup_test_make_packet(expected_packet, i, payloads[i % payloads.size()], (i % 3) == 0)) ||
+            (!packet.compare(expected_packet, false)))
+        {
+            vogl_error_printf("%s: Packet %u didn't survive the round trip\n", VOGL_FUNCTION_INFO_CSTR, total_packets_read);
+            success = false;
+            break;
+        }
+
+        total_packets_read++;
+    }
+
+    pReader.reset();
+    file_utils::delete_file(filename.get_ptr());
+
+    return success && (total_packets_read == cTotalPackets);
+}
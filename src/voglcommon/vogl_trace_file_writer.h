@@ -32,10 +32,13 @@
 #include "vogl_common.h"
 #include "vogl_trace_stream_types.h"
 #include "vogl_trace_packet.h"
+#include "vogl_trace_block_stream.h"
+#include "vogl_trace_call_index.h"
 #include "vogl_cfile_stream.h"
 #include "vogl_dynamic_stream.h"
 #include "vogl_json.h"
 #include "vogl_unique_ptr.h"
+#include "vogl_hash_map.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_trace_file_writer
@@ -55,11 +58,45 @@ public:
         return m_filename;
     }
 
+    // Packet stream - when block compression is enabled, this isn't the file stream.
     inline data_stream &get_stream()
     {
-        return m_stream;
+        return *m_pStream;
     }
 
+    // Takes effect on the next open(). cTraceBlockCodecNone (the default) writes packets directly to the file.
+    inline void set_block_codec(vogl_trace_block_codec_t codec)
+    {
+        m_block_codec = codec;
+    }
+    inline vogl_trace_block_codec_t get_block_codec() const
+    {
+        return m_block_codec;
+    }
+
+    // Client memory payloads of at least min_size bytes are deduplicated: the second time a payload is seen it's
+    // stored in the trace archive, and from then on packets only hold a reference to it. 0 (the default) disables.
+    inline void set_client_memory_dedup_threshold(uint32_t min_size)
+    {
+        m_client_memory_dedup_threshold = min_size;
+    }
+    inline uint32_t get_client_memory_dedup_threshold() const
+    {
+        return m_client_memory_dedup_threshold;
+    }
+
+    // Cheap check for whether serialize_packet_dedup() could do anything with this packet.
+    inline bool should_dedup_packet(const vogl_trace_packet &packet) const
+    {
+        return (m_client_memory_dedup_threshold) && (packet.get_total_client_memory_size() >= m_client_memory_dedup_threshold);
+    }
+
+    // Serializes packet into its internal packet buffer, deduplicating its large client memory payloads. If
+    // pArchive_mutex is NULL this must be called under the same lock as write_packet(), otherwise pArchive_mutex must
+    // be that lock: it's only held while the archive and the dedup table are touched, so hashing and compressing the
+    // payloads doesn't block other threads.
+    bool serialize_packet_dedup(const vogl_trace_packet &packet, vogl::mutex *pArchive_mutex = NULL);
+
     inline vogl_archive_blob_manager *get_trace_archive()
     {
         return m_pTrace_archive.get();
@@ -96,11 +133,30 @@ public:
         if (!m_stream.is_opened())
             return false;
 
-        if (!packet.serialize(m_stream))
-            return false;
+        uint64_t packet_ofs = m_pStream->get_ofs();
+
+        if (should_dedup_packet(packet))
+        {
+            if (!serialize_packet_dedup(packet))
+                return false;
+
+            const uint8_vec &packet_buf = packet.get_packet_buf();
+            if (m_pStream->write(packet_buf.get_ptr(), packet_buf.size()) != packet_buf.size())
+                return false;
+        }
+        else if (!write_packet_in_place(packet))
+        {
+            if (!packet.serialize(*m_pStream))
+                return false;
+        }
+
+        m_call_index.add_call(packet.get_call_counter(), packet_ofs, packet.get_entrypoint_id());
 
         if (vogl_is_swap_buffers_entrypoint(packet.get_entrypoint_id()))
-            m_frame_file_offsets.push_back(m_stream.get_ofs());
+        {
+            m_frame_file_offsets.push_back(m_pStream->get_ofs());
+            m_call_index.end_frame();
+        }
 
         return true;
     }
@@ -112,11 +168,20 @@ public:
         if (!m_stream.is_opened())
             return false;
 
-        if (m_stream.write(pPacket, packet_size) != packet_size)
+        uint64_t packet_ofs = m_pStream->get_ofs();
+
+        if (m_pStream->write(pPacket, packet_size) != packet_size)
             return false;
 
+        const vogl_trace_gl_entrypoint_packet *pGL_packet = static_cast<const vogl_trace_gl_entrypoint_packet *>(pPacket);
+        if ((packet_size >= sizeof(vogl_trace_gl_entrypoint_packet)) && (pGL_packet->m_type == cTSPTGLEntrypoint))
+            m_call_index.add_call(pGL_packet->m_call_counter, packet_ofs, static_cast<gl_entrypoint_id_t>(pGL_packet->m_entrypoint_id));
+
         if (is_swap)
-            m_frame_file_offsets.push_back(m_stream.get_ofs());
+        {
+            m_frame_file_offsets.push_back(m_pStream->get_ofs());
+            m_call_index.end_frame();
+        }
 
         return true;
     }
@@ -125,7 +190,7 @@ public:
     {
         VOGL_FUNC_TRACER
 
-        return m_stream.flush();
+        return m_pStream->flush();
     }
 
     bool close();
@@ -137,12 +202,26 @@ private:
     dynamic_string m_filename;
     cfile_stream m_stream;
 
+    vogl_trace_block_codec_t m_block_codec;
+    vogl_trace_block_writer_stream m_block_stream;
+    // Either m_stream or m_block_stream
+    data_stream *m_pStream;
+
     vogl_unique_ptr<vogl_archive_blob_manager> m_pTrace_archive;
     bool m_delete_archive;
 
     vogl_trace_stream_start_of_file_packet m_sof_packet;
 
     vogl::vector<uint64_t> m_frame_file_offsets;
+    vogl_trace_call_index_builder m_call_index;
+
+    uint32_t m_client_memory_dedup_threshold;
+    // CRC64 of each large payload seen once so far -> its size
+    vogl::hash_map<uint64_t, uint32_t> m_client_memory_seen;
+    uint64_t m_total_deduped_client_memory_bytes;
+    uint32_t m_total_deduped_client_memory_refs;
+
+    bool write_packet_in_place(const vogl_trace_packet &packet);
 
     void write_ctypes_packet();
 
@@ -152,7 +231,13 @@ private:
 
     bool write_frame_file_offsets_to_archive();
 
+    bool write_block_index_to_archive();
+
+    bool write_call_index_to_archive();
+
     void close_archive(const char *pArchive_filename);
 };
 
+bool client_memory_dedup_test();
+
 #endif // VOGL_TRACE_FILE_WRITER_H
@@ -246,7 +246,7 @@ bool vogl_trace_packet::check() const
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_trace_packet::deserialize
 //----------------------------------------------------------------------------------------------------------------------
-bool vogl_trace_packet::deserialize(const uint8_t *pPacket_data, uint32_t packet_data_buf_size, bool check_crc)
+bool vogl_trace_packet::deserialize(const uint8_t *pPacket_data, uint32_t packet_data_buf_size, bool check_crc, const vogl_blob_manager *pClient_memory_blob_manager)
 {
     VOGL_FUNC_TRACER
 
@@ -356,6 +356,12 @@ bool vogl_trace_packet::deserialize(const uint8_t *pPacket_data, uint32_t packet
     if (num_bytes_remaining)
         return false;
 
+    if ((pClient_memory_blob_manager) && (m_packet.m_name_value_map_size) && (has_client_memory_refs()))
+    {
+        if (!resolve_client_memory_refs(pClient_memory_blob_manager))
+            return false;
+    }
+
     m_is_valid = true;
 
     VOGL_ASSERT(check());
@@ -366,11 +372,74 @@ bool vogl_trace_packet::deserialize(const uint8_t *pPacket_data, uint32_t packet
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_trace_packet::deserialize
 //----------------------------------------------------------------------------------------------------------------------
-bool vogl_trace_packet::deserialize(const uint8_vec &packet_buf, bool check_crc)
+bool vogl_trace_packet::deserialize(const uint8_vec &packet_buf, bool check_crc, const vogl_blob_manager *pClient_memory_blob_manager)
 {
     VOGL_FUNC_TRACER
 
-    return deserialize(packet_buf.get_ptr(), packet_buf.size(), check_crc);
+    return deserialize(packet_buf.get_ptr(), packet_buf.size(), check_crc, pClient_memory_blob_manager);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::get_client_memory_ref_blob_id
+//----------------------------------------------------------------------------------------------------------------------
+dynamic_string vogl_trace_packet::get_client_memory_ref_blob_id(const vogl_blob_manager &blob_manager, uint64_t crc64, uint32_t data_size)
+{
+    VOGL_FUNC_TRACER
+
+    return blob_manager.compute_unique_id(NULL, data_size, "client_memory", "", &crc64);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::resolve_client_memory_refs
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet::resolve_client_memory_refs(const vogl_blob_manager *pBlob_manager)
+{
+    VOGL_FUNC_TRACER
+
+    const uint8_vec *pRefs_blob = m_key_value_map.get_blob(string_hash("client_memory_refs"));
+    if ((!pRefs_blob) || (pRefs_blob->size() % sizeof(client_memory_ref)))
+    {
+        vogl_error_printf("%s: Invalid client memory references in packet\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    if ((!pBlob_manager) || (!pBlob_manager->is_initialized()))
+    {
+        vogl_error_printf("%s: Packet references deduplicated client memory, but no trace archive is available to resolve it\n", VOGL_FUNCTION_INFO_CSTR);
+        return false;
+    }
+
+    const uint32_t total_refs = pRefs_blob->size() / sizeof(client_memory_ref);
+    const uint32_t total_params = m_total_params + m_has_return_value;
+
+    uint8_vec data;
+    for (uint32_t i = 0; i < total_refs; i++)
+    {
+        client_memory_ref ref;
+        memcpy(&ref, pRefs_blob->get_ptr() + i * sizeof(client_memory_ref), sizeof(ref));
+
+        if ((ref.m_param_index >= total_params) || (m_client_memory_descs[ref.m_param_index].m_vec_ofs >= 0))
+        {
+            vogl_error_printf("%s: Invalid client memory reference to param %u\n", VOGL_FUNCTION_INFO_CSTR, ref.m_param_index);
+            return false;
+        }
+
+        dynamic_string id(get_client_memory_ref_blob_id(*pBlob_manager, ref.m_crc64, ref.m_data_size));
+        if ((!pBlob_manager->get(id, data)) || (data.size() != ref.m_data_size))
+        {
+            vogl_error_printf("%s: Failed reading client memory blob \"%s\" from trace archive\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+            return false;
+        }
+
+        client_memory_desc_t &desc = m_client_memory_descs[ref.m_param_index];
+        desc.m_vec_ofs = m_client_memory.size();
+        desc.m_data_size = data.size();
+        m_client_memory.append(data);
+    }
+
+    m_key_value_map.erase(string_hash("client_memory_refs"));
+
+    return true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -380,99 +449,218 @@ bool vogl_trace_packet::serialize(data_stream &stream) const
 {
     VOGL_FUNC_TRACER
 
+    if (!serialize_to_packet_buf())
+        return false;
+
+    uint32_t n = stream.write(m_packet_buf.get_ptr(), m_packet_buf.size());
+    if (n != m_packet_buf.size())
+        return false;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::serialize_to_packet_buf
+// Serializes the packet into the internal packet buffer, which is valid until the packet is modified or serialized again.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet::serialize_to_packet_buf(const client_memory_ref_vec *pClient_memory_refs) const
+{
+    VOGL_FUNC_TRACER
+
     if (!m_is_valid)
         return false;
 
+    uint32_t total_params_to_serialize = m_total_params + m_has_return_value;
+
+    const client_memory_desc_t *pClient_memory_descs = m_client_memory_descs;
+    const uint8_vec *pClient_memory = &m_client_memory;
+    const key_value_map *pKey_value_map = &m_key_value_map;
+
+    // Referenced client memory is left out of the packet and the remaining client memory is compacted.
+    client_memory_desc_t deduped_client_memory_descs[cMaxParams];
+    uint8_vec deduped_client_memory;
+    key_value_map deduped_key_value_map;
+
+    if ((pClient_memory_refs) && (pClient_memory_refs->size()))
+    {
+        memcpy(deduped_client_memory_descs, m_client_memory_descs, sizeof(deduped_client_memory_descs));
+
+        for (uint32_t i = 0; i < pClient_memory_refs->size(); i++)
+        {
+            uint32_t param_index = (*pClient_memory_refs)[i].m_param_index;
+            if (param_index >= total_params_to_serialize)
+                return false;
+            deduped_client_memory_descs[param_index].m_vec_ofs = -1;
+            deduped_client_memory_descs[param_index].m_data_size = 0;
+        }
+
+        for (uint32_t i = 0; i < total_params_to_serialize; i++)
+        {
+            client_memory_desc_t &desc = deduped_client_memory_descs[i];
+            if (desc.m_vec_ofs < 0)
+                continue;
+
+            int32_t new_ofs = deduped_client_memory.size();
+            deduped_client_memory.append(m_client_memory.get_ptr() + desc.m_vec_ofs, desc.m_data_size);
+            desc.m_vec_ofs = new_ofs;
+        }
+
+        deduped_key_value_map = m_key_value_map;
+        deduped_key_value_map.insert(string_hash("client_memory_refs"), value()).first->second.set_blob(reinterpret_cast<const uint8_t *>(pClient_memory_refs->get_ptr()), pClient_memory_refs->size_in_bytes());
+
+        pClient_memory_descs = deduped_client_memory_descs;
+        pClient_memory = &deduped_client_memory;
+        pKey_value_map = &deduped_key_value_map;
+    }
+
+    uint32_t total_packet_size = compute_serialize_size(*pClient_memory, *pKey_value_map);
+    if (!total_packet_size)
+        return false;
+
+    if (!m_packet_buf.try_resize(total_packet_size))
+        return false;
+
+    return serialize_to_buffer(m_packet_buf.get_ptr(), total_packet_size, pClient_memory_descs, *pClient_memory, *pKey_value_map);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::get_serialize_size
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_trace_packet::get_serialize_size() const
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_is_valid)
+        return 0;
+
+    return compute_serialize_size(m_client_memory, m_key_value_map);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::serialize_to_buffer
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet::serialize_to_buffer(uint8_t *pDst, uint32_t dst_size) const
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_is_valid)
+        return false;
+
+    return serialize_to_buffer(pDst, dst_size, m_client_memory_descs, m_client_memory, m_key_value_map);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::compute_serialize_size
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t vogl_trace_packet::compute_serialize_size(const uint8_vec &client_memory, const key_value_map &kvm) const
+{
+    uint32_t total_params_to_serialize = m_total_params + m_has_return_value;
+
+    uint32_t param_size = 0;
+    for (uint32_t i = 0; i < total_params_to_serialize; i++)
+        param_size += m_param_size[i];
+
+    VOGL_VERIFY(param_size <= cUINT8_MAX);
+
+    uint64_t client_memory_size = (total_params_to_serialize * sizeof(client_memory_desc_t)) + client_memory.size();
+
+    uint64_t kvm_serialize_size = kvm.get_num_key_values() ? kvm.get_serialize_size(false) : 0;
+    if (kvm_serialize_size > cUINT32_MAX)
+        return 0;
+
+    uint64_t total_packet_size = sizeof(vogl_trace_gl_entrypoint_packet) + param_size + client_memory_size + kvm_serialize_size;
+    if (total_packet_size > static_cast<uint64_t>(cINT32_MAX))
+        return 0;
+
+    return static_cast<uint32_t>(total_packet_size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet::serialize_to_buffer
+// dst_size must be the size returned by compute_serialize_size(). The packet's CRC is computed as each piece is
+// copied, while it's still in the cache, instead of in a separate pass over the finished packet.
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet::serialize_to_buffer(uint8_t *pDst, uint32_t dst_size, const client_memory_desc_t *pClient_memory_descs, const uint8_vec &client_memory, const key_value_map &kvm) const
+{
     VOGL_ASSERT(m_packet.m_gl_begin_rdtsc <= m_packet.m_gl_end_rdtsc);
     VOGL_ASSERT(m_packet.m_packet_begin_rdtsc <= m_packet.m_packet_end_rdtsc);
 
-    vogl_trace_gl_entrypoint_packet packet(m_packet);
+    if ((!pDst) || (dst_size < sizeof(vogl_trace_gl_entrypoint_packet)))
+        return false;
+
+    vogl_trace_gl_entrypoint_packet *pPacket = reinterpret_cast<vogl_trace_gl_entrypoint_packet *>(pDst);
+    memcpy(pPacket, &m_packet, sizeof(m_packet));
 
-    uint8_t param_data[512];
+    uint8_t *pDst_buf = pDst + sizeof(vogl_trace_gl_entrypoint_packet);
+    const uint8_t *pDst_end = pDst + dst_size;
 
     uint32_t total_params_to_serialize = m_total_params + m_has_return_value;
-    uint8_t *pDst_param_data = param_data;
     for (uint32_t i = 0; i < total_params_to_serialize; i++)
     {
         uint32_t size = m_param_size[i];
         VOGL_ASSERT(size);
-        memcpy(pDst_param_data, &m_param_data[i], size);
-        pDst_param_data += size;
-        VOGL_ASSERT((pDst_param_data - param_data) <= static_cast<long>(sizeof(param_data)));
+        if (size > static_cast<uint32_t>(pDst_end - pDst_buf))
+            return false;
+        memcpy(pDst_buf, &m_param_data[i], size);
+        pDst_buf += size;
     }
 
-    VOGL_VERIFY((pDst_param_data - param_data) <= cUINT8_MAX);
-    packet.m_param_size = static_cast<uint8_t>(pDst_param_data - param_data);
+    VOGL_VERIFY((pDst_buf - pDst - sizeof(vogl_trace_gl_entrypoint_packet)) <= cUINT8_MAX);
+    pPacket->m_param_size = static_cast<uint8_t>(pDst_buf - pDst - sizeof(vogl_trace_gl_entrypoint_packet));
 
     uint32_t client_memory_descs_size = (total_params_to_serialize * sizeof(client_memory_desc_t));
-    packet.m_client_memory_size = client_memory_descs_size + m_client_memory.size();
+    pPacket->m_client_memory_size = client_memory_descs_size + client_memory.size();
 
-    uint64_t kvm_serialize_size = m_key_value_map.get_num_key_values() ? m_key_value_map.get_serialize_size(false) : 0;
-    if (kvm_serialize_size > cUINT32_MAX)
-        return false;
-    packet.m_name_value_map_size = static_cast<uint32_t>(kvm_serialize_size);
-
-    uint64_t total_packet_size = sizeof(vogl_trace_gl_entrypoint_packet) + packet.m_param_size + packet.m_client_memory_size + packet.m_name_value_map_size;
-    if (total_packet_size > static_cast<uint64_t>(cINT32_MAX))
+    uint64_t fixed_size = sizeof(vogl_trace_gl_entrypoint_packet) + pPacket->m_param_size + pPacket->m_client_memory_size;
+    if (fixed_size > dst_size)
         return false;
 
-    packet.m_size = static_cast<uint32_t>(total_packet_size);
-
-    if (!m_packet_buf.try_resize(static_cast<uint32_t>(total_packet_size)))
+    pPacket->m_name_value_map_size = dst_size - static_cast<uint32_t>(fixed_size);
+    if ((pPacket->m_name_value_map_size != 0) != (kvm.get_num_key_values() != 0))
         return false;
 
-    uint8_t *pDst_buf = m_packet_buf.get_ptr();
-
-#define APPEND_TO_DST_BUF(pSrc, n)                                         \
-    do                                                                     \
-    {                                                                      \
-        VOGL_ASSERT((int64_t)n <= (int64_t)(m_packet_buf.end() - pDst_buf)); \
-        memcpy(pDst_buf, pSrc, n);                                         \
-        pDst_buf += n;                                                     \
-    } while (0)
+    pPacket->m_size = dst_size;
+    pPacket->m_inv_rnd = ~pPacket->m_rnd;
 
-    APPEND_TO_DST_BUF(&packet, sizeof(packet));
-
-    if (packet.m_param_size)
+    if (pPacket->m_client_memory_size)
     {
-        APPEND_TO_DST_BUF(param_data, packet.m_param_size);
+        memcpy(pDst_buf, pClient_memory_descs, client_memory_descs_size);
+        pDst_buf += client_memory_descs_size;
     }
 
-    if (packet.m_client_memory_size)
+    const uint32_t crc_start_ofs = static_cast<uint32_t>(VOGL_OFFSETOF(vogl_trace_stream_packet_base, m_rnd));
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, pDst + crc_start_ofs, (pDst_buf - pDst) - crc_start_ofs);
+
+    // Copy and checksum large client memory in chunks which fit in the cache.
+    const uint32_t cChunkSize = 64 * 1024;
+    const uint8_t *pSrc = client_memory.get_ptr();
+    uint32_t bytes_remaining = client_memory.size();
+    while (bytes_remaining)
     {
-        APPEND_TO_DST_BUF(m_client_memory_descs, client_memory_descs_size);
-        APPEND_TO_DST_BUF(m_client_memory.get_ptr(), m_client_memory.size());
+        uint32_t n = math::minimum(bytes_remaining, cChunkSize);
+        memcpy(pDst_buf, pSrc, n);
+        crc = mz_crc32(crc, pDst_buf, n);
+        pDst_buf += n;
+        pSrc += n;
+        bytes_remaining -= n;
     }
 
-    if (m_key_value_map.get_num_key_values())
+    if (pPacket->m_name_value_map_size)
     {
-        if (pDst_buf >= m_packet_buf.end())
-        {
-            VOGL_VERIFY(0);
-            return false;
-        }
-
-        uint32_t buf_remaining = static_cast<uint32_t>(m_packet_buf.end() - pDst_buf);
-        int result = m_key_value_map.serialize_to_buffer(pDst_buf, buf_remaining, true, false);
-        if (result != static_cast<int>(packet.m_name_value_map_size))
+        int result = kvm.serialize_to_buffer(pDst_buf, pPacket->m_name_value_map_size, true, false);
+        if (result != static_cast<int>(pPacket->m_name_value_map_size))
             return false;
 
+        crc = mz_crc32(crc, pDst_buf, result);
         pDst_buf += result;
     }
 
-    if (pDst_buf != m_packet_buf.end())
+    if (pDst_buf != pDst_end)
         return false;
 
-#undef APPEND_TO_DST_BUF
+    pPacket->m_crc = static_cast<uint32_t>(crc);
 
-    vogl_trace_gl_entrypoint_packet *pBuf_packet = reinterpret_cast<vogl_trace_gl_entrypoint_packet *>(m_packet_buf.get_ptr());
-    pBuf_packet->finalize();
-
-    VOGL_ASSERT(pBuf_packet->full_validation(m_packet_buf.size()));
-
-    uint32_t n = stream.write(pBuf_packet, m_packet_buf.size());
-    if (n != m_packet_buf.size())
-        return false;
+    VOGL_ASSERT(pPacket->full_validation(dst_size));
 
     return true;
 }
@@ -183,8 +183,50 @@ public:
     bool serialize(data_stream &stream) const;
     bool serialize(uint8_vec &buf) const;
 
-    bool deserialize(const uint8_t *pPacket_data, uint32_t packet_data_buf_size, bool check_crc);
-    bool deserialize(const uint8_vec &packet_buf, bool check_crc);
+    // Client memory deduplication: a param's (or the return value's) client memory can be written as a reference to a
+    // blob holding the same data in the trace archive. The references are stored in the packet's key value map.
+    struct client_memory_ref
+    {
+        uint32_t m_param_index; // the return value is at index get_total_params()
+        uint32_t m_data_size;
+        uint64_t m_crc64;
+    };
+    typedef vogl::vector<client_memory_ref> client_memory_ref_vec;
+
+    static dynamic_string get_client_memory_ref_blob_id(const vogl_blob_manager &blob_manager, uint64_t crc64, uint32_t data_size);
+
+    inline uint32_t get_total_client_memory_size() const
+    {
+        return m_client_memory.size();
+    }
+
+    // Serializes into an internal buffer owned by this object (valid until the next serialize() or modification).
+    // The client memory of the params in pClient_memory_refs is replaced by references, the packet itself is unchanged.
+    bool serialize_to_packet_buf(const client_memory_ref_vec *pClient_memory_refs = NULL) const;
+    const uint8_vec &get_packet_buf() const
+    {
+        return m_packet_buf;
+    }
+
+    // In-place serialization, so a writer can serialize straight into its own output buffer: reserve
+    // get_serialize_size() bytes, then call serialize_to_buffer() with exactly that many bytes. Returns 0 if the packet
+    // can't be serialized.
+    uint32_t get_serialize_size() const;
+    bool serialize_to_buffer(uint8_t *pDst, uint32_t dst_size) const;
+
+    // If pClient_memory_blob_manager is not NULL, any client memory references are resolved (see
+    // resolve_client_memory_refs()), otherwise they're left in the packet.
+    bool deserialize(const uint8_t *pPacket_data, uint32_t packet_data_buf_size, bool check_crc, const vogl_blob_manager *pClient_memory_blob_manager = NULL);
+    bool deserialize(const uint8_vec &packet_buf, bool check_crc, const vogl_blob_manager *pClient_memory_blob_manager = NULL);
+
+    inline bool has_client_memory_refs() const
+    {
+        return m_key_value_map.get_blob(string_hash("client_memory_refs")) != NULL;
+    }
+
+    // Loads the referenced client memory from the blob manager and removes the references from the key value map, so
+    // the packet looks exactly like it was written without deduplication.
+    bool resolve_client_memory_refs(const vogl_blob_manager *pBlob_manager);
 
     class json_serialize_params
     {
@@ -780,6 +822,9 @@ private:
 
     mutable uint8_vec m_packet_buf;
 
+    uint32_t compute_serialize_size(const uint8_vec &client_memory, const key_value_map &kvm) const;
+    bool serialize_to_buffer(uint8_t *pDst, uint32_t dst_size, const client_memory_desc_t *pClient_memory_descs, const uint8_vec &client_memory, const key_value_map &kvm) const;
+
     bool validate_value_conversion(uint32_t dest_type_size, uint32_t dest_type_loki_type_flags, int param_index) const;
 
     static bool should_always_write_as_blob_file(const char *pFunc_name);
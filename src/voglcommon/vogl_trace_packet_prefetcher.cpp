@@ -0,0 +1,652 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_packet_prefetcher.cpp
+//----------------------------------------------------------------------------------------------------------------------
+#include "vogl_trace_packet_prefetcher.h"
+#include "vogl_console.h"
+#include "vogl_trace_file_writer.h"
+#include "vogl_file_utils.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::vogl_trace_packet_prefetcher
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_packet_prefetcher::vogl_trace_packet_prefetcher()
+    : m_pReader(NULL),
+      m_pCtypes(NULL),
+      m_max_queued_bytes(0),
+      m_pCur_packet(NULL),
+      m_thread_running(false),
+      m_head(0),
+      m_tail(0),
+      m_num_queued(0),
+      m_queued_bytes(0),
+      m_holding_tail(false),
+      m_exit_flag(false),
+      m_reader_waiting(false),
+      m_consumer_waiting(false),
+      m_space_available(0, 1),
+      m_packets_available(0, 1),
+      m_cur_frame(0),
+      m_cur_file_ofs(0),
+      m_total_packets(0),
+      m_total_stalls(0),
+      m_total_stall_ticks(0)
+{
+    VOGL_FUNC_TRACER
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::~vogl_trace_packet_prefetcher
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_packet_prefetcher::~vogl_trace_packet_prefetcher()
+{
+    VOGL_FUNC_TRACER
+
+    deinit();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::init
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet_prefetcher::init(vogl_trace_file_reader *pReader, const vogl_ctypes *pCtypes, uint32_t max_packets, uint32_t max_queued_bytes)
+{
+    VOGL_FUNC_TRACER
+
+    deinit();
+
+    if ((!pReader) || (!pCtypes))
+        return false;
+
+    m_pReader = pReader;
+    m_pCtypes = pCtypes;
+    m_max_queued_bytes = max_queued_bytes;
+
+    if (max_packets)
+    {
+        if (!m_thread_pool.init(1))
+        {
+            vogl_warning_printf("%s: Failed creating read ahead thread, reading packets on the replay thread\n", VOGL_FUNCTION_INFO_CSTR);
+            max_packets = 0;
+        }
+    }
+
+    // One extra packet for the one the caller is holding.
+    m_packets.resize(max_packets + 1);
+    for (uint32_t i = 0; i < m_packets.size(); i++)
+        m_packets[i] = vogl_new(queued_packet, m_pCtypes);
+
+    m_pCur_packet = m_packets[0];
+
+    m_cur_frame = m_pReader->get_cur_frame();
+    m_cur_file_ofs = (m_pReader->get_type() == cBINARY_TRACE_FILE_READER) ? static_cast<vogl_binary_trace_file_reader *>(m_pReader)->get_cur_file_ofs() : 0;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::deinit
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::deinit()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pReader)
+        return;
+
+    pause();
+    m_thread_pool.deinit();
+
+    discard_queued_packets();
+
+    for (uint32_t i = 0; i < m_packets.size(); i++)
+        vogl_delete(m_packets[i]);
+    m_packets.clear();
+
+    m_pCur_packet = NULL;
+    m_pReader = NULL;
+    m_pCtypes = NULL;
+    m_max_queued_bytes = 0;
+    m_cur_frame = 0;
+    m_cur_file_ofs = 0;
+    m_total_packets = 0;
+    m_total_stalls = 0;
+    m_total_stall_ticks = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::read_packet
+// Reads and deserializes the reader's next packet. Called on the read ahead thread, or the caller's thread if there
+// isn't one.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::read_packet(queued_packet &packet)
+{
+    VOGL_FUNC_TRACER
+
+    packet.m_gl_packet.reset();
+
+    packet.m_read_status = m_pReader->read_next_packet();
+    packet.m_packet_type = (packet.m_read_status == vogl_trace_file_reader::cOK) ? m_pReader->get_packet_type() : cTSPTEOF;
+    packet.m_packet_size = (packet.m_read_status == vogl_trace_file_reader::cOK) ? m_pReader->get_packet_size() : 0;
+    packet.m_cur_frame = m_pReader->get_cur_frame();
+    packet.m_cur_file_ofs = (m_pReader->get_type() == cBINARY_TRACE_FILE_READER) ? static_cast<vogl_binary_trace_file_reader *>(m_pReader)->get_cur_file_ofs() : 0;
+
+    // The replayer reports a failure if the packet isn't valid afterwards.
+    if (packet.m_packet_type == cTSPTGLEntrypoint)
+        packet.m_gl_packet.deserialize(m_pReader->get_packet_ptr(), m_pReader->get_packet_size(), false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::read_ahead_thread_func
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::read_ahead_thread_func(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_NOTE_UNUSED(data);
+    VOGL_NOTE_UNUSED(pData_ptr);
+
+    for (;;)
+    {
+        m_mutex.lock();
+
+        // Always allow at least one packet past the one the caller is holding, even if it's over the byte budget.
+        while ((!m_exit_flag) && ((m_num_queued == m_packets.size()) || ((m_queued_bytes >= m_max_queued_bytes) && (m_num_queued > 1))))
+        {
+            m_reader_waiting = true;
+            m_mutex.unlock();
+
+            m_space_available.wait();
+
+            m_mutex.lock();
+        }
+
+        if (m_exit_flag)
+        {
+            m_mutex.unlock();
+            break;
+        }
+
+        queued_packet &packet = *m_packets[m_head];
+
+        m_mutex.unlock();
+
+        read_packet(packet);
+
+        m_mutex.lock();
+
+        m_head = (m_head + 1) % m_packets.size();
+        m_num_queued++;
+        m_queued_bytes += packet.m_packet_size;
+
+        if (m_consumer_waiting)
+        {
+            m_consumer_waiting = false;
+            m_packets_available.release();
+        }
+
+        m_mutex.unlock();
+
+        // Don't read past the end of the trace (or a bad packet) until the caller gets there and asks for more.
+        if ((packet.m_read_status != vogl_trace_file_reader::cOK) || (packet.m_packet_type == cTSPTEOF))
+            break;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::start_thread
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::start_thread()
+{
+    VOGL_FUNC_TRACER
+
+    m_exit_flag = false;
+    m_thread_running = true;
+
+    // The previous task has always been joined by now, so this can't run out of task slots.
+    VOGL_VERIFY(m_thread_pool.queue_object_task(this, &vogl_trace_packet_prefetcher::read_ahead_thread_func));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::pause
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::pause()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_thread_running)
+        return;
+
+    {
+        scoped_mutex lock(m_mutex);
+
+        m_exit_flag = true;
+
+        if (m_reader_waiting)
+        {
+            m_reader_waiting = false;
+            m_space_available.release();
+        }
+    }
+
+    m_thread_pool.join();
+
+    m_thread_running = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::discard_queued_packets
+// The read ahead thread must not be running.
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::discard_queued_packets()
+{
+    VOGL_FUNC_TRACER
+
+    VOGL_ASSERT(!m_thread_running);
+
+    m_head = 0;
+    m_tail = 0;
+    m_num_queued = 0;
+    m_queued_bytes = 0;
+    m_holding_tail = false;
+
+    if (m_packets.size())
+        m_pCur_packet = m_packets[0];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::read_next_packet
+//----------------------------------------------------------------------------------------------------------------------
+vogl_trace_file_reader::trace_file_reader_status_t vogl_trace_packet_prefetcher::read_next_packet()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pReader)
+        return vogl_trace_file_reader::cFailed;
+
+    if (!is_async())
+    {
+        read_packet(*m_pCur_packet);
+    }
+    else
+    {
+        m_mutex.lock();
+
+        if (m_holding_tail)
+        {
+            m_queued_bytes -= m_packets[m_tail]->m_packet_size;
+            m_num_queued--;
+            m_tail = (m_tail + 1) % m_packets.size();
+            m_holding_tail = false;
+
+            if (m_reader_waiting)
+            {
+                m_reader_waiting = false;
+                m_space_available.release();
+            }
+        }
+
+        if ((!m_num_queued) && (!m_thread_running))
+        {
+            m_mutex.unlock();
+            start_thread();
+            m_mutex.lock();
+        }
+
+        if (!m_num_queued)
+        {
+            timer_ticks stall_start_ticks = timer::get_ticks();
+
+            do
+            {
+                m_consumer_waiting = true;
+                m_mutex.unlock();
+
+                m_packets_available.wait();
+
+                m_mutex.lock();
+            } while (!m_num_queued);
+
+            m_total_stalls++;
+            m_total_stall_ticks += timer::get_ticks() - stall_start_ticks;
+        }
+
+        m_holding_tail = true;
+        m_pCur_packet = m_packets[m_tail];
+
+        m_mutex.unlock();
+
+        // The thread stops by itself after queueing a packet like this, so this doesn't block.
+        if ((m_pCur_packet->m_read_status != vogl_trace_file_reader::cOK) || (m_pCur_packet->m_packet_type == cTSPTEOF))
+            pause();
+    }
+
+    m_total_packets++;
+
+    m_cur_frame = m_pCur_packet->m_cur_frame;
+    m_cur_file_ofs = m_pCur_packet->m_cur_file_ofs;
+
+    return m_pCur_packet->m_read_status;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::seek_to_frame
+//----------------------------------------------------------------------------------------------------------------------
+bool vogl_trace_packet_prefetcher::seek_to_frame(uint32_t frame_index)
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pReader)
+        return false;
+
+    pause();
+    discard_queued_packets();
+
+    bool success = m_pReader->seek_to_frame(frame_index);
+
+    m_cur_frame = m_pReader->get_cur_frame();
+    m_cur_file_ofs = (m_pReader->get_type() == cBINARY_TRACE_FILE_READER) ? static_cast<vogl_binary_trace_file_reader *>(m_pReader)->get_cur_file_ofs() : 0;
+
+    return success;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::get_max_frame_index
+//----------------------------------------------------------------------------------------------------------------------
+int64_t vogl_trace_packet_prefetcher::get_max_frame_index()
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pReader)
+        return -1;
+
+    pause();
+
+    return m_pReader->get_max_frame_index();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher::dump_stats
+//----------------------------------------------------------------------------------------------------------------------
+void vogl_trace_packet_prefetcher::dump_stats() const
+{
+    VOGL_FUNC_TRACER
+
+    if (!m_pReader)
+        return;
+
+    if (!is_async())
+    {
+        vogl_message_printf("Packet read ahead: disabled, %" PRIu64 " packets read on the replay thread\n", m_total_packets);
+        return;
+    }
+
+    vogl_message_printf("Packet read ahead: %" PRIu64 " packets, queue size %u packets/%u bytes, replay thread waited %" PRIu64 " times (%.3f ms total)\n",
+                        m_total_packets, m_packets.size() - 1, m_max_queued_bytes, m_total_stalls, timer::ticks_to_ms(m_total_stall_ticks));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// trace_packet_prefetcher_test
+// Writes a small trace, then checks that reading it through the prefetcher returns the same packets, frames and file
+// offsets as reading it directly, across EOF, seeks and pause(). The tiny queue makes the read ahead thread wait often.
+//----------------------------------------------------------------------------------------------------------------------
+struct prefetcher_test_packet
+{
+    vogl_trace_file_reader::trace_file_reader_status_t m_read_status;
+    vogl_trace_stream_packet_types_t m_packet_type;
+    uint32_t m_cur_frame;
+    uint64_t m_cur_file_ofs;
+    uint64_t m_call_counter;
+    uint32_t m_entrypoint_id;
+    uint32_t m_total_params;
+
+    bool operator==(const prefetcher_test_packet &rhs) const
+    {
+        return (m_read_status == rhs.m_read_status) && (m_packet_type == rhs.m_packet_type) &&
+               (m_cur_frame == rhs.m_cur_frame) && (m_cur_file_ofs == rhs.m_cur_file_ofs) &&
+               (m_call_counter == rhs.m_call_counter) && (m_entrypoint_id == rhs.m_entrypoint_id) &&
+               (m_total_params == rhs.m_total_params);
+    }
+};
+
+typedef vogl::vector<prefetcher_test_packet> prefetcher_test_packet_vec;
+
+static bool prefetcher_test_write_trace(const char *pFilename, uint32_t num_frames)
+{
+    vogl_ctypes ctypes;
+    ctypes.init(sizeof(void *));
+
+    vogl_trace_file_writer writer(&ctypes);
+    if (!writer.open(pFilename))
+        return false;
+
+    bool success = true;
+
+    vogl_trace_packet packet(&ctypes);
+    uint8_vec data;
+    uint64_t call_counter = 0;
+    for (uint32_t frame_index = 0; (frame_index < num_frames) && (success); frame_index++)
+    {
+        for (uint32_t i = 0; (i < 40 + frame_index * 3) && (success); i++)
+        {
+            if (i % 5)
+            {
+                packet.begin_construction((i & 1) ? VOGL_ENTRYPOINT_glFinish : VOGL_ENTRYPOINT_glFlush, 1, call_counter++, 1, 0);
+            }
+            else
+            {
+                // Varying sizes, so the queue's byte limit kicks in too.
+                data.resize(64 + ((i * 97 + frame_index * 31) % 3000));
+                for (uint32_t j = 0; j < data.size(); j++)
+                    data[j] = static_cast<uint8_t>(j ^ i);
+
+                GLenum target = GL_ARRAY_BUFFER;
+                GLsizeiptr size = data.size();
+                GLenum usage = GL_STATIC_DRAW;
+                const void *pData = data.get_ptr();
+
+                packet.begin_construction(VOGL_ENTRYPOINT_glBufferData, 1, call_counter++, 1, 0);
+                packet.set_param(0, VOGL_GLENUM, &target, sizeof(target));
+                packet.set_param(1, VOGL_GLSIZEIPTR, &size, sizeof(size));
+                packet.set_param(2, VOGL_CONST_GLVOID_PTR, &pData, sizeof(pData));
+                packet.set_array_client_memory(2, VOGL_GLUBYTE, data.size(), pData, data.size());
+                packet.set_param(3, VOGL_GLENUM, &usage, sizeof(usage));
+            }
+            packet.end_construction(0);
+            success = writer.write_packet(packet);
+        }
+
+        uint64_t handle = 0;
+        packet.begin_construction(VOGL_ENTRYPOINT_glXSwapBuffers, 1, call_counter++, 1, 0);
+        packet.set_param(0, VOGL_DISPLAY_PTR, &handle, sizeof(void *));
+        packet.set_param(1, VOGL_GLXDRAWABLE, &handle, sizeof(uint64_t));
+        packet.end_construction(0);
+        success = success && writer.write_packet(packet);
+    }
+
+    return writer.close() && success;
+}
+
+static void prefetcher_test_read_direct(vogl_binary_trace_file_reader &reader, const vogl_ctypes &ctypes, uint32_t max_packets, prefetcher_test_packet_vec &packets)
+{
+    packets.resize(0);
+
+    vogl_trace_packet gl_packet(&ctypes);
+    for (uint32_t i = 0; i < max_packets; i++)
+    {
+        prefetcher_test_packet &packet = *packets.enlarge(1);
+        utils::zero_object(packet);
+
+        packet.m_read_status = reader.read_next_packet();
+        packet.m_packet_type = (packet.m_read_status == vogl_trace_file_reader::cOK) ? reader.get_packet_type() : cTSPTEOF;
+        packet.m_cur_frame = reader.get_cur_frame();
+        packet.m_cur_file_ofs = reader.get_cur_file_ofs();
+        if ((packet.m_packet_type == cTSPTGLEntrypoint) && (gl_packet.deserialize(reader.get_packet_ptr(), reader.get_packet_size(), false)))
+        {
+            packet.m_call_counter = gl_packet.get_call_counter();
+            packet.m_entrypoint_id = gl_packet.get_entrypoint_id();
+            packet.m_total_params = gl_packet.total_params();
+        }
+
+        if ((packet.m_read_status != vogl_trace_file_reader::cOK) || (packet.m_packet_type == cTSPTEOF))
+            break;
+    }
+}
+
+static void prefetcher_test_read_prefetched(vogl_trace_packet_prefetcher &prefetcher, uint32_t max_packets, prefetcher_test_packet_vec &packets)
+{
+    packets.resize(0);
+
+    for (uint32_t i = 0; i < max_packets; i++)
+    {
+        prefetcher_test_packet &packet = *packets.enlarge(1);
+        utils::zero_object(packet);
+
+        packet.m_read_status = prefetcher.read_next_packet();
+        packet.m_packet_type = (packet.m_read_status == vogl_trace_file_reader::cOK) ? prefetcher.get_packet_type() : cTSPTEOF;
+        packet.m_cur_frame = prefetcher.get_cur_frame();
+        packet.m_cur_file_ofs = prefetcher.get_cur_file_ofs();
+        if ((packet.m_packet_type == cTSPTGLEntrypoint) && (prefetcher.is_gl_packet_valid()))
+        {
+            const vogl_trace_packet &gl_packet = prefetcher.get_gl_packet();
+            packet.m_call_counter = gl_packet.get_call_counter();
+            packet.m_entrypoint_id = gl_packet.get_entrypoint_id();
+            packet.m_total_params = gl_packet.total_params();
+        }
+
+        if ((packet.m_read_status != vogl_trace_file_reader::cOK) || (packet.m_packet_type == cTSPTEOF))
+            break;
+    }
+}
+
+static bool prefetcher_test_compare(const char *pDesc, const prefetcher_test_packet_vec &expected, const prefetcher_test_packet_vec &actual)
+{
+    if (expected.size() != actual.size())
+    {
+        vogl_error_printf("%s: %s: Expected %u packets, got %u\n", VOGL_FUNCTION_INFO_CSTR, pDesc, expected.size(), actual.size());
+        return false;
+    }
+
+    for (uint32_t i = 0; i < expected.size(); i++)
+    {
+        if (!(expected[i] == actual[i]))
+        {
+            vogl_error_printf("%s: %s: Packet %u differs (frame %u vs. %u)\n", VOGL_FUNCTION_INFO_CSTR, pDesc, i, expected[i].m_cur_frame, actual[i].m_cur_frame);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool trace_packet_prefetcher_test()
+{
+    const uint32_t cTotalFrames = 24;
+
+    dynamic_string filename(file_utils::generate_temp_filename("vogl_prefetcher_test"));
+    if (!prefetcher_test_write_trace(filename.get_ptr(), cTotalFrames))
+    {
+        file_utils::delete_file(filename.get_ptr());
+        return false;
+    }
+
+    bool success = true;
+
+    // Synchronous first, then with a read ahead thread.
+    for (uint32_t pass = 0; (pass < 2) && (success); pass++)
+    {
+        vogl_binary_trace_file_reader direct_reader;
+        vogl_binary_trace_file_reader prefetched_reader;
+        if ((!direct_reader.open(filename.get_ptr(), NULL)) || (!prefetched_reader.open(filename.get_ptr(), NULL)))
+        {
+            success = false;
+            break;
+        }
+
+        vogl_ctypes ctypes(direct_reader.get_sof_packet().m_pointer_sizes);
+
+        vogl_trace_packet_prefetcher prefetcher;
+        if (!prefetcher.init(&prefetched_reader, &ctypes, pass ? 4 : 0, 4096))
+        {
+            success = false;
+            break;
+        }
+
+        prefetcher_test_packet_vec expected, actual;
+
+        // The whole trace, then reading past EOF.
+        prefetcher_test_read_direct(direct_reader, ctypes, cUINT32_MAX, expected);
+        prefetcher_test_read_prefetched(prefetcher, cUINT32_MAX, actual);
+        success = prefetcher_test_compare("full", expected, actual);
+
+        prefetcher_test_read_direct(direct_reader, ctypes, 3, expected);
+        prefetcher_test_read_prefetched(prefetcher, 3, actual);
+        success = success && prefetcher_test_compare("after eof", expected, actual);
+
+        // Seek while packets are still queued from a partial read.
+        for (uint32_t i = 0; (i < 100) && (success); i++)
+        {
+            uint32_t frame_index = (i * 7) % (cTotalFrames + 1);
+            uint32_t num_packets = (i * 13) % 200;
+
+            success = (direct_reader.seek_to_frame(frame_index) == prefetcher.seek_to_frame(frame_index));
+
+            prefetcher_test_read_direct(direct_reader, ctypes, num_packets, expected);
+            prefetcher_test_read_prefetched(prefetcher, num_packets, actual);
+            success = success && prefetcher_test_compare("seek", expected, actual);
+        }
+
+        // Use the reader directly while paused, then carry on from where the prefetcher left off.
+        if (success)
+        {
+            direct_reader.seek_to_frame(5);
+            prefetcher.seek_to_frame(5);
+            prefetcher_test_read_direct(direct_reader, ctypes, 50, expected);
+            prefetcher_test_read_prefetched(prefetcher, 50, actual);
+            success = prefetcher_test_compare("before pause", expected, actual);
+
+            vogl_trace_packet_array expected_frame_packets, actual_frame_packets;
+            uint32_t expected_frames_read = 0, actual_frames_read = 0;
+            direct_reader.read_frame_packets(10, 3, expected_frame_packets, expected_frames_read);
+            prefetcher.pause();
+            prefetched_reader.read_frame_packets(10, 3, actual_frame_packets, actual_frames_read);
+
+            success = success && (expected_frames_read == 3) && (actual_frames_read == 3) &&
+                      (expected_frame_packets.size() == actual_frame_packets.size()) &&
+                      (direct_reader.get_max_frame_index() == prefetcher.get_max_frame_index());
+
+            prefetcher_test_read_direct(direct_reader, ctypes, cUINT32_MAX, expected);
+            prefetcher_test_read_prefetched(prefetcher, cUINT32_MAX, actual);
+            success = success && prefetcher_test_compare("after pause", expected, actual);
+        }
+
+        prefetcher.deinit();
+    }
+
+    file_utils::delete_file(filename.get_ptr());
+
+    return success;
+}
@@ -0,0 +1,182 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+//----------------------------------------------------------------------------------------------------------------------
+// File: vogl_trace_packet_prefetcher.h
+//----------------------------------------------------------------------------------------------------------------------
+#ifndef VOGL_TRACE_PACKET_PREFETCHER_H
+#define VOGL_TRACE_PACKET_PREFETCHER_H
+
+#include "vogl_common.h"
+#include "vogl_trace_file_reader.h"
+#include "vogl_trace_packet.h"
+#include "vogl_threading.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_trace_packet_prefetcher
+// Reads, validates and deserializes trace packets on a background thread into a bounded ring of ready to replay
+// vogl_trace_packet's, so the replay thread doesn't pay for file I/O or decoding.
+// While the read ahead thread is running it owns the trace reader. Seek through seek_to_frame(), and call pause()
+// before using the reader directly for anything that restores its location afterwards (read_frame_packets(),
+// get_max_frame_index(), etc.). The thread is restarted by the next read_next_packet().
+// With max_packets == 0 packets are read on the calling thread, which behaves exactly like reading the reader directly.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_trace_packet_prefetcher
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_trace_packet_prefetcher);
+
+public:
+    enum
+    {
+        cDefaultMaxPackets = 256,
+        cDefaultMaxQueuedBytes = 64 * 1024 * 1024
+    };
+
+    vogl_trace_packet_prefetcher();
+    ~vogl_trace_packet_prefetcher();
+
+    // pCtypes must be the trace's ctypes, and must stay valid until deinit().
+    bool init(vogl_trace_file_reader *pReader, const vogl_ctypes *pCtypes, uint32_t max_packets = cDefaultMaxPackets, uint32_t max_queued_bytes = cDefaultMaxQueuedBytes);
+    void deinit();
+
+    inline bool is_initialized() const
+    {
+        return m_pReader != NULL;
+    }
+
+    inline bool is_async() const
+    {
+        return m_thread_pool.get_num_threads() != 0;
+    }
+
+    vogl_trace_file_reader *get_reader() const
+    {
+        return m_pReader;
+    }
+
+    // Returns the reader's status for the next packet. The packet accessors below are valid until the next call.
+    vogl_trace_file_reader::trace_file_reader_status_t read_next_packet();
+
+    inline vogl_trace_stream_packet_types_t get_packet_type() const
+    {
+        return m_pCur_packet->m_packet_type;
+    }
+
+    // Only valid for cTSPTGLEntrypoint packets. Returns false if the packet couldn't be deserialized.
+    inline bool is_gl_packet_valid() const
+    {
+        return m_pCur_packet->m_gl_packet.is_valid();
+    }
+    inline vogl_trace_packet &get_gl_packet() const
+    {
+        return m_pCur_packet->m_gl_packet;
+    }
+
+    // The reader's frame index and file offset (binary traces only) just after the last packet returned by
+    // read_next_packet(), not the read ahead thread's.
+    inline uint32_t get_cur_frame() const
+    {
+        return m_cur_frame;
+    }
+    inline uint64_t get_cur_file_ofs() const
+    {
+        return m_cur_file_ofs;
+    }
+
+    // Throws away anything read ahead and seeks the reader.
+    bool seek_to_frame(uint32_t frame_index);
+
+    // Stops the read ahead thread but keeps the packets it's already queued.
+    void pause();
+
+    // Pauses, so it's safe to call while the thread is running.
+    int64_t get_max_frame_index();
+
+    void dump_stats() const;
+
+private:
+    struct queued_packet
+    {
+        queued_packet(const vogl_ctypes *pCtypes)
+            : m_gl_packet(pCtypes),
+              m_read_status(vogl_trace_file_reader::cOK),
+              m_packet_type(cTSPTEOF),
+              m_packet_size(0),
+              m_cur_frame(0),
+              m_cur_file_ofs(0)
+        {
+        }
+
+        vogl_trace_packet m_gl_packet;
+        vogl_trace_file_reader::trace_file_reader_status_t m_read_status;
+        vogl_trace_stream_packet_types_t m_packet_type;
+        uint32_t m_packet_size;
+        uint32_t m_cur_frame;
+        uint64_t m_cur_file_ofs;
+    };
+
+    vogl_trace_file_reader *m_pReader;
+    const vogl_ctypes *m_pCtypes;
+
+    uint32_t m_max_queued_bytes;
+
+    // Ring of queued packets. The packet at m_tail is the one last returned to the caller while m_holding_tail is set.
+    vogl::vector<queued_packet *> m_packets;
+    queued_packet *m_pCur_packet;
+
+    task_pool m_thread_pool;
+    bool m_thread_running;
+
+    // Guards everything below. The packet at m_head is only touched by the read ahead thread until it's published.
+    mutex m_mutex;
+    uint32_t m_head;
+    uint32_t m_tail;
+    uint32_t m_num_queued;
+    uint64_t m_queued_bytes;
+    bool m_holding_tail;
+    bool m_exit_flag;
+
+    // Each waiting flag is set under the mutex before waiting, and whoever clears it releases the semaphore once.
+    bool m_reader_waiting;
+    bool m_consumer_waiting;
+    semaphore m_space_available;
+    semaphore m_packets_available;
+
+    uint32_t m_cur_frame;
+    uint64_t m_cur_file_ofs;
+
+    uint64_t m_total_packets;
+    uint64_t m_total_stalls;
+    timer_ticks m_total_stall_ticks;
+
+    void read_packet(queued_packet &packet);
+    void read_ahead_thread_func(uint64_t data, void *pData_ptr);
+    void start_thread();
+    void discard_queued_packets();
+};
+
+bool trace_packet_prefetcher_test();
+
+#endif // VOGL_TRACE_PACKET_PREFETCHER_H
@@ -29,7 +29,7 @@
 #include "vogl_miniz.h"
 #include "vogl_port.h"
 
-#define VOGL_TRACE_FILE_VERSION 0x0106
+#define VOGL_TRACE_FILE_VERSION 0x0107
 #define VOGL_TRACE_FILE_MINIMUM_COMPATIBLE_VERSION 0x0106
 
 #define VOGL_TRACE_LINK_PROGRAM_UNIFORM_DESC_KEY_OFS 0xF0000
@@ -153,7 +153,7 @@ struct vogl_trace_stream_start_of_file_packet
 
     uint16_t m_version; // must immediately follow m_crc!
     uint8_t m_pointer_sizes;
-    uint8_t m_unused;
+    uint8_t m_block_codec; // vogl_trace_block_codec_t - if not cTraceBlockCodecNone, all packets are stored in vogl_trace_stream_block_header blocks
 
     enum
     {
@@ -222,6 +222,49 @@ struct vogl_trace_stream_start_of_file_packet
     }
 };
 
+// Version 0x0107+ traces may group packets into independently compressed blocks. Packet/frame offsets are always
+// offsets into the uncompressed packet stream (which starts at m_first_packet_offset, like an uncompressed trace).
+enum vogl_trace_block_codec_t
+{
+    cTraceBlockCodecNone = 0, // packets written directly to the file (pre-0x0107 layout), or a block stored uncompressed
+    cTraceBlockCodecDeflate = 1, // raw deflate (tdefl/tinfl)
+    cTraceBlockCodecTotal
+};
+
+struct vogl_trace_stream_block_header
+{
+    enum
+    {
+        cBlockPrefix = 0xD1C71603
+    };
+    uint32_t m_prefix;
+    uint32_t m_crc; // CRC32 of the m_compressed_size bytes following this header
+    uint32_t m_compressed_size;
+    uint32_t m_uncompressed_size;
+    uint8_t m_codec; // vogl_trace_block_codec_t, may be cTraceBlockCodecNone if the block didn't compress
+    uint8_t m_unused[3];
+
+    inline bool basic_validation() const
+    {
+        if (m_prefix != cBlockPrefix)
+            return false;
+        if ((m_codec >= cTraceBlockCodecTotal) || (!m_uncompressed_size))
+            return false;
+        if ((m_codec == cTraceBlockCodecNone) && (m_compressed_size != m_uncompressed_size))
+            return false;
+        return true;
+    }
+};
+
+// Stored in the trace archive (VOGL_TRACE_ARCHIVE_BLOCK_INDEX_FILENAME) of block compressed traces.
+struct vogl_trace_stream_block_index_entry
+{
+    uint64_t m_file_ofs;   // file offset of the block's vogl_trace_stream_block_header
+    uint64_t m_stream_ofs; // packet stream offset of the block's first byte
+    uint32_t m_compressed_size;
+    uint32_t m_uncompressed_size;
+};
+
 #define VOGL_RETURN_PARAM_INDEX 255
 
 // GL entrypoint packets contain a fixed size struct vogl_trace_gl_entrypoint_packet, immediately
@@ -318,10 +361,13 @@ struct vogl_backtrace_addrs
 typedef vogl::hash_map<vogl_backtrace_addrs, uint64_t, intrusive_hasher<vogl_backtrace_addrs> > vogl_backtrace_hashmap;
 
 #define VOGL_TRACE_ARCHIVE_FRAME_FILE_OFFSETS_FILENAME   "frame_file_offsets"
+#define VOGL_TRACE_ARCHIVE_BLOCK_INDEX_FILENAME          "block_index"
+#define VOGL_TRACE_ARCHIVE_CALL_INDEX_FILENAME           "call_index"
 
 #define VOGL_TRACE_ARCHIVE_COMPILER_INFO_FILENAME        "compiler_info.json"
 #define VOGL_TRACE_ARCHIVE_MACHINE_INFO_FILENAME         "machine_info.json"
 #define VOGL_TRACE_ARCHIVE_BACKTRACE_MAP_SYMS_FILENAME   "backtrace_map_syms.json"
 #define VOGL_TRACE_ARCHIVE_BACKTRACE_MAP_ADDRS_FILENAME  "backtrace_map_addrs.json"
+#define VOGL_TRACE_ARCHIVE_ENTRYPOINT_STATS_FILENAME     "entrypoint_stats.json"
 
 #endif // VOGL_TRACE_STREAM_TYPES_H
@@ -114,6 +114,34 @@ namespace vogl
         VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 3) == 0);
         return InterlockedExchangeAdd(pDest, val);
     }
+
+    // Returns the original value.
+    inline atomic64_t atomic_exchange_add64(atomic64_t volatile *pDest, atomic64_t val)
+    {
+        VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 7) == 0);
+        return InterlockedExchangeAdd64(pDest, val);
+    }
+
+    // Full memory barrier.
+    inline void atomic_memory_barrier()
+    {
+        MemoryBarrier();
+    }
+
+    // Loads the value, no later loads or stores will be reordered before it.
+    inline atomic32_t atomic_load32(const atomic32_t volatile *pSrc)
+    {
+        atomic32_t val = *pSrc;
+        MemoryBarrier();
+        return val;
+    }
+
+    // Stores the value, no earlier loads or stores will be reordered after it.
+    inline void atomic_store32(atomic32_t volatile *pDest, atomic32_t val)
+    {
+        MemoryBarrier();
+        *pDest = val;
+    }
 #elif VOGL_USE_GCC_ATOMIC_BUILTINS
     typedef volatile long atomic32_t;
     typedef long nonvolatile_atomic32_t;
@@ -168,6 +196,36 @@ namespace vogl
         VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 3) == 0);
         return __sync_fetch_and_add(pDest, val);
     }
+
+    // Returns the original value.
+    inline nonvolatile_atomic64_t atomic_exchange_add64(atomic64_t volatile *pDest, atomic64_t val)
+    {
+        VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 7) == 0);
+        return __sync_fetch_and_add(pDest, val);
+    }
+
+    // Full memory barrier.
+    inline void atomic_memory_barrier()
+    {
+        __sync_synchronize();
+    }
+
+    // Loads the value, no later loads or stores will be reordered before it.
+    inline nonvolatile_atomic32_t atomic_load32(const atomic32_t volatile *pSrc)
+    {
+        VOGL_ASSERT((reinterpret_cast<uintptr_t>(pSrc) & 3) == 0);
+        nonvolatile_atomic32_t val = *pSrc;
+        __sync_synchronize();
+        return val;
+    }
+
+    // Stores the value, no earlier loads or stores will be reordered after it.
+    inline void atomic_store32(atomic32_t volatile *pDest, atomic32_t val)
+    {
+        VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 3) == 0);
+        __sync_synchronize();
+        *pDest = val;
+    }
 #else
 #define VOGL_NO_ATOMICS 1
 
@@ -226,6 +284,28 @@ namespace vogl
         *pDest += val;
         return cur;
     }
+
+    inline atomic64_t atomic_exchange_add64(atomic64_t volatile *pDest, atomic64_t val)
+    {
+        VOGL_ASSERT((reinterpret_cast<uintptr_t>(pDest) & 7) == 0);
+        atomic64_t cur = *pDest;
+        *pDest += val;
+        return cur;
+    }
+
+    inline void atomic_memory_barrier()
+    {
+    }
+
+    inline atomic32_t atomic_load32(const atomic32_t volatile *pSrc)
+    {
+        return *pSrc;
+    }
+
+    inline void atomic_store32(atomic32_t volatile *pDest, atomic32_t val)
+    {
+        *pDest = val;
+    }
 #endif
 
 } // namespace vogl
@@ -0,0 +1,189 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_bidi_hash_map.cpp
+#include "vogl_bidi_hash_map.h"
+#include "vogl_rand.h"
+#include "vogl_timer.h"
+#include "vogl_console.h"
+
+namespace vogl
+{
+    typedef bidi_hash_map<uint32_t, uint32_t> uint_bidi_hash_map;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // check_bidi_hash_map
+    // Every forward entry must be reachable through the inverse index, and the inverse index must hold nothing else.
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool check_bidi_hash_map(const uint_bidi_hash_map &map, const hash_map<uint32_t, uint32_t> &ref)
+    {
+        if ((map.size() != ref.size()) || (map.get_inverse_map().size() != ref.size()))
+            return false;
+
+        for (hash_map<uint32_t, uint32_t>::const_iterator it = ref.begin(); it != ref.end(); ++it)
+        {
+            if ((map.value(it->first, cUINT32_MAX) != it->second) || (map.key(it->second, cUINT32_MAX) != it->first))
+                return false;
+
+            uint_bidi_hash_map::const_iterator key_it(map.find_key(it->second));
+            if ((key_it == map.end()) || (key_it->first != it->first))
+                return false;
+        }
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // bidi_hash_map_test
+    //----------------------------------------------------------------------------------------------------------------------
+    bool bidi_hash_map_test()
+    {
+        random rm;
+        rm.seed(2);
+
+        // Randomized correctness against a plain hash_map searched linearly, the way replay to trace handle lookups used
+        // to be done. Values are kept unique, like GL handles.
+        for (uint32_t t = 0; t < 20; t++)
+        {
+            uint_bidi_hash_map map;
+            hash_map<uint32_t, uint32_t> ref;
+
+            const uint32_t key_range = rm.irand_inclusive(1, 2000);
+            uint32_t next_value = 1;
+
+            for (uint32_t op = 0; op < 20000; op++)
+            {
+                uint32_t k = rm.irand_inclusive(0, key_range);
+
+                switch (rm.irand(0, 4))
+                {
+                    case 0:
+                    {
+                        bool inserted = map.insert(k, next_value).second;
+                        if (inserted != ref.insert(k, next_value).second)
+                            return false;
+                        next_value++;
+                        break;
+                    }
+                    case 1:
+                    {
+                        bool inserted = map.update(k, next_value);
+                        if (inserted != !ref.contains(k))
+                            return false;
+                        ref.erase(k);
+                        ref.insert(k, next_value);
+                        next_value++;
+                        break;
+                    }
+                    case 2:
+                    {
+                        if (map.erase(k) != ref.erase(k))
+                            return false;
+                        break;
+                    }
+                    default:
+                    {
+                        uint32_t v = rm.irand_inclusive(0, next_value);
+                        hash_map<uint32_t, uint32_t>::const_iterator ref_it(ref.search_table_for_value(v));
+                        uint_bidi_hash_map::const_iterator it(map.find_key(v));
+                        if ((ref_it == ref.end()) != (it == map.end()))
+                            return false;
+                        if ((it != map.end()) && ((it->first != ref_it->first) || (it->second != v)))
+                            return false;
+                        if (map.contains_value(v) != (ref_it != ref.end()))
+                            return false;
+                        break;
+                    }
+                }
+            }
+
+            if (!check_bidi_hash_map(map, ref))
+            {
+                console::error("%s: Trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                return false;
+            }
+
+            uint_bidi_hash_map map_copy(map);
+            map.clear();
+            if ((!map.is_empty()) || (map.get_inverse_map().size()) || (!check_bidi_hash_map(map_copy, ref)))
+                return false;
+        }
+
+        // A value stored under two keys: the inverse index follows the latest key, and erasing the older key leaves it.
+        {
+            uint_bidi_hash_map map;
+            map.insert(1, 100);
+            map.insert(2, 100);
+            if (map.key(100) != 2)
+                return false;
+            map.erase(1);
+            if (map.key(100) != 2)
+                return false;
+            map.erase(2);
+            if (map.contains_value(100))
+                return false;
+        }
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // bidi_hash_map_bench
+    // Replay to trace lookups of every handle of a scene with many objects, which is what snapshotting does. The linear
+    // search is only timed on a sample of the handles and extrapolated.
+    //----------------------------------------------------------------------------------------------------------------------
+    bool bidi_hash_map_bench()
+    {
+        const uint32_t cNumHandles = 100000;
+        const uint32_t cNumLinearSearches = 1000;
+
+        uint_bidi_hash_map map;
+        hash_map<uint32_t, uint32_t> ref;
+        for (uint32_t i = 0; i < cNumHandles; i++)
+        {
+            map.insert(i + 1, i * 7 + 1000);
+            ref.insert(i + 1, i * 7 + 1000);
+        }
+
+        timer tm;
+        tm.start();
+        uint64_t linear_sum = 0;
+        for (uint32_t i = 0; i < cNumLinearSearches; i++)
+            linear_sum += ref.search_table_for_value(((i * 97) % cNumHandles) * 7 + 1000)->first;
+        double linear_secs = tm.get_elapsed_secs() * (static_cast<double>(cNumHandles) / cNumLinearSearches);
+
+        tm.start();
+        uint64_t inverse_sum = 0;
+        for (uint32_t i = 0; i < cNumHandles; i++)
+            inverse_sum += map.key(i * 7 + 1000);
+        double inverse_secs = tm.get_elapsed_secs();
+
+        console::message("%s: Replay to trace lookups of %u handles: linear search ~%.3f secs, inverse index %.6f secs\n",
+                         VOGL_FUNCTION_INFO_CSTR, cNumHandles, linear_secs, inverse_secs);
+
+        return (linear_sum != 0) && (inverse_sum == (static_cast<uint64_t>(cNumHandles) * (cNumHandles + 1)) / 2);
+    }
+
+} // namespace vogl
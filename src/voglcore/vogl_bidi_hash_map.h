@@ -0,0 +1,204 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_bidi_hash_map.h
+// hash_map which also keeps an inverse index from values back to keys, so lookups are O(1) in both directions (e.g.
+// trace to replay GL handles, and replay back to trace handles when snapshotting).
+// Values are expected to be unique. If the same value is stored under more than one key, find_key() returns the key
+// it was most recently stored under, and erasing that key drops the value from the inverse index.
+// Only const iterators are exposed, change values with update() so the inverse index stays consistent.
+// ForwardMap may be any map with hash_map's interface (e.g. hybrid_hash_map for GL handles).
+#pragma once
+
+#include "vogl_core.h"
+#include "vogl_hash_map.h"
+
+namespace vogl
+{
+    template <typename Key, typename Value, typename KeyHasher = hasher<Key>, typename KeyEquals = equal_to<Key>,
+              typename ValueHasher = hasher<Value>, typename ValueEquals = equal_to<Value>,
+              typename ForwardMap = hash_map<Key, Value, KeyHasher, KeyEquals> >
+    class bidi_hash_map
+    {
+    public:
+        typedef ForwardMap forward_map_type;
+        typedef hash_map<Value, Key, ValueHasher, ValueEquals> inverse_map_type;
+
+        typedef typename forward_map_type::const_iterator const_iterator;
+        typedef const_iterator iterator;
+        typedef std::pair<const_iterator, bool> insert_result;
+
+        inline bidi_hash_map()
+        {
+        }
+
+        inline void clear()
+        {
+            m_forward.clear();
+            m_inverse.clear();
+        }
+
+        inline void reset()
+        {
+            m_forward.reset();
+            m_inverse.reset();
+        }
+
+        inline void reserve(uint32_t new_capacity)
+        {
+            m_forward.reserve(new_capacity);
+            m_inverse.reserve(new_capacity);
+        }
+
+        inline uint32_t size() const
+        {
+            return m_forward.size();
+        }
+
+        inline bool is_empty() const
+        {
+            return m_forward.is_empty();
+        }
+
+        inline const_iterator begin() const
+        {
+            return m_forward.begin();
+        }
+
+        inline const_iterator end() const
+        {
+            return m_forward.end();
+        }
+
+        // Like hash_map::insert(), an existing key is left alone and false is returned.
+        inline insert_result insert(const Key &k, const Value &v)
+        {
+            typename forward_map_type::insert_result result(m_forward.insert(k, v));
+            if (result.second)
+            {
+                typename inverse_map_type::insert_result inv_result(m_inverse.insert(v, k));
+                if (!inv_result.second)
+                    inv_result.first->second = k;
+            }
+            return insert_result(result.first, result.second);
+        }
+
+        // Inserts the key, or changes its value if it's already present. Returns true if the key was inserted.
+        inline bool update(const Key &k, const Value &v)
+        {
+            bool inserted = !erase(k);
+            insert(k, v);
+            return inserted;
+        }
+
+        // All active iterators become invalid after erase().
+        inline bool erase(const Key &k)
+        {
+            const Value *pValue = m_forward.find_value(k);
+            if (!pValue)
+                return false;
+
+            typename inverse_map_type::const_iterator inv_it(m_inverse.find(*pValue));
+            if ((inv_it != m_inverse.end()) && (KeyEquals()(inv_it->second, k)))
+                m_inverse.erase(*pValue);
+
+            return m_forward.erase(k);
+        }
+
+        inline const_iterator find(const Key &k) const
+        {
+            return m_forward.find(k);
+        }
+
+        inline const Value *find_value(const Key &k) const
+        {
+            return m_forward.find_value(k);
+        }
+
+        inline bool contains(const Key &k) const
+        {
+            return m_forward.contains(k);
+        }
+
+        // Returns const ref to value if key is found, otherwise returns the default.
+        inline const Value &value(const Key &k, const Value &def = Value()) const
+        {
+            return m_forward.value(k, def);
+        }
+
+        // Inverse lookups.
+        inline const_iterator find_key(const Value &v) const
+        {
+            const Key *pKey = m_inverse.find_value(v);
+            return pKey ? m_forward.find(*pKey) : m_forward.end();
+        }
+
+        inline bool contains_value(const Value &v) const
+        {
+            return m_inverse.contains(v);
+        }
+
+        // Returns const ref to the key the value is stored under, otherwise returns the default.
+        inline const Key &key(const Value &v, const Key &def = Key()) const
+        {
+            return m_inverse.value(v, def);
+        }
+
+        inline const forward_map_type &get_forward_map() const
+        {
+            return m_forward;
+        }
+
+        inline const inverse_map_type &get_inverse_map() const
+        {
+            return m_inverse;
+        }
+
+        inline void swap(bidi_hash_map &other)
+        {
+            m_forward.swap(other.m_forward);
+            m_inverse.swap(other.m_inverse);
+        }
+
+    private:
+        forward_map_type m_forward;
+        inverse_map_type m_inverse;
+    };
+
+    template <typename Key, typename Value, typename KeyHasher, typename KeyEquals, typename ValueHasher, typename ValueEquals, typename ForwardMap>
+    struct bitwise_movable<bidi_hash_map<Key, Value, KeyHasher, KeyEquals, ValueHasher, ValueEquals, ForwardMap> >
+    {
+        enum
+        {
+            cFlag = true
+        };
+    };
+
+    bool bidi_hash_map_test();
+
+    // Replay to trace handle lookups, inverse index vs. linear search. Run by vogltest --bench.
+    bool bidi_hash_map_bench();
+
+} // namespace vogl
@@ -26,6 +26,25 @@
 
 // File: vogl_checksum.cpp
 #include "vogl_core.h"
+#include "vogl_checksum.h"
+#include "vogl_console.h"
+#include "vogl_rand.h"
+#include "vogl_timer.h"
+
+#if (defined(COMPILER_GCCLIKE) || defined(COMPILER_MSVC)) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    #define VOGL_CRC_CLMUL_SUPPORTED 1
+    #include <emmintrin.h>
+    #include <wmmintrin.h>
+    #if defined(COMPILER_MSVC)
+        #include <intrin.h>
+        #define VOGL_CRC_CLMUL_TARGET
+    #else
+        #include <cpuid.h>
+        #define VOGL_CRC_CLMUL_TARGET __attribute__((target("sse2,pclmul")))
+    #endif
+#else
+    #define VOGL_CRC_CLMUL_SUPPORTED 0
+#endif
 
 namespace vogl
 {
@@ -87,4 +106,547 @@ namespace vogl
         return static_cast<uint16_t>(~crc);
     }
 
+    // Both CRC's are the reflected (LSB first) form. Kernels operate on the raw register value, callers invert it.
+    // Note the SSE4.2 crc32 instruction is no use here, it only computes CRC-32C (Castagnoli).
+    static const uint32_t g_crc32_poly = 0xEDB88320U;
+    static const uint64_t g_crc64_poly = 0xC96C5795D7870F42ULL;
+
+    static inline uint64_t crc_reflect64(uint64_t v)
+    {
+        uint64_t r = 0;
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            r = (r << 1) | (v & 1);
+            v >>= 1;
+        }
+        return r;
+    }
+
+    // Returns x^n mod P, with the coefficient of x^i at bit 63-i. This is the form the CLMUL folding constants take.
+    static uint64_t crc_xpow_mod(uint32_t n, uint64_t reflected_poly, uint32_t width)
+    {
+        const uint64_t poly = crc_reflect64(reflected_poly) >> (64 - width);
+        const uint64_t top_bit = 1ULL << (width - 1);
+        const uint64_t mask = (width == 64) ? cUINT64_MAX : ((1ULL << width) - 1);
+
+        uint64_t r = 1;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            bool carry = (r & top_bit) != 0;
+            r = (r << 1) & mask;
+            if (carry)
+                r ^= poly;
+        }
+
+        return crc_reflect64(r);
+    }
+
+    struct crc_tables
+    {
+        // [k][i] is the CRC of byte i followed by k zero bytes, for slicing-by-8/16.
+        uint32_t m_crc32[16][256];
+        uint64_t m_crc64[16][256];
+
+        // Folding constants for 512 and 128 bit distances: { x^(D+63) mod P, x^(D-1) mod P }
+        uint64_t m_crc32_fold[4];
+        uint64_t m_crc64_fold[4];
+
+        crc_tables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t r32 = i;
+                uint64_t r64 = i;
+                for (uint32_t j = 0; j < 8; j++)
+                {
+                    r32 = (r32 >> 1) ^ ((r32 & 1) ? g_crc32_poly : 0);
+                    r64 = (r64 >> 1) ^ ((r64 & 1) ? g_crc64_poly : 0);
+                }
+                m_crc32[0][i] = r32;
+                m_crc64[0][i] = r64;
+            }
+
+            for (uint32_t k = 1; k < 16; k++)
+            {
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    m_crc32[k][i] = (m_crc32[k - 1][i] >> 8) ^ m_crc32[0][m_crc32[k - 1][i] & 0xFF];
+                    m_crc64[k][i] = (m_crc64[k - 1][i] >> 8) ^ m_crc64[0][m_crc64[k - 1][i] & 0xFF];
+                }
+            }
+
+            const uint32_t fold_exps[4] = { 512 + 63, 512 - 1, 128 + 63, 128 - 1 };
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                m_crc32_fold[i] = crc_xpow_mod(fold_exps[i], g_crc32_poly, 32);
+                m_crc64_fold[i] = crc_xpow_mod(fold_exps[i], g_crc64_poly, 64);
+            }
+        }
+    };
+
+    static const crc_tables &get_crc_tables()
+    {
+        static crc_tables s_tables;
+        return s_tables;
+    }
+
+    static inline uint32_t crc_read32(const uint8_t *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint64_t crc_read64(const uint8_t *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint32_t crc32_kernel_table(uint32_t crc, const uint8_t *p, size_t len)
+    {
+        const uint32_t *pT = get_crc_tables().m_crc32[0];
+        while (len--)
+            crc = (crc >> 8) ^ pT[(crc ^ *p++) & 0xFF];
+        return crc;
+    }
+
+    static uint64_t crc64_kernel_table(uint64_t crc, const uint8_t *p, size_t len)
+    {
+        const uint64_t *pT = get_crc_tables().m_crc64[0];
+        while (len--)
+            crc = (crc >> 8) ^ pT[(crc ^ *p++) & 0xFF];
+        return crc;
+    }
+
+    // The slicing kernels assume a little endian CPU.
+    static uint32_t crc32_kernel_slicing8(uint32_t crc, const uint8_t *p, size_t len)
+    {
+        const uint32_t (*T)[256] = get_crc_tables().m_crc32;
+
+        while (len >= 8)
+        {
+            uint32_t a = crc ^ crc_read32(p);
+            uint32_t b = crc_read32(p + 4);
+
+            crc = T[7][a & 0xFF] ^ T[6][(a >> 8) & 0xFF] ^ T[5][(a >> 16) & 0xFF] ^ T[4][a >> 24] ^
+                  T[3][b & 0xFF] ^ T[2][(b >> 8) & 0xFF] ^ T[1][(b >> 16) & 0xFF] ^ T[0][b >> 24];
+
+            p += 8;
+            len -= 8;
+        }
+
+        while (len--)
+            crc = (crc >> 8) ^ T[0][(crc ^ *p++) & 0xFF];
+
+        return crc;
+    }
+
+    static uint32_t crc32_kernel_slicing16(uint32_t crc, const uint8_t *p, size_t len)
+    {
+        const uint32_t (*T)[256] = get_crc_tables().m_crc32;
+
+        while (len >= 16)
+        {
+            uint32_t a = crc ^ crc_read32(p);
+            uint32_t b = crc_read32(p + 4);
+            uint32_t c = crc_read32(p + 8);
+            uint32_t d = crc_read32(p + 12);
+
+            crc = T[15][a & 0xFF] ^ T[14][(a >> 8) & 0xFF] ^ T[13][(a >> 16) & 0xFF] ^ T[12][a >> 24] ^
+                  T[11][b & 0xFF] ^ T[10][(b >> 8) & 0xFF] ^ T[9][(b >> 16) & 0xFF] ^ T[8][b >> 24] ^
+                  T[7][c & 0xFF] ^ T[6][(c >> 8) & 0xFF] ^ T[5][(c >> 16) & 0xFF] ^ T[4][c >> 24] ^
+                  T[3][d & 0xFF] ^ T[2][(d >> 8) & 0xFF] ^ T[1][(d >> 16) & 0xFF] ^ T[0][d >> 24];
+
+            p += 16;
+            len -= 16;
+        }
+
+        return crc32_kernel_slicing8(crc, p, len);
+    }
+
+    static uint64_t crc64_kernel_slicing8(uint64_t crc, const uint8_t *p, size_t len)
+    {
+        const uint64_t (*T)[256] = get_crc_tables().m_crc64;
+
+        while (len >= 8)
+        {
+            uint64_t a = crc ^ crc_read64(p);
+
+            crc = T[7][a & 0xFF] ^ T[6][(a >> 8) & 0xFF] ^ T[5][(a >> 16) & 0xFF] ^ T[4][(a >> 24) & 0xFF] ^
+                  T[3][(a >> 32) & 0xFF] ^ T[2][(a >> 40) & 0xFF] ^ T[1][(a >> 48) & 0xFF] ^ T[0][a >> 56];
+
+            p += 8;
+            len -= 8;
+        }
+
+        while (len--)
+            crc = (crc >> 8) ^ T[0][(crc ^ *p++) & 0xFF];
+
+        return crc;
+    }
+
+    static uint64_t crc64_kernel_slicing16(uint64_t crc, const uint8_t *p, size_t len)
+    {
+        const uint64_t (*T)[256] = get_crc_tables().m_crc64;
+
+        while (len >= 16)
+        {
+            uint64_t a = crc ^ crc_read64(p);
+            uint64_t b = crc_read64(p + 8);
+
+            crc = T[15][a & 0xFF] ^ T[14][(a >> 8) & 0xFF] ^ T[13][(a >> 16) & 0xFF] ^ T[12][(a >> 24) & 0xFF] ^
+                  T[11][(a >> 32) & 0xFF] ^ T[10][(a >> 40) & 0xFF] ^ T[9][(a >> 48) & 0xFF] ^ T[8][a >> 56] ^
+                  T[7][b & 0xFF] ^ T[6][(b >> 8) & 0xFF] ^ T[5][(b >> 16) & 0xFF] ^ T[4][(b >> 24) & 0xFF] ^
+                  T[3][(b >> 32) & 0xFF] ^ T[2][(b >> 40) & 0xFF] ^ T[1][(b >> 48) & 0xFF] ^ T[0][b >> 56];
+
+            p += 16;
+            len -= 16;
+        }
+
+        return crc64_kernel_slicing8(crc, p, len);
+    }
+
+#if VOGL_CRC_CLMUL_SUPPORTED
+    static bool crc_cpu_has_clmul()
+    {
+        uint32_t ecx, edx;
+#if defined(COMPILER_MSVC)
+        int regs[4];
+        __cpuid(regs, 1);
+        ecx = static_cast<uint32_t>(regs[2]);
+        edx = static_cast<uint32_t>(regs[3]);
+#else
+        unsigned int eax, ebx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+#endif
+        // PCLMULQDQ and SSE2
+        return ((ecx & (1U << 1)) != 0) && ((edx & (1U << 26)) != 0);
+    }
+
+    VOGL_CRC_CLMUL_TARGET static inline __m128i crc_clmul_fold_step(__m128i x, __m128i k)
+    {
+        return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+    }
+
+    // Folds the whole 16 byte blocks of p (len >= 64) into a single 16 byte block which has the same raw CRC as the
+    // input did when started from crc, then returns the number of bytes consumed. Works for any reflected CRC up
+    // to 64 bits wide, given its folding constants.
+    VOGL_CRC_CLMUL_TARGET static size_t crc_clmul_fold(uint8_t *pFolded, uint64_t crc, const uint8_t *p, size_t len, const uint64_t *pK)
+    {
+        const uint8_t *pStart = p;
+
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+        __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+        __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48));
+
+        x1 = _mm_xor_si128(x1, _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&crc)));
+
+        p += 64;
+        len -= 64;
+
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pK));
+
+        while (len >= 64)
+        {
+            x1 = _mm_xor_si128(crc_clmul_fold_step(x1, k), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+            x2 = _mm_xor_si128(crc_clmul_fold_step(x2, k), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16)));
+            x3 = _mm_xor_si128(crc_clmul_fold_step(x3, k), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32)));
+            x4 = _mm_xor_si128(crc_clmul_fold_step(x4, k), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48)));
+
+            p += 64;
+            len -= 64;
+        }
+
+        k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pK + 2));
+
+        x1 = _mm_xor_si128(crc_clmul_fold_step(x1, k), x2);
+        x1 = _mm_xor_si128(crc_clmul_fold_step(x1, k), x3);
+        x1 = _mm_xor_si128(crc_clmul_fold_step(x1, k), x4);
+
+        while (len >= 16)
+        {
+            x1 = _mm_xor_si128(crc_clmul_fold_step(x1, k), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+
+            p += 16;
+            len -= 16;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pFolded), x1);
+
+        return p - pStart;
+    }
+
+    static uint32_t crc32_kernel_clmul(uint32_t crc, const uint8_t *p, size_t len)
+    {
+        if (len < 64)
+            return crc32_kernel_slicing16(crc, p, len);
+
+        uint8_t folded[16];
+        size_t n = crc_clmul_fold(folded, crc, p, len, get_crc_tables().m_crc32_fold);
+
+        crc = crc32_kernel_slicing16(0, folded, sizeof(folded));
+        return crc32_kernel_slicing16(crc, p + n, len - n);
+    }
+
+    static uint64_t crc64_kernel_clmul(uint64_t crc, const uint8_t *p, size_t len)
+    {
+        if (len < 64)
+            return crc64_kernel_slicing16(crc, p, len);
+
+        uint8_t folded[16];
+        size_t n = crc_clmul_fold(folded, crc, p, len, get_crc_tables().m_crc64_fold);
+
+        crc = crc64_kernel_slicing16(0, folded, sizeof(folded));
+        return crc64_kernel_slicing16(crc, p + n, len - n);
+    }
+#endif
+
+    typedef uint32_t (*crc32_kernel_func)(uint32_t crc, const uint8_t *p, size_t len);
+    typedef uint64_t (*crc64_kernel_func)(uint64_t crc, const uint8_t *p, size_t len);
+
+    static const crc32_kernel_func g_crc32_kernels[cCRCKernelTotal] =
+    {
+        crc32_kernel_table, crc32_kernel_slicing8, crc32_kernel_slicing16,
+#if VOGL_CRC_CLMUL_SUPPORTED
+        crc32_kernel_clmul
+#else
+        NULL
+#endif
+    };
+
+    static const crc64_kernel_func g_crc64_kernels[cCRCKernelTotal] =
+    {
+        crc64_kernel_table, crc64_kernel_slicing8, crc64_kernel_slicing16,
+#if VOGL_CRC_CLMUL_SUPPORTED
+        crc64_kernel_clmul
+#else
+        NULL
+#endif
+    };
+
+    const char *get_crc_kernel_name(crc_kernel kernel)
+    {
+        switch (kernel)
+        {
+            case cCRCKernelTable:
+                return "table";
+            case cCRCKernelSlicing8:
+                return "slicing8";
+            case cCRCKernelSlicing16:
+                return "slicing16";
+            case cCRCKernelCLMUL:
+                return "clmul";
+            default:
+                break;
+        }
+        return "?";
+    }
+
+    bool is_crc_kernel_supported(crc_kernel kernel)
+    {
+        switch (kernel)
+        {
+            case cCRCKernelTable:
+                return true;
+            case cCRCKernelSlicing8:
+            case cCRCKernelSlicing16:
+#if VOGL_LITTLE_ENDIAN_CPU
+                return true;
+#else
+                return false;
+#endif
+            case cCRCKernelCLMUL:
+#if VOGL_CRC_CLMUL_SUPPORTED
+                return crc_cpu_has_clmul();
+#else
+                return false;
+#endif
+            default:
+                break;
+        }
+        return false;
+    }
+
+    static crc_kernel select_crc_kernel()
+    {
+        if (is_crc_kernel_supported(cCRCKernelCLMUL))
+            return cCRCKernelCLMUL;
+        if (is_crc_kernel_supported(cCRCKernelSlicing16))
+            return cCRCKernelSlicing16;
+        return cCRCKernelTable;
+    }
+
+    crc_kernel get_active_crc_kernel()
+    {
+        static crc_kernel s_kernel = select_crc_kernel();
+        return s_kernel;
+    }
+
+    // The first call through each of these pointers picks the kernel.
+    static uint32_t crc32_kernel_first_call(uint32_t crc, const uint8_t *p, size_t len);
+    static uint64_t crc64_kernel_first_call(uint64_t crc, const uint8_t *p, size_t len);
+
+    static crc32_kernel_func g_pCRC32_kernel = crc32_kernel_first_call;
+    static crc64_kernel_func g_pCRC64_kernel = crc64_kernel_first_call;
+
+    static uint32_t crc32_kernel_first_call(uint32_t crc, const uint8_t *p, size_t len)
+    {
+        g_pCRC32_kernel = g_crc32_kernels[get_active_crc_kernel()];
+        return g_pCRC32_kernel(crc, p, len);
+    }
+
+    static uint64_t crc64_kernel_first_call(uint64_t crc, const uint8_t *p, size_t len)
+    {
+        g_pCRC64_kernel = g_crc64_kernels[get_active_crc_kernel()];
+        return g_pCRC64_kernel(crc, p, len);
+    }
+
+    uint32_t calc_crc32(uint32_t crc, const void *pBuf, size_t len)
+    {
+        return ~g_pCRC32_kernel(~crc, static_cast<const uint8_t *>(pBuf), len);
+    }
+
+    uint64_t calc_crc64(uint64_t crc, const uint8_t *buf, size_t size)
+    {
+        return ~g_pCRC64_kernel(~crc, buf, size);
+    }
+
+    uint32_t calc_crc32_with_kernel(crc_kernel kernel, uint32_t crc, const void *pBuf, size_t len)
+    {
+        VOGL_ASSERT(is_crc_kernel_supported(kernel));
+        return ~g_crc32_kernels[kernel](~crc, static_cast<const uint8_t *>(pBuf), len);
+    }
+
+    uint64_t calc_crc64_with_kernel(crc_kernel kernel, uint64_t crc, const void *pBuf, size_t len)
+    {
+        VOGL_ASSERT(is_crc_kernel_supported(kernel));
+        return ~g_crc64_kernels[kernel](~crc, static_cast<const uint8_t *>(pBuf), len);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // crc_test
+    // Checks every supported kernel against the byte at a time kernel (the previous mz_crc32()/calc_crc64() code),
+    // including odd lengths, misaligned starts and chaining.
+    //----------------------------------------------------------------------------------------------------------------------
+    bool crc_test()
+    {
+        const char *pCheck = "123456789";
+
+        for (uint32_t k = 0; k < cCRCKernelTotal; k++)
+        {
+            crc_kernel kernel = static_cast<crc_kernel>(k);
+            if (!is_crc_kernel_supported(kernel))
+                continue;
+
+            if ((calc_crc32_with_kernel(kernel, cInitCRC32, pCheck, 9) != 0xCBF43926U) ||
+                (calc_crc64_with_kernel(kernel, CRC64_INIT, pCheck, 9) != 0x995DC9BBDF1939FAULL))
+            {
+                console::error("%s: Kernel %s failed the check value test\n", VOGL_FUNCTION_INFO_CSTR, get_crc_kernel_name(kernel));
+                return false;
+            }
+        }
+
+        random rm;
+        rm.seed(1);
+
+        uint8_vec buf(64 * 1024 + 64);
+        for (uint32_t i = 0; i < buf.size(); i++)
+            buf[i] = static_cast<uint8_t>(rm.urand32());
+
+        for (uint32_t t = 0; t < 1536; t++)
+        {
+            uint32_t ofs = rm.irand(0, 64);
+            uint32_t len = (t < 1024) ? t : rm.irand_inclusive(0, (t & 1) ? 4096 : 64 * 1024);
+            uint32_t split = rm.irand_inclusive(0, len);
+            const uint8_t *p = buf.get_ptr() + ofs;
+
+            uint32_t init32 = (t & 2) ? rm.urand32() : cInitCRC32;
+            uint64_t init64 = (t & 2) ? rm.urand64() : CRC64_INIT;
+
+            uint32_t expected32 = calc_crc32_with_kernel(cCRCKernelTable, init32, p, len);
+            uint64_t expected64 = calc_crc64_with_kernel(cCRCKernelTable, init64, p, len);
+
+            if ((calc_crc32(init32, p, len) != expected32) || (calc_crc64(init64, p, len) != expected64))
+            {
+                console::error("%s: Dispatched CRC mismatch, len %u ofs %u\n", VOGL_FUNCTION_INFO_CSTR, len, ofs);
+                return false;
+            }
+
+            for (uint32_t k = cCRCKernelTable + 1; k < cCRCKernelTotal; k++)
+            {
+                crc_kernel kernel = static_cast<crc_kernel>(k);
+                if (!is_crc_kernel_supported(kernel))
+                    continue;
+
+                uint32_t crc32 = calc_crc32_with_kernel(kernel, init32, p, len);
+                uint64_t crc64 = calc_crc64_with_kernel(kernel, init64, p, len);
+
+                uint32_t chained32 = calc_crc32_with_kernel(kernel, calc_crc32_with_kernel(kernel, init32, p, split), p + split, len - split);
+                uint64_t chained64 = calc_crc64_with_kernel(kernel, calc_crc64_with_kernel(kernel, init64, p, split), p + split, len - split);
+
+                if ((crc32 != expected32) || (crc64 != expected64) || (chained32 != expected32) || (chained64 != expected64))
+                {
+                    console::error("%s: Kernel %s mismatch, len %u ofs %u split %u\n", VOGL_FUNCTION_INFO_CSTR, get_crc_kernel_name(kernel), len, ofs, split);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // crc_bench
+    // Prints each supported kernel's throughput on a large buffer, and on packet sized buffers.
+    //----------------------------------------------------------------------------------------------------------------------
+    bool crc_bench()
+    {
+        random rm;
+        rm.seed(1);
+
+        uint8_vec buf(256 * 1024 + 64);
+        for (uint32_t i = 0; i < buf.size(); i++)
+            buf[i] = static_cast<uint8_t>(rm.urand32());
+
+        printf("Active CRC kernel: %s\n", get_crc_kernel_name(get_active_crc_kernel()));
+
+        const uint32_t sizes[2] = { 256 * 1024, 96 };
+        for (uint32_t s = 0; s < VOGL_ARRAY_SIZE(sizes); s++)
+        {
+            const uint32_t size = sizes[s];
+            const uint32_t num_iters = (64 * 1024 * 1024) / size;
+
+            for (uint32_t k = 0; k < cCRCKernelTotal; k++)
+            {
+                crc_kernel kernel = static_cast<crc_kernel>(k);
+                if (!is_crc_kernel_supported(kernel))
+                    continue;
+
+                uint32_t crc32 = cInitCRC32;
+                uint64_t crc64 = CRC64_INIT;
+
+                timer tm;
+                tm.start();
+                for (uint32_t i = 0; i < num_iters; i++)
+                    crc32 = calc_crc32_with_kernel(kernel, crc32, buf.get_ptr() + (i & 15), size);
+                double secs32 = tm.get_elapsed_secs();
+
+                tm.start();
+                for (uint32_t i = 0; i < num_iters; i++)
+                    crc64 = calc_crc64_with_kernel(kernel, crc64, buf.get_ptr() + (i & 15), size);
+                double secs64 = tm.get_elapsed_secs();
+
+                double total_mb = (static_cast<double>(size) * num_iters) / (1024.0 * 1024.0);
+                printf("%10s, %6u byte buffers: crc32 %8.1f MB/sec, crc64 %8.1f MB/sec (%08X %016" PRIX64 ")\n",
+                       get_crc_kernel_name(kernel), size, secs32 > 0.0 ? total_mb / secs32 : 0.0, secs64 > 0.0 ? total_mb / secs64 : 0.0, crc32, crc64);
+            }
+        }
+
+        return true;
+    }
+
 } // namespace vogl
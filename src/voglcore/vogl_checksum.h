@@ -38,4 +38,31 @@ namespace vogl
     const uint32_t cInitCRC16 = 0;
     uint16_t crc16(const void *pBuf, size_t len, uint16_t crc = cInitCRC16);
 
+    // CRC-32 with the zlib/PNG polynomial, bit-identical to mz_crc32() (which now calls this). The 64-bit version is
+    // calc_crc64() in vogl_hash.h. Both dispatch at runtime to the fastest kernel the CPU supports.
+    const uint32_t cInitCRC32 = 0;
+    uint32_t calc_crc32(uint32_t crc, const void *pBuf, size_t len);
+
+    enum crc_kernel
+    {
+        cCRCKernelTable,     // byte at a time, the original implementation
+        cCRCKernelSlicing8,
+        cCRCKernelSlicing16,
+        cCRCKernelCLMUL,     // PCLMULQDQ folding, x86/x64 only
+        cCRCKernelTotal
+    };
+
+    const char *get_crc_kernel_name(crc_kernel kernel);
+    bool is_crc_kernel_supported(crc_kernel kernel);
+    crc_kernel get_active_crc_kernel();
+
+    // These always use the specified kernel, which must be supported. Intended for testing and benchmarking.
+    uint32_t calc_crc32_with_kernel(crc_kernel kernel, uint32_t crc, const void *pBuf, size_t len);
+    uint64_t calc_crc64_with_kernel(crc_kernel kernel, uint64_t crc, const void *pBuf, size_t len);
+
+    bool crc_test();
+
+    // Per kernel throughput. Run by vogltest --bench.
+    bool crc_bench();
+
 } // namespace vogl
@@ -131,6 +131,20 @@ namespace vogl
             return NULL;
         }
 
+        // Optional in-place writing: returns a pointer to len bytes at the current offset for the caller to fill in,
+        // followed by commit_write() with the number of bytes actually used (0 cancels). Returns NULL if the stream
+        // doesn't support this, in which case use write().
+        virtual void *reserve_write(uint32_t len)
+        {
+            VOGL_NOTE_UNUSED(len);
+            return NULL;
+        }
+        virtual bool commit_write(uint32_t len)
+        {
+            VOGL_NOTE_UNUSED(len);
+            return false;
+        }
+
         inline int read_byte()
         {
             uint8_t c;
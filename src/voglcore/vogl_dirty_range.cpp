@@ -0,0 +1,216 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_dirty_range.cpp
+#include "vogl_dirty_range.h"
+#include "vogl_rand.h"
+#include "vogl_timer.h"
+#include "vogl_console.h"
+
+namespace vogl
+{
+    bool find_dirty_ranges(dirty_range_vec &ranges, uint64_t &total_dirty_bytes, const void *pPrev, const void *pCur, uint64_t size, uint32_t granularity, uint32_t max_ranges)
+    {
+        VOGL_ASSERT(math::is_power_of_2(granularity));
+
+        ranges.resize(0);
+        total_dirty_bytes = 0;
+
+        const uint8_t *pP = static_cast<const uint8_t *>(pPrev);
+        const uint8_t *pC = static_cast<const uint8_t *>(pCur);
+
+        uint64_t ofs = 0;
+        while (ofs < size)
+        {
+            // Skip clean chunks
+            uint64_t chunk_size = math::minimum<uint64_t>(granularity, size - ofs);
+            if (memcmp(pP + ofs, pC + ofs, static_cast<size_t>(chunk_size)) == 0)
+            {
+                ofs += chunk_size;
+                continue;
+            }
+
+            // Extend the range over the following dirty chunks
+            uint64_t range_start = ofs;
+            ofs += chunk_size;
+
+            while (ofs < size)
+            {
+                chunk_size = math::minimum<uint64_t>(granularity, size - ofs);
+                if (memcmp(pP + ofs, pC + ofs, static_cast<size_t>(chunk_size)) == 0)
+                    break;
+                ofs += chunk_size;
+            }
+
+            if (ranges.size() >= max_ranges)
+            {
+                ranges.resize(0);
+                total_dirty_bytes = 0;
+                return false;
+            }
+
+            ranges.push_back(dirty_range(range_start, ofs - range_start));
+            total_dirty_bytes += ofs - range_start;
+        }
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // dirty_range_test
+    //----------------------------------------------------------------------------------------------------------------------
+    bool dirty_range_test()
+    {
+        random rm;
+        rm.seed(1);
+
+        dirty_range_vec ranges;
+        uint64_t total_dirty_bytes;
+
+        // Randomized correctness: patching a copy of prev with the found ranges must reproduce cur exactly, and every
+        // range must start on a chunk boundary.
+        for (uint32_t t = 0; t < 2000; t++)
+        {
+            uint32_t size = rm.irand_inclusive(0, 70000);
+            uint32_t granularity = 1U << rm.irand_inclusive(0, 12);
+
+            uint8_vec prev(size), cur(size);
+            for (uint32_t i = 0; i < size; i++)
+                prev[i] = static_cast<uint8_t>(rm.urand32());
+            cur = prev;
+
+            uint32_t num_writes = rm.irand_inclusive(0, 20);
+            for (uint32_t w = 0; (w < num_writes) && (size); w++)
+            {
+                uint32_t ofs = rm.irand(0, size);
+                uint32_t len = math::minimum<uint32_t>(rm.irand_inclusive(1, 3000), size - ofs);
+                for (uint32_t i = 0; i < len; i++)
+                    cur[ofs + i] = static_cast<uint8_t>(rm.urand32());
+            }
+
+            if (!find_dirty_ranges(ranges, total_dirty_bytes, prev.get_ptr(), cur.get_ptr(), size, granularity, cUINT32_MAX))
+                return false;
+
+            uint64_t expected_total = 0;
+            uint8_vec patched(prev);
+            for (uint32_t i = 0; i < ranges.size(); i++)
+            {
+                if ((ranges[i].m_ofs & (granularity - 1)) || (!ranges[i].m_size) || (ranges[i].m_ofs + ranges[i].m_size > size))
+                    return false;
+                if ((i) && (ranges[i].m_ofs <= ranges[i - 1].m_ofs + ranges[i - 1].m_size))
+                    return false;
+
+                memcpy(patched.get_ptr() + ranges[i].m_ofs, cur.get_ptr() + ranges[i].m_ofs, static_cast<size_t>(ranges[i].m_size));
+                expected_total += ranges[i].m_size;
+            }
+
+            if ((expected_total != total_dirty_bytes) || (!(patched == cur)))
+            {
+                console::error("%s: Trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                return false;
+            }
+        }
+
+        // The range limit must be honored
+        {
+            uint8_vec prev(4096), cur(4096);
+            for (uint32_t i = 0; i < cur.size(); i += 128)
+                cur[i] = 1;
+            if (find_dirty_ranges(ranges, total_dirty_bytes, prev.get_ptr(), cur.get_ptr(), cur.size(), 64, 31))
+                return false;
+            if (!find_dirty_ranges(ranges, total_dirty_bytes, prev.get_ptr(), cur.get_ptr(), cur.size(), 64, 32))
+                return false;
+            if ((ranges.size() != 32) || (total_dirty_bytes != 32 * 64))
+                return false;
+        }
+
+        // A large buffer of which the app rewrites a handful of small regions must come back as a few small ranges.
+        {
+            const uint32_t cBufSize = 1024 * 1024;
+            const uint32_t cGranularity = 256;
+
+            uint8_vec prev(cBufSize), cur(cBufSize);
+            for (uint32_t i = 0; i < cBufSize; i++)
+                prev[i] = static_cast<uint8_t>(i * 13 + (i >> 11));
+            cur = prev;
+
+            for (uint32_t w = 0; w < 16; w++)
+            {
+                uint32_t ofs = rm.irand(0, cBufSize - 4096);
+                uint32_t len = rm.irand_inclusive(64, 4096);
+                for (uint32_t i = 0; i < len; i++)
+                    cur[ofs + i] ^= 0xFF;
+            }
+
+            if (!find_dirty_ranges(ranges, total_dirty_bytes, prev.get_ptr(), cur.get_ptr(), cBufSize, cGranularity, cUINT32_MAX))
+                return false;
+
+            if ((!ranges.size()) || (total_dirty_bytes > 16 * (4096 + 2 * cGranularity)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool dirty_range_bench()
+    {
+        random rm;
+        rm.seed(1);
+
+        dirty_range_vec ranges;
+        uint64_t total_dirty_bytes;
+
+        // Size/throughput comparison: a 64MB streaming buffer of which the app rewrites a handful of small regions,
+        // recorded whole vs. recorded as dirty ranges.
+        const uint32_t cBufSize = 64 * 1024 * 1024;
+        const uint32_t cGranularity = 256;
+
+        uint8_vec prev(cBufSize), cur(cBufSize);
+        for (uint32_t i = 0; i < cBufSize; i++)
+            prev[i] = static_cast<uint8_t>(i * 13 + (i >> 11));
+        cur = prev;
+
+        for (uint32_t w = 0; w < 16; w++)
+        {
+            uint32_t ofs = rm.irand(0, cBufSize - 4096);
+            uint32_t len = rm.irand_inclusive(64, 4096);
+            for (uint32_t i = 0; i < len; i++)
+                cur[ofs + i] ^= 0xFF;
+        }
+
+        timer tm;
+        tm.start();
+        if (!find_dirty_ranges(ranges, total_dirty_bytes, prev.get_ptr(), cur.get_ptr(), cBufSize, cGranularity, cUINT32_MAX))
+            return false;
+        double scan_secs = tm.get_elapsed_secs();
+
+        console::message("%s: %u MB buffer: whole copy %u bytes, dirty ranges %" PRIu64 " bytes in %u ranges (%.3f%%), scanned at %.1f MB/sec\n",
+                         VOGL_FUNCTION_INFO_CSTR, cBufSize / (1024 * 1024), cBufSize, total_dirty_bytes, ranges.size(),
+                         (total_dirty_bytes * 100.0f) / cBufSize, (cBufSize / (1024.0 * 1024.0)) / math::maximum(scan_secs, .000001));
+
+        return true;
+    }
+
+} // namespace vogl
@@ -0,0 +1,62 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_dirty_range.h
+// Finds which parts of a memory block differ from a previously saved copy, so a writer only has to serialize the
+// bytes that were actually modified (e.g. a large mapped GL buffer the app only partially rewrote).
+#pragma once
+
+#include "vogl_core.h"
+
+namespace vogl
+{
+    struct dirty_range
+    {
+        inline dirty_range()
+        {
+        }
+        inline dirty_range(uint64_t ofs, uint64_t size)
+            : m_ofs(ofs), m_size(size)
+        {
+        }
+
+        uint64_t m_ofs;
+        uint64_t m_size;
+    };
+
+    typedef vogl::vector<dirty_range> dirty_range_vec;
+
+    // Compares pCur against pPrev in granularity sized chunks, and appends each run of adjacent modified chunks to
+    // ranges (the last chunk may be smaller than granularity). granularity must be a power of 2.
+    // Returns false if more than max_ranges ranges would be needed, in which case the caller should treat the whole
+    // block as dirty. total_dirty_bytes receives the sum of the range sizes.
+    bool find_dirty_ranges(dirty_range_vec &ranges, uint64_t &total_dirty_bytes, const void *pPrev, const void *pCur, uint64_t size, uint32_t granularity, uint32_t max_ranges);
+
+    bool dirty_range_test();
+
+    // Scan throughput on a large, sparsely modified buffer. Run by vogltest --bench.
+    bool dirty_range_bench();
+
+} // namespace vogl
@@ -65,6 +65,8 @@ namespace vogl
             DEFINE_WELL_KNOWN_STRING_HASH("map_range"),
             DEFINE_WELL_KNOWN_STRING_HASH("data"),
             DEFINE_WELL_KNOWN_STRING_HASH("flushed_ranges"),
+            DEFINE_WELL_KNOWN_STRING_HASH("dirty_ranges"),
+            DEFINE_WELL_KNOWN_STRING_HASH("dirty_tracking"),
             DEFINE_WELL_KNOWN_STRING_HASH("explicit_flush"),
             DEFINE_WELL_KNOWN_STRING_HASH("writable_map"),
             DEFINE_WELL_KNOWN_STRING_HASH("start"),
@@ -75,6 +77,7 @@ namespace vogl
             DEFINE_WELL_KNOWN_STRING_HASH("viewport_width"),
             DEFINE_WELL_KNOWN_STRING_HASH("viewport_height"),
             DEFINE_WELL_KNOWN_STRING_HASH("func_id"),
+            DEFINE_WELL_KNOWN_STRING_HASH("client_memory_refs"),
         };
         const uint32_t s_num_well_known_string_hashes = VOGL_ARRAY_SIZE(s_well_known_string_hashes);
 
@@ -138,46 +141,6 @@ namespace vogl
         return hash;
     }
 
-    // Public domain code originally from http://svn.r-project.org/R/trunk/src/extra/xz/check/crc64_small.c
-    uint64_t g_crc64_table[256];
-
-    void crc64_init()
-    {
-        static const uint64_t poly64 = 0xC96C5795D7870F42ULL;
-
-        for (size_t b = 0; b < 256; ++b)
-        {
-            uint64_t r = b;
-            for (size_t i = 0; i < 8; ++i)
-            {
-                if (r & 1)
-                    r = (r >> 1) ^ poly64;
-                else
-                    r >>= 1;
-            }
-
-            g_crc64_table[b] = r;
-        }
-
-        return;
-    }
-
-    uint64_t calc_crc64(uint64_t crc, const uint8_t *buf, size_t size)
-    {
-        if (!g_crc64_table[0])
-            crc64_init();
-
-        crc = ~crc;
-
-        while (size != 0)
-        {
-            crc = g_crc64_table[*buf++ ^ (crc & 0xFF)] ^ (crc >> 8);
-            --size;
-        }
-
-        return ~crc;
-    }
-
     uint64_t calc_sum64(const uint8_t *buf, size_t size, uint32_t shift_amount)
     {
         uint64_t sum = 0;
@@ -31,10 +31,8 @@
 
 namespace vogl
 {
-    extern uint64_t g_crc64_table[256];
-
+    // CRC-64 with the ECMA-182 polynomial (as used by xz). Implemented in vogl_checksum.cpp, see calc_crc32().
     const uint64_t CRC64_INIT = 0;
-    void crc64_init();
     uint64_t calc_crc64(uint64_t crc, const uint8_t *buf, size_t size);
 
     uint64_t calc_sum64(const uint8_t *buf, size_t size, uint32_t shift_amount = 0);
@@ -0,0 +1,216 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_hybrid_hash_map.cpp
+#include "vogl_hybrid_hash_map.h"
+#include "vogl_bidi_hash_map.h"
+#include "vogl_rand.h"
+#include "vogl_timer.h"
+#include "vogl_console.h"
+
+namespace vogl
+{
+    typedef hybrid_hash_map<uint32_t, uint32_t> uint_hybrid_hash_map;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // check_hybrid_hash_map
+    // Iteration must visit each of the reference's keys exactly once.
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool check_hybrid_hash_map(const uint_hybrid_hash_map &map, const hash_map<uint32_t, uint32_t> &ref)
+    {
+        if (map.size() != ref.size())
+            return false;
+
+        hash_map<uint32_t> visited;
+        uint32_t n = 0;
+        for (uint_hybrid_hash_map::const_iterator it = map.begin(); it != map.end(); ++it, ++n)
+        {
+            if (!visited.insert(it->first).second)
+                return false;
+
+            const uint32_t *pValue = ref.find_value(it->first);
+            if ((!pValue) || (*pValue != it->second))
+                return false;
+        }
+
+        return n == ref.size();
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // random_handle
+    // Mostly small, clustered handles like the ones GL hands out, with the occasional app chosen outlier.
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint32_t random_handle(random &rm, uint32_t dense_range)
+    {
+        if (!rm.irand(0, 50))
+            return rm.urand32();
+        return rm.irand_inclusive(0, dense_range);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // hybrid_hash_map_test
+    //----------------------------------------------------------------------------------------------------------------------
+    bool hybrid_hash_map_test()
+    {
+        random rm;
+        rm.seed(3);
+
+        for (uint32_t t = 0; t < 20; t++)
+        {
+            uint_hybrid_hash_map map;
+            hash_map<uint32_t, uint32_t> ref;
+
+            const uint32_t dense_range = rm.irand_inclusive(1, 20000);
+
+            for (uint32_t op = 0; op < 30000; op++)
+            {
+                uint32_t k = random_handle(rm, dense_range);
+
+                switch (rm.irand(0, 3))
+                {
+                    case 0:
+                    {
+                        uint32_t v = rm.urand32();
+                        if (map.insert(k, v).second != ref.insert(k, v).second)
+                            return false;
+                        break;
+                    }
+                    case 1:
+                    {
+                        if (map.erase(k) != ref.erase(k))
+                            return false;
+                        break;
+                    }
+                    default:
+                    {
+                        const uint32_t *pRef_value = ref.find_value(k);
+                        uint_hybrid_hash_map::const_iterator it(map.find(k));
+                        if ((it == map.end()) != (pRef_value == NULL))
+                            return false;
+                        if ((pRef_value) && ((it->first != k) || (it->second != *pRef_value) || (map.value(k) != *pRef_value)))
+                            return false;
+                        break;
+                    }
+                }
+
+                if ((op & 4095) == 4095)
+                {
+                    if (!check_hybrid_hash_map(map, ref))
+                    {
+                        console::error("%s: Trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                        return false;
+                    }
+                }
+            }
+
+            if (!check_hybrid_hash_map(map, ref))
+            {
+                console::error("%s: Trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                return false;
+            }
+
+            uint_hybrid_hash_map map_copy(map);
+            map.reset();
+            if ((!map.is_empty()) || (map.begin() != map.end()) || (!check_hybrid_hash_map(map_copy, ref)))
+                return false;
+        }
+
+        // Outliers must migrate into the dense array once it's grown to cover them.
+        {
+            uint_hybrid_hash_map map;
+            const uint32_t cOutlier = uint_hybrid_hash_map::cMinDenseSize * 8;
+            map.insert(cOutlier, 1);
+            if (map.get_sparse_map().size() != 1)
+                return false;
+            for (uint32_t i = 1; i <= cOutlier + 1; i++)
+                if (i != cOutlier)
+                    map.insert(i, i);
+            if ((map.get_dense_size() <= cOutlier) || (map.get_sparse_map().size()) || (map.value(cOutlier) != 1))
+                return false;
+        }
+
+        // The replayer's handle maps put a bidi_hash_map on top.
+        {
+            bidi_hash_map<uint32_t, uint32_t, hasher<uint32_t>, equal_to<uint32_t>, hasher<uint32_t>, equal_to<uint32_t>, uint_hybrid_hash_map> bidi_map;
+            for (uint32_t i = 1; i <= 1000; i++)
+                bidi_map.insert(i, i + 5000);
+            bidi_map.insert(0x80000000, 1);
+            bidi_map.update(10, 2);
+            bidi_map.erase(11);
+            if ((bidi_map.size() != 1000) || (bidi_map.key(2) != 10) || (bidi_map.contains_value(5010)) || (bidi_map.contains(11)) || (bidi_map.key(1) != 0x80000000))
+                return false;
+        }
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // hybrid_hash_map_bench
+    // Times a synthetic trace to replay handle lookup stream shaped like a real trace's: objects genned in order, a small
+    // hot working set referenced by most calls, and a few app chosen handles.
+    //----------------------------------------------------------------------------------------------------------------------
+    bool hybrid_hash_map_bench()
+    {
+        random rm;
+        rm.seed(3);
+
+        const uint32_t cNumHandles = 20000;
+        const uint32_t cNumLookups = 4000000;
+
+        uint_hybrid_hash_map map;
+        hash_map<uint32_t, uint32_t> ref;
+        vogl::vector<uint32_t> handles;
+        for (uint32_t i = 0; i < cNumHandles; i++)
+        {
+            uint32_t trace_handle = (i % 100) ? (i + 1) : (0x40000000 + i);
+            handles.push_back(trace_handle);
+            map.insert(trace_handle, i + 7);
+            ref.insert(trace_handle, i + 7);
+        }
+
+        vogl::vector<uint32_t> lookups(cNumLookups);
+        for (uint32_t i = 0; i < cNumLookups; i++)
+            lookups[i] = handles[rm.irand(0, 5) ? rm.irand(0, 256) : rm.irand(0, cNumHandles)];
+
+        timer tm;
+        tm.start();
+        uint64_t hash_sum = 0;
+        for (uint32_t i = 0; i < cNumLookups; i++)
+            hash_sum += ref.value(lookups[i]);
+        double hash_secs = tm.get_elapsed_secs();
+
+        tm.start();
+        uint64_t hybrid_sum = 0;
+        for (uint32_t i = 0; i < cNumLookups; i++)
+            hybrid_sum += map.value(lookups[i]);
+        double hybrid_secs = tm.get_elapsed_secs();
+
+        console::message("%s: %u handle lookups: hash_map %.3f secs, hybrid_hash_map %.3f secs (dense size %u, %u outliers)\n",
+                         VOGL_FUNCTION_INFO_CSTR, cNumLookups, hash_secs, hybrid_secs, map.get_dense_size(), map.get_sparse_map().size());
+
+        return hash_sum == hybrid_sum;
+    }
+
+} // namespace vogl
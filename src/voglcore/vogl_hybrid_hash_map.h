@@ -0,0 +1,385 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_hybrid_hash_map.h
+// Map from unsigned integer keys (e.g. GL handles) which directly indexes a dense array for keys below an adaptive
+// bound, and falls back to a hash_map for sparse outliers. Most GL handles are small and allocated sequentially, so most
+// lookups become a single array access instead of a hash probe.
+// The dense array grows to cover a new key only while at least 1/cMaxDenseSparsity of it would be in use (or the key
+// is below cMinDenseSize). Growing moves any outliers now covered by the array out of the hash_map.
+// Only const iterators are exposed. Iterators are invalidated by insert() and erase(), like hash_map's. Iteration order
+// is dense keys in ascending order, followed by the outliers in hash order.
+#pragma once
+
+#include "vogl_core.h"
+#include "vogl_hash_map.h"
+
+namespace vogl
+{
+    template <typename Key, typename Value, typename Hasher = hasher<Key>, typename Equals = equal_to<Key> >
+    class hybrid_hash_map
+    {
+    public:
+        typedef hybrid_hash_map<Key, Value, Hasher, Equals> hybrid_hash_map_type;
+        typedef hash_map<Key, Value, Hasher, Equals> sparse_map_type;
+        typedef std::pair<Key, Value> value_type;
+        typedef Key key_type;
+        typedef Value referent_type;
+
+        enum
+        {
+            cMinDenseSize = 1024U,
+            cMaxDenseSparsity = 4U
+        };
+
+    private:
+        struct dense_entry
+        {
+            dense_entry()
+                : m_value(), m_valid(false)
+            {
+            }
+
+            value_type m_value;
+            bool m_valid;
+        };
+
+        typedef vogl::vector<dense_entry> dense_entry_vec;
+
+    public:
+        class const_iterator
+        {
+            friend class hybrid_hash_map<Key, Value, Hasher, Equals>;
+
+        public:
+            inline const_iterator()
+                : m_pMap(NULL), m_dense_index(0)
+            {
+            }
+
+            // post-increment
+            inline const_iterator operator++(int)
+            {
+                const_iterator result(*this);
+                ++*this;
+                return result;
+            }
+
+            // pre-increment
+            inline const_iterator &operator++()
+            {
+                VOGL_ASSERT(m_pMap);
+
+                if (m_dense_index < m_pMap->m_dense.size())
+                {
+                    m_dense_index = m_pMap->find_next_dense(m_dense_index + 1);
+                    if (m_dense_index == m_pMap->m_dense.size())
+                        m_sparse_it = m_pMap->m_sparse.begin();
+                }
+                else
+                {
+                    ++m_sparse_it;
+                }
+
+                return *this;
+            }
+
+            inline const value_type &operator*() const
+            {
+                return *get_cur();
+            }
+            inline const value_type *operator->() const
+            {
+                return get_cur();
+            }
+
+            inline bool operator==(const const_iterator &b) const
+            {
+                return (m_pMap == b.m_pMap) && (m_dense_index == b.m_dense_index) && (m_sparse_it == b.m_sparse_it);
+            }
+            inline bool operator!=(const const_iterator &b) const
+            {
+                return !(*this == b);
+            }
+
+        private:
+            const hybrid_hash_map_type *m_pMap;
+
+            // Index into the dense array, or the dense array's size once iteration has moved on to the outliers.
+            uint32_t m_dense_index;
+            typename sparse_map_type::const_iterator m_sparse_it;
+
+            inline const_iterator(const hybrid_hash_map_type &map, uint32_t dense_index, const typename sparse_map_type::const_iterator &sparse_it)
+                : m_pMap(&map), m_dense_index(dense_index), m_sparse_it(sparse_it)
+            {
+            }
+
+            inline const value_type *get_cur() const
+            {
+                VOGL_ASSERT(m_pMap);
+
+                if (m_dense_index < m_pMap->m_dense.size())
+                {
+                    VOGL_ASSERT(m_pMap->m_dense[m_dense_index].m_valid);
+                    return &m_pMap->m_dense[m_dense_index].m_value;
+                }
+
+                return &*m_sparse_it;
+            }
+        };
+
+        typedef const_iterator iterator;
+        typedef std::pair<const_iterator, bool> insert_result;
+
+        inline hybrid_hash_map()
+            : m_num_dense(0)
+        {
+        }
+
+        inline void clear()
+        {
+            m_dense.clear();
+            m_sparse.clear();
+            m_num_dense = 0;
+        }
+
+        // Like clear(), but keeps the dense array's memory around.
+        inline void reset()
+        {
+            m_dense.resize(0);
+            m_sparse.reset();
+            m_num_dense = 0;
+        }
+
+        // Reserves room in the dense array, on the assumption that keys will be roughly 1..new_capacity.
+        inline void reserve(uint32_t new_capacity)
+        {
+            m_dense.reserve(new_capacity);
+        }
+
+        inline uint32_t size() const
+        {
+            return m_num_dense + m_sparse.size();
+        }
+
+        inline bool is_empty() const
+        {
+            return !size();
+        }
+
+        // The number of keys covered by the dense array, and how many of those are present.
+        inline uint32_t get_dense_size() const
+        {
+            return m_dense.size();
+        }
+
+        inline uint32_t get_num_dense() const
+        {
+            return m_num_dense;
+        }
+
+        inline const sparse_map_type &get_sparse_map() const
+        {
+            return m_sparse;
+        }
+
+        inline const_iterator begin() const
+        {
+            uint32_t dense_index = find_next_dense(0);
+            if (dense_index < m_dense.size())
+                return const_iterator(*this, dense_index, m_sparse.end());
+            return const_iterator(*this, dense_index, m_sparse.begin());
+        }
+
+        inline const_iterator end() const
+        {
+            return const_iterator(*this, m_dense.size(), m_sparse.end());
+        }
+
+        // Like hash_map::insert(), an existing key is left alone and false is returned.
+        inline insert_result insert(const Key &k, const Value &v = Value())
+        {
+            if (k >= m_dense.size())
+                grow_dense(k);
+
+            if (k < m_dense.size())
+            {
+                uint32_t index = static_cast<uint32_t>(k);
+                dense_entry &entry = m_dense[index];
+                if (entry.m_valid)
+                    return insert_result(const_iterator(*this, index, m_sparse.end()), false);
+
+                entry.m_value.first = k;
+                entry.m_value.second = v;
+                entry.m_valid = true;
+                m_num_dense++;
+
+                return insert_result(const_iterator(*this, index, m_sparse.end()), true);
+            }
+
+            typename sparse_map_type::insert_result result(m_sparse.insert(k, v));
+            return insert_result(const_iterator(*this, m_dense.size(), result.first), result.second);
+        }
+
+        inline insert_result insert(const value_type &v)
+        {
+            return insert(v.first, v.second);
+        }
+
+        inline bool erase(const Key &k)
+        {
+            if (k < m_dense.size())
+            {
+                dense_entry &entry = m_dense[static_cast<uint32_t>(k)];
+                if (!entry.m_valid)
+                    return false;
+
+                entry.m_value = value_type();
+                entry.m_valid = false;
+                m_num_dense--;
+                return true;
+            }
+
+            return m_sparse.erase(k);
+        }
+
+        inline const_iterator find(const Key &k) const
+        {
+            if (k < m_dense.size())
+            {
+                uint32_t index = static_cast<uint32_t>(k);
+                return m_dense[index].m_valid ? const_iterator(*this, index, m_sparse.end()) : end();
+            }
+
+            return const_iterator(*this, m_dense.size(), m_sparse.find(k));
+        }
+
+        inline const Value *find_value(const Key &k) const
+        {
+            if (k < m_dense.size())
+            {
+                const dense_entry &entry = m_dense[static_cast<uint32_t>(k)];
+                return entry.m_valid ? &entry.m_value.second : NULL;
+            }
+
+            return m_sparse.find_value(k);
+        }
+
+        inline Value *find_value(const Key &k)
+        {
+            if (k < m_dense.size())
+            {
+                dense_entry &entry = m_dense[static_cast<uint32_t>(k)];
+                return entry.m_valid ? &entry.m_value.second : NULL;
+            }
+
+            return m_sparse.find_value(k);
+        }
+
+        inline bool contains(const Key &k) const
+        {
+            return find_value(k) != NULL;
+        }
+
+        // Returns const ref to value if key is found, otherwise returns the default.
+        inline const Value &value(const Key &k, const Value &def = Value()) const
+        {
+            const Value *pValue = find_value(k);
+            return pValue ? *pValue : def;
+        }
+
+        inline void swap(hybrid_hash_map_type &other)
+        {
+            m_dense.swap(other.m_dense);
+            m_sparse.swap(other.m_sparse);
+            std::swap(m_num_dense, other.m_num_dense);
+        }
+
+    private:
+        dense_entry_vec m_dense;
+        sparse_map_type m_sparse;
+        uint32_t m_num_dense;
+
+        inline uint32_t find_next_dense(uint32_t index) const
+        {
+            while ((index < m_dense.size()) && (!m_dense[index].m_valid))
+                index++;
+            return index;
+        }
+
+        // Grows the dense array to cover k, if it would still be dense enough afterwards.
+        void grow_dense(const Key &k)
+        {
+            const uint32_t max_dense_size = math::maximum<uint32_t>(cMinDenseSize, (size() + 1U) * cMaxDenseSparsity);
+            if (k >= max_dense_size)
+                return;
+
+            const uint32_t new_dense_size = math::minimum(max_dense_size, math::maximum<uint32_t>(static_cast<uint32_t>(k) + 1U, m_dense.size() * 2U, cMinDenseSize));
+            m_dense.resize(new_dense_size);
+
+            if (m_sparse.is_empty())
+                return;
+
+            // Move any outliers the dense array now covers.
+            vogl::vector<Key> moved_keys;
+            for (typename sparse_map_type::const_iterator it = m_sparse.begin(); it != m_sparse.end(); ++it)
+            {
+                if (it->first >= new_dense_size)
+                    continue;
+
+                dense_entry &entry = m_dense[static_cast<uint32_t>(it->first)];
+                entry.m_value = *it;
+                entry.m_valid = true;
+                m_num_dense++;
+
+                moved_keys.push_back(it->first);
+            }
+
+            for (uint32_t i = 0; i < moved_keys.size(); i++)
+                m_sparse.erase(moved_keys[i]);
+        }
+    };
+
+    template <typename Key, typename Value, typename Hasher, typename Equals>
+    struct bitwise_movable<hybrid_hash_map<Key, Value, Hasher, Equals> >
+    {
+        enum
+        {
+            cFlag = true
+        };
+    };
+
+    template <typename Key, typename Value, typename Hasher, typename Equals>
+    inline void swap(hybrid_hash_map<Key, Value, Hasher, Equals> &a, hybrid_hash_map<Key, Value, Hasher, Equals> &b)
+    {
+        a.swap(b);
+    }
+
+    bool hybrid_hash_map_test();
+
+    // Handle lookups, hybrid_hash_map vs. hash_map. Run by vogltest --bench.
+    bool hybrid_hash_map_bench();
+
+} // namespace vogl
@@ -31,6 +31,7 @@
 #include "vogl_growable_array.h"
 #include "vogl_hash_map.h"
 #include "vogl_map.h"
+#include "vogl_rand.h"
 
 namespace vogl
 {
@@ -54,16 +55,16 @@ namespace vogl
     class json_deserialize_buf_ptr
     {
     public:
-        inline json_deserialize_buf_ptr(const char *p, size_t len)
+        inline json_deserialize_buf_ptr(const char *p, size_t len, uint32_t cur_line = 1)
         {
-            init(p, len);
+            init(p, len, cur_line);
         }
 
-        inline void init(const char *p, size_t len)
+        inline void init(const char *p, size_t len, uint32_t cur_line = 1)
         {
             m_pPtr = p;
             m_pEnd = p + len;
-            m_cur_line = 1;
+            m_cur_line = cur_line;
         }
 
         inline const char *get_end() const
@@ -3014,6 +3015,629 @@ namespace vogl
         return deserialize(str.get_ptr(), str.get_len(), pFilename);
     }
 
+    // class json_stream_reader
+
+    json_stream_reader::json_stream_reader()
+        : m_pFile(NULL),
+          m_owns_file(false),
+          m_is_binary(false),
+          m_file_eof(false),
+          m_buf_ofs(0),
+          m_buf_file_ofs(0),
+          m_read_size(cDefaultReadSize),
+          m_state(cStateClosed),
+          m_cur_line(1),
+          m_first_member(true),
+          m_first_element(true),
+          m_root_remaining(0),
+          m_array_remaining(0),
+          m_error_line(0)
+    {
+    }
+
+    json_stream_reader::~json_stream_reader()
+    {
+        close();
+    }
+
+    bool json_stream_reader::open(const char *pFilename, uint32_t read_size)
+    {
+        close();
+
+        m_error_msg.clear();
+        m_error_line = 0;
+
+        FILE *pFile = vogl_fopen(pFilename, "rb");
+        if (!pFile)
+        {
+            m_error_msg = "Unable to open file";
+            return false;
+        }
+
+        if (!open(pFile, read_size))
+        {
+            vogl_fclose(pFile);
+            return false;
+        }
+
+        m_owns_file = true;
+        return true;
+    }
+
+    bool json_stream_reader::open(FILE *pFile, uint32_t read_size)
+    {
+        close();
+
+        m_error_msg.clear();
+        m_error_line = 0;
+
+        m_pFile = pFile;
+        m_read_size = math::maximum<uint32_t>(read_size, 1U);
+
+        int64_t ofs = vogl_ftell(pFile);
+        m_buf_file_ofs = (ofs > 0) ? static_cast<uint64_t>(ofs) : 0;
+
+        m_state = cStateRoot;
+
+        // UBJ documents start with an object marker (or no-op's), text JSON with whitespace or '{'.
+        int c = peek_byte();
+        m_is_binary = (c == 'o') || (c == 'O') || (c == 'N');
+
+        bool success;
+        if (m_is_binary)
+            success = read_ubj_container_header(true, m_root_remaining);
+        else
+        {
+            skip_whitespace();
+            if (peek_byte() == '{')
+            {
+                m_buf_ofs++;
+                success = true;
+            }
+            else
+                success = set_error((c < 0) ? "Nothing to deserialize" : "Expected a root object");
+        }
+
+        if (!success)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void json_stream_reader::close()
+    {
+        if ((m_pFile) && (m_owns_file))
+            vogl_fclose(m_pFile);
+
+        m_pFile = NULL;
+        m_owns_file = false;
+        m_is_binary = false;
+        m_file_eof = false;
+
+        m_buf.clear();
+        m_buf_ofs = 0;
+        m_buf_file_ofs = 0;
+
+        m_state = cStateClosed;
+        m_cur_line = 1;
+        m_first_member = true;
+        m_first_element = true;
+        m_root_remaining = 0;
+        m_array_remaining = 0;
+
+        // The error message is kept, so it can be retrieved after a failed open().
+    }
+
+    bool json_stream_reader::set_error(const char *pMsg, ...)
+    {
+        va_list args;
+        va_start(args, pMsg);
+        m_error_msg.format_args(pMsg, args);
+        va_end(args);
+
+        m_error_line = m_is_binary ? 0 : m_cur_line;
+        m_state = cStateError;
+        return false;
+    }
+
+    // Makes at least n unconsumed bytes available, unless the file ends first.
+    bool json_stream_reader::fill(uint32_t n)
+    {
+        uint32_t num_avail = m_buf.size() - m_buf_ofs;
+        if (num_avail >= n)
+            return true;
+        if ((m_file_eof) || (n > (cUINT32_MAX - m_read_size)))
+            return false;
+
+        // Throw away what's been consumed.
+        if (m_buf_ofs)
+        {
+            if (num_avail)
+                memmove(m_buf.get_ptr(), m_buf.get_ptr() + m_buf_ofs, num_avail);
+            m_buf.resize(num_avail);
+            m_buf_file_ofs += m_buf_ofs;
+            m_buf_ofs = 0;
+        }
+
+        while ((m_buf.size() < n) && (!m_file_eof))
+        {
+            uint32_t cur_size = m_buf.size();
+            uint32_t read_size = math::maximum(m_read_size, n - cur_size);
+
+            m_buf.resize(cur_size + read_size, true);
+            size_t bytes_read = vogl_fread(m_buf.get_ptr() + cur_size, 1, read_size, m_pFile);
+            m_buf.resize(cur_size + static_cast<uint32_t>(bytes_read));
+
+            if (bytes_read < read_size)
+                m_file_eof = true;
+        }
+
+        return m_buf.size() >= n;
+    }
+
+    int json_stream_reader::peek_byte()
+    {
+        return fill(1) ? static_cast<uint8_t>(m_buf[m_buf_ofs]) : -1;
+    }
+
+    // Text JSON only, same rules as json_deserialize_buf_ptr::skip_whitespace().
+    void json_stream_reader::skip_whitespace()
+    {
+        for (;;)
+        {
+            int c = peek_byte();
+            if (c < 0)
+                break;
+
+            if (c == '/')
+            {
+                if ((!fill(2)) || (m_buf[m_buf_ofs + 1] != '/'))
+                    break;
+
+                m_buf_ofs += 2;
+                while (((c = peek_byte()) >= 0) && (c != '\n') && (c != '\r'))
+                    m_buf_ofs++;
+                continue;
+            }
+            else if (c > ' ')
+                break;
+
+            m_buf_ofs++;
+
+            if (c == '\r')
+            {
+                if (peek_byte() == '\n')
+                    m_buf_ofs++;
+                m_cur_line++;
+            }
+            else if (c == '\n')
+                m_cur_line++;
+        }
+    }
+
+    // Finds the extent of the text JSON value at the read position, reading more of the file until it's entirely buffered.
+    // This only matches up brackets, strings and comments, the value is validated when it's actually deserialized.
+    bool json_stream_reader::scan_text_value(uint32_t &len, uint32_t &num_lines)
+    {
+        uint32_t depth = 0;
+        bool in_string = false;
+        bool in_escape = false;
+        bool in_comment = false;
+        char prev_c = 0;
+
+        uint32_t i = 0;
+        num_lines = 0;
+
+        for (;;)
+        {
+            if (!fill(i + 1))
+            {
+                // Plain values may end the file.
+                if ((i) && (!depth) && (!in_string))
+                    break;
+                return set_error("Unexpected end of file");
+            }
+
+            const char c = m_buf[m_buf_ofs + i];
+            const bool is_new_line = (c == '\r') || ((c == '\n') && (prev_c != '\r'));
+            prev_c = c;
+
+            if (in_comment)
+            {
+                if ((c == '\n') || (c == '\r'))
+                    in_comment = false;
+            }
+            else if (in_string)
+            {
+                if (in_escape)
+                    in_escape = false;
+                else if (c == '\\')
+                    in_escape = true;
+                else if (c == '\"')
+                {
+                    in_string = false;
+                    if (!depth)
+                    {
+                        i++;
+                        break;
+                    }
+                }
+            }
+            else if ((!depth) && ((c <= ' ') || (c == ',') || (c == '}') || (c == ']') || (c == '/')))
+            {
+                // End of a plain value
+                break;
+            }
+            else if (c == '\"')
+                in_string = true;
+            else if ((c == '{') || (c == '['))
+                depth++;
+            else if ((c == '}') || (c == ']'))
+            {
+                if (!--depth)
+                {
+                    i++;
+                    break;
+                }
+            }
+            else if ((c == '/') && (fill(i + 2)) && (m_buf[m_buf_ofs + i + 1] == '/'))
+            {
+                in_comment = true;
+                i++;
+            }
+
+            if (is_new_line)
+                num_lines++;
+
+            i++;
+        }
+
+        len = i;
+        return true;
+    }
+
+    bool json_stream_reader::read_ubj_container_header(bool is_object, uint32_t &num_elements)
+    {
+        int c;
+        while ((c = peek_byte()) == 'N')
+            m_buf_ofs++;
+
+        const uint8_t *pSrc = reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf_ofs);
+
+        if (c == (is_object ? 'O' : 'A'))
+        {
+            if (!fill(5))
+                return set_error("Unexpected end of file");
+            pSrc = reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf_ofs);
+            num_elements = (pSrc[1] << 24) | (pSrc[2] << 16) | (pSrc[3] << 8) | pSrc[4];
+            m_buf_ofs += 5;
+        }
+        else if (c == (is_object ? 'o' : 'a'))
+        {
+            if (!fill(2))
+                return set_error("Unexpected end of file");
+            pSrc = reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf_ofs);
+            num_elements = (pSrc[1] == 255) ? cUINT32_MAX : pSrc[1];
+            m_buf_ofs += 2;
+        }
+        else
+            return set_error("Expected UBJ %s at offset %" PRIu64, is_object ? "object" : "array", get_cur_ofs());
+
+        return true;
+    }
+
+    // Moves to the next root member or array element, consuming the container's end if there are no more.
+    bool json_stream_reader::begin_element(bool in_array, bool &at_end)
+    {
+        at_end = false;
+
+        if (m_is_binary)
+        {
+            uint32_t &num_remaining = in_array ? m_array_remaining : m_root_remaining;
+            if (num_remaining == cUINT32_MAX)
+            {
+                int c;
+                while ((c = peek_byte()) == 'N')
+                    m_buf_ofs++;
+
+                if (c < 0)
+                    return set_error("Unexpected end of file");
+                else if (c == 'E')
+                {
+                    m_buf_ofs++;
+                    at_end = true;
+                }
+            }
+            else if (!num_remaining)
+                at_end = true;
+            else
+                num_remaining--;
+
+            return true;
+        }
+
+        bool &first = in_array ? m_first_element : m_first_member;
+        const char end_char = in_array ? ']' : '}';
+
+        skip_whitespace();
+
+        int c = peek_byte();
+        if (!first)
+        {
+            if (c == ',')
+            {
+                m_buf_ofs++;
+                skip_whitespace();
+                c = peek_byte();
+            }
+            else if (c != end_char)
+                return set_error((c < 0) ? "Unexpected end of file" : "Unexpected character within object or array");
+        }
+
+        if (c == end_char)
+        {
+            m_buf_ofs++;
+            at_end = true;
+        }
+        else if (c < 0)
+            return set_error("Unexpected end of file");
+        else
+            first = false;
+
+        return true;
+    }
+
+    bool json_stream_reader::read_key(dynamic_string &key)
+    {
+        if (m_is_binary)
+        {
+            int c;
+            while ((c = peek_byte()) == 'N')
+                m_buf_ofs++;
+
+            if ((c != 's') && (c != 'S'))
+                return set_error("Expected UBJ key string at offset %" PRIu64, get_cur_ofs());
+
+            const uint32_t header_size = (c == 'S') ? 5 : 2;
+            if (!fill(header_size))
+                return set_error("Unexpected end of file");
+
+            const uint8_t *pSrc = reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf_ofs);
+            uint32_t len = (c == 'S') ? ((pSrc[1] << 24) | (pSrc[2] << 16) | (pSrc[3] << 8) | pSrc[4]) : pSrc[1];
+            if ((len >= cMaxDynamicStringLen) || (!fill(header_size + len)))
+                return set_error("Invalid or truncated UBJ key string at offset %" PRIu64, get_cur_ofs());
+
+            key.set_from_buf(m_buf.get_ptr() + m_buf_ofs + header_size, len);
+            m_buf_ofs += header_size + len;
+            return true;
+        }
+
+        if (peek_byte() != '\"')
+            return set_error("Expected quoted key string");
+
+        json_value key_val;
+        if (!read_value(&key_val))
+            return false;
+        key = key_val.as_string_ptr("");
+
+        skip_whitespace();
+        if (peek_byte() != ':')
+            return set_error("Missing colon after key");
+        m_buf_ofs++;
+
+        skip_whitespace();
+        return true;
+    }
+
+    // Reads the value at the read position into pVal, or skips over it if pVal is NULL.
+    bool json_stream_reader::read_value(json_value *pVal)
+    {
+        if (m_is_binary)
+        {
+            json_value temp_val;
+            json_value &val = pVal ? *pVal : temp_val;
+
+            // A truncated UBJ value simply fails to parse, so read more and retry until the file is exhausted.
+            // The buffer grows geometrically, so this is linear in the value's size.
+            for (;;)
+            {
+                const uint8_t *pStart = reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf_ofs);
+                const uint8_t *pSrc = pStart;
+                if (val.binary_deserialize(pSrc, reinterpret_cast<const uint8_t *>(m_buf.get_ptr() + m_buf.size()), NULL, 0))
+                {
+                    m_buf_ofs += static_cast<uint32_t>(pSrc - pStart);
+                    return true;
+                }
+
+                uint32_t num_avail = m_buf.size() - m_buf_ofs;
+                fill(num_avail + math::maximum(num_avail, m_read_size));
+                if ((m_buf.size() - m_buf_ofs) == num_avail)
+                    return set_error("Invalid or truncated UBJ value at offset %" PRIu64, get_cur_ofs());
+            }
+        }
+
+        uint32_t len, num_lines;
+        if (!scan_text_value(len, num_lines))
+            return false;
+
+        if (pVal)
+        {
+            json_deserialize_buf_ptr buf_ptr(m_buf.get_ptr() + m_buf_ofs, len, m_cur_line);
+            json_error_info_t error_info;
+
+            if (!pVal->deserialize(buf_ptr, NULL, 0, error_info))
+            {
+                set_error("%s", error_info.m_error_msg.get_ptr());
+                m_error_line = error_info.m_error_line;
+                return false;
+            }
+
+            buf_ptr.skip_whitespace();
+            if (!buf_ptr.at_end())
+            {
+                set_error("Syntax error on/near line");
+                m_error_line = buf_ptr.get_cur_line();
+                return false;
+            }
+        }
+
+        m_buf_ofs += len;
+        m_cur_line += num_lines;
+        return true;
+    }
+
+    bool json_stream_reader::begin_array(const char *pKey, json_node &header)
+    {
+        if (m_state != cStateRoot)
+            return false;
+
+        header.clear();
+        header.set_is_object(true);
+
+        for (;;)
+        {
+            bool at_end;
+            if (!begin_element(false, at_end))
+                return false;
+            if (at_end)
+                return set_error("Couldn't find array \"%s\"", pKey);
+
+            dynamic_string key;
+            if (!read_key(key))
+                return false;
+
+            if (key == pKey)
+            {
+                if (m_is_binary)
+                {
+                    if (!read_ubj_container_header(false, m_array_remaining))
+                        return false;
+                }
+                else if (peek_byte() == '[')
+                {
+                    m_buf_ofs++;
+                    m_first_element = true;
+                }
+                else
+                    return set_error("\"%s\" is not an array", pKey);
+
+                m_state = cStateArray;
+                return true;
+            }
+
+            json_value val;
+            if (!read_value(&val))
+                return false;
+
+            header.add_key_value_assume_ownership(key.get_ptr(), val);
+        }
+    }
+
+    bool json_stream_reader::read_next_value(json_value &val)
+    {
+        if (m_state != cStateArray)
+            return false;
+
+        bool at_end;
+        if (!begin_element(true, at_end))
+            return false;
+
+        if (at_end)
+        {
+            m_state = cStateRoot;
+            return false;
+        }
+
+        return read_value(&val);
+    }
+
+    bool json_stream_reader::skip_next_value()
+    {
+        if (m_state != cStateArray)
+            return false;
+
+        bool at_end;
+        if (!begin_element(true, at_end))
+            return false;
+
+        if (at_end)
+        {
+            m_state = cStateRoot;
+            return false;
+        }
+
+        return read_value(NULL);
+    }
+
+    bool json_stream_reader::read_trailing_members(json_node &header)
+    {
+        if ((m_state != cStateRoot) && (m_state != cStateArray))
+            return false;
+
+        position pos;
+        get_position(pos);
+
+        while (skip_next_value())
+            ;
+
+        if (m_state != cStateRoot)
+            return false;
+
+        for (;;)
+        {
+            bool at_end;
+            if (!begin_element(false, at_end))
+                return false;
+            if (at_end)
+                break;
+
+            dynamic_string key;
+            if (!read_key(key))
+                return false;
+
+            json_value val;
+            if (!read_value(&val))
+                return false;
+
+            header.add_key_value_assume_ownership(key.get_ptr(), val);
+        }
+
+        return set_position(pos);
+    }
+
+    void json_stream_reader::get_position(position &pos) const
+    {
+        pos.m_ofs = get_cur_ofs();
+        pos.m_line = m_cur_line;
+        pos.m_state = m_state;
+        pos.m_first_member = m_first_member;
+        pos.m_first_element = m_first_element;
+        pos.m_root_remaining = m_root_remaining;
+        pos.m_array_remaining = m_array_remaining;
+    }
+
+    bool json_stream_reader::set_position(const position &pos)
+    {
+        if (vogl_fseek(m_pFile, static_cast<int64_t>(pos.m_ofs), SEEK_SET) != 0)
+            return set_error("Failed seeking file");
+
+        m_buf.resize(0);
+        m_buf_ofs = 0;
+        m_buf_file_ofs = pos.m_ofs;
+        m_file_eof = false;
+
+        m_cur_line = pos.m_line;
+        m_state = pos.m_state;
+        m_first_member = pos.m_first_member;
+        m_first_element = pos.m_first_element;
+        m_root_remaining = pos.m_root_remaining;
+        m_array_remaining = pos.m_array_remaining;
+        return true;
+    }
+
     class my_type
     {
     public:
@@ -3159,4 +3783,263 @@ namespace vogl
         return true;
     }
 
+    // json_stream_reader_test
+
+    static void json_stream_reader_test_add_random_value(json_node &node, const char *pKey, random &rm, uint32_t depth)
+    {
+        static const char *s_strings[] = { "", "glBindTexture", "a \"quoted\" string", "brackets ]}[{ and , commas", "// not a comment", "back\\slash\\", "tab\tnew\nline" };
+
+        json_value val;
+        switch (rm.irand(0, (depth < 3) ? 8 : 6))
+        {
+            case 0:
+                val.set_value_to_null();
+                break;
+            case 1:
+                val.set_value(rm.irand(0, 2) != 0);
+                break;
+            case 2:
+                val.set_value(static_cast<int64_t>(rm.irand(-100000, 100000)));
+                break;
+            case 3:
+                val.set_value(static_cast<int64_t>((static_cast<uint64_t>(rm.urand32()) << 32) | rm.urand32()));
+                break;
+            case 4:
+                val.set_value(static_cast<double>(rm.frand(-1e+6f, 1e+6f)));
+                break;
+            case 5:
+                val.set_value(s_strings[rm.irand(0, VOGL_ARRAY_SIZE(s_strings))]);
+                break;
+            case 6:
+            {
+                json_node &child = pKey ? node.add_object(pKey) : node.add_object();
+                for (uint32_t i = rm.irand(0, 6); i; --i)
+                    json_stream_reader_test_add_random_value(child, dynamic_string(cVarArg, "key%u", i).get_ptr(), rm, depth + 1);
+                return;
+            }
+            default:
+            {
+                json_node &child = pKey ? node.add_array(pKey) : node.add_array();
+                for (uint32_t i = rm.irand(0, (rm.irand(0, 8) == 0) ? 300 : 6); i; --i)
+                    json_stream_reader_test_add_random_value(child, NULL, rm, depth + 1);
+                return;
+            }
+        }
+
+        if (pKey)
+            node.add_key_value(pKey, val);
+        else
+            node.add_value(val);
+    }
+
+    static bool json_stream_reader_test_compare_members(const json_node &members, const json_node &root, uint32_t first_index, uint32_t end_index)
+    {
+        if (members.size() != (end_index - first_index))
+            return false;
+
+        for (uint32_t i = first_index; i < end_index; i++)
+        {
+            if ((members.get_key(i - first_index) != root.get_key(i)) || (!members.get_value(i - first_index).is_equal(root.get_value(i))))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Streams the "packets" array in pFile and checks it against doc.
+    static bool json_stream_reader_test_file(FILE *pFile, const json_document &doc, bool is_binary, uint32_t read_size)
+    {
+        const json_node *pRoot = doc.get_root();
+        const int packets_index = pRoot->find_key("packets");
+        const json_node *pPackets = pRoot->find_child_array("packets");
+        if ((packets_index < 0) || (!pPackets))
+            return false;
+
+        vogl_fseek(pFile, 0, SEEK_SET);
+
+        json_stream_reader reader;
+        if ((!reader.open(pFile, read_size)) || (reader.is_binary() != is_binary))
+            return false;
+
+        json_node header;
+        if (!reader.begin_array("packets", header))
+            return false;
+        if (!json_stream_reader_test_compare_members(header, *pRoot, 0, packets_index))
+            return false;
+
+        json_value val;
+        for (uint32_t i = 0; i < pPackets->size(); i++)
+        {
+            if (i == pPackets->size() / 2)
+            {
+                json_node trailer;
+                if ((!reader.read_trailing_members(trailer)) || (!json_stream_reader_test_compare_members(trailer, *pRoot, packets_index + 1, pRoot->size())))
+                    return false;
+            }
+
+            if ((i % 3) == 2)
+            {
+                if (!reader.skip_next_value())
+                    return false;
+            }
+            else if ((!reader.read_next_value(val)) || (!val.is_equal(pPackets->get_value(i))))
+            {
+                console::error("%s: Packet %u differs (read size %u)\n", VOGL_FUNCTION_INFO_CSTR, i, read_size);
+                return false;
+            }
+        }
+
+        if ((reader.read_next_value(val)) || (reader.has_error()))
+            return false;
+
+        json_node trailer;
+        if ((!reader.read_trailing_members(trailer)) || (!json_stream_reader_test_compare_members(trailer, *pRoot, packets_index + 1, pRoot->size())))
+            return false;
+
+        return true;
+    }
+
+    static bool json_stream_reader_test_buf(const void *pBuf, size_t buf_size, const json_document &doc, bool is_binary)
+    {
+        static const uint32_t s_read_sizes[] = { 1, 2, 3, 7, 61, 4096, json_stream_reader::cDefaultReadSize };
+
+        FILE *pFile = tmpfile();
+        if (!pFile)
+            return false;
+
+        bool success = fwrite(pBuf, 1, buf_size, pFile) == buf_size;
+        for (uint32_t i = 0; (success) && (i < VOGL_ARRAY_SIZE(s_read_sizes)); i++)
+            success = json_stream_reader_test_file(pFile, doc, is_binary, s_read_sizes[i]);
+
+        // Every truncation must be reported as an error by the time the root object should have ended.
+        for (uint32_t trial = 0; (success) && (trial < 16); trial++)
+        {
+            size_t truncated_size = (buf_size * trial) / 16;
+
+            FILE *pTruncated_file = tmpfile();
+            if (!pTruncated_file)
+                return false;
+
+            if (fwrite(pBuf, 1, truncated_size, pTruncated_file) == truncated_size)
+            {
+                vogl_fseek(pTruncated_file, 0, SEEK_SET);
+
+                json_stream_reader reader;
+                json_node header, trailer;
+                json_value val;
+                if ((reader.open(pTruncated_file, 61)) && (reader.begin_array("packets", header)))
+                {
+                    while (reader.read_next_value(val))
+                        ;
+                }
+                success = (!reader.is_opened()) || (reader.has_error()) || (!reader.read_trailing_members(trailer));
+            }
+            else
+                success = false;
+
+            fclose(pTruncated_file);
+        }
+
+        fclose(pFile);
+        return success;
+    }
+
+    bool json_stream_reader_test()
+    {
+        random rm;
+        rm.seed(2);
+
+        for (uint32_t t = 0; t < 8; t++)
+        {
+            json_document doc;
+            json_node *pRoot = doc.get_root();
+
+            json_node &meta_node = pRoot->add_object("meta");
+            meta_node.add_key_value("cur_frame", t);
+            json_node &uuid_array = meta_node.add_array("uuid");
+            for (uint32_t i = 0; i < 4; i++)
+                uuid_array.add_value(rm.urand32());
+            json_stream_reader_test_add_random_value(*pRoot, "sof", rm, 0);
+
+            // Cover both the short and long UBJ array encodings.
+            json_node &packets_array = pRoot->add_array("packets");
+            for (uint32_t i = (t & 1) ? rm.irand(255, 600) : rm.irand(0, 20); i; --i)
+            {
+                json_node &packet = packets_array.add_object();
+                packet.add_key_value("func", "glDrawArrays");
+                packet.add_key_value("call_counter", i);
+                for (uint32_t j = rm.irand(0, 5); j; --j)
+                    json_stream_reader_test_add_random_value(packet, dynamic_string(cVarArg, "param%u", j).get_ptr(), rm, 1);
+            }
+
+            if (t & 2)
+                json_stream_reader_test_add_random_value(*pRoot, "trailer", rm, 0);
+
+            for (uint32_t formatted = 0; formatted < 2; formatted++)
+            {
+                vogl::vector<char> text;
+                doc.serialize(text, formatted != 0, 0, false);
+                if (!json_stream_reader_test_buf(text.get_ptr(), text.size(), doc, false))
+                {
+                    console::error("%s: Text trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                    return false;
+                }
+            }
+
+            vogl::vector<uint8_t> ubj;
+            doc.binary_serialize(ubj);
+            if (!json_stream_reader_test_buf(ubj.get_ptr(), ubj.size(), doc, true))
+            {
+                console::error("%s: UBJ trial %u failed\n", VOGL_FUNCTION_INFO_CSTR, t);
+                return false;
+            }
+        }
+
+        // Hand edited text: comments, CRLF line endings, trailing commas, and plain values at the root.
+        static const char *s_pHand_edited =
+            "// frame 0\r\n"
+            "{\r\n"
+            "  \"meta\" : { \"cur_frame\" : 0, \"eof\" : 1 }, // } ] ,\r\n"
+            "  \"version\" : 3 ,\n"
+            "  \"packets\" : [ { \"func\" : \"glBegin\", \"x\" : \"]//\" } , // packet 0\n"
+            "                { \"func\" : \"glEnd\", \"p\" : [ 1, // one\n 2, ], }, \n"
+            "                \"odd\", 12.5, -3, true, null,\n"
+            "  ],\n"
+            "  \"trailer\" : \"done\"\n"
+            "}\n";
+
+        json_document hand_edited_doc;
+        if (!hand_edited_doc.deserialize(s_pHand_edited))
+            return false;
+
+        if (!json_stream_reader_test_buf(s_pHand_edited, strlen(s_pHand_edited), hand_edited_doc, false))
+        {
+            console::error("%s: Hand edited text failed\n", VOGL_FUNCTION_INFO_CSTR);
+            return false;
+        }
+
+        // Errors must report the same line as the DOM parser.
+        static const char *s_pBad = "{\r\n\"packets\" :\n[\n{ \"a\" : 1, // x\r\n \"c\" : [\r2\n] },\n\n{ \"b\" : ; }\n]\n}\n";
+
+        json_document bad_doc;
+        if (bad_doc.deserialize(s_pBad))
+            return false;
+
+        FILE *pFile = tmpfile();
+        if (!pFile)
+            return false;
+        fputs(s_pBad, pFile);
+        vogl_fseek(pFile, 0, SEEK_SET);
+
+        json_stream_reader reader;
+        json_node header;
+        json_value val;
+        bool success = reader.open(pFile) && reader.begin_array("packets", header) && reader.read_next_value(val) && !reader.read_next_value(val) &&
+                       reader.has_error() && (reader.get_error_line() == bad_doc.get_error_line());
+        reader.close();
+        fclose(pFile);
+
+        return success;
+    }
+
 } // namespace vogl
@@ -110,6 +110,7 @@ namespace vogl
     class json_value
     {
         friend class json_node;
+        friend class json_stream_reader;
 
     public:
         inline json_value();
@@ -696,6 +697,130 @@ namespace vogl
         uint32_t m_error_line;
     };
 
+    // json_stream_reader incrementally parses a text JSON or UBJ document whose root is an object holding one (possibly huge)
+    // array, such as the "packets" array of a JSON trace, and returns the array's elements one at a time.
+    // Only the current element and a small read buffer are held in memory, no matter how large the file is.
+    class json_stream_reader
+    {
+        VOGL_NO_COPY_OR_ASSIGNMENT_OP(json_stream_reader);
+
+    public:
+        enum
+        {
+            cDefaultReadSize = 64 * 1024
+        };
+
+        json_stream_reader();
+        ~json_stream_reader();
+
+        // Text JSON vs. UBJ is determined from the first byte.
+        bool open(const char *pFilename, uint32_t read_size = cDefaultReadSize);
+        // Reads from pFile's current position. The caller still owns pFile.
+        bool open(FILE *pFile, uint32_t read_size = cDefaultReadSize);
+        void close();
+
+        inline bool is_opened() const
+        {
+            return m_pFile != NULL;
+        }
+        inline bool is_binary() const
+        {
+            return m_is_binary;
+        }
+
+        // Reads the root members preceding the array named pKey into header (which is made an object), and stops at the array's first element.
+        bool begin_array(const char *pKey, json_node &header);
+
+        // Reads the next array element. Returns false at the end of the array or on errors (see has_error()).
+        bool read_next_value(json_value &val);
+        // Same, but doesn't build the value.
+        bool skip_next_value();
+
+        // Adds the root members following the array to header, then returns to the current element.
+        bool read_trailing_members(json_node &header);
+
+        inline bool has_error() const
+        {
+            return m_state == cStateError;
+        }
+        inline const dynamic_string &get_error_msg() const
+        {
+            return m_error_msg;
+        }
+        // Always 0 for UBJ.
+        inline uint32_t get_error_line() const
+        {
+            return m_error_line;
+        }
+
+        inline uint64_t get_cur_ofs() const
+        {
+            return m_buf_file_ofs + m_buf_ofs;
+        }
+
+    private:
+        enum state_t
+        {
+            cStateClosed,
+            cStateRoot,
+            cStateArray,
+            cStateDone,
+            cStateError
+        };
+
+        struct position
+        {
+            uint64_t m_ofs;
+            uint32_t m_line;
+            state_t m_state;
+            bool m_first_member;
+            bool m_first_element;
+            uint32_t m_root_remaining;
+            uint32_t m_array_remaining;
+        };
+
+        FILE *m_pFile;
+        bool m_owns_file;
+        bool m_is_binary;
+        bool m_file_eof;
+
+        // Unconsumed bytes are m_buf[m_buf_ofs, m_buf.size()). m_buf[0] is at file offset m_buf_file_ofs.
+        vogl::vector<char> m_buf;
+        uint32_t m_buf_ofs;
+        uint64_t m_buf_file_ofs;
+        uint32_t m_read_size;
+
+        state_t m_state;
+        uint32_t m_cur_line;
+
+        // Text JSON: no separator is expected before the next root member/array element.
+        bool m_first_member;
+        bool m_first_element;
+
+        // UBJ: elements left in the root object/array, or cUINT32_MAX if the container is terminated by an 'E' marker.
+        uint32_t m_root_remaining;
+        uint32_t m_array_remaining;
+
+        dynamic_string m_error_msg;
+        uint32_t m_error_line;
+
+        bool set_error(const char *pMsg, ...) VOGL_ATTRIBUTE_PRINTF(2, 3);
+
+        bool fill(uint32_t n);
+        int peek_byte();
+        void skip_whitespace();
+        bool scan_text_value(uint32_t &len, uint32_t &num_lines);
+        bool read_ubj_container_header(bool is_object, uint32_t &num_elements);
+        bool begin_element(bool in_array, bool &at_end);
+        bool read_key(dynamic_string &key);
+        bool read_value(json_value *pVal);
+
+        void get_position(position &pos) const;
+        bool set_position(const position &pos);
+    };
+
+    bool json_stream_reader_test();
+
     bool json_test();
 
 } // namespace vogl
@@ -31,6 +31,7 @@
 #include "vogl_port.h"
 #include "vogl_threading.h"
 #include "vogl_strutils.h"
+#include "vogl_timer.h"
 #include <malloc.h>
 
 // Set to 1 to enable stb_malloc, otherwise voglcore uses plain malloc/free/realloc
@@ -38,6 +39,17 @@
 #define VOGL_USE_STB_MALLOC 1
 #endif
 
+// Set to 1 to put small allocations through a per-thread block cache in front of the stb_malloc heap.
+// Always disabled when malloc debugging is enabled, so every allocation still goes through rmalloc.
+#ifndef VOGL_USE_THREAD_CACHE
+#define VOGL_USE_THREAD_CACHE 1
+#endif
+
+#if !VOGL_USE_STB_MALLOC || VOGL_MALLOC_DEBUGGING
+#undef VOGL_USE_THREAD_CACHE
+#define VOGL_USE_THREAD_CACHE 0
+#endif
+
 #ifndef VOGL_RAND_FILL_ALLLOCATED_MEMORY
 #define VOGL_RAND_FILL_ALLLOCATED_MEMORY 0
 #endif
@@ -138,6 +150,10 @@ static void *rmalloc_realloc_callback(void *ptr, size_t size, void *pUser)
 }
 #endif
 
+#if VOGL_USE_THREAD_CACHE
+static void init_thread_cache();
+#endif
+
 static void init_heap()
 {
     if (g_pHeap)
@@ -145,6 +161,10 @@ static void init_heap()
 
     pthread_mutex_init(&g_mutex, NULL);
 
+#if VOGL_USE_THREAD_CACHE
+    init_thread_cache();
+#endif
+
     stbm_heap_config config;
     memset(&config, 0, sizeof(config));
     config.system_alloc = sys_alloc;
@@ -175,12 +195,232 @@ static void unlock_heap()
     pthread_mutex_unlock(&g_mutex);
 }
 
+#if VOGL_USE_THREAD_CACHE
+// Per-thread cache of small heap blocks. Cached blocks are ordinary stb_malloc blocks sitting on a thread private
+// free list, so once handed out they can be freed, realloc'd or msize'd by any thread with no extra bookkeeping.
+// Blocks are binned by their usable size rounded down to cThreadCacheGranularity. A miss refills a bin with a batch of
+// blocks under a single heap lock, and a bin which grows past cThreadCacheMaxBlocksPerBin returns a batch to the heap.
+// This also bounds the cache of threads which mostly free blocks allocated by other threads (i.e. the async trace
+// writer thread).
+enum
+{
+    cThreadCacheGranularity = 16,
+    cThreadCacheNumBins = 32,
+    cThreadCacheMaxBlockSize = cThreadCacheGranularity * cThreadCacheNumBins,
+    cThreadCacheBatchSize = 32,
+    cThreadCacheMaxBlocksPerBin = cThreadCacheBatchSize * 4
+};
+
+struct thread_cache_block
+{
+    thread_cache_block *m_pNext;
+};
+
+struct thread_cache_bin
+{
+    thread_cache_block *m_pHead;
+    uint32_t m_num_blocks;
+};
+
+struct thread_cache
+{
+    thread_cache_bin m_bins[cThreadCacheNumBins];
+
+    // Links all live caches, guarded by g_mutex.
+    thread_cache *m_pPrev;
+    thread_cache *m_pNext;
+};
+
+static pthread_key_t g_thread_cache_key;
+static bool g_thread_cache_key_valid;
+
+// Left in a thread's slot once its cache has been torn down, so frees from TLS destructors which run after ours go
+// straight to the heap instead of creating a new cache which would never be freed.
+static thread_cache *const g_pTorn_down_thread_cache = reinterpret_cast<thread_cache *>(1);
+
+// Guarded by g_mutex
+static thread_cache *g_pThread_caches;
+static uint64_t g_total_thread_caches;
+static uint64_t g_total_thread_cache_refills;
+static uint64_t g_total_thread_cache_flushes;
+
+// Returns up to max_blocks blocks from the bin to the heap. Caller must hold the heap lock.
+static void thread_cache_flush_bin_locked(thread_cache_bin &bin, uint32_t max_blocks)
+{
+    while ((bin.m_pHead) && (max_blocks--))
+    {
+        thread_cache_block *pBlock = bin.m_pHead;
+        bin.m_pHead = pBlock->m_pNext;
+        bin.m_num_blocks--;
+
+        stbm_free(NULL, g_pHeap, pBlock);
+    }
+}
+
+static void thread_cache_destructor(void *pValue)
+{
+    thread_cache *pCache = static_cast<thread_cache *>(pValue);
+
+    // pthreads clears the slot before calling us, and calls us again (up to PTHREAD_DESTRUCTOR_ITERATIONS times) as
+    // long as other destructors leave values behind - keep the marker in place until the thread is gone.
+    if ((!pCache) || (pCache == g_pTorn_down_thread_cache))
+    {
+        if (pCache)
+            pthread_setspecific(g_thread_cache_key, g_pTorn_down_thread_cache);
+        return;
+    }
+
+    pthread_setspecific(g_thread_cache_key, g_pTorn_down_thread_cache);
+
+    lock_heap();
+
+    for (uint32_t i = 0; i < cThreadCacheNumBins; i++)
+        thread_cache_flush_bin_locked(pCache->m_bins[i], vogl::cUINT32_MAX);
+
+    if (pCache->m_pPrev)
+        pCache->m_pPrev->m_pNext = pCache->m_pNext;
+    else
+        g_pThread_caches = pCache->m_pNext;
+    if (pCache->m_pNext)
+        pCache->m_pNext->m_pPrev = pCache->m_pPrev;
+
+    stbm_free(NULL, g_pHeap, pCache);
+
+    unlock_heap();
+}
+
+static void init_thread_cache()
+{
+    g_thread_cache_key_valid = (pthread_key_create(&g_thread_cache_key, thread_cache_destructor) == 0);
+}
+
+static thread_cache *get_thread_cache()
+{
+    if (!g_thread_cache_key_valid)
+        return NULL;
+
+    thread_cache *pCache = static_cast<thread_cache *>(pthread_getspecific(g_thread_cache_key));
+    if (pCache)
+        return (pCache != g_pTorn_down_thread_cache) ? pCache : NULL;
+
+    lock_heap();
+
+    pCache = static_cast<thread_cache *>(stbm_alloc(NULL, g_pHeap, sizeof(thread_cache), 0));
+    if (pCache)
+    {
+        memset(pCache, 0, sizeof(thread_cache));
+
+        if (pthread_setspecific(g_thread_cache_key, pCache) != 0)
+        {
+            stbm_free(NULL, g_pHeap, pCache);
+            pCache = NULL;
+        }
+        else
+        {
+            pCache->m_pNext = g_pThread_caches;
+            if (g_pThread_caches)
+                g_pThread_caches->m_pPrev = pCache;
+            g_pThread_caches = pCache;
+
+            g_total_thread_caches++;
+        }
+    }
+
+    unlock_heap();
+
+    return pCache;
+}
+
+static void *thread_cache_alloc(size_t size)
+{
+    if (size > cThreadCacheMaxBlockSize)
+        return NULL;
+
+    thread_cache *pCache = get_thread_cache();
+    if (!pCache)
+        return NULL;
+
+    uint32_t bin_index = static_cast<uint32_t>((size + cThreadCacheGranularity - 1) / cThreadCacheGranularity) - 1;
+    thread_cache_bin &bin = pCache->m_bins[bin_index];
+
+    if (!bin.m_pHead)
+    {
+        size_t block_size = (bin_index + 1) * cThreadCacheGranularity;
+
+        lock_heap();
+
+        for (uint32_t i = 0; i < cThreadCacheBatchSize; i++)
+        {
+            thread_cache_block *pBlock = static_cast<thread_cache_block *>(stbm_alloc(NULL, g_pHeap, block_size, 0));
+            if (!pBlock)
+                break;
+
+            pBlock->m_pNext = bin.m_pHead;
+            bin.m_pHead = pBlock;
+            bin.m_num_blocks++;
+        }
+
+        g_total_thread_cache_refills++;
+
+        unlock_heap();
+
+        if (!bin.m_pHead)
+            return NULL;
+    }
+
+    thread_cache_block *pBlock = bin.m_pHead;
+    bin.m_pHead = pBlock->m_pNext;
+    bin.m_num_blocks--;
+
+    return pBlock;
+}
+
+// Returns false if the block wasn't cached, in which case the caller must free it to the heap.
+static bool thread_cache_free(void *p)
+{
+    // Reads the block's header only, doesn't need the heap lock.
+    size_t usable_size = stbm_get_allocation_size(p);
+    if ((usable_size < cThreadCacheGranularity) || (usable_size > cThreadCacheMaxBlockSize))
+        return false;
+
+    thread_cache *pCache = get_thread_cache();
+    if (!pCache)
+        return false;
+
+    uint32_t bin_index = static_cast<uint32_t>(usable_size / cThreadCacheGranularity) - 1;
+    thread_cache_bin &bin = pCache->m_bins[bin_index];
+
+    thread_cache_block *pBlock = static_cast<thread_cache_block *>(p);
+    pBlock->m_pNext = bin.m_pHead;
+    bin.m_pHead = pBlock;
+    bin.m_num_blocks++;
+
+    if (bin.m_num_blocks > cThreadCacheMaxBlocksPerBin)
+    {
+        lock_heap();
+
+        thread_cache_flush_bin_locked(bin, bin.m_num_blocks - cThreadCacheMaxBlocksPerBin + cThreadCacheBatchSize);
+        g_total_thread_cache_flushes++;
+
+        unlock_heap();
+    }
+
+    return true;
+}
+#endif // VOGL_USE_THREAD_CACHE
+
 static void *malloc_block(size_t size, const char *pFile_line)
 {
     // If you hit this assert, it's most likely because vogl_core_init()
     //  (which calls vogl_init_heap) hasn't been called.
     VOGL_ASSERT(g_pHeap);
 
+#if VOGL_USE_THREAD_CACHE
+    void *pCached = thread_cache_alloc(size);
+    if (pCached)
+        return pCached;
+#endif
+
     lock_heap();
 
 #if VOGL_MALLOC_DEBUGGING
@@ -217,6 +457,11 @@ static void free_block(void *p, const char *pFile_line)
 {
     VOGL_ASSERT(g_pHeap);
 
+#if VOGL_USE_THREAD_CACHE
+    if (thread_cache_free(p))
+        return;
+#endif
+
     lock_heap();
 
 #if VOGL_MALLOC_DEBUGGING
@@ -260,6 +505,35 @@ static void print_stats(const char *pFile_line)
 #else
     VOGL_NOTE_UNUSED(pFile_line);
 #endif
+
+#if VOGL_USE_THREAD_CACHE
+    lock_heap();
+
+    uint64_t total_thread_caches = g_total_thread_caches;
+    uint64_t total_refills = g_total_thread_cache_refills;
+    uint64_t total_flushes = g_total_thread_cache_flushes;
+
+    // Cached blocks are allocated as far as the heap is concerned. The owning threads update their bins without
+    // the lock, so this is only a snapshot.
+    uint32_t num_live_caches = 0;
+    uint64_t total_cached_blocks = 0, total_cached_bytes = 0;
+    for (const thread_cache *pCache = g_pThread_caches; pCache; pCache = pCache->m_pNext)
+    {
+        num_live_caches++;
+
+        for (uint32_t i = 0; i < cThreadCacheNumBins; i++)
+        {
+            uint32_t num_blocks = *static_cast<const volatile uint32_t *>(&pCache->m_bins[i].m_num_blocks);
+            total_cached_blocks += num_blocks;
+            total_cached_bytes += static_cast<uint64_t>(num_blocks) * (i + 1) * cThreadCacheGranularity;
+        }
+    }
+
+    unlock_heap();
+
+    printf("Thread cache: %" PRIu64 " caches created, %u live caches holding %" PRIu64 " blocks (at least %" PRIu64 " bytes), %" PRIu64 " bin refills, %" PRIu64 " bin flushes\n",
+           total_thread_caches, num_live_caches, total_cached_blocks, total_cached_bytes, total_refills, total_flushes);
+#endif
 }
 
 static void check(const char *pFile_line)
@@ -619,6 +893,198 @@ void vogl_tracked_check_heap(const char *pFile_line)
 #endif
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// mem_thread_cache_test / mem_perf_bench
+// Each thread randomly frees and reallocates blocks in a private set of slots, then frees the blocks left in its
+// neighbor's slots (so some frees happen on a different thread than the allocation).
+//----------------------------------------------------------------------------------------------------------------------
+enum
+{
+    cMemPerfSlotsPerThread = 512,
+    cMemPerfMaxThreads = 8
+};
+
+struct mem_perf_thread_state
+{
+    void *m_slots[cMemPerfSlotsPerThread];
+    uint32_t m_iterations;
+    uint32_t m_seed;
+    uint32_t m_num_errors;
+};
+
+static inline uint32_t mem_perf_rand(uint32_t &seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static inline uint8_t mem_perf_tag(void *p)
+{
+    return static_cast<uint8_t>((reinterpret_cast<uintptr_t>(p) >> 4) ^ 0xA5);
+}
+
+static void mem_perf_alloc_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_NOTE_UNUSED(data);
+
+    mem_perf_thread_state &state = *static_cast<mem_perf_thread_state *>(pData_ptr);
+
+    for (uint32_t i = 0; i < state.m_iterations; i++)
+    {
+        uint32_t r = mem_perf_rand(state.m_seed);
+        uint32_t slot = r % cMemPerfSlotsPerThread;
+
+        void *p = state.m_slots[slot];
+        if (p)
+        {
+            if (*static_cast<uint8_t *>(p) != mem_perf_tag(p))
+                state.m_num_errors++;
+            vogl_tracked_free(VOGL_FILE_POS_STRING, p);
+        }
+
+        // Mostly small blocks, with the occasional larger one.
+        size_t size = ((r >> 16) & 15) ? (8 + ((r >> 8) & 255)) : (1024 + ((r >> 8) & 4095));
+
+        p = vogl_tracked_malloc(VOGL_FILE_POS_STRING, size);
+        *static_cast<uint8_t *>(p) = mem_perf_tag(p);
+        state.m_slots[slot] = p;
+    }
+}
+
+static void mem_perf_free_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_NOTE_UNUSED(data);
+
+    mem_perf_thread_state &state = *static_cast<mem_perf_thread_state *>(pData_ptr);
+
+    for (uint32_t i = 0; i < cMemPerfSlotsPerThread; i++)
+    {
+        void *p = state.m_slots[i];
+        if (!p)
+            continue;
+
+        if (*static_cast<uint8_t *>(p) != mem_perf_tag(p))
+            state.m_num_errors++;
+
+        vogl_tracked_free(VOGL_FILE_POS_STRING, p);
+        state.m_slots[i] = NULL;
+    }
+}
+
+// Returns the number of corrupted blocks seen, or cUINT32_MAX if the threads couldn't be created.
+static uint32_t mem_perf_run(uint32_t num_threads, uint32_t iterations, double &secs)
+{
+    secs = 0.0;
+
+    mem_perf_thread_state *pStates = static_cast<mem_perf_thread_state *>(vogl_tracked_calloc(VOGL_FILE_POS_STRING, num_threads, sizeof(mem_perf_thread_state)));
+
+    task_pool pool;
+    if (!pool.init(num_threads))
+    {
+        vogl_tracked_free(VOGL_FILE_POS_STRING, pStates);
+        return cUINT32_MAX;
+    }
+
+    for (uint32_t i = 0; i < num_threads; i++)
+    {
+        pStates[i].m_iterations = iterations;
+        pStates[i].m_seed = 0x9E3779B9U * (i + 1);
+    }
+
+    timer tm;
+    tm.start();
+
+    for (uint32_t i = 0; i < num_threads; i++)
+        pool.queue_task(mem_perf_alloc_task, 0, &pStates[i]);
+    pool.join();
+
+    // Free each thread's remaining blocks on another thread.
+    for (uint32_t i = 0; i < num_threads; i++)
+        pool.queue_task(mem_perf_free_task, 0, &pStates[(i + 1) % num_threads]);
+    pool.join();
+
+    secs = tm.get_elapsed_secs();
+
+    pool.deinit();
+
+    uint32_t total_errors = 0;
+    for (uint32_t i = 0; i < num_threads; i++)
+        total_errors += pStates[i].m_num_errors;
+
+    vogl_tracked_free(VOGL_FILE_POS_STRING, pStates);
+
+    return total_errors;
+}
+
+#if VOGL_USE_THREAD_CACHE
+static uint32_t get_num_live_thread_caches()
+{
+    lock_heap();
+
+    uint32_t n = 0;
+    for (const thread_cache *pCache = g_pThread_caches; pCache; pCache = pCache->m_pNext)
+        n++;
+
+    unlock_heap();
+
+    return n;
+}
+#endif
+
+bool mem_thread_cache_test()
+{
+#if VOGL_USE_THREAD_CACHE
+    uint32_t prev_live_caches = get_num_live_thread_caches();
+#endif
+
+    double secs;
+    uint32_t total_errors = mem_perf_run(4, 20000, secs);
+    if (total_errors)
+    {
+        printf("mem_thread_cache_test: %u corrupted blocks detected!\n", total_errors);
+        return false;
+    }
+
+#if VOGL_USE_THREAD_CACHE
+    // The pool's threads have exited, so their caches must have been flushed and released (and not recreated by
+    // frees made later during thread teardown).
+    uint32_t live_caches = get_num_live_thread_caches();
+    if (live_caches != prev_live_caches)
+    {
+        printf("mem_thread_cache_test: %u thread caches live after the worker threads exited, expected %u\n", live_caches, prev_live_caches);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool mem_perf_bench()
+{
+    const uint32_t cIterations = 250000;
+
+    for (uint32_t num_threads = 1; num_threads <= cMemPerfMaxThreads; num_threads *= 2)
+    {
+        double secs;
+        uint32_t total_errors = mem_perf_run(num_threads, cIterations, secs);
+        if (total_errors)
+        {
+            printf("mem_perf_bench: %u corrupted blocks detected!\n", total_errors);
+            return false;
+        }
+
+        uint64_t total_ops = static_cast<uint64_t>(cIterations) * 2U * num_threads;
+        printf("%u thread(s): %.3f secs, %.2f million allocs+frees/sec\n",
+               num_threads, secs, secs > 0.0 ? (total_ops / secs) / 1000000.0 : 0.0);
+    }
+
+    vogl_tracked_print_stats(VOGL_FILE_POS_STRING);
+
+    return true;
+}
+
 VOGL_NAMESPACE_END(vogl)
 
 extern "C" void *vogl_realloc(const char *pFile_line, void *p, size_t new_size)
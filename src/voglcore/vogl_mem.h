@@ -70,6 +70,11 @@ namespace vogl
 #endif
     void vogl_init_heap();
 
+    // Multithreaded allocation test (checks blocks freed on other threads and per-thread cache teardown), and a
+    // throughput benchmark of the same pattern.
+    bool mem_thread_cache_test();
+    bool mem_perf_bench();
+
     void *vogl_tracked_malloc(const char *pFile_line, size_t size, size_t *pActual_size = NULL);
     void *vogl_tracked_realloc(const char *pFile_line, void *p, size_t size, size_t *pActual_size = NULL);
     void *vogl_tracked_calloc(const char *pFile_line, size_t count, size_t size, size_t *pActual_size = NULL);
@@ -71,6 +71,18 @@ int32_t plat_get_virtual_page_size();
 void* plat_virtual_alloc(size_t size_requested, uint32_t access_flags, size_t* out_size_provided);
 void plat_virtual_free(void* free_addr, size_t size);
 
+// Read-only file mappings
+#define PLAT_ADVISE_NORMAL 0
+#define PLAT_ADVISE_SEQUENTIAL 1
+#define PLAT_ADVISE_WILLNEED 2
+
+// Maps the whole file read-only. Returns NULL on failure, or if the file is empty or too large to map.
+const void* plat_map_file_readonly(const char* path, uint64_t* out_size);
+void plat_unmap_file(const void* addr, uint64_t size);
+
+// Access pattern hint for part of a file mapping. Only a hint, may do nothing.
+void plat_advise_mapped_file(const void* addr, uint64_t size, uint32_t advice);
+
 #if VOGL_USE_PTHREADS_API
     int plat_sem_post(sem_t* sem, uint32_t release_count);
     void plat_try_sem_post(sem_t* sem, uint32_t release_count);
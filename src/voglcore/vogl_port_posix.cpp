@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <paths.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
 
@@ -225,6 +226,58 @@ void plat_virtual_free(void* free_addr, size_t size)
     }
 }
 
+const void* plat_map_file_readonly(const char* path, uint64_t* out_size)
+{
+    *out_size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0) || (static_cast<uint64_t>(st.st_size) > static_cast<uint64_t>(SIZE_MAX)))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping holds its own reference to the file.
+    close(fd);
+
+    if (p == MAP_FAILED)
+        return NULL;
+
+    *out_size = static_cast<uint64_t>(st.st_size);
+    return p;
+}
+
+void plat_unmap_file(const void* addr, uint64_t size)
+{
+    if (addr)
+        munmap(const_cast<void *>(addr), static_cast<size_t>(size));
+}
+
+void plat_advise_mapped_file(const void* addr, uint64_t size, uint32_t advice)
+{
+    if ((!addr) || (!size))
+        return;
+
+    // madvise() wants a page aligned start address.
+    uintptr_t page_mask = static_cast<uintptr_t>(plat_get_virtual_page_size()) - 1;
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~page_mask;
+    size_t len = static_cast<size_t>(size + (reinterpret_cast<uintptr_t>(addr) - start));
+
+    int posix_advice = MADV_NORMAL;
+    if (advice == PLAT_ADVISE_SEQUENTIAL)
+        posix_advice = MADV_SEQUENTIAL;
+    else if (advice == PLAT_ADVISE_WILLNEED)
+        posix_advice = MADV_WILLNEED;
+
+    madvise(reinterpret_cast<void *>(start), len, posix_advice);
+}
+
 #if VOGL_USE_PTHREADS_API
     int plat_sem_post(sem_t* sem, uint32_t release_count)
     {
@@ -209,6 +209,54 @@ void plat_virtual_free(void* free_addr, size_t size)
     }
 }
 
+const void* plat_map_file_readonly(const char* path, uint64_t* out_size)
+{
+    *out_size = 0;
+
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER file_size;
+    if ((!GetFileSizeEx(hFile, &file_size)) || (file_size.QuadPart <= 0) || (static_cast<uint64_t>(file_size.QuadPart) > static_cast<uint64_t>(SIZE_MAX)))
+    {
+        CloseHandle(hFile);
+        return NULL;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(hFile);
+    if (!hMapping)
+        return NULL;
+
+    // The view holds its own reference to the mapping.
+    void* p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping);
+
+    if (!p)
+        return NULL;
+
+    *out_size = static_cast<uint64_t>(file_size.QuadPart);
+    return p;
+}
+
+void plat_unmap_file(const void* addr, uint64_t size)
+{
+    VOGL_NOTE_UNUSED(size);
+
+    if (addr)
+        UnmapViewOfFile(addr);
+}
+
+void plat_advise_mapped_file(const void* addr, uint64_t size, uint32_t advice)
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN already covers the sequential case, and PrefetchVirtualMemory() isn't available on
+    // every version of Windows we support.
+    VOGL_NOTE_UNUSED(addr);
+    VOGL_NOTE_UNUSED(size);
+    VOGL_NOTE_UNUSED(advice);
+}
+
 #if VOGL_USE_PTHREADS_API
     int plat_sem_post(sem_t* sem, uint32_t release_count)
     {
@@ -0,0 +1,305 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_spsc_ring_buffer.cpp
+#include "vogl_spsc_ring_buffer.h"
+#include "vogl_threading.h"
+#include "vogl_rand.h"
+#include "vogl_console.h"
+
+namespace vogl
+{
+    spsc_ring_buffer::spsc_ring_buffer()
+        : m_pBuf(NULL),
+          m_capacity(0),
+          m_pending_write_bytes(0),
+          m_pending_read_bytes(0),
+          m_write_ofs(0),
+          m_read_ofs(0)
+    {
+    }
+
+    spsc_ring_buffer::~spsc_ring_buffer()
+    {
+        deinit();
+    }
+
+    bool spsc_ring_buffer::init(uint32_t capacity)
+    {
+        deinit();
+
+        capacity = math::clamp<uint32_t>(math::next_pow2(capacity), cMinCapacity, cMaxCapacity);
+
+        m_pBuf = static_cast<uint8_t *>(vogl_malloc(capacity));
+        if (!m_pBuf)
+            return false;
+
+        m_capacity = capacity;
+
+        return true;
+    }
+
+    void spsc_ring_buffer::deinit()
+    {
+        if (m_pBuf)
+        {
+            vogl_free(m_pBuf);
+            m_pBuf = NULL;
+        }
+
+        m_capacity = 0;
+        m_pending_write_bytes = 0;
+        m_pending_read_bytes = 0;
+        m_write_ofs = 0;
+        m_read_ofs = 0;
+    }
+
+    void *spsc_ring_buffer::begin_write(uint32_t size)
+    {
+        VOGL_ASSERT(!m_pending_write_bytes);
+
+        if ((!m_pBuf) || (size > get_max_record_size()))
+            return NULL;
+
+        const uint32_t record_bytes = align_record_size(size);
+
+        // Only the producer modifies m_write_ofs, so a plain read is fine here.
+        const uint32_t write_ofs = static_cast<uint32_t>(m_write_ofs);
+        const uint32_t read_ofs = static_cast<uint32_t>(atomic_load32(&m_read_ofs));
+
+        uint32_t buf_ofs = write_ofs & (m_capacity - 1);
+        const uint32_t bytes_until_wrap = m_capacity - buf_ofs;
+
+        uint32_t padding_bytes = 0;
+        if (record_bytes > bytes_until_wrap)
+            padding_bytes = bytes_until_wrap;
+
+        const uint32_t bytes_free = m_capacity - (write_ofs - read_ofs);
+        if ((padding_bytes + record_bytes) > bytes_free)
+            return NULL;
+
+        if (padding_bytes)
+        {
+            // bytes_until_wrap is always a multiple of cRecordAlignment, so there's always room for a header here.
+            record_header *pPadding = reinterpret_cast<record_header *>(m_pBuf + buf_ofs);
+            pPadding->m_size = padding_bytes - sizeof(record_header);
+            pPadding->m_flags = cRecordFlagPadding;
+            buf_ofs = 0;
+        }
+
+        record_header *pHeader = reinterpret_cast<record_header *>(m_pBuf + buf_ofs);
+        pHeader->m_size = size;
+        pHeader->m_flags = 0;
+
+        m_pending_write_bytes = padding_bytes + record_bytes;
+
+        return pHeader + 1;
+    }
+
+    void spsc_ring_buffer::end_write()
+    {
+        VOGL_ASSERT(m_pending_write_bytes);
+
+        // The store has release semantics, so the consumer can't observe the new offset before the record's contents.
+        atomic_store32(&m_write_ofs, static_cast<uint32_t>(m_write_ofs) + m_pending_write_bytes);
+
+        m_pending_write_bytes = 0;
+    }
+
+    const void *spsc_ring_buffer::begin_read(uint32_t &size)
+    {
+        VOGL_ASSERT(!m_pending_read_bytes);
+
+        size = 0;
+
+        if (!m_pBuf)
+            return NULL;
+
+        // Only the consumer modifies m_read_ofs.
+        uint32_t read_ofs = static_cast<uint32_t>(m_read_ofs);
+        const uint32_t write_ofs = static_cast<uint32_t>(atomic_load32(&m_write_ofs));
+
+        for (;;)
+        {
+            if (read_ofs == write_ofs)
+                return NULL;
+
+            const record_header *pHeader = reinterpret_cast<const record_header *>(m_pBuf + (read_ofs & (m_capacity - 1)));
+            if (pHeader->m_flags & cRecordFlagPadding)
+            {
+                read_ofs += sizeof(record_header) + pHeader->m_size;
+                atomic_store32(&m_read_ofs, read_ofs);
+                continue;
+            }
+
+            size = pHeader->m_size;
+            m_pending_read_bytes = align_record_size(size);
+
+            return pHeader + 1;
+        }
+    }
+
+    void spsc_ring_buffer::end_read()
+    {
+        VOGL_ASSERT(m_pending_read_bytes);
+
+        atomic_store32(&m_read_ofs, static_cast<uint32_t>(m_read_ofs) + m_pending_read_bytes);
+
+        m_pending_read_bytes = 0;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // spsc_ring_buffer::backoff::wait
+    //----------------------------------------------------------------------------------------------------------------------
+    void spsc_ring_buffer::backoff::wait()
+    {
+        if (m_count < cMaxSpins)
+        {
+            m_count++;
+
+            // Spinning only helps if the other side is running on another core.
+            if (g_number_of_processors > 1)
+            {
+                vogl_yield_processor();
+                return;
+            }
+        }
+
+        if (m_count < cMaxSpins + cMaxYields)
+        {
+            m_count++;
+
+#if VOGL_USE_PTHREADS_API
+            sched_yield();
+#else
+            vogl_sleep(0);
+#endif
+            return;
+        }
+
+        vogl_sleep(1);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    // spsc_ring_buffer_test
+    //----------------------------------------------------------------------------------------------------------------------
+    namespace
+    {
+        struct spsc_ring_buffer_test_state
+        {
+            spsc_ring_buffer m_ring;
+            uint32_t m_total_records;
+            uint32_t m_seed;
+        };
+
+        void spsc_ring_buffer_test_producer(uint64_t data, void *pData_ptr)
+        {
+            VOGL_NOTE_UNUSED(data);
+
+            spsc_ring_buffer_test_state &state = *static_cast<spsc_ring_buffer_test_state *>(pData_ptr);
+
+            random rm;
+            rm.seed(state.m_seed);
+
+            for (uint32_t i = 0; i < state.m_total_records; i++)
+            {
+                uint32_t size = rm.irand_inclusive(sizeof(uint32_t), state.m_ring.get_max_record_size());
+
+                uint8_t *pDst;
+                spsc_ring_buffer::backoff waiter;
+                while ((pDst = static_cast<uint8_t *>(state.m_ring.begin_write(size))) == NULL)
+                    waiter.wait();
+
+                memcpy(pDst, &i, sizeof(i));
+                for (uint32_t j = sizeof(i); j < size; j++)
+                    pDst[j] = static_cast<uint8_t>(i + j);
+
+                state.m_ring.end_write();
+            }
+        }
+    }
+
+    bool spsc_ring_buffer_test()
+    {
+        spsc_ring_buffer_test_state state;
+        state.m_total_records = 200000;
+        state.m_seed = 1;
+
+        if (!state.m_ring.init(4096))
+            return false;
+
+        if ((state.m_ring.begin_write(state.m_ring.get_max_record_size() + 1)) || (!state.m_ring.is_empty()))
+            return false;
+
+        task_pool tp;
+        if (!tp.init(1))
+            return false;
+
+        if (!tp.queue_task(spsc_ring_buffer_test_producer, 0, &state))
+            return false;
+
+        random rm;
+        rm.seed(state.m_seed);
+
+        bool success = true;
+
+        for (uint32_t i = 0; i < state.m_total_records; i++)
+        {
+            uint32_t expected_size = rm.irand_inclusive(sizeof(uint32_t), state.m_ring.get_max_record_size());
+
+            uint32_t size;
+            const uint8_t *pSrc;
+            spsc_ring_buffer::backoff waiter;
+            while ((pSrc = static_cast<const uint8_t *>(state.m_ring.begin_read(size))) == NULL)
+                waiter.wait();
+
+            uint32_t index;
+            memcpy(&index, pSrc, sizeof(index));
+
+            bool record_ok = (size == expected_size) && (index == i);
+
+            for (uint32_t j = sizeof(index); (j < size) && (record_ok); j++)
+                if (pSrc[j] != static_cast<uint8_t>(i + j))
+                    record_ok = false;
+
+            state.m_ring.end_read();
+
+            // Keep consuming after a failure so the producer task can finish.
+            if ((!record_ok) && (success))
+            {
+                console::error("%s: Record %u is corrupted\n", VOGL_FUNCTION_INFO_CSTR, i);
+                success = false;
+            }
+        }
+
+        tp.join();
+
+        if ((success) && (!state.m_ring.is_empty()))
+            success = false;
+
+        return success;
+    }
+
+} // namespace vogl
@@ -0,0 +1,162 @@
+/**************************************************************************
+ *
+ * Copyright 2013-2014 RAD Game Tools and Valve Software
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ **************************************************************************/
+
+// File: vogl_spsc_ring_buffer.h
+// Lock-free ring buffer of variable sized records, for exactly one producer thread and one consumer thread.
+// The producer reserves space with begin_write()/end_write(), the consumer peeks at the oldest record with
+// begin_read() and releases it with end_read(). Records never straddle the end of the buffer - if a record doesn't
+// fit before the wrap point a padding record is inserted and the record is placed at the start of the buffer.
+#pragma once
+
+#include "vogl_core.h"
+#include "vogl_atomics.h"
+
+namespace vogl
+{
+    class spsc_ring_buffer
+    {
+        VOGL_NO_COPY_OR_ASSIGNMENT_OP(spsc_ring_buffer);
+
+    public:
+        enum
+        {
+            cMinCapacity = 256,
+            cMaxCapacity = 0x40000000,
+            cRecordAlignment = 8
+        };
+
+        spsc_ring_buffer();
+        ~spsc_ring_buffer();
+
+        // capacity is rounded up to the next power of 2.
+        bool init(uint32_t capacity);
+        void deinit();
+
+        inline bool is_initialized() const
+        {
+            return m_pBuf != NULL;
+        }
+
+        inline uint32_t get_capacity() const
+        {
+            return m_capacity;
+        }
+
+        // Largest record begin_write() will ever accept. Anything larger must be handled by the caller.
+        inline uint32_t get_max_record_size() const
+        {
+            return m_capacity ? ((m_capacity / 2) - sizeof(record_header)) : 0;
+        }
+
+        // Safe to call from either thread, but the result is only a snapshot.
+        inline uint32_t get_bytes_used() const
+        {
+            return static_cast<uint32_t>(atomic_load32(&m_write_ofs)) - static_cast<uint32_t>(atomic_load32(&m_read_ofs));
+        }
+
+        inline bool is_empty() const
+        {
+            return !get_bytes_used();
+        }
+
+        // Producer: returns NULL if there isn't enough free space for a record of size bytes (or size is too large).
+        void *begin_write(uint32_t size);
+        // Producer: publishes the record returned by the last successful begin_write().
+        void end_write();
+
+        // Consumer: returns the oldest record, or NULL if the buffer is empty. The record stays valid until end_read().
+        const void *begin_read(uint32_t &size);
+        // Consumer: releases the record returned by the last successful begin_read().
+        void end_read();
+        // Consumer: leaves the record returned by the last successful begin_read() in the buffer, so the next begin_read() returns it again.
+        inline void cancel_read()
+        {
+            m_pending_read_bytes = 0;
+        }
+
+        // Backoff for a producer or consumer waiting on the other side. Spins briefly (only if there's another core for
+        // the other side to run on), then yields the rest of its time slice, then sleeps, so it can't starve the other
+        // thread when both share a core.
+        class backoff
+        {
+        public:
+            backoff()
+                : m_count(0)
+            {
+            }
+
+            inline void reset()
+            {
+                m_count = 0;
+            }
+
+            void wait();
+
+        private:
+            enum
+            {
+                cMaxSpins = 64,
+                cMaxYields = 64
+            };
+
+            uint32_t m_count;
+        };
+
+    private:
+        struct record_header
+        {
+            uint32_t m_size;
+            uint32_t m_flags;
+        };
+
+        enum
+        {
+            cRecordFlagPadding = 1
+        };
+
+        uint8_t *m_pBuf;
+        uint32_t m_capacity;
+
+        // Producer owned
+        uint32_t m_pending_write_bytes;
+        // Consumer owned
+        uint32_t m_pending_read_bytes;
+
+        // Keep the producer and consumer offsets on separate cache lines. Both offsets increase monotonically and wrap at 2^32.
+        uint8_t m_pad0[64];
+        atomic32_t m_write_ofs;
+        uint8_t m_pad1[64];
+        atomic32_t m_read_ofs;
+        uint8_t m_pad2[64];
+
+        static inline uint32_t align_record_size(uint32_t size)
+        {
+            return (size + sizeof(record_header) + (cRecordAlignment - 1)) & ~(cRecordAlignment - 1);
+        }
+    };
+
+    bool spsc_ring_buffer_test();
+
+} // namespace vogl
@@ -528,6 +528,8 @@ void VoglEditor::close_trace_file()
       vogl_delete(m_pTraceReader);
       m_pTraceReader = NULL;
 
+      m_traceReplayer.clear_snapshot_cache();
+
       setWindowTitle(g_PROJECT_NAME);
 
       m_openFilename.clear();
@@ -1017,7 +1019,7 @@ vogl_gl_state_snapshot* VoglEditor::read_state_snapshot_from_trace(vogl_trace_fi
       if (pTrace_reader->get_packet_type() != cTSPTGLEntrypoint)
          continue;
 
-      if (!keyframe_trace_packet.deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), false))
+      if (!keyframe_trace_packet.deserialize(pTrace_reader->get_packet_ptr(), pTrace_reader->get_packet_size(), false))
       {
          vogl_error_printf("%s: Failed parsing GL entrypoint packet in keyframe file\n", VOGL_FUNCTION_INFO_CSTR);
          return NULL;
@@ -1053,39 +1055,9 @@ vogl_gl_state_snapshot* VoglEditor::read_state_snapshot_from_trace(vogl_trace_fi
                      return NULL;
                   }
 
-                  uint8_vec snapshot_data;
-                  {
-                     timed_scope ts("get_multi_blob_manager().get");
-                     if (!pTrace_reader->get_multi_blob_manager().get(id, snapshot_data) || (snapshot_data.is_empty()))
-                     {
-                        vogl_error_printf("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
-                        return NULL;
-                     }
-                  }
-
-                  vogl_message_printf("%s: Deserializing state snapshot \"%s\", %u bytes\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr(), snapshot_data.size());
-
-                  json_document doc;
-                  {
-                     timed_scope ts("doc.binary_deserialize");
-                     if (!doc.binary_deserialize(snapshot_data) || (!doc.get_root()))
-                     {
-                        vogl_error_printf("%s: Failed deserializing JSON snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
-                        return NULL;
-                     }
-                  }
-
-                  pSnapshot = vogl_new(vogl_gl_state_snapshot);
-
-                  timed_scope ts("pSnapshot->deserialize");
-                  if (!pSnapshot->deserialize(*doc.get_root(), pTrace_reader->get_multi_blob_manager(), &trace_gl_ctypes))
-                  {
-                     vogl_delete(pSnapshot);
-                     pSnapshot = NULL;
-
-                     vogl_error_printf("%s: Failed deserializing snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+                  pSnapshot = vogl_gl_state_snapshot_cache::load(id, true, pTrace_reader->get_multi_blob_manager(), &trace_gl_ctypes);
+                  if (!pSnapshot)
                      return NULL;
-                  }
 
                   found_snapshot = true;
                }
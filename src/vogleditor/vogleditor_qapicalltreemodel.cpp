@@ -91,7 +91,6 @@ bool vogleditor_QApiCallTreeModel::init(vogl_trace_file_reader* pTrace_reader)
          return false;
       }
 
-      const vogl::vector<uint8_t> &packet_buf = pTrace_reader->get_packet_buf(); VOGL_NOTE_UNUSED(packet_buf);
 
       const vogl_trace_stream_packet_base &base_packet = pTrace_reader->get_base_packet(); VOGL_NOTE_UNUSED(base_packet);
       const vogl_trace_gl_entrypoint_packet *pGL_packet = NULL;
@@ -100,7 +99,7 @@ bool vogleditor_QApiCallTreeModel::init(vogl_trace_file_reader* pTrace_reader)
       {
          vogl_trace_packet* pTrace_packet = vogl_new(vogl_trace_packet, &m_trace_ctypes);
 
-         if (!pTrace_packet->deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), false))
+         if (!pTrace_packet->deserialize(pTrace_reader->get_packet_ptr(), pTrace_reader->get_packet_size(), false))
          {
              vogleditor_output_error("Failed parsing GL entrypoint packet.");
              return false;
@@ -246,7 +246,7 @@ vogleditor_tracereplayer_result vogleditor_traceReplayer::replay(vogl_trace_file
       return VOGLEDITOR_TRR_ERROR;
    }
 
-   uint replayer_flags = cGLReplayerForceDebugContexts;
+   uint replayer_flags = cGLReplayerForceDebugContexts | cGLReplayerSnapshotCaching;
    if (!m_pTraceReplayer->init(replayer_flags, &m_window, m_pTraceReader->get_sof_packet(), m_pTraceReader->get_multi_blob_manager()))
    {
       vogleditor_output_error("Failed initializing GL replayer!");
@@ -254,6 +254,8 @@ vogleditor_tracereplayer_result vogleditor_traceReplayer::replay(vogl_trace_file
       return VOGLEDITOR_TRR_ERROR;
    }
 
+   m_pTraceReplayer->set_snapshot_cache(&m_snapshotCache);
+
    XSelectInput(m_window.get_display(), m_window.get_xwindow(),
                 EnterWindowMask | LeaveWindowMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask | ExposureMask | FocusChangeMask | KeyPressMask | KeyReleaseMask | PropertyChangeMask | StructureNotifyMask | KeymapStateMask);
 
@@ -326,6 +328,11 @@ vogleditor_tracereplayer_result vogleditor_traceReplayer::replay(vogl_trace_file
    return result;
 }
 
+void vogleditor_traceReplayer::clear_snapshot_cache()
+{
+    m_snapshotCache.clear();
+}
+
 bool vogleditor_traceReplayer::pause()
 {
     VOGL_ASSERT(!"Not implemented");
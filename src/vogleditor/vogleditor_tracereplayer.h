@@ -3,6 +3,7 @@
 
 #include "vogl_common.h"
 #include "vogl_replay_window.h"
+#include "vogl_gl_state_snapshot_cache.h"
 
 class vogl_gl_replayer;
 class vogleditor_gl_state_snapshot;
@@ -30,6 +31,9 @@ public:
     bool trim();
     bool stop();
 
+    // Deserialized state snapshots from the trace are kept across replays until the trace is closed.
+    void clear_snapshot_cache();
+
 private:
 
     bool applying_snapshot_and_process_resize(const vogl_gl_state_snapshot* pSnapshot);
@@ -38,6 +42,7 @@ private:
     bool process_x_events();
     vogl_gl_replayer* m_pTraceReplayer;
     vogl_replay_window m_window;
+    vogl_gl_state_snapshot_cache m_snapshotCache;
     Atom m_wmDeleteMessage;
 };
 
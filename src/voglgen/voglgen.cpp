@@ -2812,7 +2812,7 @@ public:
             vogl_fprintf(pFile, "DEF_PTR_TO_POINTEE_TYPE(%s, %s)\n", it->first.get_ptr(), it->second.get_ptr());
         vogl_fclose(pFile);
 
-        // -- Generate the gl_glx_wgl_simple_replay_funcs.inc simple replay funcs file, and update the whitelist
+        // -- Generate the gl_glx_wgl_simple_replay_funcs.inc simple replay funcs and gl_glx_wgl_replay_dispatch_table.inc files, and update the whitelist
         generate_simple_replay_funcs(out_inc_dir, m_all_gl_funcs, m_unique_ctype_enums, m_pointee_types, m_whitelisted_funcs);
 
         // -- Generate replayer helper macros
@@ -4433,6 +4433,17 @@ local:
 
         dump_inc_file_header(pFile);
 
+        // The replayer's dispatch table, with one entry per entrypoint in entrypoint ID order (gl_funcs must be the
+        // master list of all funcs, like gl_glx_wgl_func_descs.inc).
+        FILE *pTable_file = fopen_and_log_generic(out_dir, "gl_glx_wgl_replay_dispatch_table.inc", "w");
+        if (!pTable_file)
+        {
+            vogl_fclose(pFile);
+            return false;
+        }
+
+        dump_inc_file_header(pTable_file);
+
         vogl::vector<bool> used_flags(m_simple_replay_funcs.size());
 
         for (uint32_t func_index = 0; func_index < gl_funcs.size(); func_index++)
@@ -4458,11 +4469,16 @@ local:
             }
 
             if (i == m_simple_replay_funcs.size())
+            {
+                vogl_fprintf(pTable_file, "VOGL_REPLAY_DISPATCH_CUSTOM(%s)\n", full_func_name.get_ptr());
                 continue;
+            }
 
             VOGL_ASSERT(!used_flags[i]);
             used_flags[i] = true;
 
+            vogl_fprintf(pTable_file, "VOGL_REPLAY_DISPATCH_SIMPLE(%s)\n", full_func_name.get_ptr());
+
             vogl_fprintf(pFile, "VOGL_SIMPLE_REPLAY_FUNC_BEGIN(%s, func_def.m_params.size())\n", full_func_name.get_ptr());
 
             for (uint32_t param_index = 0; param_index < func_def.m_params.size(); param_index++)
@@ -4476,6 +4492,7 @@ local:
                     {
                         console::error("Failed finding pointee ctype for ctype %s\n", func_def.m_params[param_index].m_ctype.get_ptr());
                         vogl_fclose(pFile);
+                        vogl_fclose(pTable_file);
                         return false;
                     }
 
@@ -4484,6 +4501,7 @@ local:
                     {
                         console::error("Failed finding pointee ctype for ctype %s\n", func_def.m_params[param_index].m_ctype.get_ptr());
                         vogl_fclose(pFile);
+                        vogl_fclose(pTable_file);
                         return false;
                     }
 
@@ -4503,6 +4521,7 @@ local:
         }
 
         vogl_fclose(pFile);
+        vogl_fclose(pTable_file);
 
         return true;
     }
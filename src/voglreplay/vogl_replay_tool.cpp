@@ -73,11 +73,16 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "replay", 0, false, "Replay mode (the default), must specify .BIN or .JSON trace file to replay" },
         { "dump", 0, false, "Dump mode: Dumps binary trace file to a JSON trace file, must specify input and output filenames" },
         { "parse", 0, false, "Parse mode: Parse JSON trace file to a binary trace file, must specify input and output filenames" },
+        { "splice", 0, false, "Splice mode: Copy the raw packets of one or more binary trace files to a new binary trace file, must specify input filename(s) followed by the output filename" },
         { "info", 0, false, "Info mode: Output statistics about a trace file" },
         { "unpack_json", 0, false, "Unpack UBJ to JSON mode: Unpack UBJ (Universal Binary JSON) to textual JSON, must specify input and output filenames" },
         { "pack_json", 0, false, "Pack JSON to UBJ mode: Pack textual JSON to UBJ, must specify input and output filenames" },
         { "find", 0, false, "Find all calls with parameters containing a specific value, combine with -find_param, -find_func, find_namespace, etc. params" },
         { "compare_hash_files", 0, false, "Compare two files containing CRC's or per-component sums (presumably written using dump_backbuffer_hashes)" },
+        { "index", 0, false, "Index mode: Scan a binary trace file and write a call index file next to it (for traces which don't already contain one)" },
+        { "export_columns", 0, false, "Export columns mode: Write the call counter, frame, entrypoint, context, thread, timestamps, client memory size and backtrace index of every GL call to fixed width binary column files plus a JSON manifest, must specify input filename and output filename prefix" },
+        { "scan_bench", 0, false, "Scan benchmark mode: Time reading every packet of a binary trace file with each binary trace reader" },
+        { "packet_array_bench", 0, false, "Packet array benchmark mode: Time loading trim_len frames starting at trim_frame into memory, the way trimming does" },
 
         // replay specific
         { "width", 1, false, "Replay: Set replay window's initial width (default is 1024)" },
@@ -101,6 +106,7 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "dump_screenshots", 0, false, "Replay: Dump backbuffer screenshot before every swap to numbered PNG files" },
         { "dump_screenshots_prefix", 1, false, "Replay: Set PNG screenshot file prefix" },
         { "swap_sleep", 1, false, "Replay: Sleep for X milliseconds after every swap" },
+        { "read_ahead", 1, false, "Replay: Number of trace packets to read and decode ahead of the GL calls on a background thread, 0=read them on the replay thread (default is 256)" },
         { "dump_packets_on_error", 0, false, "Replay: Dump GL trace packets as JSON to stdout on replay errors" },
         { "dump_packet_blob_files_on_error", 0, false, "Replay: Used with -dump_packets_on_error, also dumps all binary blob files associated with each packet" },
         { "dump_all_packets", 0, false, "Replay: Dump all GL trace packets as JSON to stdout" },
@@ -117,6 +123,8 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "pause_on_frame", 1, false, "Replay interactive mode: Pause on specified frame" },
         { "interactive", 0, false, "Replay mode: Enable keyboard keys" },
         { "disable_snapshot_caching", 0, false, "Replay mode: Disable caching of all state snapshot files, so they can be manually modified during replay" },
+        { "snapshot_cache_size", 1, false, "Replay interactive mode: Memory budget in MB for cached state snapshots (default is 2048 on 64-bit, 512 on 32-bit)" },
+        { "snapshot_cache_compressed_size", 1, false, "Replay interactive mode: Memory budget in MB for deflated copies of state snapshots and all the blobs they reference, so evicted snapshots are reloaded without reading the trace, 0=disabled (the default)" },
         { "benchmark", 0, false, "Replay mode: Disable glGetError()'s, divergence checks, during replaying" },
         { "keyframe_base_filename", 1, false, "Replay: Set base filename of trimmed replay keyframes, used for fast seeking" },
 #ifdef USE_TELEMETRY
@@ -137,6 +145,7 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "find_frame_high", 1, false, "Find: Limit the find to frames up to and including the specified frame index" },
         { "find_call_low", 1, false, "Find: Limit the find to GL calls beginning at the specified call index" },
         { "find_call_high", 1, false, "Find: Limit the find to GL calls up to and including the specified call index" },
+        { "find_json_lines", 1, false, "Find: Write each match to the specified file (\"-\" for stdout) as a single line JSON object, instead of printing it" },
 
         // compare_hash_files specific
         { "sum_compare_threshold", 1, false, "compare_hash_files: Only report mismatches greater than the specified threshold, use with --sum_hashing" },
@@ -147,9 +156,18 @@ static command_line_param_desc g_command_line_param_descs[] =
 
         // dump specific
         { "verify", 0, false, "Dump: Fully round-trip verify all JSON objects vs. the original packet's" },
+        { "dump_frame_low", 1, false, "Dump: Only dump frames beginning at the specified frame index" },
+        { "dump_frame_high", 1, false, "Dump: Only dump frames up to and including the specified frame index" },
+        { "dump_call_low", 1, false, "Dump: Only dump GL calls beginning at the specified call index" },
+        { "dump_call_high", 1, false, "Dump: Only dump GL calls up to and including the specified call index" },
         { "no_blobs", 0, false, "Dump: Don't write binary blob files" },
         { "write_debug_info", 0, false, "Dump: Write extra debug info to output JSON trace files" },
+        { "splice_frame_low", 1, false, "Splice: Only copy frames beginning at the specified frame index of each input trace" },
+        { "splice_frame_high", 1, false, "Splice: Only copy frames up to and including the specified frame index of each input trace" },
+        { "splice_no_archive", 0, false, "Splice: Don't copy the input trace archives (state snapshots, backtrace maps, machine info, etc.)" },
         { "loose_file_path", 1, false, "Prefer reading trace blob files from this directory vs. the archive referred to or present in the trace file" },
+        { "threads", 1, false, "Info/find/dump/export_columns: Number of threads used to process binary traces which have a frame offset table, 0=one per core (the default)" },
+        { "mmap", 0, false, "Read binary trace files through a read-only memory mapping instead of buffered file reads" },
         { "debug", 0, false, "Enable verbose debug information" },
         { "logfile", 1, false, "Create logfile" },
         { "logfile_append", 1, false, "Append output to logfile" },
@@ -479,8 +497,9 @@ static void vogl_replay_deinit()
 
 //----------------------------------------------------------------------------------------------------------------------
 // read_state_snapshot_from_trace
+// If pCache isn't NULL the snapshot is owned by the cache, otherwise the caller must vogl_delete it.
 //----------------------------------------------------------------------------------------------------------------------
-static vogl_gl_state_snapshot *read_state_snapshot_from_trace(dynamic_string filename)
+static vogl_gl_state_snapshot *read_state_snapshot_from_trace(dynamic_string filename, vogl_gl_state_snapshot_cache *pCache)
 {
     VOGL_FUNC_TRACER
 
@@ -524,7 +543,7 @@ static vogl_gl_state_snapshot *read_state_snapshot_from_trace(dynamic_string fil
         if (pTrace_reader->get_packet_type() != cTSPTGLEntrypoint)
             continue;
 
-        if (!keyframe_trace_packet.deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), false))
+        if (!keyframe_trace_packet.deserialize(pTrace_reader->get_packet_ptr(), pTrace_reader->get_packet_size(), false))
         {
             vogl_error_printf("%s: Failed parsing GL entrypoint packet in keyframe file\n", VOGL_FUNCTION_INFO_CSTR);
             return NULL;
@@ -563,39 +582,12 @@ static vogl_gl_state_snapshot *read_state_snapshot_from_trace(dynamic_string fil
                             return NULL;
                         }
 
-                        uint8_vec snapshot_data;
-                        {
-                            timed_scope ts2("get_multi_blob_manager().get");
-                            if (!pTrace_reader->get_multi_blob_manager().get(id, snapshot_data) || (snapshot_data.is_empty()))
-                            {
-                                vogl_error_printf("%s: Failed reading snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
-                                return NULL;
-                            }
-                        }
-
-                        vogl_message_printf("%s: Deserializing state snapshot \"%s\", %u bytes\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr(), snapshot_data.size());
-
-                        json_document doc;
-                        {
-                            timed_scope ts2("doc.binary_deserialize");
-                            if (!doc.binary_deserialize(snapshot_data) || (!doc.get_root()))
-                            {
-                                vogl_error_printf("%s: Failed deserializing JSON snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
-                                return NULL;
-                            }
-                        }
-
-                        pSnapshot = vogl_new(vogl_gl_state_snapshot);
-
-                        timed_scope ts2("pSnapshot->deserialize");
-                        if (!pSnapshot->deserialize(*doc.get_root(), pTrace_reader->get_multi_blob_manager(), &trace_gl_ctypes))
-                        {
-                            vogl_delete(pSnapshot);
-                            pSnapshot = NULL;
-
-                            vogl_error_printf("%s: Failed deserializing snapshot blob data \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, id.get_ptr());
+                        if (pCache)
+                            pSnapshot = pCache->get_or_load(id, true, pTrace_reader->get_multi_blob_manager(), &trace_gl_ctypes);
+                        else
+                            pSnapshot = vogl_gl_state_snapshot_cache::load(id, true, pTrace_reader->get_multi_blob_manager(), &trace_gl_ctypes);
+                        if (!pSnapshot)
                             return NULL;
-                        }
 
                         found_snapshot = true;
                     }
@@ -670,7 +662,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
         }
 
         dynamic_string actual_trace_filename;
-        vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(trace_filename, actual_trace_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr()));
+        vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(trace_filename, actual_trace_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
         if (!pTrace_reader.get())
         {
             vogl_error_printf("%s: File not found, or unable to determine file type of trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, trace_filename.get_ptr());
@@ -708,6 +700,21 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
             vogl_disable_gl_get_error();
         }
 
+        if (replayer_flags & cGLReplayerSnapshotCaching)
+        {
+            vogl_gl_state_snapshot_cache &snapshot_cache = replayer.get_snapshot_cache();
+            snapshot_cache.set_max_size(g_command_line_params().get_value_as_uint64("snapshot_cache_size", 0, snapshot_cache.get_max_size() >> 20U, 0, cUINT64_MAX >> 20U) << 20U);
+            snapshot_cache.set_max_compressed_size(g_command_line_params().get_value_as_uint64("snapshot_cache_compressed_size", 0, 0, 0, cUINT64_MAX >> 20U) << 20U);
+        }
+
+        // All reads and seeks go through the prefetcher from here on, the reader is only used directly while it's paused.
+        vogl_trace_packet_prefetcher packet_prefetcher;
+        if (!packet_prefetcher.init(pTrace_reader.get(), &replayer.get_trace_gl_ctypes(), g_command_line_params().get_value_as_uint("read_ahead", 0, vogl_trace_packet_prefetcher::cDefaultMaxPackets)))
+        {
+            vogl_error_printf("%s: Failed initializing trace packet read ahead\n", VOGL_FUNCTION_INFO_CSTR);
+            return false;
+        }
+
         replayer.set_swap_sleep_time(g_command_line_params().get_value_as_uint("swap_sleep"));
         replayer.set_dump_framebuffer_on_draw_prefix(g_command_line_params().get_value_as_string("dump_framebuffer_on_draw_prefix", 0, "screenshot"));
         replayer.set_screenshot_prefix(g_command_line_params().get_value_as_string("dump_screenshots_prefix", 0, "screenshot"));
@@ -789,6 +796,29 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
         dynamic_string write_snapshot_filename = g_command_line_params().get_value_as_string("write_snapshot_file", 0, "state_snapshot.json");
 
         int64_t trim_call_index = g_command_line_params().get_value_as_int64("trim_call", 0, -1, 0);
+
+        // The replayer still has to play every call up to these, but with a call index bad call counters are caught
+        // before replaying the whole trace.
+        if (pTrace_reader->get_call_index())
+        {
+            const vogl_trace_call_index &call_index = *pTrace_reader->get_call_index();
+
+            const int64_t calls_to_check[2] = { write_snapshot_index, trim_call_index };
+            for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(calls_to_check); i++)
+            {
+                if (calls_to_check[i] < 0)
+                    continue;
+
+                uint32_t call_index_index;
+                if (!call_index.find_call(static_cast<uint64_t>(calls_to_check[i]), call_index_index))
+                {
+                    vogl_error_printf("%s: Call counter %" PRIi64 " is not in the trace\n", VOGL_FUNCTION_INFO_CSTR, calls_to_check[i]);
+                    return false;
+                }
+
+                vogl_message_printf("Call counter %" PRIi64 " is in frame %u\n", calls_to_check[i], call_index.get_call_frame(call_index_index));
+            }
+        }
         vogl::vector<uint32_t> trim_frames(g_command_line_params().get_count("trim_frame"));
         for (uint32_t i = 0; i < trim_frames.size(); i++)
         {
@@ -1239,6 +1269,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                             dynamic_string trim_filename(trim_name + "/" + trim_name + ".bin");
                             dynamic_string snapshot_id;
                             uint32_t write_trim_file_flags = vogl_gl_replayer::cWriteTrimFileFromStartOfFrame | (g_command_line_params().get_value_as_bool("no_trim_optimization") ? 0 : vogl_gl_replayer::cWriteTrimFileOptimizeSnapshot);
+                            packet_prefetcher.pause();
                             if (replayer.write_trim_file(write_trim_file_flags, trim_filename, 1, *pTrace_reader, &snapshot_id))
                             {
                                 dynamic_string json_trim_base_filename(trim_name + "/j" + trim_name);
@@ -1275,7 +1306,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                     }
 
                     // Now replay the next frame's GL commands up to the swap
-                    status = replayer.process_frame(*pTrace_reader);
+                    status = replayer.process_frame(packet_prefetcher);
                 }
 
                 if (status == vogl_gl_replayer::cStatusHardFailure)
@@ -1304,7 +1335,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                         replayer.reset_state();
 
-                        if (!pTrace_reader->seek_to_frame(0))
+                        if (!packet_prefetcher.seek_to_frame(0))
                         {
                             vogl_error_printf("%s: Failed rewinding trace reader!\n", VOGL_FUNCTION_INFO_CSTR);
                             goto error_exit;
@@ -1340,7 +1371,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                         replayer.reset_state();
 
-                        if (!pTrace_reader->seek_to_frame(0))
+                        if (!packet_prefetcher.seek_to_frame(0))
                         {
                             vogl_error_printf("%s: Failed rewinding trace reader!\n", VOGL_FUNCTION_INFO_CSTR);
                             goto error_exit;
@@ -1361,7 +1392,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             vogl_printf("Seeking to last frame\n");
 
-                            int64_t max_frame_index = pTrace_reader->get_max_frame_index();
+                            int64_t max_frame_index = packet_prefetcher.get_max_frame_index();
                             if (max_frame_index < 0)
                             {
                                 vogl_error_printf("%s: Failed determining the total number of trace frames!\n", VOGL_FUNCTION_INFO_CSTR);
@@ -1387,7 +1418,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                         if (num_key <= '9')
                         {
-                            int64_t max_frame_index = pTrace_reader->get_max_frame_index();
+                            int64_t max_frame_index = packet_prefetcher.get_max_frame_index();
                             if (max_frame_index < 0)
                             {
                                 vogl_error_printf("%s: Failed determining the total number of trace frames!\n", VOGL_FUNCTION_INFO_CSTR);
@@ -1488,7 +1519,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                                 goto error_exit;
                             }
 
-                            pTrace_reader->seek_to_frame(static_cast<uint32_t>(paused_mode_frame_index));
+                            packet_prefetcher.seek_to_frame(static_cast<uint32_t>(paused_mode_frame_index));
                         }
                     }
                 }
@@ -1546,12 +1577,15 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             dynamic_string keyframe_filename(cVarArg, "%s_%06" PRIu64 ".bin", keyframe_base_filename.get_ptr(), keyframe_index);
 
-                            vogl_gl_state_snapshot *pKeyframe_snapshot = read_state_snapshot_from_trace(keyframe_filename);
+                            // Keyframe snapshots stay in the replayer's snapshot cache, so seeking back and forth is cheap.
+                            vogl_gl_state_snapshot_cache *pSnapshot_cache = (replayer_flags & cGLReplayerSnapshotCaching) ? &replayer.get_snapshot_cache() : NULL;
+
+                            vogl_gl_state_snapshot *pKeyframe_snapshot = read_state_snapshot_from_trace(keyframe_filename, pSnapshot_cache);
                             if (!pKeyframe_snapshot)
                                 goto error_exit;
 
                             bool delete_snapshot_after_applying = true;
-                            if (seek_to_target_frame == keyframe_index)
+                            if ((pSnapshot_cache) || (seek_to_target_frame == keyframe_index))
                                 delete_snapshot_after_applying = false;
 
                             status = replayer.begin_applying_snapshot(pKeyframe_snapshot, delete_snapshot_after_applying);
@@ -1563,7 +1597,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             pKeyframe_snapshot->set_frame_index(static_cast<uint32_t>(keyframe_index));
 
-                            if (!pTrace_reader->seek_to_frame(static_cast<uint32_t>(keyframe_index)))
+                            if (!packet_prefetcher.seek_to_frame(static_cast<uint32_t>(keyframe_index)))
                             {
                                 vogl_error_printf("%s: Failed seeking to keyframe!\n", VOGL_FUNCTION_INFO_CSTR);
                                 goto error_exit;
@@ -1571,6 +1605,10 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             if (seek_to_target_frame == keyframe_index)
                             {
+                                // pSnapshot is ours to delete.
+                                if (pSnapshot_cache)
+                                    pSnapshot_cache->release(pKeyframe_snapshot);
+
                                 pSnapshot = pKeyframe_snapshot;
                                 paused_mode_frame_index = seek_to_target_frame;
                             }
@@ -1582,7 +1620,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                             if (seek_to_target_frame < static_cast<int64_t>(replayer.get_frame_index()))
                             {
                                 replayer.reset_state();
-                                pTrace_reader->seek_to_frame(0);
+                                packet_prefetcher.seek_to_frame(0);
                             }
 
                             take_snapshot_at_frame_index = seek_to_target_frame;
@@ -1682,6 +1720,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                             file_utils::create_directories(trim_path, false);
 
                             uint32_t write_trim_file_flags = vogl_gl_replayer::cWriteTrimFileFromStartOfFrame | (g_command_line_params().get_value_as_bool("no_trim_optimization") ? 0 : vogl_gl_replayer::cWriteTrimFileOptimizeSnapshot);
+                            packet_prefetcher.pause();
                             if (!replayer.write_trim_file(write_trim_file_flags, filename, multitrim_mode ? 1 : len, *pTrace_reader))
                                 goto error_exit;
 
@@ -1719,8 +1758,8 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                         {
                             vogl_printf("Snapshot succeeded\n");
 
-                            snapshot_loop_start_frame = pTrace_reader->get_cur_frame();
-                            snapshot_loop_end_frame = pTrace_reader->get_cur_frame() + loop_len;
+                            snapshot_loop_start_frame = packet_prefetcher.get_cur_frame();
+                            snapshot_loop_end_frame = packet_prefetcher.get_cur_frame() + loop_len;
 
                             if (draw_kill_max_thresh > 0)
                             {
@@ -1743,7 +1782,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                 {
                     for (;;)
                     {
-                        status = replayer.process_next_packet(*pTrace_reader);
+                        status = replayer.process_next_packet(packet_prefetcher);
 
                         if ((status != vogl_gl_replayer::cStatusHardFailure) && (status != vogl_gl_replayer::cStatusAtEOF))
                         {
@@ -1799,6 +1838,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                                 file_utils::create_directories(trim_path, false);
 
+                                packet_prefetcher.pause();
                                 if (!replayer.write_trim_file(0, filename, trim_lens.size() ? trim_lens[0] : 1, *pTrace_reader, NULL))
                                     goto error_exit;
 
@@ -1820,13 +1860,13 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
                     vogl_message_printf("%s: At trace EOF, frame index %u\n", VOGL_FUNCTION_INFO_CSTR, replayer.get_frame_index());
                 }
 
-                if ((replayer.get_at_frame_boundary()) && (pSnapshot) && (loop_count > 0) && ((pTrace_reader->get_cur_frame() == snapshot_loop_end_frame) || (status == vogl_gl_replayer::cStatusAtEOF)))
+                if ((replayer.get_at_frame_boundary()) && (pSnapshot) && (loop_count > 0) && ((packet_prefetcher.get_cur_frame() == snapshot_loop_end_frame) || (status == vogl_gl_replayer::cStatusAtEOF)))
                 {
                     status = replayer.begin_applying_snapshot(pSnapshot, false);
                     if ((status != vogl_gl_replayer::cStatusOK) && (status != vogl_gl_replayer::cStatusResizeWindow))
                         goto error_exit;
 
-                    pTrace_reader->seek_to_frame(static_cast<uint32_t>(snapshot_loop_start_frame));
+                    packet_prefetcher.seek_to_frame(static_cast<uint32_t>(snapshot_loop_start_frame));
 
                     if (draw_kill_max_thresh > 0)
                     {
@@ -1854,9 +1894,9 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             vogl_printf("Replay now at frame index %d, trace file offet %" PRIu64 ", GL call counter %" PRIu64 ", %3.2f%% percent complete\n",
                                        replayer.get_frame_index(),
-                                       binary_trace_reader.get_cur_file_ofs(),
+                                       packet_prefetcher.get_cur_file_ofs(),
                                        replayer.get_last_parsed_call_counter(),
-                                       binary_trace_reader.get_trace_file_size() ? (binary_trace_reader.get_cur_file_ofs() * 100.0f) / binary_trace_reader.get_trace_file_size() : 0);
+                                       binary_trace_reader.get_trace_file_size() ? (packet_prefetcher.get_cur_file_ofs() * 100.0f) / binary_trace_reader.get_trace_file_size() : 0);
                         }
                     }
 
@@ -1868,6 +1908,8 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                             vogl_printf("%u total swaps, %.3f secs, %3.3f avg fps\n", replayer.get_total_swaps(), time_since_start, replayer.get_frame_index() / time_since_start);
 
+                            packet_prefetcher.dump_stats();
+
                             break;
                         }
 
@@ -1875,7 +1917,7 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
                         replayer.reset_state();
 
-                        if (!pTrace_reader->seek_to_frame(0))
+                        if (!packet_prefetcher.seek_to_frame(0))
                         {
                             vogl_error_printf("%s: Failed rewinding trace reader!\n", VOGL_FUNCTION_INFO_CSTR);
                             goto error_exit;
@@ -1898,6 +1940,9 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
     normal_exit:
 
+        if (replayer_flags & cGLReplayerSnapshotCaching)
+            replayer.get_snapshot_cache().print_stats();
+
         if (g_command_line_params().get_value_as_bool("pause_on_exit") && (window.is_opened()))
         {
             vogl_printf("Press a key to continue.\n");
@@ -1952,114 +1997,324 @@ static uint32_t get_replayer_flags_from_command_line_params(bool interactive_mod
 
 
 //----------------------------------------------------------------------------------------------------------------------
-// tool_dump_mode
+// get_scan_thread_count
 //----------------------------------------------------------------------------------------------------------------------
-static bool tool_dump_mode()
+static uint32_t get_scan_thread_count()
+{
+    uint32_t num_threads = g_command_line_params().get_value_as_uint("threads", 0, 0, 0, task_pool::cMaxThreads);
+    if (!num_threads)
+        num_threads = math::clamp<uint32_t>(g_number_of_processors, 1, task_pool::cMaxThreads);
+    return num_threads;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct trace_frame_range
+//----------------------------------------------------------------------------------------------------------------------
+struct trace_frame_range
+{
+    uint32_t m_first_frame;
+    // Offset of the first packet after the range, or cUINT64_MAX if the range runs to the end of the trace.
+    uint64_t m_end_ofs;
+};
+
+typedef vogl::vector<trace_frame_range> trace_frame_range_vec;
+
+//----------------------------------------------------------------------------------------------------------------------
+// split_trace_into_frame_ranges
+// Splits frames [first_frame, end_frame) of a binary trace with a frame offset table into at most max_ranges ranges of
+// whole frames, each with roughly the same number of packet bytes. Returns false if the trace can't be split, in which
+// case the caller should scan it on one thread.
+//----------------------------------------------------------------------------------------------------------------------
+static bool split_trace_into_frame_ranges(vogl_trace_file_reader &trace_reader, uint32_t first_frame, uint32_t end_frame, uint32_t max_ranges, trace_frame_range_vec &ranges)
 {
     VOGL_FUNC_TRACER
 
-    dynamic_string input_trace_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
-    if (input_trace_filename.is_empty())
-    {
-        vogl_error_printf("Must specify filename of input binary trace file!\n");
+    ranges.resize(0);
+
+    if ((max_ranges < 2) || (trace_reader.get_type() != cBINARY_TRACE_FILE_READER) || (!trace_reader.can_quickly_seek_forward()))
+        return false;
+
+    vogl_binary_trace_file_reader &binary_reader = static_cast<vogl_binary_trace_file_reader &>(trace_reader);
+
+    const vogl::vector<uint64_t> &frame_offsets = binary_reader.get_frame_file_offsets();
+
+    end_frame = math::minimum(end_frame, frame_offsets.size());
+    if ((first_frame + 1) >= end_frame)
         return false;
+
+    // Frame offsets are strictly increasing, every frame has at least one packet.
+    const uint64_t begin_ofs = frame_offsets[first_frame];
+    const uint64_t end_ofs = (end_frame < frame_offsets.size()) ? frame_offsets[end_frame] : cUINT64_MAX;
+    const uint64_t total_size = ((end_ofs != cUINT64_MAX) ? end_ofs : binary_reader.get_trace_file_size()) - begin_ofs;
+
+    const uint32_t num_ranges = math::minimum(max_ranges, end_frame - first_frame);
+
+    uint32_t frame_index = first_frame;
+    for (uint32_t i = 0; i < num_ranges; i++)
+    {
+        trace_frame_range range;
+        range.m_first_frame = frame_index;
+        range.m_end_ofs = end_ofs;
+
+        if (i < (num_ranges - 1))
+        {
+            uint64_t target_ofs = begin_ofs + (total_size * (i + 1)) / num_ranges;
+
+            frame_index++;
+            while ((frame_index < end_frame) && (frame_offsets[frame_index] < target_ofs))
+                frame_index++;
+
+            if (frame_index < end_frame)
+                range.m_end_ofs = frame_offsets[frame_index];
+        }
+
+        ranges.push_back(range);
+
+        if (frame_index >= end_frame)
+            break;
     }
 
-    dynamic_string output_base_filename(g_command_line_params().get_value_as_string_or_empty("", 2));
-    if (output_base_filename.is_empty())
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// open_trace_at_frame
+// Opens another reader on a binary trace, positioned at the start of the specified frame.
+//----------------------------------------------------------------------------------------------------------------------
+static vogl_trace_file_reader *open_trace_at_frame(const dynamic_string &filename, uint32_t frame_index)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_create_trace_file_reader(cBINARY_TRACE_FILE_READER, g_command_line_params().get_value_as_bool("mmap")));
+    if ((!pTrace_reader.get()) || (!pTrace_reader->open(filename.get_ptr(), g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr())))
     {
-        vogl_error_printf("Must specify base filename of output JSON/blob files!\n");
-        return false;
+        vogl_error_printf("Failed opening trace file \"%s\"\n", filename.get_ptr());
+        return NULL;
     }
 
-    vogl_loose_file_blob_manager output_file_blob_manager;
+    if (!pTrace_reader->seek_to_frame(frame_index))
+    {
+        vogl_error_printf("Failed seeking to frame %u\n", frame_index);
+        return NULL;
+    }
 
-    dynamic_string output_trace_path(file_utils::get_pathname(output_base_filename.get_ptr()));
-    vogl_debug_printf("%s: Output trace path: %s\n", VOGL_FUNCTION_INFO_CSTR, output_trace_path.get_ptr());
-    output_file_blob_manager.init(cBMFReadWrite, output_trace_path.get_ptr());
+    return pTrace_reader.release();
+}
 
-    file_utils::create_directories(output_trace_path, false);
+//----------------------------------------------------------------------------------------------------------------------
+// struct dump_context
+// Settings shared by every range of a --dump. Only packets in frames [m_first_frame, m_end_frame) with call counters in
+// [m_call_low, m_call_high] are dumped (-1 means unbounded).
+//----------------------------------------------------------------------------------------------------------------------
+struct dump_context
+{
+    dynamic_string m_input_filename;
+    dynamic_string m_output_base_filename;
+    dynamic_string m_archive_name;
+    vogl_loose_file_blob_manager *m_pBlob_manager;
+
+    uint32_t m_first_frame;
+    uint32_t m_end_frame;
+    int64_t m_call_low;
+    int64_t m_call_high;
+
+    bool m_full_verification;
+    bool m_write_debug_info;
+    bool m_debug;
+};
 
-    dynamic_string actual_input_trace_filename;
-    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_trace_filename, actual_input_trace_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr()));
-    if (!pTrace_reader.get())
+//----------------------------------------------------------------------------------------------------------------------
+// struct dump_range
+// A range of whole frames dumped by one reader. Each frame goes to its own JSON document, numbered from
+// m_first_file_index. A frame which needs more than one document shifts the numbering of every later frame, so unless
+// m_allow_split_frames is set the range stops at that frame and sets m_split_frame, and the rest of the trace must be
+// dumped by a single range.
+//----------------------------------------------------------------------------------------------------------------------
+struct dump_range
+{
+    trace_frame_range m_frames;
+    uint32_t m_first_file_index;
+    bool m_allow_split_frames;
+    // Only the last range's last document gets an eof meta key.
+    bool m_last;
+
+    uint32_t m_end_file_index;
+    bool m_split_frame;
+    bool m_failed;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// begin_dump_document
+//----------------------------------------------------------------------------------------------------------------------
+static json_node *begin_dump_document(json_document &doc, vogl_trace_file_reader &trace_reader, const dump_context &context, uint32_t frame_index, uint32_t file_index)
+{
+    VOGL_FUNC_TRACER
+
+    doc.clear();
+
+    const vogl_trace_stream_start_of_file_packet &sof_packet = trace_reader.get_sof_packet();
+
+    json_node &meta_node = doc.get_root()->add_object("meta");
+    meta_node.add_key_value("cur_frame", frame_index);
+
+    if (!file_index)
     {
-        vogl_error_printf("%s: Failed opening input trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, input_trace_filename.get_ptr());
-        return false;
+        json_node &sof_node = doc.get_root()->add_object("sof");
+        sof_node.add_key_value("pointer_sizes", sof_packet.m_pointer_sizes);
+        sof_node.add_key_value("version", to_hex_string(sof_packet.m_version));
+        if (!context.m_archive_name.is_empty())
+            sof_node.add_key_value("archive_filename", context.m_archive_name);
+
+        json_node &uuid_array = sof_node.add_array("uuid");
+        for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(sof_packet.m_uuid); i++)
+            uuid_array.add_value(sof_packet.m_uuid[i]);
+    }
+    else
+    {
+        json_node &uuid_array = meta_node.add_array("uuid");
+        for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(sof_packet.m_uuid); i++)
+            uuid_array.add_value(sof_packet.m_uuid[i]);
     }
 
-    const bool full_verification = g_command_line_params().get_value_as_bool("verify");
+    // TODO: Automatically dump binary snapshot file to text?
+    // Right now we can't afford to do it at trace time, it takes too much memory.
 
-    vogl_ctypes trace_gl_ctypes;
-    trace_gl_ctypes.init(pTrace_reader->get_sof_packet().m_pointer_sizes);
+    return &doc.get_root()->add_array("packets");
+}
 
-    dynamic_string archive_name;
-    if (pTrace_reader->get_archive_blob_manager().is_initialized())
+//----------------------------------------------------------------------------------------------------------------------
+// write_dump_document
+//----------------------------------------------------------------------------------------------------------------------
+static bool write_dump_document(const json_document &doc, const dump_context &context, uint32_t file_index)
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string output_filename(cVarArg, "%s_%06u.json", context.m_output_base_filename.get_ptr(), file_index);
+    vogl_message_printf("Writing file: \"%s\"\n", output_filename.get_ptr());
+
+    if (!doc.serialize_to_file(output_filename.get_ptr(), true))
     {
-        dynamic_string archive_filename(output_base_filename.get_ptr());
-        archive_filename += "_trace_archive.zip";
+        vogl_error_printf("%s: Failed serializing JSON document to file %s\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
+        return false;
+    }
 
-        archive_name = file_utils::get_filename(archive_filename.get_ptr());
+    if (doc.get_root()->check_for_duplicate_keys())
+        vogl_warning_printf("%s: JSON document %s has nodes with duplicate keys, this document may not be readable by some JSON parsers\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
 
-        vogl_message_printf("Writing trace archive \"%s\", size %" PRIu64 " bytes\n", archive_filename.get_ptr(), pTrace_reader->get_archive_blob_manager().get_archive_size());
+    return true;
+}
 
-        cfile_stream archive_stream;
-        if (!archive_stream.open(archive_filename.get_ptr(), cDataStreamWritable | cDataStreamSeekable))
-        {
-            vogl_error_printf("%s: Failed opening output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
-            return false;
-        }
+//----------------------------------------------------------------------------------------------------------------------
+// verify_dumped_packet
+// Fully round trips a packet's JSON back to binary and compares it against the original packet.
+//----------------------------------------------------------------------------------------------------------------------
+static bool verify_dumped_packet(const json_node &new_node, const vogl_trace_packet &gl_packet_cracker, vogl_ctypes &trace_gl_ctypes, const dump_context &context, uint32_t packet_size)
+{
+    VOGL_FUNC_TRACER
 
-        if (!pTrace_reader->get_archive_blob_manager().write_archive_to_stream(archive_stream))
-        {
-            vogl_error_printf("%s: Failed writing to output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
-            return false;
-        }
+    vogl::vector<char> new_node_as_text;
+    new_node.serialize(new_node_as_text, true, 0);
 
-        if (!archive_stream.close())
-        {
-            vogl_error_printf("%s: Failed writing to output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
-            return false;
-        }
+    json_document round_tripped_node;
+    if (!round_tripped_node.deserialize(new_node_as_text.get_ptr()) || !round_tripped_node.get_root())
+    {
+        vogl_error_printf("Failed verifying serialized JSON data (step 1)!\n");
+        return false;
     }
 
-    vogl_trace_packet gl_packet_cracker(&trace_gl_ctypes);
+    vogl_trace_packet temp_cracker(&trace_gl_ctypes);
+    if (!temp_cracker.json_deserialize(*round_tripped_node.get_root(), "<memory>", context.m_pBlob_manager))
+    {
+        vogl_error_printf("Failed verifying serialized JSON data (step 2)!\n");
+        return false;
+    }
 
-    uint32_t cur_file_index = 0;
-    uint32_t cur_frame_index = 0;
-    uint64_t cur_packet_index = 0;
-    VOGL_NOTE_UNUSED(cur_packet_index);
-    json_document cur_doc;
+    if (!gl_packet_cracker.compare(temp_cracker, false))
+    {
+        vogl_error_printf("Failed verifying serialized JSON data (step 3)!\n");
+        return false;
+    }
 
+    dynamic_stream dyn_stream;
+    if (!temp_cracker.serialize(dyn_stream))
     {
-        json_node &meta_node = cur_doc.get_root()->add_object("meta");
-        meta_node.add_key_value("cur_frame", cur_frame_index);
+        vogl_error_printf("Failed verifying serialized JSON data (step 4)!\n");
+        return false;
+    }
 
-        json_node &sof_node = cur_doc.get_root()->add_object("sof");
-        sof_node.add_key_value("pointer_sizes", pTrace_reader->get_sof_packet().m_pointer_sizes);
-        sof_node.add_key_value("version", to_hex_string(pTrace_reader->get_sof_packet().m_version));
-        if (!archive_name.is_empty())
-            sof_node.add_key_value("archive_filename", archive_name);
+    vogl_trace_packet temp_cracker2(&trace_gl_ctypes);
+    if (!temp_cracker2.deserialize(static_cast<const uint8_t *>(dyn_stream.get_ptr()), static_cast<uint32_t>(dyn_stream.get_size()), true))
+    {
+        vogl_error_printf("Failed verifying serialized JSON data (step 5)!\n");
+        return false;
+    }
 
-        json_node &uuid_array = sof_node.add_array("uuid");
-        for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(pTrace_reader->get_sof_packet().m_uuid); i++)
-            uuid_array.add_value(pTrace_reader->get_sof_packet().m_uuid[i]);
+    if (!gl_packet_cracker.compare(temp_cracker2, true))
+    {
+        vogl_error_printf("Failed verifying serialized JSON data (step 6)!\n");
+        return false;
     }
 
-    // TODO: Automatically dump binary snapshot file to text?
-    // Right now we can't afford to do it at trace time, it takes too much memory.
+    // Comparing the round-tripped bytes against the original packet would be excessive- the key value map fields may be
+    // binary serialized in different orders.
+    // TODO: maybe fix the key value map class so it serializes in a stable order (independent of hash table construction)?
+    if (dyn_stream.get_size() != packet_size)
+    {
+        vogl_error_printf("Round-tripped binary serialized size differs from original packet's' size (step 7)!\n");
+        return false;
+    }
 
-    json_node *pPacket_array = &cur_doc.get_root()->add_array("packets");
+    return true;
+}
 
-    bool flush_current_document = false;
+//----------------------------------------------------------------------------------------------------------------------
+// dump_trace_frames
+// Dumps one range, the reader must be positioned within frame range.m_frames.m_first_frame. Documents are started
+// lazily so frames before the first dumped packet don't use up file indices.
+//----------------------------------------------------------------------------------------------------------------------
+static bool dump_trace_frames(vogl_trace_file_reader &trace_reader, const dump_context &context, dump_range &range)
+{
+    VOGL_FUNC_TRACER
 
-    bool status = true;
+    range.m_end_file_index = range.m_first_file_index;
+    range.m_split_frame = false;
+    range.m_failed = false;
+
+    vogl_ctypes trace_gl_ctypes;
+    trace_gl_ctypes.init(trace_reader.get_sof_packet().m_pointer_sizes);
+
+    vogl_trace_packet gl_packet_cracker(&trace_gl_ctypes);
+
+    vogl_trace_packet::json_serialize_params serialize_params;
+    serialize_params.m_output_basename = file_utils::get_filename(context.m_output_base_filename.get_ptr());
+    serialize_params.m_pBlob_manager = context.m_pBlob_manager;
+    serialize_params.m_write_debug_info = context.m_write_debug_info;
+
+    const bool is_binary = (trace_reader.get_type() == cBINARY_TRACE_FILE_READER);
+
+    uint32_t cur_file_index = range.m_first_file_index;
+    uint32_t cur_frame_index = range.m_frames.m_first_frame;
+    json_document cur_doc;
+
+    // The JSON reader expects document N to hold frame N, so frames are numbered from the first dumped frame.
+    uint32_t base_frame_index = cur_frame_index - cur_file_index;
+
+    // NULL until the range's first document has been started. Only document 0 is started up front, so a dump always
+    // has at least one document even if nothing was in range, but later ranges which turn out to be past the end of
+    // the call range don't write empty documents.
+    json_node *pPacket_array = NULL;
+    if ((!range.m_first_file_index) && (context.m_call_low < 0) && (cur_frame_index >= context.m_first_frame))
+        pPacket_array = begin_dump_document(cur_doc, trace_reader, context, cur_frame_index - base_frame_index, cur_file_index);
+
+    bool flush_current_document = false;
 
     for (;;)
     {
-        uint64_t cur_packet_ofs = (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER) ? static_cast<vogl_binary_trace_file_reader *>(pTrace_reader.get())->get_cur_file_ofs() : 0;
+        uint64_t cur_packet_ofs = is_binary ? static_cast<vogl_binary_trace_file_reader &>(trace_reader).get_cur_file_ofs() : 0;
+        if (cur_packet_ofs >= range.m_frames.m_end_ofs)
+            break;
 
-        vogl_trace_file_reader::trace_file_reader_status_t read_status = pTrace_reader->read_next_packet();
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
 
         if (read_status == vogl_trace_file_reader::cEOF)
         {
@@ -2070,256 +2325,385 @@ static bool tool_dump_mode()
         {
             vogl_error_printf("Failed reading from trace file, or file size was too small\n");
 
-            status = false;
+            range.m_failed = true;
             break;
         }
 
-        if (pTrace_reader->get_packet_type() != cTSPTGLEntrypoint)
+        if (trace_reader.get_packet_type() != cTSPTGLEntrypoint)
         {
-            if (pTrace_reader->get_packet_type() == cTSPTSOF)
+            if (trace_reader.get_packet_type() == cTSPTSOF)
             {
                 vogl_error_printf("Encountered redundant SOF packet!\n");
-                status = false;
+                range.m_failed = true;
             }
 
-            json_node *pMeta_node = cur_doc.get_root()->find_child_object("meta");
+            json_node *pMeta_node = pPacket_array ? cur_doc.get_root()->find_child_object("meta") : NULL;
             if (pMeta_node)
-                pMeta_node->add_key_value("eof", (pTrace_reader->get_packet_type() == cTSPTEOF) ? 1 : 2);
+                pMeta_node->add_key_value("eof", (trace_reader.get_packet_type() == cTSPTEOF) ? 1 : 2);
 
             break;
         }
 
-        if (flush_current_document)
-        {
-            flush_current_document = false;
-
-            dynamic_string output_filename(cVarArg, "%s_%06u.json", output_base_filename.get_ptr(), cur_file_index);
-            vogl_message_printf("Writing file: \"%s\"\n", output_filename.get_ptr());
+        const vogl_trace_gl_entrypoint_packet &gl_packet = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
 
-            if (!cur_doc.serialize_to_file(output_filename.get_ptr(), true))
-            {
-                vogl_error_printf("%s: Failed serializing JSON document to file %s\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
+        if ((context.m_call_high >= 0) && (gl_packet.m_call_counter > static_cast<uint64_t>(context.m_call_high)))
+            break;
 
-                status = false;
-                break;
-            }
+        bool in_range = (cur_frame_index >= context.m_first_frame) && ((context.m_call_low < 0) || (gl_packet.m_call_counter >= static_cast<uint64_t>(context.m_call_low)));
 
-            if (cur_doc.get_root()->check_for_duplicate_keys())
-                vogl_warning_printf("%s: JSON document %s has nodes with duplicate keys, this document may not be readable by some JSON parsers\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
+        if (in_range)
+        {
+            if (flush_current_document)
+            {
+                flush_current_document = false;
 
-            cur_file_index++;
+                if (!write_dump_document(cur_doc, context, cur_file_index))
+                {
+                    range.m_failed = true;
+                    break;
+                }
 
-            pPacket_array = NULL;
-            cur_doc.clear();
+                cur_file_index++;
 
-            json_node &note_node = cur_doc.get_root()->add_object("meta");
-            note_node.add_key_value("cur_frame", cur_frame_index);
+                pPacket_array = begin_dump_document(cur_doc, trace_reader, context, cur_frame_index - base_frame_index, cur_file_index);
+            }
+            else if (!pPacket_array)
+            {
+                base_frame_index = cur_frame_index - cur_file_index;
+                pPacket_array = begin_dump_document(cur_doc, trace_reader, context, cur_frame_index - base_frame_index, cur_file_index);
+            }
 
-            json_node &uuid_array = note_node.add_array("uuid");
-            for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(pTrace_reader->get_sof_packet().m_uuid); i++)
-                uuid_array.add_value(pTrace_reader->get_sof_packet().m_uuid[i]);
+            if (context.m_debug)
+            {
+                vogl_debug_printf("Trace packet: File offset: %" PRIu64 ", Total size %u, Param size: %u, Client mem size %u, Name value size %u, call %" PRIu64 ", ID: %s (%u), Thread ID: 0x%" PRIX64 ", Trace Context: 0x%" PRIX64 "\n",
+                                 cur_packet_ofs,
+                                 gl_packet.m_size,
+                                 gl_packet.m_param_size,
+                                 gl_packet.m_client_memory_size,
+                                 gl_packet.m_name_value_map_size,
+                                 gl_packet.m_call_counter,
+                                 g_vogl_entrypoint_descs[gl_packet.m_entrypoint_id].m_pName,
+                                 gl_packet.m_entrypoint_id,
+                                 gl_packet.m_thread_id,
+                                 gl_packet.m_context_handle);
+            }
 
-            pPacket_array = &cur_doc.get_root()->add_array("packets");
-        }
+            if (!gl_packet_cracker.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), true))
+            {
+                vogl_error_printf("Failed deserializing GL entrypoint packet. Trying to continue parsing the file, this may die!\n");
+                continue;
+            }
 
-        const vogl_trace_gl_entrypoint_packet &gl_packet = pTrace_reader->get_packet<vogl_trace_gl_entrypoint_packet>();
-        const char *pFunc_name = g_vogl_entrypoint_descs[gl_packet.m_entrypoint_id].m_pName;
-        VOGL_NOTE_UNUSED(pFunc_name);
+            json_node &new_node = pPacket_array->add_object();
 
-        if (g_command_line_params().get_value_as_bool("debug"))
-        {
-            vogl_debug_printf("Trace packet: File offset: %" PRIu64 ", Total size %u, Param size: %u, Client mem size %u, Name value size %u, call %" PRIu64 ", ID: %s (%u), Thread ID: 0x%" PRIX64 ", Trace Context: 0x%" PRIX64 "\n",
-                             cur_packet_ofs,
-                             gl_packet.m_size,
-                             gl_packet.m_param_size,
-                             gl_packet.m_client_memory_size,
-                             gl_packet.m_name_value_map_size,
-                             gl_packet.m_call_counter,
-                             g_vogl_entrypoint_descs[gl_packet.m_entrypoint_id].m_pName,
-                             gl_packet.m_entrypoint_id,
-                             gl_packet.m_thread_id,
-                             gl_packet.m_context_handle);
-        }
+            serialize_params.m_cur_frame = cur_file_index;
+            if (!gl_packet_cracker.json_serialize(new_node, serialize_params))
+            {
+                vogl_error_printf("JSON serialization failed!\n");
 
-        if (!gl_packet_cracker.deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), true))
-        {
-            vogl_error_printf("Failed deserializing GL entrypoint packet. Trying to continue parsing the file, this may die!\n");
+                range.m_failed = true;
+                break;
+            }
 
-            //status = false;
-            //break;
-            continue;
+            if ((context.m_full_verification) && (!verify_dumped_packet(new_node, gl_packet_cracker, trace_gl_ctypes, context, trace_reader.get_packet_size())))
+            {
+                range.m_failed = true;
+                break;
+            }
         }
 
-        json_node &new_node = pPacket_array->add_object();
-
-        vogl_trace_packet::json_serialize_params serialize_params;
-        serialize_params.m_output_basename = file_utils::get_filename(output_base_filename.get_ptr());
-        serialize_params.m_pBlob_manager = &output_file_blob_manager;
-        serialize_params.m_cur_frame = cur_file_index;
-        serialize_params.m_write_debug_info = g_command_line_params().get_value_as_bool("write_debug_info");
-        if (!gl_packet_cracker.json_serialize(new_node, serialize_params))
+        if (vogl_is_swap_buffers_entrypoint(static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id)))
         {
-            vogl_error_printf("JSON serialization failed!\n");
+            if (pPacket_array)
+                flush_current_document = true;
 
-            status = false;
-            break;
+            cur_frame_index++;
+            if (cur_frame_index >= context.m_end_frame)
+                break;
         }
 
-        if (full_verification)
+        if ((pPacket_array) && (cur_doc.get_root()->size() >= 1 * 1000 * 1000))
         {
-#if 0
-            if (!strcmp(pFunc_name, "glClearColor"))
+            if (!range.m_allow_split_frames)
             {
-                VOGL_BREAKPOINT
+                range.m_split_frame = true;
+                break;
             }
-#endif
 
-            vogl::vector<char> new_node_as_text;
-            new_node.serialize(new_node_as_text, true, 0);
+            // TODO: Support replaying dumps like this, or fix the code to serialize the text as it goes.
+            vogl_error_printf("Haven't encountered a SwapBuffers() call in over 1000000 GL calls, dumping current in-memory JSON document to disk to avoid running out of memory. This JSON dump may not be replayable, but writing it anyway.\n");
+            flush_current_document = true;
+        }
+    }
 
-#if 0
-            if (new_node_as_text.size())
-            {
-                printf("%s\n", new_node_as_text.get_ptr());
-            }
-#endif
+    // Write whatever we have, even after a failure.
+    if ((pPacket_array) && (!range.m_split_frame))
+    {
+        json_node *pMeta_node = cur_doc.get_root()->find_child_object("meta");
+        if ((range.m_last) && (pMeta_node) && (!pMeta_node->has_key("eof")))
+            pMeta_node->add_key_value("eof", 2);
 
-            json_document round_tripped_node;
-            if (!round_tripped_node.deserialize(new_node_as_text.get_ptr()) || !round_tripped_node.get_root())
-            {
-                vogl_error_printf("Failed verifying serialized JSON data (step 1)!\n");
+        if (write_dump_document(cur_doc, context, cur_file_index))
+            cur_file_index++;
+        else
+            range.m_failed = true;
+    }
 
-                status = false;
-                break;
-            }
-            else
-            {
-                vogl_trace_packet temp_cracker(&trace_gl_ctypes);
-                bool success = temp_cracker.json_deserialize(*round_tripped_node.get_root(), "<memory>", &output_file_blob_manager);
-                if (!success)
-                {
-                    vogl_error_printf("Failed verifying serialized JSON data (step 2)!\n");
+    range.m_end_file_index = cur_file_index;
 
-                    status = false;
-                    break;
-                }
-                else
-                {
-                    success = gl_packet_cracker.compare(temp_cracker, false);
-                    if (!success)
-                    {
-                        vogl_error_printf("Failed verifying serialized JSON data (step 3)!\n");
+    return !range.m_failed;
+}
 
-                        status = false;
-                        break;
-                    }
-                    else
-                    {
-                        dynamic_stream dyn_stream;
+//----------------------------------------------------------------------------------------------------------------------
+// struct dump_task_context
+//----------------------------------------------------------------------------------------------------------------------
+struct dump_task_context
+{
+    const dump_context *m_pContext;
+    vogl::vector<dump_range> m_ranges;
+};
 
-                        success = temp_cracker.serialize(dyn_stream);
-                        if (!success)
-                        {
-                            vogl_error_printf("Failed verifying serialized JSON data (step 4)!\n");
+//----------------------------------------------------------------------------------------------------------------------
+// dump_range_task
+// Dumps one range with its own reader.
+//----------------------------------------------------------------------------------------------------------------------
+static void dump_range_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
 
-                            status = false;
-                            break;
-                        }
-                        else
-                        {
-                            vogl_trace_packet temp_cracker2(&trace_gl_ctypes);
-                            success = temp_cracker2.deserialize(static_cast<const uint8_t *>(dyn_stream.get_ptr()), static_cast<uint32_t>(dyn_stream.get_size()), true);
-                            if (!success)
-                            {
-                                vogl_error_printf("Failed verifying serialized JSON data (step 5)!\n");
+    dump_task_context &task_context = *static_cast<dump_task_context *>(pData_ptr);
+    dump_range &range = task_context.m_ranges[static_cast<uint32_t>(data)];
 
-                                status = false;
-                                break;
-                            }
-                            success = gl_packet_cracker.compare(temp_cracker2, true);
-                            if (!success)
-                            {
-                                vogl_error_printf("Failed verifying serialized JSON data (step 6)!\n");
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(open_trace_at_frame(task_context.m_pContext->m_input_filename, range.m_frames.m_first_frame));
+    if (!pTrace_reader.get())
+    {
+        range.m_end_file_index = range.m_first_file_index;
+        range.m_split_frame = false;
+        range.m_failed = true;
+        return;
+    }
 
-                                status = false;
-                                break;
-                            }
-                            else
-                            {
-                                uint64_t binary_serialized_size = dyn_stream.get_size();
-                                if (binary_serialized_size != pTrace_reader->get_packet_buf().size())
-                                {
-                                    vogl_error_printf("Round-tripped binary serialized size differs from original packet's' size (step 7)!\n");
+    dump_trace_frames(*pTrace_reader, *task_context.m_pContext, range);
+}
 
-                                    status = false;
-                                    break;
-                                }
-                                else
-                                {
-#if 0
-									// This is excessive- the key value map fields may be binary serialized in different orders
-									// TODO: maybe fix the key value map class so it serializes in a stable order (independent of hash table construction)?
-									const uint8_t *p = static_cast<const uint8_t *>(dyn_stream.get_ptr());
-									const uint8_t *q = static_cast<const uint8_t *>(pTrace_reader->get_packet_buf().get_ptr());
-									if (memcmp(p, q, binary_serialized_size) != 0)
-									{
-										file_utils::write_buf_to_file("p.bin", p, binary_serialized_size);
-										file_utils::write_buf_to_file("q.bin", q, binary_serialized_size);
-										vogl_error_printf("Round-tripped binary serialized data differs from original packet's data (step 7)!\n");
-
-										status = false;
-										break;
-									}
-#endif
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+//----------------------------------------------------------------------------------------------------------------------
+// tool_dump_mode
+//----------------------------------------------------------------------------------------------------------------------
+static bool tool_dump_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_trace_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_trace_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input binary trace file!\n");
+        return false;
+    }
+
+    dynamic_string output_base_filename(g_command_line_params().get_value_as_string_or_empty("", 2));
+    if (output_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify base filename of output JSON/blob files!\n");
+        return false;
+    }
+
+    vogl_loose_file_blob_manager output_file_blob_manager;
+
+    dynamic_string output_trace_path(file_utils::get_pathname(output_base_filename.get_ptr()));
+    vogl_debug_printf("%s: Output trace path: %s\n", VOGL_FUNCTION_INFO_CSTR, output_trace_path.get_ptr());
+    output_file_blob_manager.init(cBMFReadWrite, output_trace_path.get_ptr());
+
+    file_utils::create_directories(output_trace_path, false);
+
+    dynamic_string actual_input_trace_filename;
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_trace_filename, actual_input_trace_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
+    if (!pTrace_reader.get())
+    {
+        vogl_error_printf("%s: Failed opening input trace file \"%s\"\n", VOGL_FUNCTION_INFO_CSTR, input_trace_filename.get_ptr());
+        return false;
+    }
+
+    dump_context context;
+    context.m_input_filename = actual_input_trace_filename;
+    context.m_output_base_filename = output_base_filename;
+    context.m_pBlob_manager = &output_file_blob_manager;
+    context.m_call_low = g_command_line_params().get_value_as_int64("dump_call_low", 0, -1);
+    context.m_call_high = g_command_line_params().get_value_as_int64("dump_call_high", 0, -1);
+    context.m_full_verification = g_command_line_params().get_value_as_bool("verify");
+    context.m_write_debug_info = g_command_line_params().get_value_as_bool("write_debug_info");
+    context.m_debug = g_command_line_params().get_value_as_bool("debug");
+
+    int64_t frame_low = g_command_line_params().get_value_as_int64("dump_frame_low", 0, -1);
+    int64_t frame_high = g_command_line_params().get_value_as_int64("dump_frame_high", 0, -1);
+    context.m_first_frame = (frame_low > 0) ? static_cast<uint32_t>(math::minimum<int64_t>(frame_low, cUINT32_MAX)) : 0;
+    context.m_end_frame = (frame_high >= 0) ? static_cast<uint32_t>(math::minimum<int64_t>(frame_high + 1, cUINT32_MAX)) : cUINT32_MAX;
+
+    if (pTrace_reader->get_archive_blob_manager().is_initialized())
+    {
+        dynamic_string archive_filename(output_base_filename.get_ptr());
+        archive_filename += "_trace_archive.zip";
+
+        context.m_archive_name = file_utils::get_filename(archive_filename.get_ptr());
+
+        vogl_message_printf("Writing trace archive \"%s\", size %" PRIu64 " bytes\n", archive_filename.get_ptr(), pTrace_reader->get_archive_blob_manager().get_archive_size());
+
+        cfile_stream archive_stream;
+        if (!archive_stream.open(archive_filename.get_ptr(), cDataStreamWritable | cDataStreamSeekable))
+        {
+            vogl_error_printf("%s: Failed opening output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
+            return false;
         }
 
-        if (vogl_is_swap_buffers_entrypoint(static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id)))
+        if (!pTrace_reader->get_archive_blob_manager().write_archive_to_stream(archive_stream))
         {
-            flush_current_document = true;
-            cur_frame_index++;
+            vogl_error_printf("%s: Failed writing to output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
+            return false;
         }
 
-        if (cur_doc.get_root()->size() >= 1 * 1000 * 1000)
+        if (!archive_stream.close())
         {
-            // TODO: Support replaying dumps like this, or fix the code to serialize the text as it goes.
-            vogl_error_printf("Haven't encountered a SwapBuffers() call in over 1000000 GL calls, dumping current in-memory JSON document to disk to avoid running out of memory. This JSON dump may not be replayable, but writing it anyway.\n");
-            flush_current_document = true;
+            vogl_error_printf("%s: Failed writing to output trace archive \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, archive_filename.get_ptr());
+            return false;
         }
     }
 
-    json_node *pMeta_node = cur_doc.get_root()->find_child_object("meta");
+    // The first dumped frame becomes document 0. With a call index the frames holding the call range are known up
+    // front, otherwise a call range can only be found by reading the trace from the start on one thread.
+    uint32_t first_frame = context.m_first_frame;
+    uint32_t end_frame = context.m_end_frame;
+    uint32_t first_call_index = 0;
+    bool frames_known = (context.m_call_low < 0) && (context.m_call_high < 0);
+    bool nothing_to_dump = false;
 
-    if (pMeta_node)
+    if (pTrace_reader->get_call_index())
     {
-        if (!pMeta_node->has_key("eof"))
-            pMeta_node->add_key_value("eof", 2);
+        const vogl_trace_call_index &call_index = *pTrace_reader->get_call_index();
+
+        if ((context.m_call_low >= 0) && (!call_index.find_first_call_at_or_after(static_cast<uint64_t>(context.m_call_low), first_call_index)))
+            first_call_index = call_index.get_total_calls();
+        if (first_frame)
+        {
+            uint32_t frame_first_call = (first_frame < call_index.get_total_frames()) ? call_index.get_frame_first_call(first_frame) : call_index.get_total_calls();
+            first_call_index = math::maximum(first_call_index, frame_first_call);
+        }
+
+        if (first_call_index >= call_index.get_total_calls())
+            nothing_to_dump = true;
+        else
+            first_frame = call_index.get_call_frame(first_call_index);
+
+        uint32_t end_call_index;
+        if ((context.m_call_high >= 0) && (context.m_call_high < cINT64_MAX) && (call_index.find_first_call_at_or_after(static_cast<uint64_t>(context.m_call_high + 1), end_call_index)))
+            end_frame = math::minimum(end_frame, call_index.get_call_frame(end_call_index) + 1);
+
+        frames_known = true;
+    }
+
+    uint32_t num_threads = get_scan_thread_count();
+
+    dump_task_context task_context;
+    task_context.m_pContext = &context;
 
-        dynamic_string output_filename(cVarArg, "%s_%06u.json", output_base_filename.get_ptr(), cur_file_index);
-        vogl_message_printf("Writing file: \"%s\"\n", output_filename.get_ptr());
+    bool status = true;
+    uint32_t total_files = 0;
+
+    trace_frame_range_vec frame_ranges;
+    if ((!nothing_to_dump) && (frames_known) && (split_trace_into_frame_ranges(*pTrace_reader, first_frame, end_frame, num_threads, frame_ranges)))
+    {
+        task_context.m_ranges.resize(frame_ranges.size());
+        for (uint32_t i = 0; i < frame_ranges.size(); i++)
+        {
+            dump_range &range = task_context.m_ranges[i];
+            range.m_frames = frame_ranges[i];
+            range.m_first_file_index = frame_ranges[i].m_first_frame - first_frame;
+            range.m_allow_split_frames = false;
+            range.m_last = (i == (frame_ranges.size() - 1));
+        }
+
+        task_pool tp;
+        tp.init(num_threads - 1);
 
-        if (!cur_doc.serialize_to_file(output_filename.get_ptr(), true))
+        for (uint32_t i = 0; i < task_context.m_ranges.size(); i++)
         {
-            vogl_error_printf("%s: Failed serializing JSON document to file %s\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
+            if (!tp.queue_task(dump_range_task, i, &task_context))
+                dump_range_task(i, &task_context);
+        }
+
+        tp.join();
+        tp.deinit();
 
-            status = false;
+        uint32_t split_range_index = 0;
+        while ((split_range_index < task_context.m_ranges.size()) && (!task_context.m_ranges[split_range_index].m_split_frame))
+        {
+            if (task_context.m_ranges[split_range_index].m_failed)
+                status = false;
+            split_range_index++;
         }
 
-        if (cur_doc.get_root()->check_for_duplicate_keys())
-            vogl_warning_printf("%s: JSON document %s has nodes with duplicate keys, this document may not be readable by some JSON parsers\n", VOGL_FUNCTION_INFO_CSTR, output_filename.get_ptr());
+        if (split_range_index < task_context.m_ranges.size())
+        {
+            // A frame didn't fit in one document, so every later document needs renumbering. Redo everything from the
+            // start of its range on this thread, which overwrites every document the later ranges wrote.
+            dump_range range(task_context.m_ranges[split_range_index]);
+            range.m_frames.m_end_ofs = task_context.m_ranges.back().m_frames.m_end_ofs;
+            range.m_allow_split_frames = true;
+            range.m_last = true;
+
+            vogl_warning_printf("A frame in the range beginning at frame %u needs more than one JSON document, dumping the rest of the trace on one thread\n", range.m_frames.m_first_frame);
+
+            if (!pTrace_reader->seek_to_frame(range.m_frames.m_first_frame))
+            {
+                vogl_error_printf("Failed seeking to frame %u!\n", range.m_frames.m_first_frame);
+                return false;
+            }
+
+            if (!dump_trace_frames(*pTrace_reader, context, range))
+                status = false;
+            total_files = range.m_end_file_index;
+        }
+        else
+        {
+            // Ranges past the end of the call range don't write anything.
+            for (uint32_t i = 0; i < task_context.m_ranges.size(); i++)
+                total_files = math::maximum(total_files, task_context.m_ranges[i].m_end_file_index);
+        }
+    }
+    else if (!nothing_to_dump)
+    {
+        dump_range range;
+        range.m_frames.m_first_frame = 0;
+        range.m_frames.m_end_ofs = cUINT64_MAX;
+        range.m_first_file_index = 0;
+        range.m_allow_split_frames = true;
+        range.m_last = true;
+
+        if (first_call_index)
+        {
+            if (!pTrace_reader->seek_to_call_index(first_call_index))
+            {
+                vogl_error_printf("Failed seeking to call %u!\n", first_call_index);
+                return false;
+            }
+            range.m_frames.m_first_frame = first_frame;
+        }
+        else if ((first_frame) && (pTrace_reader->can_quickly_seek_forward()))
+        {
+            if (!pTrace_reader->seek_to_frame(first_frame))
+            {
+                vogl_error_printf("Failed seeking to frame %u!\n", first_frame);
+                return false;
+            }
+            range.m_frames.m_first_frame = first_frame;
+        }
 
-        cur_file_index++;
+        status = dump_trace_frames(*pTrace_reader, context, range);
+        total_files = range.m_end_file_index;
     }
 
     if (!status)
         vogl_error_printf("Failed dumping binary trace to JSON files starting with filename prefix \"%s\" (but wrote as much as possible)\n", output_base_filename.get_ptr());
     else
-        vogl_message_printf("Successfully dumped binary trace to %u JSON file(s) starting with filename prefix \"%s\"\n", cur_file_index, output_base_filename.get_ptr());
+        vogl_message_printf("Successfully dumped binary trace to %u JSON file(s) starting with filename prefix \"%s\"\n", total_files, output_base_filename.get_ptr());
 
     return status;
 }
@@ -2339,7 +2723,7 @@ static bool tool_parse_mode()
     }
 
     dynamic_string actual_input_filename;
-    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr()));
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
     if (!pTrace_reader.get())
         return false;
 
@@ -2409,9 +2793,7 @@ static bool tool_parse_mode()
             break;
         }
 
-        const vogl::vector<uint8_t> &packet_buf = pTrace_reader->get_packet_buf();
-
-        if (!trace_writer.write_packet(packet_buf.get_ptr(), packet_buf.size(), pTrace_reader->is_swap_buffers_packet()))
+        if (!trace_writer.write_packet(pTrace_reader->get_packet_ptr(), pTrace_reader->get_packet_size(), pTrace_reader->is_swap_buffers_packet()))
         {
             vogl_error_printf("Failed writing to output trace file \"%s\"\n", output_trace_filename.get_ptr());
             goto failed;
@@ -2437,236 +2819,589 @@ failed:
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-// struct histo_entry
+// struct splice_stats
 //----------------------------------------------------------------------------------------------------------------------
-typedef vogl::map<dynamic_string> dynamic_string_set;
-typedef vogl::map<dynamic_string, uint64_t> dynamic_string_hash_map;
-typedef vogl::map<uint32_t> uint_map;
-
-struct histo_entry
+struct splice_stats
 {
-    histo_entry()
-    {
-    }
-    histo_entry(dynamic_string_hash_map::const_iterator it, double val)
-        : m_it(it), m_value(val)
+    splice_stats()
     {
+        utils::zero_object(*this);
     }
 
-    dynamic_string_hash_map::const_iterator m_it;
-    double m_value;
+    uint64_t m_total_packets;
+    uint64_t m_total_packet_bytes;
+    uint32_t m_total_frames;
 
-    bool operator<(const histo_entry &rhs) const
-    {
-        return m_value > rhs.m_value;
-    }
+    // Highest call counter written so far, valid if m_total_packets != 0.
+    uint64_t m_max_call_counter;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
-// dump_histogram
+// splice_blobs_match
 //----------------------------------------------------------------------------------------------------------------------
-#define SAFE_FLOAT_DIV(n, d) (d ? ((double)(n) / (d)) : 0)
+static bool splice_blobs_match(const vogl_blob_manager &src_blob_manager, const vogl_blob_manager &dst_blob_manager, const dynamic_string &id)
+{
+    VOGL_FUNC_TRACER
 
-static void dump_histogram(const char *pMsg, const dynamic_string_hash_map &map, uint64_t total_gl_entrypoint_packets, uint64_t total_swaps)
+    if (src_blob_manager.get_size(id) != dst_blob_manager.get_size(id))
+        return false;
+
+    uint8_vec src_data, dst_data;
+    if ((!src_blob_manager.get(id, src_data)) || (!dst_blob_manager.get(id, dst_data)))
+        return false;
+
+    return src_data == dst_data;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// is_per_trace_info_blob
+// Blobs which describe the traced process rather than being referenced by packets, so an input's copy can be kept
+// under another name when an earlier input already provided one.
+//----------------------------------------------------------------------------------------------------------------------
+static bool is_per_trace_info_blob(const dynamic_string &id)
+{
+    return (id == VOGL_TRACE_ARCHIVE_COMPILER_INFO_FILENAME) || (id == VOGL_TRACE_ARCHIVE_MACHINE_INFO_FILENAME) ||
+           (id == VOGL_TRACE_ARCHIVE_ENTRYPOINT_STATS_FILENAME);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// get_internal_trace_command_type
+// Returns the command_type of a glInternalTraceCommandRAD key value map packet, or an empty string for any other
+// packet. Only internal trace commands are deserialized, every other packet is rejected by its header.
+//----------------------------------------------------------------------------------------------------------------------
+static dynamic_string get_internal_trace_command_type(vogl_trace_file_reader &trace_reader, vogl_trace_packet &trace_packet)
 {
     VOGL_FUNC_TRACER
 
-    vogl::vector<histo_entry> histo;
-    for (dynamic_string_hash_map::const_iterator it = map.begin(); it != map.end(); ++it)
-        histo.push_back(histo_entry(it, static_cast<double>(it->second)));
-    mergesort(histo);
-    vogl_printf("\n----------------------\n%s: %u\n", pMsg, map.size());
+    const vogl_trace_gl_entrypoint_packet &gl_packet = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
+    if (gl_packet.m_entrypoint_id != VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
+        return dynamic_string();
 
-    for (uint32_t i = 0; i < histo.size(); i++)
-    {
-        dynamic_string_hash_map::const_iterator it = histo[i].m_it;
-        vogl_printf("%s: Total calls: %" PRIu64 " %3.1f%%, Avg calls per frame: %f\n", it->first.get_ptr(), it->second, SAFE_FLOAT_DIV(it->second * 100.0f, total_gl_entrypoint_packets), SAFE_FLOAT_DIV(it->second, total_swaps));
-    }
+    if (!trace_packet.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), false))
+        return dynamic_string();
+
+    if (trace_packet.get_param_value<GLuint>(0) != cITCRKeyValueMap)
+        return dynamic_string();
+
+    return trace_packet.get_key_value_map().get_string("command_type");
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-// tool_info_mode
+// splice_trace_file
+// Copies the raw GL packets of frames [first_frame, end_frame) of a binary trace to trace_writer, which writes its own
+// SOF, ctypes, entrypoints and EOF packets, frame offset table and call index. If copy_archive is true the input's
+// archive blobs are copied too, except the ones the writer regenerates and deduplicated client memory (the reader
+// expands it into the packets it returns).
+// input_index is the input's position on the command line, starting at 1. Later inputs have their call counters
+// shifted past the highest one already written, so the output's counters stay unique.
 //----------------------------------------------------------------------------------------------------------------------
-static bool tool_info_mode()
+static bool splice_trace_file(vogl_trace_file_writer &trace_writer, vogl_trace_file_reader &trace_reader, const dynamic_string &input_filename,
+                              uint32_t input_index, uint32_t first_frame, uint32_t end_frame, bool copy_archive, splice_stats &stats)
 {
     VOGL_FUNC_TRACER
 
-    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
-    if (input_base_filename.is_empty())
+    const vogl_blob_manager &input_archive = trace_reader.get_archive_blob_manager();
+    vogl_archive_blob_manager &output_archive = *trace_writer.get_trace_archive();
+
+    bool has_archive_blobs = false;
+    if (input_archive.is_initialized())
     {
-        vogl_error_printf("Must specify filename of input JSON/blob trace files!\n");
-        return false;
-    }
+        dynamic_string_array blob_files(input_archive.enumerate());
+        for (uint32_t i = 0; i < blob_files.size(); i++)
+        {
+            const dynamic_string &id = blob_files[i];
+            if ((id.is_empty()) || (id == VOGL_TRACE_ARCHIVE_FRAME_FILE_OFFSETS_FILENAME) || (id == VOGL_TRACE_ARCHIVE_BLOCK_INDEX_FILENAME) ||
+                (id == VOGL_TRACE_ARCHIVE_CALL_INDEX_FILENAME) || (input_archive.get_prefix(id) == "client_memory"))
+                continue;
 
-    dynamic_string actual_input_filename;
-    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr()));
-    if (!pTrace_reader.get())
-        return false;
+            has_archive_blobs = true;
 
-    vogl_printf("Scanning trace file %s\n", actual_input_filename.get_ptr());
+            if (!copy_archive)
+                continue;
 
-    const vogl_trace_stream_start_of_file_packet &sof_packet = pTrace_reader->get_sof_packet();
+            dynamic_string dst_id(id);
+            if (output_archive.does_exist(id))
+            {
+                // Snapshot blobs are named by their contents, so the same name usually means the same data.
+                if (splice_blobs_match(input_archive, output_archive, id))
+                    continue;
 
-    if (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER)
+                if (!is_per_trace_info_blob(id))
+                {
+                    // Packets refer to these by name (or to backtrace map entries by index), so keeping either copy
+                    // would leave some packets pointing at the wrong data.
+                    vogl_error_printf("Blob file \"%s\" of trace \"%s\" conflicts with a different blob of the same name from an earlier input. "
+                                      "Splice with --splice_no_archive to leave the archives out.\n", id.get_ptr(), input_filename.get_ptr());
+                    return false;
+                }
+
+                file_utils::remove_extension(dst_id);
+                dst_id = dynamic_string(cVarArg, "%s_input%u.json", dst_id.get_ptr(), input_index);
+
+                vogl_message_printf("Trace \"%s\" has a different \"%s\" than an earlier input, copying it as \"%s\"\n", input_filename.get_ptr(), id.get_ptr(), dst_id.get_ptr());
+            }
+
+            if (!output_archive.copy_file(trace_reader.get_archive_blob_manager(), id, dst_id).has_content())
+            {
+                vogl_error_printf("Failed copying blob file \"%s\" from trace \"%s\" to output trace archive!\n", id.get_ptr(), input_filename.get_ptr());
+                return false;
+            }
+        }
+    }
+
+    if ((first_frame) && (!trace_reader.seek_to_frame(first_frame)))
     {
-        uint64_t file_size = dynamic_cast<vogl_binary_trace_file_reader *>(pTrace_reader.get())->get_stream().get_size();
-        vogl_printf("Total file size: %s\n", uint64_to_string_with_commas(file_size).get_ptr());
+        vogl_error_printf("Failed seeking to frame %u of trace \"%s\"\n", first_frame, input_filename.get_ptr());
+        return false;
     }
 
-    vogl_printf("SOF packet size: %" PRIu64 " bytes\n", sof_packet.m_size);
-    vogl_printf("Version: 0x%04X\n", sof_packet.m_version);
-    vogl_printf("UUID: 0x%08x 0x%08x 0x%08x 0x%08x\n", sof_packet.m_uuid[0], sof_packet.m_uuid[1], sof_packet.m_uuid[2], sof_packet.m_uuid[3]);
-    vogl_printf("First packet offset: %" PRIu64 "\n", sof_packet.m_first_packet_offset);
-    vogl_printf("Trace pointer size: %u\n", sof_packet.m_pointer_sizes);
-    vogl_printf("Trace archive size: %" PRIu64 " offset: %" PRIu64 "\n", sof_packet.m_archive_size, sof_packet.m_archive_offset);
-    vogl_printf("Can quickly seek forward: %u\nMax frame index: %" PRIu64 "\n", pTrace_reader->can_quickly_seek_forward(), pTrace_reader->get_max_frame_index());
+    vogl_ctypes trace_gl_ctypes(trace_reader.get_sof_packet().m_pointer_sizes);
+    vogl_trace_packet trace_packet(&trace_gl_ctypes);
 
-    if (!pTrace_reader->get_archive_blob_manager().is_initialized())
+    // A state snapshot can only be among the internal trace commands written before the range's first real GL call.
+    bool at_range_start = true;
+    bool found_state_snapshot = false;
+
+    uint64_t call_counter_ofs = stats.m_total_packets ? (stats.m_max_call_counter + 1) : 0;
+    uint8_vec renumbered_packet;
+
+    while (trace_reader.get_cur_frame() < end_frame)
     {
-        vogl_warning_printf("This trace does not have a trace archive!\n");
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+        if ((read_status != vogl_trace_file_reader::cOK) && (read_status != vogl_trace_file_reader::cEOF))
+        {
+            vogl_error_printf("Failed reading from trace file \"%s\"\n", input_filename.get_ptr());
+            return false;
+        }
+
+        if ((read_status == vogl_trace_file_reader::cEOF) || (trace_reader.is_eof_packet()))
+            break;
+
+        // The writer wrote its own SOF packet, and the EOF packet comes from close().
+        if (trace_reader.get_packet_type() != cTSPTGLEntrypoint)
+            continue;
+
+        dynamic_string command_type(get_internal_trace_command_type(trace_reader, trace_packet));
+
+        // The writer wrote its own ctypes and entrypoints packets.
+        if ((command_type == "ctypes") || (command_type == "entrypoints"))
+            continue;
+
+        if (at_range_start)
+        {
+            if (command_type == "state_snapshot")
+                found_state_snapshot = true;
+            else if (trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>().m_entrypoint_id != VOGL_ENTRYPOINT_glInternalTraceCommandRAD)
+                at_range_start = false;
+        }
+
+        const uint8_t *pPacket = static_cast<const uint8_t *>(trace_reader.get_packet_ptr());
+        uint64_t call_counter = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>().m_call_counter + call_counter_ofs;
+
+        if (call_counter_ofs)
+        {
+            renumbered_packet.resize(trace_reader.get_packet_size());
+            memcpy(renumbered_packet.get_ptr(), pPacket, renumbered_packet.size());
+
+            vogl_trace_gl_entrypoint_packet *pGL_packet = reinterpret_cast<vogl_trace_gl_entrypoint_packet *>(renumbered_packet.get_ptr());
+            pGL_packet->m_call_counter = call_counter;
+            pGL_packet->finalize();
+
+            pPacket = renumbered_packet.get_ptr();
+        }
+
+        bool is_swap = trace_reader.is_swap_buffers_packet();
+        if (!trace_writer.write_packet(pPacket, trace_reader.get_packet_size(), is_swap))
+        {
+            vogl_error_printf("Failed writing to output trace file \"%s\"\n", trace_writer.get_filename().get_ptr());
+            return false;
+        }
+
+        stats.m_max_call_counter = stats.m_total_packets ? math::maximum(stats.m_max_call_counter, call_counter) : call_counter;
+        stats.m_total_packets++;
+        stats.m_total_packet_bytes += trace_reader.get_packet_size();
+        if (is_swap)
+            stats.m_total_frames++;
     }
-    else
+
+    if ((first_frame) && (!found_state_snapshot))
     {
-        vogl_printf("----------------------\n");
-        vogl::vector<dynamic_string> archive_files(pTrace_reader->get_archive_blob_manager().enumerate());
-        vogl_printf("Total trace archive files: %u\n", archive_files.size());
-        for (uint32_t i = 0; i < archive_files.size(); i++)
-            vogl_printf("\"%s\"\n", archive_files[i].get_ptr());
-        vogl_printf("----------------------\n");
+        vogl_warning_printf("Frames 0-%u of trace \"%s\" were left out and the spliced range doesn't start with a state snapshot, so it will only replay correctly "
+                            "if it doesn't use any GL objects or state set up by the earlier frames. Replay with --trim_file to write a trace which does.\n",
+                            first_frame - 1, input_filename.get_ptr());
     }
 
-    uint32_t min_packet_size = cUINT32_MAX;
-    uint32_t max_packet_size = 0;
-    uint64_t total_packets = 1; // 1, not 0, to account for the SOF packet
-    uint64_t total_packet_bytes = 0;
-    uint64_t total_swaps = 0;
-    uint64_t total_make_currents = 0;
-    uint64_t total_internal_trace_commands = 0;
-    uint64_t total_non_gl_entrypoint_packets = 1; // 1, not 0, to account for the SOF packet
-    uint64_t total_gl_entrypoint_packets = 0;
-    uint64_t total_gl_commands = 0;
-    uint64_t total_glx_commands = 0;
-    uint64_t total_wgl_commands = 0;
-    uint64_t total_unknown_commands = 0;
-    uint64_t total_draws = 0;
-    bool found_eof_packet = false;
+    if ((!copy_archive) && (has_archive_blobs) && (found_state_snapshot))
+    {
+        vogl_warning_printf("The state snapshot at the start of the spliced range of trace \"%s\" refers to blob files in its trace archive, which isn't being copied, "
+                            "so the output trace won't replay.\n", input_filename.get_ptr());
+    }
 
-    uint64_t min_packets_per_frame = cUINT64_MAX;
-    uint64_t max_packets_per_frame = 0;
-    uint64_t max_frame_make_currents = 0;
-    uint64_t min_frame_make_currents = cUINT64_MAX;
+    if (call_counter_ofs)
+    {
+        vogl_message_printf("Renumbered the call counters of trace \"%s\" to follow on from the earlier inputs (added %" PRIu64 ")\n",
+                            input_filename.get_ptr(), call_counter_ofs);
+    }
 
-    uint64_t min_frame_draws = cUINT64_MAX;
-    uint64_t max_frame_draws = 0;
-    uint64_t cur_frame_draws = 0;
+    return true;
+}
 
-    uint64_t cur_frame_packet_count = 0;
-    uint64_t total_frame_make_currents = 0;
+//----------------------------------------------------------------------------------------------------------------------
+// tool_splice_mode
+// Extracts frame ranges of binary traces, concatenates traces or strips their archives, by copying raw packets. Usage:
+// --splice input.bin [input2.bin ...] output.bin, the frame range (if any) is applied to every input.
+//----------------------------------------------------------------------------------------------------------------------
+static bool tool_splice_mode()
+{
+    VOGL_FUNC_TRACER
 
-    uint64_t num_non_whitelisted_funcs = 0;
-    dynamic_string_set non_whitelisted_funcs_called;
+    // Param 0 is the executable.
+    uint32_t num_filenames = g_command_line_params().get_count("");
+    if (num_filenames < 3)
+    {
+        vogl_error_printf("Must specify one or more input binary trace files followed by the output binary trace file!\n");
+        return false;
+    }
+
+    dynamic_string output_trace_filename(g_command_line_params().get_value_as_string_or_empty("", num_filenames - 1));
+
+    file_utils::create_directories(output_trace_filename, true);
+
+    if (file_utils::add_default_extension(output_trace_filename, ".bin"))
+        vogl_message_printf("Splice output filename doesn't have an extension, appending \".bin\" to the filename\n");
 
-    uint64_t total_programs_linked = 0;
-    uint64_t total_program_binary_calls = 0;
-    uint_map unique_programs_used;
+    int64_t frame_low = g_command_line_params().get_value_as_int64("splice_frame_low", 0, -1);
+    int64_t frame_high = g_command_line_params().get_value_as_int64("splice_frame_high", 0, -1);
+    uint32_t first_frame = (frame_low > 0) ? static_cast<uint32_t>(math::minimum<int64_t>(frame_low, cUINT32_MAX)) : 0;
+    uint32_t end_frame = (frame_high >= 0) ? static_cast<uint32_t>(math::minimum<int64_t>(frame_high + 1, cUINT32_MAX)) : cUINT32_MAX;
+    if (first_frame >= end_frame)
+    {
+        vogl_error_printf("Invalid frame range!\n");
+        return false;
+    }
 
-    uint32_t total_gl_state_snapshots = 0;
+    bool copy_archive = !g_command_line_params().get_value_as_bool("splice_no_archive");
 
-    uint32_t total_display_list_calls = false;
-    uint32_t total_gl_get_errors = 0;
+    vogl_ctypes trace_ctypes;
+    vogl_trace_file_writer trace_writer(&trace_ctypes);
 
-    uint32_t total_context_creates = 0;
-    uint32_t total_context_destroys = 0;
+    splice_stats stats;
 
-    dynamic_string_hash_map all_apis_called, category_histogram, version_histogram, profile_histogram, deprecated_histogram;
+    timer splice_timer;
+    splice_timer.start();
 
-    vogl_ctypes trace_gl_ctypes(pTrace_reader->get_sof_packet().m_pointer_sizes);
+    for (uint32_t input_index = 1; input_index < (num_filenames - 1); input_index++)
+    {
+        const dynamic_string &input_filename = g_command_line_params().get_value_as_string_or_empty("", input_index);
+
+        vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_create_trace_file_reader(cBINARY_TRACE_FILE_READER, g_command_line_params().get_value_as_bool("mmap")));
+        if ((!pTrace_reader.get()) || (!pTrace_reader->open(input_filename.get_ptr(), g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr())))
+        {
+            vogl_error_printf("Failed opening binary trace file \"%s\"\n", input_filename.get_ptr());
+            goto failed;
+        }
+
+        const vogl_trace_stream_start_of_file_packet &sof_packet = pTrace_reader->get_sof_packet();
+
+        if (!trace_writer.is_opened())
+        {
+            // Keep the first input's pointer size and block compression.
+            trace_ctypes.init(sof_packet.m_pointer_sizes);
+            trace_writer.set_block_codec(static_cast<vogl_trace_block_codec_t>(sof_packet.m_block_codec));
+
+            if (!trace_writer.open(output_trace_filename.get_ptr(), NULL, true, false, sof_packet.m_pointer_sizes))
+            {
+                vogl_error_printf("Unable to create file \"%s\"!\n", output_trace_filename.get_ptr());
+                return false;
+            }
+        }
+        else if (sof_packet.m_pointer_sizes != trace_ctypes.get_pointer_size())
+        {
+            vogl_error_printf("Trace \"%s\" has a different pointer size than the first trace, they can't be spliced together\n", input_filename.get_ptr());
+            goto failed;
+        }
+
+        vogl_message_printf("Splicing trace \"%s\"\n", input_filename.get_ptr());
+
+        if (!splice_trace_file(trace_writer, *pTrace_reader, input_filename, input_index, first_frame, end_frame, copy_archive, stats))
+            goto failed;
+    }
+
+    if (!trace_writer.close())
+    {
+        vogl_error_printf("Failed closing output trace file \"%s\"\n", output_trace_filename.get_ptr());
+        goto failed;
+    }
+
+    splice_timer.stop();
+
+    vogl_message_printf("Successfully wrote %u frame(s), %s packets (%s bytes) to binary trace file \"%s\" in %.3f secs (%.1f MB/sec)\n", stats.m_total_frames,
+                        uint64_to_string_with_commas(stats.m_total_packets).get_ptr(), uint64_to_string_with_commas(stats.m_total_packet_bytes).get_ptr(),
+                        output_trace_filename.get_ptr(), splice_timer.get_elapsed_secs(), stats.m_total_packet_bytes / math::maximum(splice_timer.get_elapsed_secs(), 1e-6) / (1024.0 * 1024.0));
+
+    return true;
+
+failed:
+    trace_writer.close();
+
+    vogl_warning_printf("Processing failed, output trace file \"%s\" may be invalid!\n", output_trace_filename.get_ptr());
+
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct histo_entry
+//----------------------------------------------------------------------------------------------------------------------
+typedef vogl::map<dynamic_string> dynamic_string_set;
+typedef vogl::map<dynamic_string, uint64_t> dynamic_string_hash_map;
+typedef vogl::map<uint32_t> uint_map;
+
+struct histo_entry
+{
+    histo_entry()
+    {
+    }
+    histo_entry(dynamic_string_hash_map::const_iterator it, double val)
+        : m_it(it), m_value(val)
+    {
+    }
+
+    dynamic_string_hash_map::const_iterator m_it;
+    double m_value;
+
+    bool operator<(const histo_entry &rhs) const
+    {
+        return m_value > rhs.m_value;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// dump_histogram
+//----------------------------------------------------------------------------------------------------------------------
+#define SAFE_FLOAT_DIV(n, d) (d ? ((double)(n) / (d)) : 0)
+
+static void dump_histogram(const char *pMsg, const dynamic_string_hash_map &map, uint64_t total_gl_entrypoint_packets, uint64_t total_swaps)
+{
+    VOGL_FUNC_TRACER
+
+    vogl::vector<histo_entry> histo;
+    for (dynamic_string_hash_map::const_iterator it = map.begin(); it != map.end(); ++it)
+        histo.push_back(histo_entry(it, static_cast<double>(it->second)));
+    mergesort(histo);
+    vogl_printf("\n----------------------\n%s: %u\n", pMsg, map.size());
+
+    for (uint32_t i = 0; i < histo.size(); i++)
+    {
+        dynamic_string_hash_map::const_iterator it = histo[i].m_it;
+        vogl_printf("%s: Total calls: %" PRIu64 " %3.1f%%, Avg calls per frame: %f\n", it->first.get_ptr(), it->second, SAFE_FLOAT_DIV(it->second * 100.0f, total_gl_entrypoint_packets), SAFE_FLOAT_DIV(it->second, total_swaps));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct trace_info_stats
+// Totals gathered by --info over a range of whole frames. Ranges may be scanned by different threads and merged in any
+// order, so everything in here must be a sum, a min/max, or a set.
+//----------------------------------------------------------------------------------------------------------------------
+struct trace_info_stats
+{
+    uint32_t m_min_packet_size;
+    uint32_t m_max_packet_size;
+    uint64_t m_total_packets;
+    uint64_t m_total_packet_bytes;
+    uint64_t m_total_swaps;
+    uint64_t m_total_make_currents;
+    uint64_t m_total_internal_trace_commands;
+    uint64_t m_total_non_gl_entrypoint_packets;
+    uint64_t m_total_draws;
+
+    uint64_t m_min_packets_per_frame;
+    uint64_t m_max_packets_per_frame;
+    uint64_t m_min_frame_make_currents;
+    uint64_t m_max_frame_make_currents;
+    uint64_t m_min_frame_draws;
+    uint64_t m_max_frame_draws;
+
+    uint64_t m_total_programs_linked;
+    uint64_t m_total_program_binary_calls;
+    uint_map m_unique_programs_used;
+
+    uint32_t m_total_gl_state_snapshots;
+    uint32_t m_total_display_list_calls;
+    uint32_t m_total_gl_get_errors;
+    uint32_t m_total_context_creates;
+    uint32_t m_total_context_destroys;
+
+    // The API histograms, whitelist and API prefix totals are all derived from the per-entrypoint call counts.
+    uint64_t m_entrypoint_calls[VOGL_NUM_ENTRYPOINTS];
+
+    bool m_hit_eof;
+    bool m_found_eof_packet;
+    bool m_failed;
+
+    trace_info_stats()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        m_min_packet_size = cUINT32_MAX;
+        m_max_packet_size = 0;
+        m_total_packets = 0;
+        m_total_packet_bytes = 0;
+        m_total_swaps = 0;
+        m_total_make_currents = 0;
+        m_total_internal_trace_commands = 0;
+        m_total_non_gl_entrypoint_packets = 0;
+        m_total_draws = 0;
+
+        m_min_packets_per_frame = cUINT64_MAX;
+        m_max_packets_per_frame = 0;
+        m_min_frame_make_currents = cUINT64_MAX;
+        m_max_frame_make_currents = 0;
+        m_min_frame_draws = cUINT64_MAX;
+        m_max_frame_draws = 0;
+
+        m_total_programs_linked = 0;
+        m_total_program_binary_calls = 0;
+        m_unique_programs_used.clear();
+
+        m_total_gl_state_snapshots = 0;
+        m_total_display_list_calls = 0;
+        m_total_gl_get_errors = 0;
+        m_total_context_creates = 0;
+        m_total_context_destroys = 0;
+
+        utils::zero_object(m_entrypoint_calls);
+
+        m_hit_eof = false;
+        m_found_eof_packet = false;
+        m_failed = false;
+    }
+
+    void merge(const trace_info_stats &other)
+    {
+        m_min_packet_size = math::minimum(m_min_packet_size, other.m_min_packet_size);
+        m_max_packet_size = math::maximum(m_max_packet_size, other.m_max_packet_size);
+        m_total_packets += other.m_total_packets;
+        m_total_packet_bytes += other.m_total_packet_bytes;
+        m_total_swaps += other.m_total_swaps;
+        m_total_make_currents += other.m_total_make_currents;
+        m_total_internal_trace_commands += other.m_total_internal_trace_commands;
+        m_total_non_gl_entrypoint_packets += other.m_total_non_gl_entrypoint_packets;
+        m_total_draws += other.m_total_draws;
+
+        m_min_packets_per_frame = math::minimum(m_min_packets_per_frame, other.m_min_packets_per_frame);
+        m_max_packets_per_frame = math::maximum(m_max_packets_per_frame, other.m_max_packets_per_frame);
+        m_min_frame_make_currents = math::minimum(m_min_frame_make_currents, other.m_min_frame_make_currents);
+        m_max_frame_make_currents = math::maximum(m_max_frame_make_currents, other.m_max_frame_make_currents);
+        m_min_frame_draws = math::minimum(m_min_frame_draws, other.m_min_frame_draws);
+        m_max_frame_draws = math::maximum(m_max_frame_draws, other.m_max_frame_draws);
+
+        m_total_programs_linked += other.m_total_programs_linked;
+        m_total_program_binary_calls += other.m_total_program_binary_calls;
+        for (uint_map::const_iterator it = other.m_unique_programs_used.begin(); it != other.m_unique_programs_used.end(); ++it)
+            m_unique_programs_used.insert(it->first);
+
+        m_total_gl_state_snapshots += other.m_total_gl_state_snapshots;
+        m_total_display_list_calls += other.m_total_display_list_calls;
+        m_total_gl_get_errors += other.m_total_gl_get_errors;
+        m_total_context_creates += other.m_total_context_creates;
+        m_total_context_destroys += other.m_total_context_destroys;
+
+        for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+            m_entrypoint_calls[i] += other.m_entrypoint_calls[i];
+
+        m_hit_eof = m_hit_eof || other.m_hit_eof;
+        m_found_eof_packet = m_found_eof_packet || other.m_found_eof_packet;
+        m_failed = m_failed || other.m_failed;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// scan_trace_info
+// Accumulates stats from the reader's current position, which must be the start of a frame, until EOF or until a binary
+// reader's packet stream offset reaches end_ofs (the start of a later frame).
+//----------------------------------------------------------------------------------------------------------------------
+static void scan_trace_info(vogl_trace_file_reader &trace_reader, uint64_t end_ofs, trace_info_stats &stats, bool print_progress)
+{
+    VOGL_FUNC_TRACER
+
+    // end_ofs is only used with binary readers.
+    vogl_binary_trace_file_reader *pBinary_reader = NULL;
+    if (end_ofs != cUINT64_MAX)
+    {
+        VOGL_ASSERT(trace_reader.get_type() == cBINARY_TRACE_FILE_READER);
+        pBinary_reader = static_cast<vogl_binary_trace_file_reader *>(&trace_reader);
+    }
+
+    uint64_t cur_frame_draws = 0;
+    uint64_t cur_frame_packet_count = 0;
+    uint64_t total_frame_make_currents = 0;
+
+    vogl_ctypes trace_gl_ctypes(trace_reader.get_sof_packet().m_pointer_sizes);
 
     vogl_trace_packet trace_packet(&trace_gl_ctypes);
 
     for (;;)
     {
-        vogl_trace_file_reader::trace_file_reader_status_t read_status = pTrace_reader->read_next_packet();
+        if ((pBinary_reader) && (pBinary_reader->get_cur_file_ofs() >= end_ofs))
+            break;
+
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
 
         if ((read_status != vogl_trace_file_reader::cOK) && (read_status != vogl_trace_file_reader::cEOF))
         {
             vogl_error_printf("Failed reading from trace file!\n");
 
-            goto done;
+            stats.m_failed = true;
+            break;
         }
 
         if (read_status == vogl_trace_file_reader::cEOF)
         {
-            vogl_printf("At trace file EOF on swap %" PRIu64 "\n", total_swaps);
+            stats.m_hit_eof = true;
             break;
         }
 
-        const vogl::vector<uint8_t> &packet_buf = pTrace_reader->get_packet_buf();
-        VOGL_NOTE_UNUSED(packet_buf);
-
-        uint32_t packet_size = pTrace_reader->get_packet_size();
+        uint32_t packet_size = trace_reader.get_packet_size();
 
-        min_packet_size = math::minimum<uint32_t>(min_packet_size, packet_size);
-        max_packet_size = math::maximum<uint32_t>(max_packet_size, packet_size);
-        total_packets++;
-        total_packet_bytes += packet_size;
+        stats.m_min_packet_size = math::minimum<uint32_t>(stats.m_min_packet_size, packet_size);
+        stats.m_max_packet_size = math::maximum<uint32_t>(stats.m_max_packet_size, packet_size);
+        stats.m_total_packets++;
+        stats.m_total_packet_bytes += packet_size;
 
         cur_frame_packet_count++;
 
-        const vogl_trace_stream_packet_base &base_packet = pTrace_reader->get_base_packet();
-        VOGL_NOTE_UNUSED(base_packet);
-        const vogl_trace_gl_entrypoint_packet *pGL_packet = NULL;
-
-        if (pTrace_reader->get_packet_type() == cTSPTGLEntrypoint)
+        if (trace_reader.get_packet_type() == cTSPTGLEntrypoint)
         {
-            if (!trace_packet.deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), false))
+            if (!trace_packet.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), false))
             {
                 console::error("%s: Failed parsing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR);
-                goto done;
-            }
-
-            pGL_packet = &pTrace_reader->get_packet<vogl_trace_gl_entrypoint_packet>();
-            gl_entrypoint_id_t entrypoint_id = static_cast<gl_entrypoint_id_t>(pGL_packet->m_entrypoint_id);
 
-            const gl_entrypoint_desc_t &entrypoint_desc = g_vogl_entrypoint_descs[entrypoint_id];
-
-            all_apis_called[entrypoint_desc.m_pName]++;
-            category_histogram[entrypoint_desc.m_pCategory]++;
-            version_histogram[entrypoint_desc.m_pVersion]++;
-            profile_histogram[entrypoint_desc.m_pProfile]++;
-            deprecated_histogram[entrypoint_desc.m_pDeprecated]++;
-
-            if (!entrypoint_desc.m_is_whitelisted)
-            {
-                num_non_whitelisted_funcs++;
-                non_whitelisted_funcs_called.insert(entrypoint_desc.m_pName);
+                stats.m_failed = true;
+                break;
             }
 
-            if (!strcmp(entrypoint_desc.m_pAPI_prefix, "GLX"))
-                total_glx_commands++;
-            else if (!strcmp(entrypoint_desc.m_pAPI_prefix, "WGL"))
-                total_wgl_commands++;
-            else if (!strcmp(entrypoint_desc.m_pAPI_prefix, "GL"))
-                total_gl_commands++;
-            else
-                total_unknown_commands++;
+            const vogl_trace_gl_entrypoint_packet &gl_packet = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
+            gl_entrypoint_id_t entrypoint_id = static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id);
 
-            total_gl_entrypoint_packets++;
+            stats.m_entrypoint_calls[entrypoint_id]++;
 
             if (vogl_is_swap_buffers_entrypoint(entrypoint_id))
             {
-                total_swaps++;
-                if ((total_swaps & 255) == 255)
-                    console::progress("Frame %" PRIu64 "\n", total_swaps);
+                stats.m_total_swaps++;
+                if ((print_progress) && ((stats.m_total_swaps & 255) == 255))
+                    console::progress("Frame %" PRIu64 "\n", stats.m_total_swaps);
 
-                min_packets_per_frame = math::minimum(min_packets_per_frame, cur_frame_packet_count);
-                max_packets_per_frame = math::maximum(max_packets_per_frame, cur_frame_packet_count);
+                stats.m_min_packets_per_frame = math::minimum(stats.m_min_packets_per_frame, cur_frame_packet_count);
+                stats.m_max_packets_per_frame = math::maximum(stats.m_max_packets_per_frame, cur_frame_packet_count);
 
-                min_frame_draws = math::minimum(min_frame_draws, cur_frame_draws);
-                max_frame_draws = math::maximum(max_frame_draws, cur_frame_draws);
+                stats.m_min_frame_draws = math::minimum(stats.m_min_frame_draws, cur_frame_draws);
+                stats.m_max_frame_draws = math::maximum(stats.m_max_frame_draws, cur_frame_draws);
 
-                max_frame_make_currents = math::maximum(max_frame_make_currents, total_frame_make_currents);
-                min_frame_make_currents = math::minimum(min_frame_make_currents, total_frame_make_currents);
+                stats.m_max_frame_make_currents = math::maximum(stats.m_max_frame_make_currents, total_frame_make_currents);
+                stats.m_min_frame_make_currents = math::minimum(stats.m_min_frame_make_currents, total_frame_make_currents);
 
                 cur_frame_packet_count = 0;
                 total_frame_make_currents = 0;
@@ -2674,12 +3409,12 @@ static bool tool_info_mode()
             }
             else if (vogl_is_draw_entrypoint(entrypoint_id))
             {
-                total_draws++;
+                stats.m_total_draws++;
                 cur_frame_draws++;
             }
             else if (vogl_is_make_current_entrypoint(entrypoint_id))
             {
-                total_make_currents++;
+                stats.m_total_make_currents++;
                 total_frame_make_currents++;
             }
 
@@ -2687,7 +3422,7 @@ static bool tool_info_mode()
             {
                 case VOGL_ENTRYPOINT_glInternalTraceCommandRAD:
                 {
-                    total_internal_trace_commands++;
+                    stats.m_total_internal_trace_commands++;
 
                     GLuint cmd = trace_packet.get_param_value<GLuint>(0);
                     GLuint size = trace_packet.get_param_value<GLuint>(1);
@@ -2700,7 +3435,7 @@ static bool tool_info_mode()
                         dynamic_string cmd_type(kvm.get_string("command_type"));
                         if (cmd_type == "state_snapshot")
                         {
-                            total_gl_state_snapshots++;
+                            stats.m_total_gl_state_snapshots++;
                         }
                     }
 
@@ -2708,20 +3443,20 @@ static bool tool_info_mode()
                 }
                 case VOGL_ENTRYPOINT_glProgramBinary:
                 {
-                    total_program_binary_calls++;
+                    stats.m_total_program_binary_calls++;
                     break;
                 }
                 case VOGL_ENTRYPOINT_glLinkProgram:
                 case VOGL_ENTRYPOINT_glLinkProgramARB:
                 {
-                    total_programs_linked++;
+                    stats.m_total_programs_linked++;
                     break;
                 }
                 case VOGL_ENTRYPOINT_glUseProgram:
                 case VOGL_ENTRYPOINT_glUseProgramObjectARB:
                 {
                     GLuint trace_handle = trace_packet.get_param_value<GLuint>(0);
-                    unique_programs_used.insert(trace_handle);
+                    stats.m_unique_programs_used.insert(trace_handle);
 
                     break;
                 }
@@ -2732,23 +3467,23 @@ static bool tool_info_mode()
                 case VOGL_ENTRYPOINT_glCallLists:
                 case VOGL_ENTRYPOINT_glListBase:
                 {
-                    total_display_list_calls++;
+                    stats.m_total_display_list_calls++;
                     break;
                 }
                 case VOGL_ENTRYPOINT_glGetError:
                 {
-                    total_gl_get_errors++;
+                    stats.m_total_gl_get_errors++;
                     break;
                 }
                 case VOGL_ENTRYPOINT_glXCreateContext:
                 case VOGL_ENTRYPOINT_glXCreateContextAttribsARB:
                 {
-                    total_context_creates++;
+                    stats.m_total_context_creates++;
                     break;
                 }
                 case VOGL_ENTRYPOINT_glXDestroyContext:
                 {
-                    total_context_destroys++;
+                    stats.m_total_context_destroys++;
                     break;
                 }
                 default:
@@ -2757,196 +3492,1356 @@ static bool tool_info_mode()
         }
         else
         {
-            total_non_gl_entrypoint_packets++;
+            stats.m_total_non_gl_entrypoint_packets++;
         }
 
-        if (pTrace_reader->get_packet_type() == cTSPTEOF)
+        if (trace_reader.get_packet_type() == cTSPTEOF)
         {
-            found_eof_packet = true;
-            vogl_printf("Found trace file EOF packet on swap %" PRIu64 "\n", total_swaps);
+            stats.m_found_eof_packet = true;
             break;
         }
     }
+}
 
-done:
-    vogl_printf("\n");
+//----------------------------------------------------------------------------------------------------------------------
+// struct info_scan_context
+//----------------------------------------------------------------------------------------------------------------------
+struct info_scan_context
+{
+    dynamic_string m_filename;
+    trace_frame_range_vec m_ranges;
+    vogl::vector<trace_info_stats> m_stats;
+};
 
-#define PRINT_UINT_VAR(x) vogl_printf("%s: %u\n", dynamic_string(#x).replace("_", " ").get_ptr(), x);
-#define PRINT_UINT64_VAR(x) vogl_printf("%s: %" PRIu64 "\n", dynamic_string(#x).replace("_", " ").get_ptr(), x);
-#define PRINT_FLOAT(x, f) vogl_printf("%s: %f\n", dynamic_string(#x).replace("_", " ").get_ptr(), f);
+//----------------------------------------------------------------------------------------------------------------------
+// info_scan_range_task
+// Scans one range of frames with its own reader.
+//----------------------------------------------------------------------------------------------------------------------
+static void info_scan_range_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
 
-    PRINT_UINT64_VAR(num_non_whitelisted_funcs);
-    PRINT_UINT_VAR(total_gl_state_snapshots);
-
-    PRINT_UINT64_VAR(total_swaps);
-
-    PRINT_UINT64_VAR(total_make_currents);
-    PRINT_FLOAT(avg_make_currents_per_frame, SAFE_FLOAT_DIV(total_make_currents, total_swaps));
-    PRINT_UINT64_VAR(max_frame_make_currents);
-    PRINT_UINT64_VAR(min_frame_make_currents);
-
-    PRINT_UINT64_VAR(total_draws);
-    PRINT_FLOAT(avg_draws_per_frame, SAFE_FLOAT_DIV(total_draws, total_swaps));
-    PRINT_UINT64_VAR(min_frame_draws);
-    PRINT_UINT64_VAR(max_frame_draws);
-
-    PRINT_UINT_VAR(min_packet_size);
-    PRINT_UINT_VAR(max_packet_size);
-    PRINT_UINT64_VAR(total_packets);
-    PRINT_UINT64_VAR(total_packet_bytes);
-    PRINT_FLOAT(avg_packet_bytes_per_frame, SAFE_FLOAT_DIV(total_packet_bytes, total_swaps));
-    PRINT_FLOAT(avg_packet_size, SAFE_FLOAT_DIV(total_packet_bytes, total_packets));
-    PRINT_UINT64_VAR(min_packets_per_frame);
-    PRINT_UINT64_VAR(max_packets_per_frame);
-    PRINT_FLOAT(avg_packets_per_frame, SAFE_FLOAT_DIV(total_packets, total_swaps));
-
-    PRINT_UINT64_VAR(total_internal_trace_commands);
-    PRINT_UINT64_VAR(total_non_gl_entrypoint_packets);
-    PRINT_UINT64_VAR(total_gl_entrypoint_packets);
-    PRINT_UINT64_VAR(total_gl_commands);
-    PRINT_UINT64_VAR(total_glx_commands);
-    PRINT_UINT64_VAR(total_wgl_commands);
-    PRINT_UINT64_VAR(total_unknown_commands);
+    info_scan_context &context = *static_cast<info_scan_context *>(pData_ptr);
+    const trace_frame_range &range = context.m_ranges[static_cast<uint32_t>(data)];
+    trace_info_stats &stats = context.m_stats[static_cast<uint32_t>(data)];
+
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(open_trace_at_frame(context.m_filename, range.m_first_frame));
+    if (!pTrace_reader.get())
+    {
+        stats.m_failed = true;
+        return;
+    }
+
+    scan_trace_info(*pTrace_reader, range.m_end_ofs, stats, false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// scan_trace_info_multithreaded
+// Scans ranges of whole frames in parallel. Returns false (without touching stats) if the trace can't be split, in
+// which case the caller should scan it on one thread.
+//----------------------------------------------------------------------------------------------------------------------
+static bool scan_trace_info_multithreaded(vogl_trace_file_reader &trace_reader, const dynamic_string &filename, uint32_t num_threads, trace_info_stats &stats)
+{
+    VOGL_FUNC_TRACER
+
+    info_scan_context context;
+    context.m_filename = filename;
+
+    // One range per thread, each range re-opens the trace so more ranges cost more than they save in load balancing.
+    if (!split_trace_into_frame_ranges(trace_reader, 0, cUINT32_MAX, num_threads, context.m_ranges))
+        return false;
+
+    context.m_stats.resize(context.m_ranges.size());
+
+    task_pool tp;
+    if (!tp.init(num_threads - 1))
+        return false;
+
+    for (uint32_t i = 0; i < context.m_ranges.size(); i++)
+    {
+        if (!tp.queue_task(info_scan_range_task, i, &context))
+            info_scan_range_task(i, &context);
+    }
+
+    tp.join();
+    tp.deinit();
+
+    for (uint32_t i = 0; i < context.m_stats.size(); i++)
+        stats.merge(context.m_stats[i]);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// tool_info_mode
+//----------------------------------------------------------------------------------------------------------------------
+static bool tool_info_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input JSON/blob trace files!\n");
+        return false;
+    }
+
+    dynamic_string actual_input_filename;
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
+    if (!pTrace_reader.get())
+        return false;
+
+    vogl_printf("Scanning trace file %s\n", actual_input_filename.get_ptr());
+
+    const vogl_trace_stream_start_of_file_packet &sof_packet = pTrace_reader->get_sof_packet();
+
+    if (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER)
+    {
+        uint64_t file_size = dynamic_cast<vogl_binary_trace_file_reader *>(pTrace_reader.get())->get_stream().get_size();
+        vogl_printf("Total file size: %s\n", uint64_to_string_with_commas(file_size).get_ptr());
+    }
+
+    vogl_printf("SOF packet size: %" PRIu64 " bytes\n", sof_packet.m_size);
+    vogl_printf("Version: 0x%04X\n", sof_packet.m_version);
+    vogl_printf("UUID: 0x%08x 0x%08x 0x%08x 0x%08x\n", sof_packet.m_uuid[0], sof_packet.m_uuid[1], sof_packet.m_uuid[2], sof_packet.m_uuid[3]);
+    vogl_printf("First packet offset: %" PRIu64 "\n", sof_packet.m_first_packet_offset);
+    vogl_printf("Trace pointer size: %u\n", sof_packet.m_pointer_sizes);
+    vogl_printf("Trace block codec: %u\n", sof_packet.m_block_codec);
+    vogl_printf("Trace archive size: %" PRIu64 " offset: %" PRIu64 "\n", sof_packet.m_archive_size, sof_packet.m_archive_offset);
+    vogl_printf("Can quickly seek forward: %u\nMax frame index: %" PRIu64 "\n", pTrace_reader->can_quickly_seek_forward(), pTrace_reader->get_max_frame_index());
+
+    if (!pTrace_reader->get_archive_blob_manager().is_initialized())
+    {
+        vogl_warning_printf("This trace does not have a trace archive!\n");
+    }
+    else
+    {
+        vogl_printf("----------------------\n");
+        vogl::vector<dynamic_string> archive_files(pTrace_reader->get_archive_blob_manager().enumerate());
+        vogl_printf("Total trace archive files: %u\n", archive_files.size());
+        for (uint32_t i = 0; i < archive_files.size(); i++)
+            vogl_printf("\"%s\"\n", archive_files[i].get_ptr());
+        vogl_printf("----------------------\n");
+    }
+
+    uint32_t num_threads = get_scan_thread_count();
+
+    trace_info_stats stats;
+
+    // 1, not 0, to account for the SOF packet
+    stats.m_total_packets = 1;
+    stats.m_total_non_gl_entrypoint_packets = 1;
+
+    timer scan_timer;
+    scan_timer.start();
+
+    if (!scan_trace_info_multithreaded(*pTrace_reader, actual_input_filename, num_threads, stats))
+    {
+        num_threads = 1;
+        scan_trace_info(*pTrace_reader, cUINT64_MAX, stats, true);
+    }
+
+    scan_timer.stop();
+
+    vogl_debug_printf("Scanned trace in %.3f secs using %u thread(s)\n", scan_timer.get_elapsed_secs(), num_threads);
+
+    if (stats.m_found_eof_packet)
+        vogl_printf("Found trace file EOF packet on swap %" PRIu64 "\n", stats.m_total_swaps);
+    else if ((stats.m_hit_eof) && (!stats.m_failed))
+        vogl_printf("At trace file EOF on swap %" PRIu64 "\n", stats.m_total_swaps);
+
+    uint64_t num_non_whitelisted_funcs = 0;
+    dynamic_string_set non_whitelisted_funcs_called;
+
+    uint64_t total_gl_entrypoint_packets = 0;
+    uint64_t total_gl_commands = 0;
+    uint64_t total_glx_commands = 0;
+    uint64_t total_wgl_commands = 0;
+    uint64_t total_unknown_commands = 0;
+
+    dynamic_string_hash_map all_apis_called, category_histogram, version_histogram, profile_histogram, deprecated_histogram;
+
+    for (uint32_t entrypoint_id = 0; entrypoint_id < VOGL_NUM_ENTRYPOINTS; entrypoint_id++)
+    {
+        uint64_t num_calls = stats.m_entrypoint_calls[entrypoint_id];
+        if (!num_calls)
+            continue;
+
+        const gl_entrypoint_desc_t &entrypoint_desc = g_vogl_entrypoint_descs[entrypoint_id];
+
+        all_apis_called[entrypoint_desc.m_pName] += num_calls;
+        category_histogram[entrypoint_desc.m_pCategory] += num_calls;
+        version_histogram[entrypoint_desc.m_pVersion] += num_calls;
+        profile_histogram[entrypoint_desc.m_pProfile] += num_calls;
+        deprecated_histogram[entrypoint_desc.m_pDeprecated] += num_calls;
+
+        if (!entrypoint_desc.m_is_whitelisted)
+        {
+            num_non_whitelisted_funcs += num_calls;
+            non_whitelisted_funcs_called.insert(entrypoint_desc.m_pName);
+        }
+
+        if (!strcmp(entrypoint_desc.m_pAPI_prefix, "GLX"))
+            total_glx_commands += num_calls;
+        else if (!strcmp(entrypoint_desc.m_pAPI_prefix, "WGL"))
+            total_wgl_commands += num_calls;
+        else if (!strcmp(entrypoint_desc.m_pAPI_prefix, "GL"))
+            total_gl_commands += num_calls;
+        else
+            total_unknown_commands += num_calls;
+
+        total_gl_entrypoint_packets += num_calls;
+    }
+
+    vogl_printf("\n");
+
+#define PRINT_UINT_VAR(x) vogl_printf("%s: %u\n", dynamic_string(#x).replace("_", " ").get_ptr(), x);
+#define PRINT_UINT64_VAR(x) vogl_printf("%s: %" PRIu64 "\n", dynamic_string(#x).replace("_", " ").get_ptr(), x);
+#define PRINT_UINT_STAT(x) vogl_printf("%s: %u\n", dynamic_string(#x).replace("_", " ").get_ptr(), stats.m_##x);
+#define PRINT_UINT64_STAT(x) vogl_printf("%s: %" PRIu64 "\n", dynamic_string(#x).replace("_", " ").get_ptr(), stats.m_##x);
+#define PRINT_FLOAT(x, f) vogl_printf("%s: %f\n", dynamic_string(#x).replace("_", " ").get_ptr(), f);
+
+    PRINT_UINT64_VAR(num_non_whitelisted_funcs);
+    PRINT_UINT_STAT(total_gl_state_snapshots);
+
+    PRINT_UINT64_STAT(total_swaps);
+
+    PRINT_UINT64_STAT(total_make_currents);
+    PRINT_FLOAT(avg_make_currents_per_frame, SAFE_FLOAT_DIV(stats.m_total_make_currents, stats.m_total_swaps));
+    PRINT_UINT64_STAT(max_frame_make_currents);
+    PRINT_UINT64_STAT(min_frame_make_currents);
+
+    PRINT_UINT64_STAT(total_draws);
+    PRINT_FLOAT(avg_draws_per_frame, SAFE_FLOAT_DIV(stats.m_total_draws, stats.m_total_swaps));
+    PRINT_UINT64_STAT(min_frame_draws);
+    PRINT_UINT64_STAT(max_frame_draws);
+
+    PRINT_UINT_STAT(min_packet_size);
+    PRINT_UINT_STAT(max_packet_size);
+    PRINT_UINT64_STAT(total_packets);
+    PRINT_UINT64_STAT(total_packet_bytes);
+    PRINT_FLOAT(avg_packet_bytes_per_frame, SAFE_FLOAT_DIV(stats.m_total_packet_bytes, stats.m_total_swaps));
+    PRINT_FLOAT(avg_packet_size, SAFE_FLOAT_DIV(stats.m_total_packet_bytes, stats.m_total_packets));
+    PRINT_UINT64_STAT(min_packets_per_frame);
+    PRINT_UINT64_STAT(max_packets_per_frame);
+    PRINT_FLOAT(avg_packets_per_frame, SAFE_FLOAT_DIV(stats.m_total_packets, stats.m_total_swaps));
+
+    PRINT_UINT64_STAT(total_internal_trace_commands);
+    PRINT_UINT64_STAT(total_non_gl_entrypoint_packets);
+    PRINT_UINT64_VAR(total_gl_entrypoint_packets);
+    PRINT_UINT64_VAR(total_gl_commands);
+    PRINT_UINT64_VAR(total_glx_commands);
+    PRINT_UINT64_VAR(total_wgl_commands);
+    PRINT_UINT64_VAR(total_unknown_commands);
+
+    PRINT_UINT_STAT(found_eof_packet);
+
+    PRINT_UINT_STAT(total_display_list_calls);
+    printf("Avg display lists calls per frame: %f\n", SAFE_FLOAT_DIV(stats.m_total_display_list_calls, stats.m_total_swaps));
+
+    PRINT_UINT_STAT(total_gl_get_errors);
+    printf("Avg glGetError calls per frame: %f\n", SAFE_FLOAT_DIV(stats.m_total_gl_get_errors, stats.m_total_swaps));
+
+    PRINT_UINT_STAT(total_context_creates);
+    PRINT_UINT_STAT(total_context_destroys);
+
+#undef PRINT_UINT_VAR
+#undef PRINT_UINT64_VAR
+#undef PRINT_UINT_STAT
+#undef PRINT_UINT64_STAT
+#undef PRINT_FLOAT
+
+    vogl_printf("----------------------\n%s: %" PRIu64 "\n", "Total calls to glLinkProgram/glLinkProgramARB", stats.m_total_programs_linked);
+    vogl_printf("%s: %" PRIu64 "\n", "Total calls to glProgramBinary", stats.m_total_program_binary_calls);
+    vogl_printf("%s: %u\n", "Total unique program handles passed to glUseProgram/glUseProgramObjectARB", stats.m_unique_programs_used.size());
+
+    dump_histogram("API histogram", all_apis_called, total_gl_entrypoint_packets, stats.m_total_swaps);
+    dump_histogram("API Category histogram", category_histogram, total_gl_entrypoint_packets, stats.m_total_swaps);
+    dump_histogram("API Version histogram", version_histogram, total_gl_entrypoint_packets, stats.m_total_swaps);
+//dump_histogram("API Profile histogram", profile_histogram, total_gl_entrypoint_packets, stats.m_total_swaps);
+//dump_histogram("API Deprecated histogram", deprecated_histogram, total_gl_entrypoint_packets, stats.m_total_swaps);
+
+    if (non_whitelisted_funcs_called.size())
+    {
+        vogl_warning_printf("\n----------------------\n");
+        vogl_warning_printf("Number of non-whitelisted functions actually called: %u\n", non_whitelisted_funcs_called.size());
+        for (dynamic_string_set::const_iterator it = non_whitelisted_funcs_called.begin(); it != non_whitelisted_funcs_called.end(); ++it)
+            vogl_warning_printf("%s\n", it->first.get_ptr());
+        vogl_warning_printf("\n----------------------\n");
+    }
+
+    return true;
+}
+#undef SAFE_FLOAT_DIV
+
+//----------------------------------------------------------------------------------------------------------------------
+// param_value_matches
+//----------------------------------------------------------------------------------------------------------------------
+static bool param_value_matches(const bigint128 &value_to_find, vogl_namespace_t find_namespace, uint64_t value_data, vogl_ctype_t value_ctype, vogl_namespace_t value_namespace)
+{
+    if (find_namespace != VOGL_NAMESPACE_UNKNOWN)
+    {
+        if (find_namespace != value_namespace)
+            return false;
+    }
+
+    bigint128 value(0);
+
+    switch (value_ctype)
+    {
+        case VOGL_BOOL:
+        case VOGL_GLBOOLEAN:
+        {
+            value = value_data;
+            break;
+        }
+        case VOGL_GLENUM:
+        {
+            value = value_data;
+            break;
+        }
+        case VOGL_FLOAT:
+        case VOGL_GLFLOAT:
+        case VOGL_GLCLAMPF:
+        {
+            // Not supporting float/double finds for now
+            return false;
+        }
+        case VOGL_GLDOUBLE:
+        case VOGL_GLCLAMPD:
+        {
+            // Not supporting float/double finds for now
+            return false;
+        }
+        case VOGL_GLINT:
+        case VOGL_INT:
+        case VOGL_INT32T:
+        case VOGL_GLSIZEI:
+        case VOGL_GLFIXED:
+        {
+            value = static_cast<int32_t>(value_data);
+            break;
+        }
+        case VOGL_GLSHORT:
+        {
+            value = static_cast<int16_t>(value_data);
+            break;
+        }
+        case VOGL_GLBYTE:
+        {
+            value = static_cast<int8_t>(value_data);
+            break;
+        }
+        case VOGL_GLINT64:
+        case VOGL_GLINT64EXT:
+        {
+            value = static_cast<int64_t>(value_data);
+            break;
+        }
+        default:
+        {
+            value = value_data;
+            break;
+        }
+    }
+
+    if (value == value_to_find)
+        return true;
+
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// tool_index_mode
+//----------------------------------------------------------------------------------------------------------------------
+static bool tool_index_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input binary trace file!\n");
+        return false;
+    }
+
+    dynamic_string actual_input_filename;
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
+    if (!pTrace_reader.get())
+        return false;
+
+    if (pTrace_reader->get_type() != cBINARY_TRACE_FILE_READER)
+    {
+        vogl_error_printf("Only binary trace files can be indexed\n");
+        return false;
+    }
+
+    vogl_binary_trace_file_reader &binary_trace_reader = *static_cast<vogl_binary_trace_file_reader *>(pTrace_reader.get());
+
+    vogl_printf("Scanning trace file %s\n", actual_input_filename.get_ptr());
+
+    vogl_trace_call_index_builder call_index_builder;
+
+    for (;;)
+    {
+        uint64_t packet_ofs = binary_trace_reader.get_cur_file_ofs();
+
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = binary_trace_reader.read_next_packet();
+        if (read_status == vogl_trace_file_reader::cFailed)
+        {
+            vogl_error_printf("Failed reading from trace file!\n");
+            return false;
+        }
+
+        if ((read_status == vogl_trace_file_reader::cEOF) || (binary_trace_reader.is_eof_packet()))
+            break;
+
+        if (binary_trace_reader.get_packet_type() != cTSPTGLEntrypoint)
+            continue;
+
+        const vogl_trace_gl_entrypoint_packet &gl_packet = binary_trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
+
+        // Skip the commands the tracer writes itself (they aren't GL calls and all use call counter 0), so the index
+        // matches the one vogl_trace_file_writer would have written.
+        if ((gl_packet.m_entrypoint_id == VOGL_ENTRYPOINT_glInternalTraceCommandRAD) && (!gl_packet.m_context_handle))
+            continue;
+
+        call_index_builder.add_call(gl_packet.m_call_counter, packet_ofs, static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id));
+
+        if (binary_trace_reader.is_swap_buffers_packet())
+            call_index_builder.end_frame();
+    }
+
+    uint8_vec call_index_data;
+    call_index_builder.serialize(call_index_data, binary_trace_reader.get_sof_packet().m_uuid);
+
+    dynamic_string call_index_filename(vogl_trace_call_index::get_sidecar_filename(actual_input_filename.get_ptr()));
+    if (!file_utils::write_vec_to_file(call_index_filename.get_ptr(), call_index_data))
+    {
+        vogl_error_printf("Failed writing call index file \"%s\"\n", call_index_filename.get_ptr());
+        return false;
+    }
+
+    vogl_printf("Wrote %s byte call index for %s calls to \"%s\"\n", uint64_to_string_with_commas(call_index_data.size()).get_ptr(),
+                uint64_to_string_with_commas(call_index_builder.get_total_calls()).get_ptr(), call_index_filename.get_ptr());
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct export_columns_range
+// The columns of every GL entrypoint packet in one range of frames, one vector per column.
+//----------------------------------------------------------------------------------------------------------------------
+struct export_columns_range
+{
+    export_columns_range()
+        : m_failed(false)
+    {
+        utils::zero_object(m_frames);
+    }
+
+    void reserve(uint32_t num_rows)
+    {
+        m_call_counters.reserve(num_rows);
+        m_frame_indices.reserve(num_rows);
+        m_entrypoint_ids.reserve(num_rows);
+        m_context_handles.reserve(num_rows);
+        m_thread_ids.reserve(num_rows);
+        m_packet_begin_rdtscs.reserve(num_rows);
+        m_gl_begin_rdtscs.reserve(num_rows);
+        m_gl_end_rdtscs.reserve(num_rows);
+        m_packet_end_rdtscs.reserve(num_rows);
+        m_client_memory_sizes.reserve(num_rows);
+        m_backtrace_hash_indices.reserve(num_rows);
+    }
+
+    trace_frame_range m_frames;
+
+    vogl::vector<uint64_t> m_call_counters;
+    vogl::vector<uint32_t> m_frame_indices;
+    vogl::vector<uint16_t> m_entrypoint_ids;
+    vogl::vector<uint64_t> m_context_handles;
+    vogl::vector<uint64_t> m_thread_ids;
+    vogl::vector<uint64_t> m_packet_begin_rdtscs;
+    vogl::vector<uint64_t> m_gl_begin_rdtscs;
+    vogl::vector<uint64_t> m_gl_end_rdtscs;
+    vogl::vector<uint64_t> m_packet_end_rdtscs;
+    vogl::vector<uint32_t> m_client_memory_sizes;
+    vogl::vector<uint32_t> m_backtrace_hash_indices;
+
+    bool m_failed;
+};
+
+typedef vogl::vector<export_columns_range> export_columns_range_vec;
+
+//----------------------------------------------------------------------------------------------------------------------
+// export_trace_columns
+// Appends a row for each GL entrypoint packet from the reader's current position, which must be the start of the
+// range's first frame, until EOF or until a binary reader's packet stream offset reaches the range's end offset.
+// Only the fixed size packet header is used. Binary readers are told not to resolve deduplicated client memory, so
+// packets are returned as stored and the params and client memory are never deserialized. The client memory size
+// column is therefore the number of client memory bytes stored in each packet, which excludes any client memory
+// deduplicated into the trace archive.
+//----------------------------------------------------------------------------------------------------------------------
+static bool export_trace_columns(vogl_trace_file_reader &trace_reader, export_columns_range &range)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_binary_trace_file_reader *pBinary_reader = NULL;
+    if (trace_reader.get_type() == cBINARY_TRACE_FILE_READER)
+        static_cast<vogl_binary_trace_file_reader &>(trace_reader).set_resolve_client_memory_refs(false);
+
+    if (range.m_frames.m_end_ofs != cUINT64_MAX)
+    {
+        VOGL_ASSERT(trace_reader.get_type() == cBINARY_TRACE_FILE_READER);
+        pBinary_reader = static_cast<vogl_binary_trace_file_reader *>(&trace_reader);
+    }
+
+    // Count swaps here, the readers don't agree on when their frame index moves past a swap.
+    uint32_t frame_index = range.m_frames.m_first_frame;
+
+    for (;;)
+    {
+        if ((pBinary_reader) && (pBinary_reader->get_cur_file_ofs() >= range.m_frames.m_end_ofs))
+            break;
+
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+        if (read_status == vogl_trace_file_reader::cEOF)
+            break;
+
+        if (read_status != vogl_trace_file_reader::cOK)
+        {
+            vogl_error_printf("Failed reading from trace file!\n");
+            range.m_failed = true;
+            return false;
+        }
+
+        if (trace_reader.get_packet_type() == cTSPTEOF)
+            break;
+
+        if (trace_reader.get_packet_type() != cTSPTGLEntrypoint)
+            continue;
+
+        const vogl_trace_gl_entrypoint_packet &gl_packet = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
+        if ((trace_reader.get_packet_size() < sizeof(vogl_trace_gl_entrypoint_packet)) || (gl_packet.m_entrypoint_id >= VOGL_NUM_ENTRYPOINTS))
+        {
+            vogl_error_printf("Invalid GL entrypoint packet in frame %u\n", frame_index);
+            range.m_failed = true;
+            return false;
+        }
+
+        range.m_call_counters.push_back(gl_packet.m_call_counter);
+        range.m_frame_indices.push_back(frame_index);
+        range.m_entrypoint_ids.push_back(gl_packet.m_entrypoint_id);
+        range.m_context_handles.push_back(gl_packet.m_context_handle);
+        range.m_thread_ids.push_back(gl_packet.m_thread_id);
+        range.m_packet_begin_rdtscs.push_back(gl_packet.m_packet_begin_rdtsc);
+        range.m_gl_begin_rdtscs.push_back(gl_packet.m_gl_begin_rdtsc);
+        range.m_gl_end_rdtscs.push_back(gl_packet.m_gl_end_rdtsc);
+        range.m_packet_end_rdtscs.push_back(gl_packet.m_packet_end_rdtsc);
+        range.m_client_memory_sizes.push_back(gl_packet.m_client_memory_size);
+        range.m_backtrace_hash_indices.push_back(gl_packet.m_backtrace_hash_index);
+
+        if (vogl_is_swap_buffers_entrypoint(static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id)))
+            frame_index++;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct export_columns_context
+//----------------------------------------------------------------------------------------------------------------------
+struct export_columns_context
+{
+    dynamic_string m_filename;
+    export_columns_range_vec m_ranges;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// export_columns_range_task
+// Exports one range of frames with its own reader.
+//----------------------------------------------------------------------------------------------------------------------
+static void export_columns_range_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
+
+    export_columns_context &context = *static_cast<export_columns_context *>(pData_ptr);
+    export_columns_range &range = context.m_ranges[static_cast<uint32_t>(data)];
+
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(open_trace_at_frame(context.m_filename, range.m_frames.m_first_frame));
+    if (!pTrace_reader.get())
+    {
+        range.m_failed = true;
+        return;
+    }
+
+    export_trace_columns(*pTrace_reader, range);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// write_export_column
+// Writes one column of every range, in trace order, to "<prefix>_<name>.bin" as raw little endian values and adds it
+// to the manifest's column array, along with pDescription if the column's name alone isn't enough.
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+static bool write_export_column(const dynamic_string &output_prefix, const char *pName, const export_columns_range_vec &ranges, vogl::vector<T> export_columns_range::*pColumn, json_node &columns_node, const char *pDescription = NULL)
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string output_filename(cVarArg, "%s_%s.bin", output_prefix.get_ptr(), pName);
+
+    cfile_stream output_stream;
+    if (!output_stream.open(output_filename.get_ptr(), cDataStreamWritable))
+    {
+        vogl_error_printf("Failed creating column file \"%s\"\n", output_filename.get_ptr());
+        return false;
+    }
+
+    for (uint32_t i = 0; i < ranges.size(); i++)
+    {
+        const vogl::vector<T> &column = ranges[i].*pColumn;
+        if ((column.size()) && (output_stream.write(column.get_ptr(), column.size_in_bytes()) != column.size_in_bytes()))
+        {
+            vogl_error_printf("Failed writing column file \"%s\"\n", output_filename.get_ptr());
+            return false;
+        }
+    }
+
+    if (!output_stream.close())
+    {
+        vogl_error_printf("Failed writing column file \"%s\"\n", output_filename.get_ptr());
+        return false;
+    }
+
+    json_node &column_node = columns_node.add_object();
+    column_node.add_key_value("name", pName);
+    column_node.add_key_value("type", dynamic_string(cVarArg, "uint%u", static_cast<uint32_t>(sizeof(T) * 8)));
+    column_node.add_key_value("file", file_utils::get_filename(output_filename.get_ptr()));
+    if (pDescription)
+        column_node.add_key_value("description", pDescription);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// tool_export_columns_mode
+// Writes the header fields of every GL call to one fixed width binary file per column, plus a JSON manifest holding the
+// column types, row count and a dictionary of the entrypoint names used by the entrypoint_id column.
+//----------------------------------------------------------------------------------------------------------------------
+static bool tool_export_columns_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input trace file!\n");
+        return false;
+    }
+
+    dynamic_string output_prefix(g_command_line_params().get_value_as_string_or_empty("", 2));
+    if (output_prefix.is_empty())
+    {
+        vogl_error_printf("Must specify output filename prefix!\n");
+        return false;
+    }
+
+    dynamic_string actual_input_filename;
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
+    if (!pTrace_reader.get())
+        return false;
+
+    dynamic_string output_path(file_utils::get_pathname(output_prefix.get_ptr()));
+    if (!output_path.is_empty())
+        file_utils::create_directories(output_path, false);
+
+    vogl_printf("Exporting trace file %s\n", actual_input_filename.get_ptr());
+
+    uint32_t num_threads = get_scan_thread_count();
+
+    timer export_timer;
+    export_timer.start();
+
+    export_columns_context context;
+    context.m_filename = actual_input_filename;
+
+    trace_frame_range_vec frame_ranges;
+    if (split_trace_into_frame_ranges(*pTrace_reader, 0, cUINT32_MAX, num_threads, frame_ranges))
+    {
+        // The call index (if any) gives each range's row count up front, minus the tracer's own commands which it skips.
+        const vogl_trace_call_index *pCall_index = pTrace_reader->get_call_index();
+
+        context.m_ranges.resize(frame_ranges.size());
+        for (uint32_t i = 0; i < frame_ranges.size(); i++)
+        {
+            context.m_ranges[i].m_frames = frame_ranges[i];
+
+            if ((pCall_index) && (frame_ranges[i].m_first_frame < pCall_index->get_total_frames()))
+            {
+                uint32_t end_frame = ((i + 1) < frame_ranges.size()) ? frame_ranges[i + 1].m_first_frame : pCall_index->get_total_frames();
+                end_frame = math::minimum(end_frame, pCall_index->get_total_frames());
+                context.m_ranges[i].reserve(pCall_index->get_frame_first_call(end_frame) - pCall_index->get_frame_first_call(frame_ranges[i].m_first_frame));
+            }
+        }
+
+        task_pool tp;
+        tp.init(num_threads - 1);
+
+        for (uint32_t i = 0; i < context.m_ranges.size(); i++)
+        {
+            if (!tp.queue_task(export_columns_range_task, i, &context))
+                export_columns_range_task(i, &context);
+        }
+
+        tp.join();
+        tp.deinit();
+    }
+    else
+    {
+        num_threads = 1;
+
+        context.m_ranges.resize(1);
+        context.m_ranges[0].m_frames.m_end_ofs = cUINT64_MAX;
+
+        export_trace_columns(*pTrace_reader, context.m_ranges[0]);
+    }
+
+    uint64_t total_rows = 0;
+    uint64_t entrypoint_calls[VOGL_NUM_ENTRYPOINTS];
+    utils::zero_object(entrypoint_calls);
+
+    for (uint32_t i = 0; i < context.m_ranges.size(); i++)
+    {
+        const export_columns_range &range = context.m_ranges[i];
+        if (range.m_failed)
+        {
+            vogl_error_printf("Failed exporting frames beginning at frame %u\n", range.m_frames.m_first_frame);
+            return false;
+        }
+
+        total_rows += range.m_call_counters.size();
+        for (uint32_t j = 0; j < range.m_entrypoint_ids.size(); j++)
+            entrypoint_calls[range.m_entrypoint_ids[j]]++;
+    }
+
+    json_document manifest_doc;
+    json_node &root = *manifest_doc.get_root();
+    root.add_key_value("trace", file_utils::get_filename(actual_input_filename.get_ptr()));
+    root.add_key_value("rows", total_rows);
+    root.add_key_value("byte_order", "little");
+
+    json_node &columns_node = root.add_array("columns");
+
+    bool status = true;
+    status = status && write_export_column(output_prefix, "call_counter", context.m_ranges, &export_columns_range::m_call_counters, columns_node);
+    status = status && write_export_column(output_prefix, "frame", context.m_ranges, &export_columns_range::m_frame_indices, columns_node);
+    status = status && write_export_column(output_prefix, "entrypoint_id", context.m_ranges, &export_columns_range::m_entrypoint_ids, columns_node);
+    status = status && write_export_column(output_prefix, "context_handle", context.m_ranges, &export_columns_range::m_context_handles, columns_node);
+    status = status && write_export_column(output_prefix, "thread_id", context.m_ranges, &export_columns_range::m_thread_ids, columns_node);
+    status = status && write_export_column(output_prefix, "packet_begin_rdtsc", context.m_ranges, &export_columns_range::m_packet_begin_rdtscs, columns_node);
+    status = status && write_export_column(output_prefix, "gl_begin_rdtsc", context.m_ranges, &export_columns_range::m_gl_begin_rdtscs, columns_node);
+    status = status && write_export_column(output_prefix, "gl_end_rdtsc", context.m_ranges, &export_columns_range::m_gl_end_rdtscs, columns_node);
+    status = status && write_export_column(output_prefix, "packet_end_rdtsc", context.m_ranges, &export_columns_range::m_packet_end_rdtscs, columns_node);
+    status = status && write_export_column(output_prefix, "client_memory_size", context.m_ranges, &export_columns_range::m_client_memory_sizes, columns_node,
+                                              "Client memory bytes stored in the packet, excluding client memory deduplicated into the trace archive");
+    status = status && write_export_column(output_prefix, "backtrace_hash_index", context.m_ranges, &export_columns_range::m_backtrace_hash_indices, columns_node);
+    if (!status)
+        return false;
+
+    // Only the entrypoints which appear in the trace, ordered by id.
+    json_node &entrypoints_node = root.add_array("entrypoints");
+    for (uint32_t i = 0; i < VOGL_NUM_ENTRYPOINTS; i++)
+    {
+        if (!entrypoint_calls[i])
+            continue;
+
+        json_node &entrypoint_node = entrypoints_node.add_object();
+        entrypoint_node.add_key_value("id", i);
+        entrypoint_node.add_key_value("name", g_vogl_entrypoint_descs[i].m_pName);
+        entrypoint_node.add_key_value("calls", entrypoint_calls[i]);
+    }
+
+    dynamic_string manifest_filename(cVarArg, "%s_columns.json", output_prefix.get_ptr());
+    if (!manifest_doc.serialize_to_file(manifest_filename.get_ptr(), true))
+    {
+        vogl_error_printf("Failed writing column manifest \"%s\"\n", manifest_filename.get_ptr());
+        return false;
+    }
+
+    export_timer.stop();
+
+    vogl_printf("Exported %s GL calls to \"%s\" in %.3f secs using %u thread(s)\n", uint64_to_string_with_commas(total_rows).get_ptr(), manifest_filename.get_ptr(),
+                export_timer.get_elapsed_secs(), num_threads);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// tool_scan_bench_mode
+// Reads every packet of a binary trace with the buffered and memory mapped readers. An untimed pass is done first so
+// both readers see the same (hot) page cache.
+//----------------------------------------------------------------------------------------------------------------------
+static bool scan_trace_file(const dynamic_string &filename, bool memory_map, uint64_t &total_packets, uint64_t &total_packet_bytes, double &total_time)
+{
+    VOGL_FUNC_TRACER
+
+    total_packets = 0;
+    total_packet_bytes = 0;
+    total_time = 0;
+
+    timer tm;
+    tm.start();
+
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_create_trace_file_reader(cBINARY_TRACE_FILE_READER, memory_map));
+    if ((!pTrace_reader.get()) || (!pTrace_reader->open(filename.get_ptr(), g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr())))
+    {
+        vogl_error_printf("Failed opening trace file \"%s\"\n", filename.get_ptr());
+        return false;
+    }
+
+    uint32_t checksum = 0;
+
+    for (;;)
+    {
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = pTrace_reader->read_next_packet();
+        if (read_status == vogl_trace_file_reader::cFailed)
+        {
+            vogl_error_printf("Failed reading from trace file \"%s\"\n", filename.get_ptr());
+            return false;
+        }
+
+        if (read_status == vogl_trace_file_reader::cEOF)
+            break;
+
+        total_packets++;
+        total_packet_bytes += pTrace_reader->get_packet_size();
+
+        // Consume the packet the way most tools do, by looking at its header.
+        checksum ^= pTrace_reader->get_base_packet().m_crc;
+
+        if (pTrace_reader->is_eof_packet())
+            break;
+    }
+
+    pTrace_reader->close();
+
+    total_time = tm.get_elapsed_secs();
+
+    if (g_command_line_params().get_value_as_bool("verbose"))
+        vogl_debug_printf("Packet CRC checksum: 0x%08X\n", checksum);
+
+    return true;
+}
+
+static bool tool_scan_bench_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input binary trace file!\n");
+        return false;
+    }
+
+    dynamic_string actual_input_filename;
+    if (vogl_determine_trace_file_type(input_base_filename, actual_input_filename) != cBINARY_TRACE_FILE_READER)
+    {
+        vogl_error_printf("Input file \"%s\" is not a binary trace file\n", input_base_filename.get_ptr());
+        return false;
+    }
+
+    uint64_t total_packets, total_packet_bytes;
+    double total_time;
+
+    vogl_printf("Warming up file cache with \"%s\"\n", actual_input_filename.get_ptr());
+    if (!scan_trace_file(actual_input_filename, false, total_packets, total_packet_bytes, total_time))
+        return false;
+
+    static const struct
+    {
+        const char *m_pName;
+        bool m_memory_map;
+    } s_readers[] = { { "buffered", false }, { "mmap", true } };
+
+    for (uint32_t i = 0; i < VOGL_ARRAY_SIZE(s_readers); i++)
+    {
+        if (!scan_trace_file(actual_input_filename, s_readers[i].m_memory_map, total_packets, total_packet_bytes, total_time))
+            return false;
+
+        vogl_printf("%8s reader: %s packets, %s bytes, %3.3f secs, %3.1f MB/sec\n", s_readers[i].m_pName,
+                    uint64_to_string_with_commas(total_packets).get_ptr(), uint64_to_string_with_commas(total_packet_bytes).get_ptr(),
+                    total_time, (total_packet_bytes / (1024.0 * 1024.0)) / math::maximum(total_time, 1e-6));
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// tool_packet_array_bench_mode
+// Times loading trim_len frames starting at trim_frame into memory the way trimming does, with one heap block per
+// packet (the old vogl_trace_packet_array layout) and with vogl_trace_packet_array's arena. Each method is run several
+// times after an untimed warm-up pass, and the fastest run is reported.
+//----------------------------------------------------------------------------------------------------------------------
+static bool load_frames_into_packet_bufs(vogl_trace_file_reader &trace_reader, uint32_t frame_index, uint32_t num_frames, vogl::vector<uint8_vec> &packet_bufs)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_scoped_location_saver saved_loc(trace_reader);
+
+    if (!trace_reader.seek_to_frame(frame_index))
+        return false;
+
+    packet_bufs.reserve(packet_bufs.size() + num_frames * 1000);
+
+    uint32_t total_frames_read = 0;
+    for (;;)
+    {
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+        if (read_status == vogl_trace_file_reader::cFailed)
+            return false;
+
+        packet_bufs.enlarge(1)->append(trace_reader.get_packet_ptr(), trace_reader.get_packet_size());
+
+        if ((read_status == vogl_trace_file_reader::cEOF) || (trace_reader.is_eof_packet()))
+            break;
+
+        if ((trace_reader.is_swap_buffers_packet()) && (++total_frames_read == num_frames))
+            break;
+    }
+
+    return true;
+}
+
+static bool tool_packet_array_bench_mode()
+{
+    VOGL_FUNC_TRACER
+
+    dynamic_string input_base_filename(g_command_line_params().get_value_as_string_or_empty("", 1));
+    if (input_base_filename.is_empty())
+    {
+        vogl_error_printf("Must specify filename of input trace file!\n");
+        return false;
+    }
+
+    dynamic_string actual_input_filename;
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
+    if (!pTrace_reader.get())
+        return false;
+
+    uint32_t frame_index = g_command_line_params().get_value_as_uint("trim_frame", 0, 0);
+    uint32_t num_frames = g_command_line_params().get_value_as_uint("trim_len", 0, 1, 1);
+
+    const uint32_t cNumRuns = 5;
+
+    uint32_t actual_frames_read = 0;
+    uint32_t total_packets = 0;
+    uint64_t total_packet_bytes = 0;
+
+    {
+        vogl_trace_packet_array packets;
+        if (pTrace_reader->read_frame_packets(frame_index, num_frames, packets, actual_frames_read) != vogl_trace_file_reader::cOK)
+        {
+            vogl_error_printf("Failed reading frames %u-%u from trace file \"%s\"\n", frame_index, frame_index + num_frames - 1, actual_input_filename.get_ptr());
+            return false;
+        }
+
+        vogl::vector<uint8_vec> packet_bufs;
+        if (!load_frames_into_packet_bufs(*pTrace_reader, frame_index, num_frames, packet_bufs))
+        {
+            vogl_error_printf("Failed reading from trace file \"%s\"\n", actual_input_filename.get_ptr());
+            return false;
+        }
+
+        // Both methods must load exactly the same packets.
+        bool same_packets = (packets.size() == packet_bufs.size());
+        for (uint32_t i = 0; (same_packets) && (i < packets.size()); i++)
+        {
+            same_packets = (packets.get_packet_size(i) == packet_bufs[i].size()) && (!memcmp(packets.get_packet_ptr(i), packet_bufs[i].get_ptr(), packet_bufs[i].size()));
+            total_packet_bytes += packets.get_packet_size(i);
+        }
+
+        if (!same_packets)
+        {
+            vogl_error_printf("Packet arena contents don't match the packets read from trace file \"%s\"\n", actual_input_filename.get_ptr());
+            return false;
+        }
+
+        total_packets = packets.size();
+    }
+
+    vogl_printf("Loading %u frame(s) starting at frame %u: %s packets, %s bytes\n", actual_frames_read, frame_index,
+                uint64_to_string_with_commas(total_packets).get_ptr(), uint64_to_string_with_commas(total_packet_bytes).get_ptr());
+
+    double best_times[2] = { 1e+10, 1e+10 };
+
+    for (uint32_t run = 0; run < cNumRuns; run++)
+    {
+        timer tm;
+
+        tm.start();
+        {
+            vogl::vector<uint8_vec> packet_bufs;
+            if (!load_frames_into_packet_bufs(*pTrace_reader, frame_index, num_frames, packet_bufs))
+            {
+                vogl_error_printf("Failed reading from trace file \"%s\"\n", actual_input_filename.get_ptr());
+                return false;
+            }
+        }
+        best_times[0] = math::minimum(best_times[0], tm.get_elapsed_secs());
+
+        tm.start();
+        {
+            vogl_trace_packet_array packets;
+            if (pTrace_reader->read_frame_packets(frame_index, num_frames, packets, actual_frames_read) != vogl_trace_file_reader::cOK)
+            {
+                vogl_error_printf("Failed reading from trace file \"%s\"\n", actual_input_filename.get_ptr());
+                return false;
+            }
+        }
+        best_times[1] = math::minimum(best_times[1], tm.get_elapsed_secs());
+    }
+
+    static const char *s_method_names[2] = { "per-packet buffers", "packet arena" };
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        vogl_printf("%18s: %3.6f secs, %3.3f M packets/sec\n", s_method_names[i], best_times[i],
+                    (total_packets / 1000000.0) / math::maximum(best_times[i], 1e-9));
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct find_criteria
+// The parsed --find options, shared read-only by all the threads searching the trace.
+//----------------------------------------------------------------------------------------------------------------------
+struct find_criteria
+{
+    bigint128 m_value_to_find;
+    bool m_has_find_param;
+    vogl_namespace_t m_find_namespace;
+    dynamic_string m_find_param_name;
+
+    // One entry per entrypoint, non-zero if the entrypoint matches --find_func. Empty if there's no --find_func.
+    uint8_vec m_func_filter;
+
+    int64_t m_find_frame_low;
+    int64_t m_find_frame_high;
+    int64_t m_find_call_low;
+    int64_t m_find_call_high;
+
+    // Set by --find_json_lines, otherwise matches are printed to the console.
+    FILE *m_pJSON_lines_file;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// struct find_match
+//----------------------------------------------------------------------------------------------------------------------
+struct find_match
+{
+    // Empty when writing JSON lines.
+    dynamic_string m_heading;
+    dynamic_string m_json;
+};
+
+namespace vogl
+{
+    VOGL_DEFINE_BITWISE_MOVABLE(find_match);
+}
 
-    PRINT_UINT_VAR(found_eof_packet);
+typedef vogl::vector<find_match> find_match_vec;
 
-    PRINT_UINT_VAR(total_display_list_calls);
-    printf("Avg display lists calls per frame: %f\n", SAFE_FLOAT_DIV(total_display_list_calls, total_swaps));
+//----------------------------------------------------------------------------------------------------------------------
+// struct find_range
+// A part of the trace searched by one thread: either a range of whole frames, or a slice of the calls listed by the
+// call index.
+//----------------------------------------------------------------------------------------------------------------------
+struct find_range
+{
+    trace_frame_range m_frames;
 
-    PRINT_UINT_VAR(total_gl_get_errors);
-    printf("Avg glGetError calls per frame: %f\n", SAFE_FLOAT_DIV(total_gl_get_errors, total_swaps));
+    uint32_t m_first_indexed_call;
+    uint32_t m_end_indexed_call;
 
-    PRINT_UINT_VAR(total_context_creates);
-    PRINT_UINT_VAR(total_context_destroys);
+    // Matches are kept until every range is done, so they can be printed in trace order.
+    find_match_vec m_matches;
+    uint64_t m_total_matches;
+    bool m_failed;
 
-#undef PRINT_UINT
-#undef PRINT_UINT64_VAR
-#undef PRINT_FLOAT
+    find_range()
+        : m_first_indexed_call(0),
+          m_end_indexed_call(0),
+          m_total_matches(0),
+          m_failed(false)
+    {
+        m_frames.m_first_frame = 0;
+        m_frames.m_end_ofs = cUINT64_MAX;
+    }
+};
 
-    vogl_printf("----------------------\n%s: %" PRIu64 "\n", "Total calls to glLinkProgram/glLinkProgramARB", total_programs_linked);
-    vogl_printf("%s: %" PRIu64 "\n", "Total calls to glProgramBinary", total_program_binary_calls);
-    vogl_printf("%s: %u\n", "Total unique program handles passed to glUseProgram/glUseProgramObjectARB", unique_programs_used.size());
+//----------------------------------------------------------------------------------------------------------------------
+// print_find_match
+//----------------------------------------------------------------------------------------------------------------------
+static void print_find_match(const find_criteria &criteria, const find_match &match)
+{
+    if (criteria.m_pJSON_lines_file)
+    {
+        fputs(match.m_json.get_ptr(), criteria.m_pJSON_lines_file);
+        fputc('\n', criteria.m_pJSON_lines_file);
+    }
+    else
+    {
+        vogl_printf("%s", match.m_heading.get_ptr());
+        vogl_printf("%s\n", match.m_json.get_ptr());
+    }
+}
 
-    dump_histogram("API histogram", all_apis_called, total_gl_entrypoint_packets, total_swaps);
-    dump_histogram("API Category histogram", category_histogram, total_gl_entrypoint_packets, total_swaps);
-    dump_histogram("API Version histogram", version_histogram, total_gl_entrypoint_packets, total_swaps);
-//dump_histogram("API Profile histogram", profile_histogram, total_gl_entrypoint_packets, total_swaps);
-//dump_histogram("API Deprecated histogram", deprecated_histogram, total_gl_entrypoint_packets, total_swaps);
+//----------------------------------------------------------------------------------------------------------------------
+// add_find_match
+// param_index is -2 for a function match, -1 for a return value match.
+//----------------------------------------------------------------------------------------------------------------------
+static void add_find_match(const find_criteria &criteria, find_range &range, bool print_immediately, const vogl_trace_packet &trace_packet, int param_index, int array_element_index, uint64_t total_swaps)
+{
+    find_match local_match;
+    find_match &match = print_immediately ? local_match : *range.m_matches.enlarge(1);
 
-#undef DUMP_HISTOGRAM
+    json_document doc;
+    vogl_trace_packet::json_serialize_params params;
 
-    if (non_whitelisted_funcs_called.size())
+    if (criteria.m_pJSON_lines_file)
     {
-        vogl_warning_printf("\n----------------------\n");
-        vogl_warning_printf("Number of non-whitelisted functions actually called: %u\n", non_whitelisted_funcs_called.size());
-        for (dynamic_string_set::const_iterator it = non_whitelisted_funcs_called.begin(); it != non_whitelisted_funcs_called.end(); ++it)
-            vogl_warning_printf("%s\n", it->first.get_ptr());
-        vogl_warning_printf("\n----------------------\n");
+        json_node &root = *doc.get_root();
+        root.add_key_value("call_counter", trace_packet.get_call_counter());
+        root.add_key_value("frame", total_swaps);
+        root.add_key_value("func", trace_packet.get_entrypoint_desc().m_pName);
+
+        if (param_index == -2)
+            root.add_key_value("match", "func");
+        else if (param_index < 0)
+            root.add_key_value("match", "return");
+        else
+        {
+            root.add_key_value("match", "param");
+            root.add_key_value("param_index", param_index);
+            root.add_key_value("param_name", trace_packet.get_param_desc(param_index).m_pName);
+            if (array_element_index >= 0)
+                root.add_key_value("element_index", array_element_index);
+        }
+
+        trace_packet.json_serialize(root.add_object("packet"), params);
+
+        doc.serialize(match.m_json, false);
     }
+    else
+    {
+        trace_packet.json_serialize(*doc.get_root(), params);
 
-    return true;
+        doc.serialize(match.m_json);
+
+        if (param_index == -2)
+            match.m_heading.format("----- Function match, frame %" PRIu64 ":\n", total_swaps);
+        else if (param_index < 0)
+            match.m_heading.format("----- Return value match, frame %" PRIu64 ":\n", total_swaps);
+        else if (array_element_index >= 0)
+            match.m_heading.format("----- Parameter %i element %i match, frame %" PRIu64 ":\n", param_index, array_element_index, total_swaps);
+        else
+            match.m_heading.format("----- Parameter %i match, frame %" PRIu64 ":\n", param_index, total_swaps);
+    }
+
+    range.m_total_matches++;
+
+    if (print_immediately)
+        print_find_match(criteria, match);
 }
-#undef SAFE_FLOAT_DIV
 
 //----------------------------------------------------------------------------------------------------------------------
-// param_value_matches
+// find_in_packet
+// The second stage of the find: matches the parameters of a packet which passed the header checks.
 //----------------------------------------------------------------------------------------------------------------------
-static bool param_value_matches(const bigint128 &value_to_find, vogl_namespace_t find_namespace, uint64_t value_data, vogl_ctype_t value_ctype, vogl_namespace_t value_namespace)
+static void find_in_packet(const find_criteria &criteria, find_range &range, bool print_immediately, const vogl_trace_packet &trace_packet, uint64_t total_swaps)
 {
-    if (find_namespace != VOGL_NAMESPACE_UNKNOWN)
+    if (!criteria.m_has_find_param)
     {
-        if (find_namespace != value_namespace)
-            return false;
+        add_find_match(criteria, range, print_immediately, trace_packet, -2, -1, total_swaps);
+        return;
     }
 
-    bigint128 value(0);
+    const vogl_namespace_t find_namespace = criteria.m_find_namespace;
+    const dynamic_string &find_param_name = criteria.m_find_param_name;
 
-    switch (value_ctype)
+    if (trace_packet.has_return_value())
     {
-        case VOGL_BOOL:
-        case VOGL_GLBOOLEAN:
+        if ((find_param_name.is_empty()) || (find_param_name == "return"))
         {
-            value = value_data;
-            break;
+            if (param_value_matches(criteria.m_value_to_find, find_namespace, trace_packet.get_return_value_data(), trace_packet.get_return_value_ctype(), trace_packet.get_return_value_namespace()))
+                add_find_match(criteria, range, print_immediately, trace_packet, -1, -1, total_swaps);
         }
-        case VOGL_GLENUM:
+    }
+
+    for (uint32_t i = 0; i < trace_packet.total_params(); i++)
+    {
+        if ((find_param_name.has_content()) && (find_param_name != trace_packet.get_param_desc(i).m_pName))
+            continue;
+
+        const vogl_ctype_desc_t &param_ctype_desc = trace_packet.get_param_ctype_desc(i);
+
+        if (param_ctype_desc.m_is_pointer)
         {
-            value = value_data;
-            break;
+            if ((!param_ctype_desc.m_is_opaque_pointer) && (param_ctype_desc.m_pointee_ctype != VOGL_VOID) && (trace_packet.has_param_client_memory(i)))
+            {
+                const vogl_client_memory_array array(trace_packet.get_param_client_memory_array(i));
+
+                for (uint32_t j = 0; j < array.size(); j++)
+                {
+                    if (param_value_matches(criteria.m_value_to_find, find_namespace, array.get_element<uint64_t>(j), array.get_element_ctype(), trace_packet.get_param_namespace(i)))
+                        add_find_match(criteria, range, print_immediately, trace_packet, i, j, total_swaps);
+                }
+            }
         }
-        case VOGL_FLOAT:
-        case VOGL_GLFLOAT:
-        case VOGL_GLCLAMPF:
+        else if (param_value_matches(criteria.m_value_to_find, find_namespace, trace_packet.get_param_data(i), trace_packet.get_param_ctype(i), trace_packet.get_param_namespace(i)))
         {
-            // Not supporting float/double finds for now
-            return false;
+            add_find_match(criteria, range, print_immediately, trace_packet, i, -1, total_swaps);
         }
-        case VOGL_GLDOUBLE:
-        case VOGL_GLCLAMPD:
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// find_in_trace
+// Searches from the reader's current position, which must be the start of a frame, until EOF or until a binary reader's
+// packet stream offset reaches the end of the range. If pIndexed_calls isn't NULL, only the range's slice of those
+// calls is read instead.
+//----------------------------------------------------------------------------------------------------------------------
+static void find_in_trace(vogl_trace_file_reader &trace_reader, const find_criteria &criteria, const uint32_vec *pIndexed_calls, find_range &range, bool print_immediately)
+{
+    VOGL_FUNC_TRACER
+
+    vogl_binary_trace_file_reader *pBinary_reader = NULL;
+    if ((!pIndexed_calls) && (range.m_frames.m_end_ofs != cUINT64_MAX))
+    {
+        VOGL_ASSERT(trace_reader.get_type() == cBINARY_TRACE_FILE_READER);
+        pBinary_reader = static_cast<vogl_binary_trace_file_reader *>(&trace_reader);
+    }
+
+    vogl_ctypes trace_gl_ctypes(trace_reader.get_sof_packet().m_pointer_sizes);
+    vogl_trace_packet trace_packet(&trace_gl_ctypes);
+
+    uint64_t total_swaps = trace_reader.get_cur_frame();
+    uint32_t indexed_call_pos = range.m_first_indexed_call;
+
+    for (;;)
+    {
+        if (pIndexed_calls)
         {
-            // Not supporting float/double finds for now
-            return false;
+            if (indexed_call_pos >= range.m_end_indexed_call)
+                break;
+
+            uint32_t call_index = (*pIndexed_calls)[indexed_call_pos++];
+            if (!trace_reader.seek_to_call_index(call_index))
+            {
+                vogl_error_printf("Failed seeking to call %u!\n", call_index);
+                range.m_failed = true;
+                break;
+            }
+
+            total_swaps = trace_reader.get_cur_frame();
         }
-        case VOGL_GLINT:
-        case VOGL_INT:
-        case VOGL_INT32T:
-        case VOGL_GLSIZEI:
-        case VOGL_GLFIXED:
+        else if ((pBinary_reader) && (pBinary_reader->get_cur_file_ofs() >= range.m_frames.m_end_ofs))
         {
-            value = static_cast<int32_t>(value_data);
             break;
         }
-        case VOGL_GLSHORT:
+
+        vogl_trace_file_reader::trace_file_reader_status_t read_status = trace_reader.read_next_packet();
+
+        if ((read_status != vogl_trace_file_reader::cOK) && (read_status != vogl_trace_file_reader::cEOF))
         {
-            value = static_cast<int16_t>(value_data);
+            vogl_error_printf("Failed reading from trace file!\n");
+            range.m_failed = true;
             break;
         }
-        case VOGL_GLBYTE:
-        {
-            value = static_cast<int8_t>(value_data);
+
+        if (read_status == vogl_trace_file_reader::cEOF)
             break;
-        }
-        case VOGL_GLINT64:
-        case VOGL_GLINT64EXT:
-        {
-            value = static_cast<int64_t>(value_data);
+
+        if (trace_reader.get_packet_type() == cTSPTEOF)
             break;
-        }
-        default:
+        else if (trace_reader.get_packet_type() != cTSPTGLEntrypoint)
+            continue;
+
+        // First stage: everything which can be decided from the packet's header, without deserializing it.
+        const vogl_trace_gl_entrypoint_packet &gl_packet = trace_reader.get_packet<vogl_trace_gl_entrypoint_packet>();
+        if (gl_packet.m_entrypoint_id >= VOGL_NUM_ENTRYPOINTS)
         {
-            value = value_data;
+            console::error("%s: Failed parsing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR);
+            range.m_failed = true;
             break;
         }
-    }
 
-    if (value == value_to_find)
-        return true;
+        const gl_entrypoint_id_t entrypoint_id = static_cast<gl_entrypoint_id_t>(gl_packet.m_entrypoint_id);
+        const uint64_t call_counter = gl_packet.m_call_counter;
 
-    return false;
+        if ((criteria.m_find_frame_high >= 0) && (total_swaps > static_cast<uint64_t>(criteria.m_find_frame_high)))
+            break;
+        if ((criteria.m_find_call_high >= 0) && (call_counter > static_cast<uint64_t>(criteria.m_find_call_high)))
+            break;
+
+        bool is_candidate = true;
+        if ((criteria.m_find_frame_low >= 0) && (total_swaps < static_cast<uint64_t>(criteria.m_find_frame_low)))
+            is_candidate = false;
+        else if ((criteria.m_find_call_low >= 0) && (call_counter < static_cast<uint64_t>(criteria.m_find_call_low)))
+            is_candidate = false;
+        else if ((criteria.m_func_filter.size()) && (!criteria.m_func_filter[entrypoint_id]))
+            is_candidate = false;
+
+        if (is_candidate)
+        {
+            if (!trace_packet.deserialize(trace_reader.get_packet_ptr(), trace_reader.get_packet_size(), false))
+            {
+                console::error("%s: Failed parsing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR);
+                range.m_failed = true;
+                break;
+            }
+
+            find_in_packet(criteria, range, print_immediately, trace_packet, total_swaps);
+        }
+
+        if (vogl_is_swap_buffers_entrypoint(entrypoint_id))
+            total_swaps++;
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-// print_match
+// struct find_context
 //----------------------------------------------------------------------------------------------------------------------
-static void print_match(const vogl_trace_packet &trace_packet, int param_index, int array_element_index, uint64_t total_swaps)
+struct find_context
 {
-    json_document doc;
-    vogl_trace_packet::json_serialize_params params;
-    trace_packet.json_serialize(*doc.get_root(), params);
+    dynamic_string m_filename;
+    const find_criteria *m_pCriteria;
+    // Only set when searching the calls listed by the call index.
+    const uint32_vec *m_pIndexed_calls;
+    vogl::vector<find_range> m_ranges;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// find_range_task
+// Searches one range with its own reader.
+//----------------------------------------------------------------------------------------------------------------------
+static void find_range_task(uint64_t data, void *pData_ptr)
+{
+    VOGL_FUNC_TRACER
 
-    dynamic_string packet_as_json;
-    doc.serialize(packet_as_json);
+    find_context &context = *static_cast<find_context *>(pData_ptr);
+    find_range &range = context.m_ranges[static_cast<uint32_t>(data)];
 
-    if (param_index == -2)
-        vogl_printf("----- Function match, frame %" PRIu64 ":\n", total_swaps);
-    else if (param_index < 0)
-        vogl_printf("----- Return value match, frame %" PRIu64 ":\n", total_swaps);
-    else if (array_element_index >= 0)
-        vogl_printf("----- Parameter %i element %i match, frame %" PRIu64 ":\n", param_index, array_element_index, total_swaps);
-    else
-        vogl_printf("----- Parameter %i match, frame %" PRIu64 ":\n", param_index, total_swaps);
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(open_trace_at_frame(context.m_filename, range.m_frames.m_first_frame));
+    if (!pTrace_reader.get())
+    {
+        range.m_failed = true;
+        return;
+    }
 
-    vogl_printf("%s\n", packet_as_json.get_ptr());
+    find_in_trace(*pTrace_reader, *context.m_pCriteria, context.m_pIndexed_calls, range, false);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -2964,10 +4859,12 @@ static bool tool_find_mode()
     }
 
     dynamic_string actual_input_filename;
-    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr()));
+    vogl_unique_ptr<vogl_trace_file_reader> pTrace_reader(vogl_open_trace_file(input_base_filename, actual_input_filename, g_command_line_params().get_value_as_string_or_empty("loose_file_path").get_ptr(), g_command_line_params().get_value_as_bool("mmap")));
     if (!pTrace_reader.get())
         return false;
 
+    find_criteria criteria;
+
     bigint128 value_to_find(static_cast<uint64_t>(gl_enums::cUnknownEnum));
     bool has_find_param = g_command_line_params().has_key("find_param");
     if (has_find_param)
@@ -2997,164 +4894,214 @@ static bool tool_find_mode()
         }
     }
 
+    criteria.m_value_to_find = value_to_find;
+    criteria.m_has_find_param = has_find_param;
+
     dynamic_string find_namespace_str(g_command_line_params().get_value_as_string_or_empty("find_namespace"));
-    vogl_namespace_t find_namespace = VOGL_NAMESPACE_UNKNOWN;
+    criteria.m_find_namespace = VOGL_NAMESPACE_UNKNOWN;
     if (find_namespace_str.has_content())
     {
-        find_namespace = vogl_find_namespace_from_gl_type(find_namespace_str.get_ptr());
-        if ((find_namespace == VOGL_NAMESPACE_INVALID) && (find_namespace_str != "invalid"))
+        criteria.m_find_namespace = vogl_find_namespace_from_gl_type(find_namespace_str.get_ptr());
+        if ((criteria.m_find_namespace == VOGL_NAMESPACE_INVALID) && (find_namespace_str != "invalid"))
         {
             vogl_error_printf("Invalid namespace: \"%s\"\n", find_namespace_str.get_ptr());
             return false;
         }
     }
 
-    dynamic_string find_param_name(g_command_line_params().get_value_as_string_or_empty("find_param_name"));
+    criteria.m_find_param_name = g_command_line_params().get_value_as_string_or_empty("find_param_name");
 
     dynamic_string find_func_pattern(g_command_line_params().get_value_as_string_or_empty("find_func"));
-    regexp func_regex;
     if (find_func_pattern.has_content())
     {
+        regexp func_regex;
         if (!func_regex.init(find_func_pattern.get_ptr(), REGEX_IGNORE_CASE))
         {
             vogl_error_printf("Invalid func regex: \"%s\"\n", find_func_pattern.get_ptr());
             return false;
         }
-    }
 
-    int64_t find_frame_low = g_command_line_params().get_value_as_int64("find_frame_low", 0, -1);
-    int64_t find_frame_high = g_command_line_params().get_value_as_int64("find_frame_high", 0, -1);
-    int64_t find_call_low = g_command_line_params().get_value_as_int64("find_call_low", 0, -1);
-    int64_t find_call_high = g_command_line_params().get_value_as_int64("find_call_high", 0, -1);
-
-    vogl_printf("Scanning trace file %s\n", actual_input_filename.get_ptr());
+        criteria.m_func_filter.resize(VOGL_NUM_ENTRYPOINTS);
+        for (uint32_t id = 0; id < VOGL_NUM_ENTRYPOINTS; id++)
+            criteria.m_func_filter[id] = func_regex.full_match(g_vogl_entrypoint_descs[id].m_pName);
+    }
 
-    vogl_ctypes trace_gl_ctypes(pTrace_reader->get_sof_packet().m_pointer_sizes);
-    vogl_trace_packet trace_packet(&trace_gl_ctypes);
+    criteria.m_find_frame_low = g_command_line_params().get_value_as_int64("find_frame_low", 0, -1);
+    criteria.m_find_frame_high = g_command_line_params().get_value_as_int64("find_frame_high", 0, -1);
+    criteria.m_find_call_low = g_command_line_params().get_value_as_int64("find_call_low", 0, -1);
+    criteria.m_find_call_high = g_command_line_params().get_value_as_int64("find_call_high", 0, -1);
 
-    uint64_t total_matches = 0;
-    uint64_t total_swaps = 0;
+    criteria.m_pJSON_lines_file = NULL;
 
-    for (;;)
+    cfile_stream json_lines_stream;
+    dynamic_string json_lines_filename(g_command_line_params().get_value_as_string_or_empty("find_json_lines"));
+    if (json_lines_filename == "-")
     {
-        vogl_trace_file_reader::trace_file_reader_status_t read_status = pTrace_reader->read_next_packet();
-
-        if ((read_status != vogl_trace_file_reader::cOK) && (read_status != vogl_trace_file_reader::cEOF))
+        criteria.m_pJSON_lines_file = stdout;
+    }
+    else if (json_lines_filename.has_content())
+    {
+        if (!json_lines_stream.open(json_lines_filename.get_ptr(), cDataStreamWritable, false))
         {
-            vogl_error_printf("Failed reading from trace file!\n");
-            goto done;
+            vogl_error_printf("Failed opening JSON lines output file \"%s\"\n", json_lines_filename.get_ptr());
+            return false;
         }
 
-        if (read_status == vogl_trace_file_reader::cEOF)
-            break;
+        criteria.m_pJSON_lines_file = json_lines_stream.get_file();
+    }
 
-        const vogl::vector<uint8_t> &packet_buf = pTrace_reader->get_packet_buf();
-        VOGL_NOTE_UNUSED(packet_buf);
+    // With "--find_json_lines -" stdout must only contain the matches, so status lines go to stderr instead.
+    FILE *pStatus_file = (criteria.m_pJSON_lines_file == stdout) ? stderr : NULL;
 
-        const vogl_trace_stream_packet_base &base_packet = pTrace_reader->get_base_packet();
-        VOGL_NOTE_UNUSED(base_packet);
+    if (pStatus_file)
+        fprintf(pStatus_file, "Scanning trace file %s\n", actual_input_filename.get_ptr());
+    else
+        vogl_printf("Scanning trace file %s\n", actual_input_filename.get_ptr());
 
-        const vogl_trace_gl_entrypoint_packet *pGL_packet = NULL;
-        VOGL_NOTE_UNUSED(pGL_packet);
+    uint32_t num_threads = get_scan_thread_count();
 
-        if (pTrace_reader->get_packet_type() == cTSPTEOF)
-            break;
-        else if (pTrace_reader->get_packet_type() != cTSPTGLEntrypoint)
-            continue;
+    find_context context;
+    context.m_filename = actual_input_filename;
+    context.m_pCriteria = &criteria;
+    context.m_pIndexed_calls = NULL;
 
-        if (!trace_packet.deserialize(pTrace_reader->get_packet_buf().get_ptr(), pTrace_reader->get_packet_buf().size(), false))
-        {
-            console::error("%s: Failed parsing GL entrypoint packet\n", VOGL_FUNCTION_INFO_CSTR);
-            goto done;
-        }
+    uint32_t first_frame = (criteria.m_find_frame_low > 0) ? static_cast<uint32_t>(math::minimum<int64_t>(criteria.m_find_frame_low, cUINT32_MAX)) : 0;
+    uint32_t end_frame = (criteria.m_find_frame_high >= 0) ? static_cast<uint32_t>(math::minimum<int64_t>(criteria.m_find_frame_high + 1, cUINT32_MAX)) : cUINT32_MAX;
 
-        pGL_packet = &pTrace_reader->get_packet<vogl_trace_gl_entrypoint_packet>();
+    // With a call index, skip straight to the first call in range, and if only some functions are wanted only read
+    // the calls to those functions.
+    uint32_vec indexed_calls;
+    uint32_t first_call_index = 0;
+    bool nothing_to_find = false;
 
-        if (find_frame_low >= 0)
-        {
-            if (total_swaps < static_cast<uint64_t>(find_frame_low))
-                goto skip;
-        }
-        if (find_frame_high >= 0)
-        {
-            if (total_swaps > static_cast<uint64_t>(find_frame_high))
-                break;
-        }
+    if (pTrace_reader->get_call_index())
+    {
+        const vogl_trace_call_index &call_index = *pTrace_reader->get_call_index();
 
-        if (find_call_low >= 0)
+        if ((criteria.m_find_call_low >= 0) && (!call_index.find_first_call_at_or_after(static_cast<uint64_t>(criteria.m_find_call_low), first_call_index)))
+            first_call_index = call_index.get_total_calls();
+        if (first_frame)
         {
-            if (trace_packet.get_call_counter() < static_cast<uint64_t>(find_call_low))
-                goto skip;
+            uint32_t frame_first_call = (first_frame < call_index.get_total_frames()) ? call_index.get_frame_first_call(first_frame) : call_index.get_total_calls();
+            first_call_index = math::maximum(first_call_index, frame_first_call);
         }
-        if (find_call_high >= 0)
+
+        if (first_call_index >= call_index.get_total_calls())
+            nothing_to_find = true;
+        else
+            first_frame = call_index.get_call_frame(first_call_index);
+
+        uint32_t end_call_index;
+        if ((criteria.m_find_call_high >= 0) && (criteria.m_find_call_high < cINT64_MAX) && (call_index.find_first_call_at_or_after(static_cast<uint64_t>(criteria.m_find_call_high + 1), end_call_index)))
+            end_frame = math::minimum(end_frame, call_index.get_call_frame(end_call_index) + 1);
+
+        if ((!nothing_to_find) && (criteria.m_func_filter.size()))
         {
-            if (trace_packet.get_call_counter() > static_cast<uint64_t>(find_call_high))
-                break;
+            for (uint32_t id = 0; id < VOGL_NUM_ENTRYPOINTS; id++)
+            {
+                if (!criteria.m_func_filter[id])
+                    continue;
+
+                const uint32_vec &calls = call_index.get_entrypoint_calls(static_cast<gl_entrypoint_id_t>(id));
+                for (uint32_t i = 0; i < calls.size(); i++)
+                    if (calls[i] >= first_call_index)
+                        indexed_calls.push_back(calls[i]);
+            }
+
+            indexed_calls.sort();
+            context.m_pIndexed_calls = &indexed_calls;
         }
+    }
 
-        if (func_regex.is_initialized())
+    uint64_t total_matches = 0;
+
+    if ((!nothing_to_find) && (context.m_pIndexed_calls))
+    {
+        // Split the call list into one contiguous slice per thread, each thread needs its own binary reader.
+        const uint32_t cMinIndexedCallsPerThread = 4096;
+
+        uint32_t num_ranges = 1;
+        if (pTrace_reader->get_type() == cBINARY_TRACE_FILE_READER)
+            num_ranges = math::clamp<uint32_t>(indexed_calls.size() / cMinIndexedCallsPerThread, 1, num_threads);
+
+        context.m_ranges.resize(num_ranges);
+        for (uint32_t i = 0; i < num_ranges; i++)
         {
-            if (!func_regex.full_match(trace_packet.get_entrypoint_desc().m_pName))
-                goto skip;
+            context.m_ranges[i].m_first_indexed_call = static_cast<uint32_t>((static_cast<uint64_t>(indexed_calls.size()) * i) / num_ranges);
+            context.m_ranges[i].m_end_indexed_call = static_cast<uint32_t>((static_cast<uint64_t>(indexed_calls.size()) * (i + 1)) / num_ranges);
         }
-
-        if (!has_find_param)
+    }
+    else if (!nothing_to_find)
+    {
+        trace_frame_range_vec frame_ranges;
+        if (split_trace_into_frame_ranges(*pTrace_reader, first_frame, end_frame, num_threads, frame_ranges))
         {
-            print_match(trace_packet, -2, -1, total_swaps);
-            total_matches++;
+            context.m_ranges.resize(frame_ranges.size());
+            for (uint32_t i = 0; i < frame_ranges.size(); i++)
+                context.m_ranges[i].m_frames = frame_ranges[i];
         }
         else
         {
-            if (trace_packet.has_return_value())
+            context.m_ranges.resize(1);
+
+            if (first_call_index)
             {
-                if ((find_param_name.is_empty()) || (find_param_name == "return"))
+                if (!pTrace_reader->seek_to_call_index(first_call_index))
                 {
-                    if (param_value_matches(value_to_find, find_namespace, trace_packet.get_return_value_data(), trace_packet.get_return_value_ctype(), trace_packet.get_return_value_namespace()))
-                    {
-                        print_match(trace_packet, -1, -1, total_swaps);
-                        total_matches++;
-                    }
+                    vogl_error_printf("Failed seeking to call %u!\n", first_call_index);
+                    context.m_ranges.clear();
                 }
             }
-
-            for (uint32_t i = 0; i < trace_packet.total_params(); i++)
+            else if ((first_frame) && (pTrace_reader->can_quickly_seek_forward()))
             {
-                if ((find_param_name.has_content()) && (find_param_name != trace_packet.get_param_desc(i).m_pName))
-                    continue;
-
-                const vogl_ctype_desc_t &param_ctype_desc = trace_packet.get_param_ctype_desc(i);
-
-                if (param_ctype_desc.m_is_pointer)
-                {
-                    if ((!param_ctype_desc.m_is_opaque_pointer) && (param_ctype_desc.m_pointee_ctype != VOGL_VOID) && (trace_packet.has_param_client_memory(i)))
-                    {
-                        const vogl_client_memory_array array(trace_packet.get_param_client_memory_array(i));
-
-                        for (uint32_t j = 0; j < array.size(); j++)
-                        {
-                            if (param_value_matches(value_to_find, find_namespace, array.get_element<uint64_t>(j), array.get_element_ctype(), trace_packet.get_param_namespace(i)))
-                            {
-                                print_match(trace_packet, i, j, total_swaps);
-                                total_matches++;
-                            }
-                        }
-                    }
-                }
-                else if (param_value_matches(value_to_find, find_namespace, trace_packet.get_param_data(i), trace_packet.get_param_ctype(i), trace_packet.get_param_namespace(i)))
+                if (!pTrace_reader->seek_to_frame(first_frame))
                 {
-                    print_match(trace_packet, i, -1, total_swaps);
-                    total_matches++;
+                    vogl_error_printf("Failed seeking to frame %u!\n", first_frame);
+                    context.m_ranges.clear();
                 }
             }
         }
+    }
 
-    skip:
-        if (vogl_is_swap_buffers_entrypoint(trace_packet.get_entrypoint_id()))
-            total_swaps++;
+    if (context.m_ranges.size() == 1)
+    {
+        // Nothing to split, search with the reader that's already open and print matches as they're found.
+        find_in_trace(*pTrace_reader, criteria, context.m_pIndexed_calls, context.m_ranges[0], true);
+
+        total_matches = context.m_ranges[0].m_total_matches;
+    }
+    else if (context.m_ranges.size() > 1)
+    {
+        task_pool tp;
+        tp.init(num_threads - 1);
+
+        for (uint32_t i = 0; i < context.m_ranges.size(); i++)
+        {
+            if (!tp.queue_task(find_range_task, i, &context))
+                find_range_task(i, &context);
+        }
+
+        tp.join();
+        tp.deinit();
+
+        for (uint32_t i = 0; i < context.m_ranges.size(); i++)
+        {
+            const find_range &range = context.m_ranges[i];
+
+            for (uint32_t j = 0; j < range.m_matches.size(); j++)
+                print_find_match(criteria, range.m_matches[j]);
+
+            total_matches += range.m_total_matches;
+        }
     }
 
-done:
-    vogl_printf("Total matches found: %" PRIu64 "\n", total_matches);
+    if (criteria.m_pJSON_lines_file)
+        fflush(criteria.m_pJSON_lines_file);
+
+    if (pStatus_file)
+        fprintf(pStatus_file, "Total matches found: %" PRIu64 "\n", total_matches);
+    else
+        vogl_printf("Total matches found: %" PRIu64 "\n", total_matches);
 
     return true;
 }
@@ -3467,6 +5414,13 @@ int main(int argc, char *argv[])
 
         success = tool_parse_mode();
     }
+    else if (g_command_line_params().get_value_as_bool("splice"))
+    {
+        tmZone(TELEMETRY_LEVEL0, TMZF_NONE, "splice");
+        vogl_message_printf("Splice binary trace mode\n");
+
+        success = tool_splice_mode();
+    }
     else if (g_command_line_params().get_value_as_bool("info"))
     {
         tmZone(TELEMETRY_LEVEL0, TMZF_NONE, "info");
@@ -3494,6 +5448,30 @@ int main(int argc, char *argv[])
 
         success = tool_find_mode();
     }
+    else if (g_command_line_params().get_value_as_bool("index"))
+    {
+        vogl_message_printf("Index mode\n");
+
+        success = tool_index_mode();
+    }
+    else if (g_command_line_params().get_value_as_bool("export_columns"))
+    {
+        vogl_message_printf("Export columns mode\n");
+
+        success = tool_export_columns_mode();
+    }
+    else if (g_command_line_params().get_value_as_bool("scan_bench"))
+    {
+        vogl_message_printf("Scan benchmark mode\n");
+
+        success = tool_scan_bench_mode();
+    }
+    else if (g_command_line_params().get_value_as_bool("packet_array_bench"))
+    {
+        vogl_message_printf("Packet array benchmark mode\n");
+
+        success = tool_packet_array_bench_mode();
+    }
     else if (g_command_line_params().get_value_as_bool("compare_hash_files"))
     {
        vogl_message_printf("Comparing hash/sum files\n");
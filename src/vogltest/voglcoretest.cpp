@@ -36,6 +36,19 @@
 #include "vogl_map.h"
 #include "vogl_md5.h"
 #include "vogl_rh_hash_map.h"
+#include "vogl_spsc_ring_buffer.h"
+#include "vogl_dirty_range.h"
+#include "vogl_bidi_hash_map.h"
+#include "vogl_hybrid_hash_map.h"
+#include "vogl_checksum.h"
+#include "vogl_json.h"
+
+#include "vogl_common.h"
+#include "vogl_trace_block_stream.h"
+#include "vogl_trace_file_writer.h"
+#include "vogl_backtrace_intern_table.h"
+#include "vogl_trace_packet_prefetcher.h"
+#include "vogl_gl_state_snapshot_cache.h"
 
 //$ TODO?
 //#include "vogl_timer.h"
@@ -69,12 +82,42 @@ static const struct test_data_t g_tests[] =
     DEFTEST(map),
     DEFTEST(hash_map),
     DEFTEST(sort),
+    DEFTEST(spsc_ring_buffer),
+    DEFTEST(dirty_range),
+    DEFTEST(mem_thread_cache),
+    DEFTEST(crc),
+    DEFTEST(json_stream_reader),
+    DEFTEST(bidi_hash_map),
+    DEFTEST(hybrid_hash_map),
+    DEFTEST(trace_block_stream),
+    DEFTEST(trace_file_version_compat),
+    DEFTEST(client_memory_dedup),
+    DEFTEST(backtrace_intern_table),
+    DEFTEST(trace_packet_prefetcher),
+    DEFTEST(gl_state_snapshot_cache),
     DEFTEST2(sparse_vector),
     DEFTEST2(bigint128),
 #undef DEFTEST
 #undef DEFTEST2
 };
 
+// Benchmarks only print timings, and are too slow to run with the tests. They're only run with --bench.
+struct bench_data_t
+{
+    const char *name;
+    bool (*pfunc)(void);
+};
+static const struct bench_data_t g_benchmarks[] =
+{
+#define DEFBENCH(_x) { #_x, _x ## _bench }
+    DEFBENCH(dirty_range),
+    DEFBENCH(mem_perf),
+    DEFBENCH(crc),
+    DEFBENCH(bidi_hash_map),
+    DEFBENCH(hybrid_hash_map),
+#undef DEFBENCH
+};
+
 //----------------------------------------------------------------------------------------------------------------------
 // command line params
 //----------------------------------------------------------------------------------------------------------------------
@@ -82,6 +125,7 @@ static command_line_param_desc g_command_line_param_descs[] =
 {
     { "test", 0, false, "Run named list of tests." },
     { "all", 0, false, "Run all tests." },
+    { "bench", 0, false, "Run the named (or with --all, all) benchmarks instead of the tests." },
 
     { "help", 0, false, "Display this help" },
     { "?", 0, false, "Display this help" },
@@ -92,7 +136,7 @@ static command_line_param_desc g_command_line_param_descs[] =
 //----------------------------------------------------------------------------------------------------------------------
 static void tool_print_help()
 {
-    console::printf("Usage: vogltest [ --all ] [--test testname1 testname2 ...]\n");
+    console::printf("Usage: vogltest [--bench] [ --all ] [--test testname1 testname2 ...]\n");
     console::printf("\nCommand line options:\n");
 
     dump_command_line_info(VOGL_ARRAY_SIZE(g_command_line_param_descs), g_command_line_param_descs, "--");
@@ -103,6 +147,13 @@ static void tool_print_help()
     {
         printf("  % 2d: %s\n", (int)i, g_tests[i].name);
     }
+
+    printf("\nVoglcore benchmarks (--bench):\n");
+
+    for (size_t i = 0; i < VOGL_ARRAY_SIZE(g_benchmarks); i++)
+    {
+        printf("  % 2d: %s\n", (int)i, g_benchmarks[i].name);
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -140,9 +191,14 @@ int run_voglcore_tests(int argc, char *argv[])
     if (!init_command_line_params(argc, argv))
         return EXIT_FAILURE;
 
+    // Some of the tests exercise voglcommon.
+    vogl_common_lib_early_init();
+    vogl_common_lib_global_init();
+
     int num_failures = 0;
     bool arg_test = g_command_line_params().has_key("test");
     bool arg_all = g_command_line_params().has_key("all");
+    bool arg_bench = g_command_line_params().has_key("bench");
 
     if (!arg_test && !arg_all)
     {
@@ -150,7 +206,25 @@ int run_voglcore_tests(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    for (size_t i = 0; i < VOGL_ARRAY_SIZE(g_tests); i++)
+    for (size_t i = 0; (i < VOGL_ARRAY_SIZE(g_benchmarks)) && (arg_bench); i++)
+    {
+        if (arg_all || check_for_command_line_param(g_benchmarks[i].name))
+        {
+            printf("\n%zu: %s (bench)...\n", i, g_benchmarks[i].name);
+
+            timer tm;
+            tm.start();
+            bool ret = g_benchmarks[i].pfunc();
+            double time = tm.get_elapsed_secs();
+
+            printf("%zu: %s (bench): %s (%.3f secs)\n", i, g_benchmarks[i].name,
+                   ret ? "Success" : "Failed", time);
+
+            num_failures += !ret;
+        }
+    }
+
+    for (size_t i = 0; (i < VOGL_ARRAY_SIZE(g_tests)) && (!arg_bench); i++)
     {
         // If --all was passed or the name of this test, then run it.
         bool run_test = arg_all || check_for_command_line_param(g_tests[i].name);
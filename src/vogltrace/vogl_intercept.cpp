@@ -30,6 +30,9 @@
 #include "vogl_texture_format.h"
 #include "vogl_gl_state_snapshot.h"
 #include "vogl_trace_file_writer.h"
+#include "vogl_async_trace_writer.h"
+#include "vogl_backtrace_intern_table.h"
+#include "vogl_entrypoint_stats.h"
 #include "vogl_framebuffer_capturer.h"
 #include "vogl_trace_file_reader.h"
 
@@ -42,6 +45,7 @@
 #include "vogl_value.h"
 #include "vogl_file_utils.h"
 #include "vogl_uuid.h"
+#include "vogl_dirty_range.h"
 #include "vogl_unique_ptr.h"
 #include "vogl_port.h"
 
@@ -108,6 +112,8 @@ static GLuint g_dummy_program;
 static void vogl_glInternalTraceCommandRAD(GLuint cmd, GLuint size, const GLubyte *data);
 static void vogl_end_capture(bool inside_signal_handler = false);
 static void vogl_atexit();
+static void vogl_init_screen_capture();
+static void vogl_deinit_screen_capture();
 // TODO: Move this declaration into a header that we share with the location the code actually exists.
 vogl_void_func_ptr_t vogl_get_proc_address_helper_return_actual(const char *pName);
 
@@ -167,6 +173,8 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "vogl_hash_backbuffer", 0, false, NULL },
         { "vogl_dump_backbuffer_hashes", 1, false, NULL },
         { "vogl_sum_hashing", 0, false, NULL },
+        { "vogl_screenshot_threads", 1, false, NULL },
+        { "vogl_screenshot_queue_size", 1, false, NULL },
         { "vogl_disable_atexit_context_flushing", 0, false, NULL },
         { "vogl_null_mode", 0, false, NULL },
         { "vogl_force_debug_context", 0, false, NULL },
@@ -175,8 +183,15 @@ static command_line_param_desc g_command_line_param_descs[] =
         { "vogl_func_tracing", 0, false, NULL },
         { "vogl_backtrace_all_calls", 0, false, NULL },
         { "vogl_backtrace_no_calls", 0, false, NULL },
+        { "vogl_backtrace_sample_rate", 1, false, NULL },
         { "vogl_exit_after_x_frames", 1, false, NULL },
         { "vogl_traceport", 1, false, NULL },
+        { "vogl_async_trace", 0, false, NULL },
+        { "vogl_async_ring_size", 1, false, NULL },
+        { "vogl_async_max_pending", 1, false, NULL },
+        { "vogl_compress_trace", 0, false, NULL },
+        { "vogl_dirty_map_tracking", 0, false, NULL },
+        { "vogl_dedup_client_memory", 1, false, NULL },
     };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -189,10 +204,13 @@ bool g_disable_gl_program_binary_flag;
 bool g_null_mode;
 bool g_backtrace_all_calls;
 bool g_backtrace_no_calls;
+static uint32_t g_backtrace_sample_rate;
 static bool g_disable_client_side_array_tracing;
 
 static bool g_flush_files_after_each_call;
 static bool g_flush_files_after_each_swap;
+static bool g_async_trace;
+static bool g_dirty_map_tracking;
 static bool g_gather_statistics;
 
 static uint32_t g_vogl_total_frames_to_capture;
@@ -220,10 +238,16 @@ static mutex &get_vogl_trace_mutex()
     return s_vogl_trace_mutex;
 }
 
-static mutex &get_backtrace_hashmap_mutex()
+static vogl_async_trace_writer &get_vogl_async_trace_writer()
 {
-    static mutex s_backtrace_hashmap_mutex(0, false);
-    return s_backtrace_hashmap_mutex;
+    static vogl_async_trace_writer s_vogl_async_trace_writer;
+    return s_vogl_async_trace_writer;
+}
+
+static vogl_entrypoint_stats &get_vogl_entrypoint_stats()
+{
+    static vogl_entrypoint_stats s_vogl_entrypoint_stats;
+    return s_vogl_entrypoint_stats;
 }
 
 struct vogl_intercept_data
@@ -231,7 +255,7 @@ struct vogl_intercept_data
     dynamic_string capture_path;
     dynamic_string capture_basename;
     #if VOGL_PLATFORM_SUPPORTS_BTRACE
-        vogl_backtrace_hashmap backtrace_hashmap;
+        vogl_backtrace_intern_table backtrace_table;
     #endif
 };
 static vogl_intercept_data &get_vogl_intercept_data()
@@ -416,6 +440,8 @@ class vogl_thread_local_data
 public:
     vogl_thread_local_data()
         : m_pContext(NULL),
+          m_pAsync_producer(NULL),
+          m_pEntrypoint_stats(NULL),
           m_calling_driver_entrypoint_id(VOGL_ENTRYPOINT_INVALID)
     {
     }
@@ -423,11 +449,41 @@ public:
     ~vogl_thread_local_data()
     {
         m_pContext = NULL;
+
+        if (m_pAsync_producer)
+        {
+            // Packets already queued by this thread are still written, the producer is freed once they've been drained.
+            get_vogl_async_trace_writer().release_producer(m_pAsync_producer);
+            m_pAsync_producer = NULL;
+        }
+
+        if (m_pEntrypoint_stats)
+        {
+            get_vogl_entrypoint_stats().release_thread_counters(m_pEntrypoint_stats);
+            m_pEntrypoint_stats = NULL;
+        }
+
+        #if VOGL_PLATFORM_SUPPORTS_BTRACE
+            get_vogl_intercept_data().backtrace_table.release_thread_cache(m_backtrace_cache);
+        #endif
     }
 
     vogl_context *m_pContext;
     vogl_entrypoint_serializer m_serializer;
 
+    // Only used in async trace mode (--vogl_async_trace), created on this thread's first traced call.
+    vogl_async_trace_writer::producer *m_pAsync_producer;
+
+    // Only used with --vogl_dump_stats, created on this thread's first traced call.
+    vogl_entrypoint_stats::thread_counters *m_pEntrypoint_stats;
+
+    #if VOGL_PLATFORM_SUPPORTS_BTRACE
+        vogl_backtrace_intern_table::thread_cache m_backtrace_cache;
+
+        // Per-entrypoint call counts, only used if --vogl_backtrace_sample_rate is greater than 1.
+        vogl::vector<uint32_t> m_backtrace_sample_counters;
+    #endif
+
     // Set to a valid entrypoint ID if we're currently trying to call the driver on this thread. The "direct" GL function wrappers (in
     // vogl_entrypoints.cpp) call our vogl_direct_gl_func_prolog/epilog func callbacks below, which manipulate this member.
     gl_entrypoint_id_t m_calling_driver_entrypoint_id;
@@ -457,6 +513,19 @@ static VOGL_FORCE_INLINE vogl_thread_local_data *vogl_get_or_create_thread_local
     return pTLS_data;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_get_async_trace_producer
+// Returns NULL if the producer couldn't be created, in which case the caller should fall back to synchronous writes.
+//----------------------------------------------------------------------------------------------------------------------
+static inline vogl_async_trace_writer::producer *vogl_get_async_trace_producer()
+{
+    vogl_thread_local_data *pTLS_data = vogl_get_or_create_thread_local_data();
+    if (!pTLS_data->m_pAsync_producer)
+        pTLS_data->m_pAsync_producer = get_vogl_async_trace_writer().create_producer();
+
+    return pTLS_data->m_pAsync_producer;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // tls_thread_local_data_destructor
 //----------------------------------------------------------------------------------------------------------------------
@@ -723,6 +792,7 @@ static void vogl_deinit_callback()
     VOGL_FUNC_TRACER // I'm not sure this is a good idea here.
 
     vogl_end_capture();
+    vogl_deinit_screen_capture();
     vogl_dump_statistics();
 }
 
@@ -833,11 +903,14 @@ static void vogl_init_command_line_params()
     g_disable_gl_program_binary_flag = g_command_line_params().get_value_as_bool("vogl_disable_gl_program_binary");
     g_flush_files_after_each_call = g_command_line_params().get_value_as_bool("vogl_flush_files_after_each_call");
     g_flush_files_after_each_swap = g_command_line_params().get_value_as_bool("vogl_flush_files_after_each_swap");
+    g_async_trace = g_command_line_params().get_value_as_bool("vogl_async_trace");
+    g_dirty_map_tracking = g_command_line_params().get_value_as_bool("vogl_dirty_map_tracking");
 
     g_gather_statistics = g_command_line_params().get_value_as_bool("vogl_dump_stats");
     g_null_mode = g_command_line_params().get_value_as_bool("vogl_null_mode");
     g_backtrace_all_calls = g_command_line_params().get_value_as_bool("vogl_backtrace_all_calls");
     g_backtrace_no_calls = g_command_line_params().get_value_as_bool("vogl_backtrace_no_calls");
+    g_backtrace_sample_rate = g_command_line_params().get_value_as_uint("vogl_backtrace_sample_rate", 0, 1, 1);
     g_disable_client_side_array_tracing = g_command_line_params().get_value_as_bool("vogl_disable_client_side_array_tracing");
 
     if (g_command_line_params().get_value_as_bool("vogl_dump_gl_full"))
@@ -907,6 +980,42 @@ static void vogl_global_init()
 
     vogl_common_lib_global_init();
 
+    if (g_async_trace)
+    {
+        uint32_t ring_size = g_command_line_params().get_value_as_uint("vogl_async_ring_size", 0, vogl_async_trace_writer::cDefaultRingSize / 1024, 1, 1024 * 1024) * 1024;
+        uint64_t max_pending_bytes = g_command_line_params().get_value_as_uint64("vogl_async_max_pending", 0, vogl_async_trace_writer::cDefaultMaxPendingBytes / (1024 * 1024), 1) * 1024 * 1024;
+
+        // Make sure the trace writer and mutex are constructed first, so they're destroyed after the async writer.
+        vogl_trace_file_writer &trace_writer = get_vogl_trace_writer();
+        mutex &trace_mutex = get_vogl_trace_mutex();
+
+        if (!get_vogl_async_trace_writer().init(&trace_writer, &trace_mutex, ring_size, max_pending_bytes))
+        {
+            vogl_error_printf("%s: Failed initializing async trace writer, falling back to synchronous trace writes\n", VOGL_FUNCTION_INFO_CSTR);
+            g_async_trace = false;
+        }
+        else
+        {
+            console::message("Async trace writes enabled, %u KB packet ring per thread\n", ring_size / 1024);
+        }
+    }
+
+    if (g_command_line_params().get_value_as_bool("vogl_compress_trace"))
+    {
+        get_vogl_trace_writer().set_block_codec(cTraceBlockCodecDeflate);
+        console::message("Trace packet stream compression enabled\n");
+    }
+
+    if (g_command_line_params().has_key("vogl_dedup_client_memory"))
+    {
+        // Threshold is in KB
+        uint32_t min_size = g_command_line_params().get_value_as_uint("vogl_dedup_client_memory", 0, 64, 1, 1024 * 1024) * 1024;
+        get_vogl_trace_writer().set_client_memory_dedup_threshold(min_size);
+        console::message("Deduplicating client memory payloads of %u KB or more\n", min_size / 1024);
+    }
+
+    vogl_init_screen_capture();
+
     if (g_command_line_params().has_key("vogl_tracefile"))
     {
         if (!get_vogl_trace_writer().open(g_command_line_params().get_value_as_string_or_empty("vogl_tracefile").get_ptr()))
@@ -917,6 +1026,9 @@ static void vogl_global_init()
 
             exit(EXIT_FAILURE);
         }
+
+        if (g_gather_statistics)
+            get_vogl_entrypoint_stats().reset();
     }
 
     if (!g_command_line_params().get_value_as_bool("vogl_disable_signal_interception"))
@@ -936,7 +1048,8 @@ static void vogl_global_init()
     vogl_check_for_threaded_driver_optimizations();
 
     #if VOGL_PLATFORM_SUPPORTS_BTRACE
-        get_vogl_intercept_data().backtrace_hashmap.reserve(VOGL_BACKTRACE_HASHMAP_CAPACITY);
+        if (!get_vogl_intercept_data().backtrace_table.init(VOGL_BACKTRACE_HASHMAP_CAPACITY))
+            vogl_error_printf("%s: Failed allocating backtrace table, backtraces will not be recorded\n", VOGL_FUNCTION_INFO_CSTR);
     #endif
 
     // atexit routines are called in the reverse order in which they were registered. We would like
@@ -1063,6 +1176,12 @@ struct gl_buffer_desc
     };
     vogl::vector<flushed_range> m_flushed_ranges;
 
+    // Copy of the mapped region taken at map time (only when m_map_shadowed is true), compared against the map at
+    // unmap time so only the modified ranges get written to the trace. Kept across maps to avoid reallocating.
+    uint8_vec m_map_shadow;
+    dirty_range_vec m_dirty_ranges;
+    bool m_map_shadowed;
+
     inline gl_buffer_desc()
     {
         clear();
@@ -1084,11 +1203,98 @@ struct gl_buffer_desc
         m_map_access = 0;
         m_map_range = false;
         m_flushed_ranges.clear();
+        m_map_shadow.clear();
+        m_dirty_ranges.clear();
+        m_map_shadowed = false;
     }
 };
 
 typedef vogl::hash_map<GLuint, gl_buffer_desc> gl_buffer_desc_map;
 
+//----------------------------------------------------------------------------------------------------------------------
+// Mapped buffer dirty range tracking (--vogl_dirty_map_tracking)
+//----------------------------------------------------------------------------------------------------------------------
+enum
+{
+    cDirtyMapTrackingMinMapSize = 64 * 1024,
+    cDirtyMapTrackingGranularity = 256,
+    cDirtyMapTrackingMaxRanges = 4096
+};
+
+static atomic64_t g_dirty_map_total_unmaps;
+static atomic64_t g_dirty_map_total_mapped_bytes;
+static atomic64_t g_dirty_map_total_recorded_bytes;
+static atomic64_t g_dirty_map_total_scan_ticks;
+
+static void vogl_dump_dirty_map_stats()
+{
+    uint64_t total_mapped_bytes = g_dirty_map_total_mapped_bytes;
+    uint64_t total_recorded_bytes = g_dirty_map_total_recorded_bytes;
+    double scan_secs = timer::ticks_to_secs(g_dirty_map_total_scan_ticks);
+
+    vogl_message_printf("Dirty map tracking: %" PRIu64 " unmaps, %s bytes mapped, %s bytes recorded (%.2f%%), %.3f secs scanning (%.1f MB/sec)\n",
+                        static_cast<uint64_t>(g_dirty_map_total_unmaps),
+                        uint64_to_string_with_commas(total_mapped_bytes).get_ptr(),
+                        uint64_to_string_with_commas(total_recorded_bytes).get_ptr(),
+                        total_mapped_bytes ? (total_recorded_bytes * 100.0 / total_mapped_bytes) : 0.0,
+                        scan_secs, scan_secs ? (total_mapped_bytes / (1024.0 * 1024.0)) / scan_secs : 0.0);
+}
+
+// Snapshots the mapped region if it's large enough for dirty range tracking to pay off.
+static inline void vogl_begin_dirty_map_tracking(gl_buffer_desc &buf_desc, bool track_dirty_ranges)
+{
+    buf_desc.m_map_shadowed = false;
+
+    if ((!track_dirty_ranges) || (buf_desc.m_map_size < cDirtyMapTrackingMinMapSize) || (buf_desc.m_map_size > cUINT32_MAX))
+        return;
+
+    if (!buf_desc.m_map_shadow.try_resize(static_cast<uint32_t>(buf_desc.m_map_size)))
+    {
+        vogl_warning_printf("%s: Failed allocating %" PRIi64 " byte shadow copy of buffer 0x%08X, recording the whole map\n", VOGL_FUNCTION_INFO_CSTR, buf_desc.m_map_size, buf_desc.m_handle);
+        buf_desc.m_map_shadow.clear();
+        return;
+    }
+
+    memcpy(buf_desc.m_map_shadow.get_ptr(), buf_desc.m_pMap, static_cast<size_t>(buf_desc.m_map_size));
+    buf_desc.m_map_shadowed = true;
+}
+
+// Writes the modified ranges of a shadowed map to the unmap packet. Returns false if the whole map should be
+// recorded instead (too many ranges, or most of the map changed anyway).
+static bool vogl_serialize_dirty_map_ranges(vogl_entrypoint_serializer &trace_serializer, gl_buffer_desc &buf_desc)
+{
+    VOGL_ASSERT(buf_desc.m_map_shadowed && (buf_desc.m_map_shadow.size() == buf_desc.m_map_size));
+
+    timer_ticks start_ticks = timer::get_ticks();
+
+    uint64_t total_dirty_bytes = 0;
+    bool use_dirty_ranges = find_dirty_ranges(buf_desc.m_dirty_ranges, total_dirty_bytes, buf_desc.m_map_shadow.get_ptr(), buf_desc.m_pMap,
+                                              buf_desc.m_map_size, cDirtyMapTrackingGranularity, cDirtyMapTrackingMaxRanges);
+    if (total_dirty_bytes > static_cast<uint64_t>(buf_desc.m_map_size / 2))
+        use_dirty_ranges = false;
+
+    atomic_exchange_add64(&g_dirty_map_total_scan_ticks, timer::get_ticks() - start_ticks);
+    atomic_exchange_add64(&g_dirty_map_total_unmaps, 1);
+    atomic_exchange_add64(&g_dirty_map_total_mapped_bytes, buf_desc.m_map_size);
+    atomic_exchange_add64(&g_dirty_map_total_recorded_bytes, use_dirty_ranges ? total_dirty_bytes : buf_desc.m_map_size);
+
+    if (!use_dirty_ranges)
+        return false;
+
+    const dirty_range_vec &ranges = buf_desc.m_dirty_ranges;
+
+    trace_serializer.add_key_value(string_hash("dirty_ranges"), ranges.size());
+    for (uint32_t i = 0; i < ranges.size(); i++)
+    {
+        int key_index = i * 4;
+        trace_serializer.add_key_value(key_index, ranges[i].m_ofs);
+        trace_serializer.add_key_value(key_index + 1, ranges[i].m_size);
+        trace_serializer.add_key_value_blob(key_index + 2, static_cast<const uint8_t *>(buf_desc.m_pMap) + ranges[i].m_ofs, static_cast<uint32_t>(ranges[i].m_size));
+    }
+
+    return true;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_scoped_gl_error_absorber
 //----------------------------------------------------------------------------------------------------------------------
@@ -3048,23 +3254,49 @@ static void vogl_atexit()
         vogl_backtrace_addrs addrs;
         addrs.m_num_addrs = btrace_get(addrs.m_addrs, addrs.cMaxAddrs, addrs_to_skip);
 
-        vogl_backtrace_hashmap::insert_result ins_res;
+        vogl_thread_local_data *pTLS_data = vogl_get_thread_local_data();
+
+        uint32_t index;
+        if (!get_vogl_intercept_data().backtrace_table.intern(index, addrs, pTLS_data ? &pTLS_data->m_backtrace_cache : NULL))
+        {
+            // Only complain once, this would otherwise happen on every call once the table is full.
+            static bool s_printed_warning;
+            if (!s_printed_warning)
+            {
+                s_printed_warning = true;
+                vogl_error_printf("%s: Backtrace table exhausted! Please increase VOGL_BACKTRACE_HASHMAP_CAPACITY. Some backtraces in this trace will not have symbols.\n", VOGL_FUNCTION_INFO_CSTR);
+            }
+        }
+
+        return index;
+    }
 
-        uint32_t index = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    // vogl_should_sample_backtrace
+    // Returns true on every Nth call to id on this thread (N=--vogl_backtrace_sample_rate).
+    //----------------------------------------------------------------------------------------------------------------------
+    static inline bool vogl_should_sample_backtrace(gl_entrypoint_id_t id)
+    {
+        if (g_backtrace_sample_rate <= 1)
+            return true;
 
-        get_backtrace_hashmap_mutex().lock();
+        vogl_thread_local_data *pTLS_data = vogl_get_thread_local_data();
+        if (!pTLS_data)
+            return true;
 
-        if (!get_vogl_intercept_data().backtrace_hashmap.insert_no_grow(ins_res, addrs))
-            vogl_error_printf("%s: Backtrace hashmap exhausted! Please increase VOGL_BACKTRACE_HASHMAP_CAPACITY. Some backtraces in this trace will not have symbols.\n", VOGL_FUNCTION_INFO_CSTR);
-        else
+        vogl::vector<uint32_t> &counters = pTLS_data->m_backtrace_sample_counters;
+        if (counters.is_empty())
+            counters.resize(VOGL_NUM_ENTRYPOINTS);
+
+        uint32_t &counter = counters[id];
+        if (counter)
         {
-            index = ins_res.first.get_index();
-            (ins_res.first)->second++;
+            counter--;
+            return false;
         }
 
-        get_backtrace_hashmap_mutex().unlock();
-
-        return index;
+        counter = g_backtrace_sample_rate - 1;
+        return true;
     }
 #endif
 //----------------------------------------------------------------------------------------------------------------------
@@ -3080,10 +3312,12 @@ static void vogl_atexit()
 
         json_document doc;
 
-        get_backtrace_hashmap_mutex().lock();
+        vogl_backtrace_intern_table &backtrace_table = get_vogl_intercept_data().backtrace_table;
+
+        // Other threads may still be holding hit counts in their caches.
+        backtrace_table.flush_all_thread_caches();
 
-        vogl_backtrace_hashmap &backtrace_hashmap = get_vogl_intercept_data().backtrace_hashmap;
-        uint32_t backtrace_hashmap_size = backtrace_hashmap.size();
+        uint32_t backtrace_hashmap_size = backtrace_table.get_size();
         if (backtrace_hashmap_size)
         {
             vogl_message_printf("%s: Writing backtrace %u addrs\n", VOGL_FUNCTION_INFO_CSTR, backtrace_hashmap_size);
@@ -3091,15 +3325,20 @@ static void vogl_atexit()
             json_node *pRoot = doc.get_root();
             pRoot->init_array();
 
-            for (vogl_backtrace_hashmap::const_iterator it = backtrace_hashmap.begin(); it != backtrace_hashmap.end(); ++it)
+            vogl_backtrace_addrs addrs;
+            uint64_t count;
+
+            for (uint32_t index = 0; index < backtrace_hashmap_size; index++)
             {
+                if (!backtrace_table.get_entry(index, addrs, count))
+                    continue;
+
                 json_node &node = pRoot->add_array();
 
-                node.add_key_value("index", it.get_index());
-                node.add_key_value("count", it->second);
+                node.add_key_value("index", index);
+                node.add_key_value("count", count);
 
                 json_node &addrs_arr = node.add_array("addrs");
-                const vogl_backtrace_addrs &addrs = it->first;
 
                 for (uint32_t i = 0; i < addrs.m_num_addrs; i++)
                 {
@@ -3108,8 +3347,7 @@ static void vogl_atexit()
             }
         }
 
-        backtrace_hashmap.reset();
-        get_backtrace_hashmap_mutex().unlock();
+        backtrace_table.reset();
 
         if (backtrace_hashmap_size)
         {
@@ -3196,6 +3434,31 @@ static bool vogl_flush_machineinfo_to_trace_file()
     return true;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_flush_entrypoint_stats_to_trace_file
+// Prints the tracer overhead table, and stores the full per-entrypoint stats in the trace archive.
+//----------------------------------------------------------------------------------------------------------------------
+static bool vogl_flush_entrypoint_stats_to_trace_file()
+{
+    scoped_mutex lock(get_vogl_trace_mutex());
+
+    get_vogl_entrypoint_stats().print_table(50);
+
+    if (!get_vogl_trace_writer().is_opened() || (get_vogl_trace_writer().get_trace_archive() == NULL))
+        return false;
+
+    json_document doc;
+    get_vogl_entrypoint_stats().get_json(*doc.get_root());
+
+    char_vec data;
+    doc.serialize(data, true, 0, false);
+
+    if (get_vogl_trace_writer().get_trace_archive()->add_buf_using_id(data.get_ptr(), data.size(), VOGL_TRACE_ARCHIVE_ENTRYPOINT_STATS_FILENAME).is_empty())
+        vogl_error_printf("%s: Failed adding serialized entrypoint stats to trace archive\n", VOGL_FUNCTION_INFO_CSTR);
+
+    return true;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // vogl_entrypoint_serializer::begin
 //----------------------------------------------------------------------------------------------------------------------
@@ -3214,7 +3477,10 @@ inline bool vogl_entrypoint_serializer::begin(gl_entrypoint_id_t id, vogl_contex
     uint64_t thread_id = vogl_get_current_kernel_thread_id();
     uint64_t context_id = pContext ? reinterpret_cast<uint64_t>(pContext->get_context_handle()) : 0;
 
-    m_packet.begin_construction(id, context_id, get_vogl_trace_writer().get_next_gl_call_counter(), thread_id, utils::RDTSC());
+    vogl_async_trace_writer::producer *pAsync_producer = g_async_trace ? vogl_get_async_trace_producer() : NULL;
+    uint64_t call_counter = pAsync_producer ? get_vogl_async_trace_writer().get_next_gl_call_counter(pAsync_producer) : get_vogl_trace_writer().get_next_gl_call_counter();
+
+    m_packet.begin_construction(id, context_id, call_counter, thread_id, utils::RDTSC());
 
     #if VOGL_PLATFORM_SUPPORTS_BTRACE
         if (!g_backtrace_no_calls)
@@ -3224,7 +3490,7 @@ inline bool vogl_entrypoint_serializer::begin(gl_entrypoint_id_t id, vogl_contex
                     vogl_is_swap_buffers_entrypoint(id) ||
                     vogl_is_clear_entrypoint(id) ||
                     vogl_is_draw_entrypoint(id);
-            if (do_backtrace && get_vogl_trace_writer().is_opened())
+            if (do_backtrace && get_vogl_trace_writer().is_opened() && vogl_should_sample_backtrace(id))
             {
                 // Take a backtrace and store its hashtable index into the packet.
                 m_packet.set_backtrace_hash_index(vogl_backtrace(1));
@@ -3968,12 +4234,33 @@ static inline bool vogl_should_serialize_call(gl_entrypoint_id_t func, vogl_cont
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-// vogl_write_packet_to_trace
+// vogl_write_packet_to_trace_file
 //----------------------------------------------------------------------------------------------------------------------
-static inline void vogl_write_packet_to_trace(vogl_trace_packet &packet)
+static inline void vogl_write_packet_to_trace_file(vogl_trace_packet &packet)
 {
-    if (!get_vogl_trace_writer().is_opened())
+    vogl_async_trace_writer::producer *pAsync_producer = g_async_trace ? vogl_get_async_trace_producer() : NULL;
+    if (pAsync_producer)
+    {
+        // Queue the packet on this thread's ring, the writer thread writes it to the trace file in call counter order.
+        uint32_t write_flags = 0;
+        if (vogl_is_swap_buffers_entrypoint(packet.get_entrypoint_id()))
+            write_flags |= vogl_async_trace_writer::cWriteFlagSwap;
+        if ((g_flush_files_after_each_call) ||
+            ((g_flush_files_after_each_swap) && (packet.get_entrypoint_id() == VOGL_ENTRYPOINT_glXSwapBuffers)))
+            write_flags |= vogl_async_trace_writer::cWriteFlagFlushAfter;
+
+        if (!get_vogl_async_trace_writer().write_packet(pAsync_producer, packet, write_flags))
+        {
+            vogl_error_printf("%s: Failed queuing packet to trace file! Exiting app.\n", VOGL_FUNCTION_INFO_CSTR);
+
+            exit(EXIT_FAILURE);
+        }
+
+        if ((write_flags & vogl_async_trace_writer::cWriteFlagFlushAfter) && (g_vogl_pLog_stream))
+            g_vogl_pLog_stream->flush();
+
         return;
+    }
 
     scoped_mutex lock(get_vogl_trace_mutex());
 
@@ -4004,6 +4291,48 @@ static inline void vogl_write_packet_to_trace(vogl_trace_packet &packet)
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_record_entrypoint_stats
+// Called after the packet has been written, so the post-call overhead includes serializing and queuing/writing it.
+//----------------------------------------------------------------------------------------------------------------------
+static void vogl_record_entrypoint_stats(const vogl_trace_packet &packet)
+{
+    vogl_thread_local_data *pTLS_data = vogl_get_or_create_thread_local_data();
+    if (!pTLS_data->m_pEntrypoint_stats)
+    {
+        pTLS_data->m_pEntrypoint_stats = get_vogl_entrypoint_stats().create_thread_counters();
+        if (!pTLS_data->m_pEntrypoint_stats)
+            return;
+    }
+
+    const vogl_trace_gl_entrypoint_packet &entrypoint_packet = packet.get_entrypoint_packet();
+
+    pTLS_data->m_pEntrypoint_stats->record(static_cast<gl_entrypoint_id_t>(entrypoint_packet.m_entrypoint_id),
+                                           entrypoint_packet.m_packet_begin_rdtsc, entrypoint_packet.m_gl_begin_rdtsc,
+                                           entrypoint_packet.m_gl_end_rdtsc, utils::RDTSC());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_write_packet_to_trace
+//----------------------------------------------------------------------------------------------------------------------
+static inline void vogl_write_packet_to_trace(vogl_trace_packet &packet)
+{
+    if (!get_vogl_trace_writer().is_opened())
+    {
+        // Not tracing (e.g. only compiling a display list), but begin() may have still reserved a call counter on
+        // this thread's producer - retire it so the writer thread doesn't wait on it.
+        vogl_async_trace_writer::producer *pAsync_producer = g_async_trace ? vogl_get_async_trace_producer() : NULL;
+        if (pAsync_producer)
+            get_vogl_async_trace_writer().cancel_gl_call_counter(pAsync_producer, packet.get_call_counter());
+        return;
+    }
+
+    vogl_write_packet_to_trace_file(packet);
+
+    if (g_gather_statistics)
+        vogl_record_entrypoint_stats(packet);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Declare gl/glx internal wrapper functions, all start with "vogl_" (so we can safely get the address of our internal
 // wrappers, avoiding global symbol naming conflicts that I started to see on test apps when I started building with -fPIC)
@@ -4827,93 +5156,414 @@ static void vogl_glTexStorage2D(	GLenum target,
 #endif
 
 //----------------------------------------------------------------------------------------------------------------------
-static bool vogl_screen_capture_callback(uint32_t width, uint32_t height, uint32_t pitch, size_t size, GLenum pixel_format, GLenum pixel_type, const void *pImage, void *pOpaque, uint64_t frame_index)
+// vogl_screen_capture_settings
+// Screenshot/backbuffer hash options, resolved once from the command line in vogl_global_init().
+//----------------------------------------------------------------------------------------------------------------------
+struct vogl_screen_capture_settings
 {
-    vogl_context *pContext = static_cast<vogl_context *>(pOpaque);
+    vogl_screen_capture_settings()
+        : m_dump_png(false),
+          m_dump_jpeg(false),
+          m_hash_backbuffer(false),
+          m_sum_hashing(false),
+          m_jpeg_quality(80)
+    {
+    }
 
-    if ((!pContext) || (!width) || (!height))
+    inline bool is_enabled() const
     {
-        VOGL_ASSERT_ALWAYS;
-        return false;
+        return m_dump_png || m_dump_jpeg || m_hash_backbuffer;
     }
 
-    if ((pixel_format != GL_RGB) || (pixel_type != GL_UNSIGNED_BYTE) || (pitch != width * 3))
+    bool m_dump_png;
+    bool m_dump_jpeg;
+    bool m_hash_backbuffer;
+    bool m_sum_hashing;
+    int m_jpeg_quality;
+    dynamic_string m_screenshot_prefix;
+    dynamic_string m_backbuffer_hash_file;
+};
+
+static vogl_screen_capture_settings g_screen_capture_settings;
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_screen_capture_pipeline
+// Encodes screenshots and hashes backbuffers on a small pool of worker threads, so the app thread only has to copy the
+// pixels out of the framebuffer capturer's mapped PBO. The number of frames in flight is bounded. When all frame
+// buffers are busy, frames which only produce screenshots are dropped, and frames which need a backbuffer hash are
+// delayed until a buffer is free (hash files are compared line by line against replays, so no hash may be skipped).
+// Hashes are written in submission order.
+//----------------------------------------------------------------------------------------------------------------------
+class vogl_screen_capture_pipeline
+{
+    VOGL_NO_COPY_OR_ASSIGNMENT_OP(vogl_screen_capture_pipeline);
+
+public:
+    enum
+    {
+        cDefaultNumThreads = 2,
+        cDefaultQueueSize = 4
+    };
+
+    vogl_screen_capture_pipeline()
+        : m_initialized(false),
+          m_next_hash_seq(0),
+          m_next_hash_seq_to_write(0),
+          m_total_frames(0),
+          m_total_dropped_frames(0),
+          m_total_delayed_frames(0),
+          m_total_delay_ticks(0),
+          m_max_frames_in_flight(0)
     {
-        VOGL_ASSERT_ALWAYS;
-        return false;
     }
 
-    if (g_command_line_params().get_value_as_bool("vogl_dump_png_screenshots"))
+    ~vogl_screen_capture_pipeline()
     {
-        size_t png_size = 0;
-        void *pPNG_data = tdefl_write_image_to_png_file_in_memory_ex(pImage, width, height, 3, &png_size, 1, true);
+        deinit();
+    }
+
+    bool init(const vogl_screen_capture_settings &settings, uint32_t num_threads, uint32_t queue_size)
+    {
+        deinit();
+
+        m_settings = settings;
+
+        if (!m_thread_pool.init(math::maximum<uint32_t>(num_threads, 1)))
+            return false;
 
-        dynamic_string screenshot_filename(cVarArg, "%s_%08" PRIx64 "_%08" PRIu64 ".png", g_command_line_params().get_value_as_string("vogl_screenshot_prefix", 0, "screenshot").get_ptr(), cast_val_to_uint64(pContext->get_context_handle()), cast_val_to_uint64(frame_index));
-        if (!file_utils::write_buf_to_file(screenshot_filename.get_ptr(), pPNG_data, png_size))
+        queue_size = math::maximum<uint32_t>(queue_size, 1);
+        m_frames.resize(queue_size);
+        m_free_frames.reserve(queue_size);
+        for (uint32_t i = 0; i < queue_size; i++)
         {
-            console::error("Failed writing PNG screenshot to file %s\n", screenshot_filename.get_ptr());
+            m_frames[i] = vogl_new(frame);
+            m_free_frames.push_back(m_frames[i]);
         }
 
-        mz_free(pPNG_data);
+        m_initialized = true;
+        return true;
     }
-    else if (g_command_line_params().get_value_as_bool("vogl_dump_jpeg_screenshots"))
+
+    // Waits for all queued frames to be written.
+    void deinit()
     {
-        int jpeg_quality = g_command_line_params().get_value_as_int("vogl_jpeg_quality", 0, 80, 1, 100);
+        if (!m_initialized)
+            return;
+
+        m_thread_pool.join();
 
-        long unsigned int jpeg_size = 0;
-        unsigned char *pJPEG_data = NULL;
+        dump_stats();
 
-        tjhandle _jpegCompressor = tjInitCompress();
+        m_thread_pool.deinit();
 
-        int status = tjCompress2(_jpegCompressor, (unsigned char *)pImage, width, pitch, height, TJPF_RGB,
-                                 &pJPEG_data, &jpeg_size, TJSAMP_422, jpeg_quality,
-                                 TJFLAG_FASTDCT | TJFLAG_BOTTOMUP);
+        for (uint32_t i = 0; i < m_frames.size(); i++)
+            vogl_delete(m_frames[i]);
+        m_frames.clear();
+        m_free_frames.clear();
+        m_completed_hashes.clear();
 
-        tjDestroy(_jpegCompressor);
+        m_next_hash_seq = 0;
+        m_next_hash_seq_to_write = 0;
+        m_total_frames = 0;
+        m_total_dropped_frames = 0;
+        m_total_delayed_frames = 0;
+        m_total_delay_ticks = 0;
+        m_max_frames_in_flight = 0;
 
-        if (status == 0)
+        m_initialized = false;
+    }
+
+    inline bool is_initialized() const
+    {
+        return m_initialized;
+    }
+
+    // Called on the app thread. Copies the image and queues it for encoding/hashing.
+    bool submit(uint64_t context_handle, uint32_t width, uint32_t height, uint32_t pitch, size_t size, const void *pImage, uint64_t frame_index)
+    {
+        if (!m_initialized)
+            return false;
+
+        frame *pFrame = NULL;
+        bool delayed = false;
+        timer_ticks delay_start_ticks = 0;
+
+        for (;;)
         {
-            dynamic_string screenshot_filename(cVarArg, "%s_%08" PRIx64 "_%08" PRIu64 ".jpg",
-                g_command_line_params().get_value_as_string("vogl_screenshot_prefix", 0, "screenshot").get_ptr(),
-                cast_val_to_uint64(pContext->get_context_handle()),
-                cast_val_to_uint64(frame_index));
-            if (!file_utils::write_buf_to_file(screenshot_filename.get_ptr(), pJPEG_data, jpeg_size))
             {
-                console::error("Failed writing JPEG screenshot to file %s\n", screenshot_filename.get_ptr());
+                scoped_mutex lock(m_mutex);
+
+                if (!delayed)
+                    m_total_frames++;
+
+                if (m_free_frames.size())
+                {
+                    pFrame = m_free_frames.back();
+                    m_free_frames.pop_back();
+
+                    m_max_frames_in_flight = math::maximum<uint32_t>(m_max_frames_in_flight, m_frames.size() - m_free_frames.size());
+
+                    if (delayed)
+                        m_total_delay_ticks += timer::get_ticks() - delay_start_ticks;
+
+                    if (m_settings.m_hash_backbuffer)
+                        pFrame->m_hash_seq = m_next_hash_seq++;
+                    break;
+                }
+
+                if (!m_settings.m_hash_backbuffer)
+                {
+                    m_total_dropped_frames++;
+                    return false;
+                }
+
+                if (!delayed)
+                {
+                    m_total_delayed_frames++;
+                    delayed = true;
+                    delay_start_ticks = timer::get_ticks();
+                }
             }
+
+            vogl_sleep(1);
         }
 
-        tjFree(pJPEG_data);
+        pFrame->m_context_handle = context_handle;
+        pFrame->m_frame_index = frame_index;
+        pFrame->m_width = width;
+        pFrame->m_height = height;
+        pFrame->m_pitch = pitch;
+        pFrame->m_pixels.resize(static_cast<uint32_t>(size));
+        memcpy(pFrame->m_pixels.get_ptr(), pImage, size);
+
+        if (!m_thread_pool.queue_object_task(this, &vogl_screen_capture_pipeline::process_frame, 0, pFrame))
+        {
+            process_frame(0, pFrame);
+        }
+
+        return true;
     }
 
-    if (g_command_line_params().get_value_as_bool("vogl_dump_backbuffer_hashes") || g_command_line_params().get_value_as_bool("vogl_hash_backbuffer"))
+    void dump_stats()
+    {
+        scoped_mutex lock(m_mutex);
+
+        if (!m_total_frames)
+            return;
+
+        vogl_message_printf("Screen capture: %" PRIu64 " frames, %" PRIu64 " dropped, %" PRIu64 " delayed (%.3f ms total), %u of %u frame buffers in flight at most, %u worker threads\n",
+                            m_total_frames, m_total_dropped_frames, m_total_delayed_frames, timer::ticks_to_ms(m_total_delay_ticks),
+                            m_max_frames_in_flight, m_frames.size(), m_thread_pool.get_num_threads());
+    }
+
+private:
+    struct frame
+    {
+        uint8_vec m_pixels;
+        uint64_t m_context_handle;
+        uint64_t m_frame_index;
+        uint64_t m_hash_seq;
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_pitch;
+    };
+
+    struct completed_hash
+    {
+        uint64_t m_frame_index;
+        uint64_t m_hash;
+    };
+
+    typedef vogl::hash_map<uint64_t, completed_hash> completed_hash_map;
+
+    vogl_screen_capture_settings m_settings;
+    bool m_initialized;
+
+    task_pool m_thread_pool;
+
+    // Everything below is guarded by m_mutex
+    mutex m_mutex;
+    vogl::vector<frame *> m_frames;
+    vogl::vector<frame *> m_free_frames;
+
+    uint64_t m_next_hash_seq;
+    uint64_t m_next_hash_seq_to_write;
+    completed_hash_map m_completed_hashes;
+
+    uint64_t m_total_frames;
+    uint64_t m_total_dropped_frames;
+    uint64_t m_total_delayed_frames;
+    timer_ticks m_total_delay_ticks;
+    uint32_t m_max_frames_in_flight;
+
+    void process_frame(uint64_t data, void *pData_ptr)
     {
-        uint64_t backbuffer_crc64;
+        VOGL_NOTE_UNUSED(data);
+
+        frame *pFrame = static_cast<frame *>(pData_ptr);
+        const void *pImage = pFrame->m_pixels.get_ptr();
+        size_t size = pFrame->m_pixels.size();
 
-        if (g_command_line_params().get_value_as_bool("vogl_sum_hashing"))
+        if (m_settings.m_dump_png)
         {
-            backbuffer_crc64 = calc_sum64(static_cast<const uint8_t *>(pImage), size);
+            size_t png_size = 0;
+            void *pPNG_data = tdefl_write_image_to_png_file_in_memory_ex(pImage, pFrame->m_width, pFrame->m_height, 3, &png_size, 1, true);
+
+            dynamic_string screenshot_filename(cVarArg, "%s_%08" PRIx64 "_%08" PRIu64 ".png", m_settings.m_screenshot_prefix.get_ptr(), pFrame->m_context_handle, pFrame->m_frame_index);
+            if (!file_utils::write_buf_to_file(screenshot_filename.get_ptr(), pPNG_data, png_size))
+            {
+                console::error("Failed writing PNG screenshot to file %s\n", screenshot_filename.get_ptr());
+            }
+
+            mz_free(pPNG_data);
         }
-        else
+        else if (m_settings.m_dump_jpeg)
         {
-            backbuffer_crc64 = calc_crc64(CRC64_INIT, static_cast<const uint8_t *>(pImage), size);
+            long unsigned int jpeg_size = 0;
+            unsigned char *pJPEG_data = NULL;
+
+            tjhandle _jpegCompressor = tjInitCompress();
+
+            int status = tjCompress2(_jpegCompressor, (unsigned char *)pImage, pFrame->m_width, pFrame->m_pitch, pFrame->m_height, TJPF_RGB,
+                                     &pJPEG_data, &jpeg_size, TJSAMP_422, m_settings.m_jpeg_quality,
+                                     TJFLAG_FASTDCT | TJFLAG_BOTTOMUP);
+
+            tjDestroy(_jpegCompressor);
+
+            if (status == 0)
+            {
+                dynamic_string screenshot_filename(cVarArg, "%s_%08" PRIx64 "_%08" PRIu64 ".jpg",
+                    m_settings.m_screenshot_prefix.get_ptr(),
+                    pFrame->m_context_handle,
+                    pFrame->m_frame_index);
+                if (!file_utils::write_buf_to_file(screenshot_filename.get_ptr(), pJPEG_data, jpeg_size))
+                {
+                    console::error("Failed writing JPEG screenshot to file %s\n", screenshot_filename.get_ptr());
+                }
+            }
+
+            tjFree(pJPEG_data);
         }
 
-        console::printf("Frame %" PRIu64 " hash: 0x%016" PRIX64 "\n", cast_val_to_uint64(frame_index), backbuffer_crc64);
+        completed_hash hash;
+        hash.m_frame_index = pFrame->m_frame_index;
+        hash.m_hash = 0;
 
-        dynamic_string backbuffer_hash_file;
-        if (g_command_line_params().get_value_as_string(backbuffer_hash_file, "vogl_dump_backbuffer_hashes"))
+        if (m_settings.m_hash_backbuffer)
         {
-            FILE *pFile = vogl_fopen(backbuffer_hash_file.get_ptr(), "a");
-            if (!pFile)
-                console::error("Failed writing to backbuffer hash file %s\n", backbuffer_hash_file.get_ptr());
+            if (m_settings.m_sum_hashing)
+                hash.m_hash = calc_sum64(static_cast<const uint8_t *>(pImage), size);
             else
+                hash.m_hash = calc_crc64(CRC64_INIT, static_cast<const uint8_t *>(pImage), size);
+        }
+
+        scoped_mutex lock(m_mutex);
+
+        if (m_settings.m_hash_backbuffer)
+        {
+            m_completed_hashes.insert(pFrame->m_hash_seq, hash);
+            write_completed_hashes();
+        }
+
+        m_free_frames.push_back(pFrame);
+    }
+
+    // Caller must hold m_mutex.
+    void write_completed_hashes()
+    {
+        for (;;)
+        {
+            completed_hash_map::iterator it(m_completed_hashes.find(m_next_hash_seq_to_write));
+            if (it == m_completed_hashes.end())
+                break;
+
+            const completed_hash &hash = it->second;
+
+            console::printf("Frame %" PRIu64 " hash: 0x%016" PRIX64 "\n", hash.m_frame_index, hash.m_hash);
+
+            if (m_settings.m_backbuffer_hash_file.has_content())
             {
-                vogl_fprintf(pFile, "0x%016" PRIX64 "\n", backbuffer_crc64);
-                vogl_fclose(pFile);
+                FILE *pFile = vogl_fopen(m_settings.m_backbuffer_hash_file.get_ptr(), "a");
+                if (!pFile)
+                    console::error("Failed writing to backbuffer hash file %s\n", m_settings.m_backbuffer_hash_file.get_ptr());
+                else
+                {
+                    vogl_fprintf(pFile, "0x%016" PRIX64 "\n", hash.m_hash);
+                    vogl_fclose(pFile);
+                }
             }
+
+            m_completed_hashes.erase(m_next_hash_seq_to_write);
+            m_next_hash_seq_to_write++;
         }
     }
+};
+
+static vogl_screen_capture_pipeline &get_vogl_screen_capture_pipeline()
+{
+    static vogl_screen_capture_pipeline s_vogl_screen_capture_pipeline;
+    return s_vogl_screen_capture_pipeline;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_init_screen_capture
+//----------------------------------------------------------------------------------------------------------------------
+static void vogl_init_screen_capture()
+{
+    vogl_screen_capture_settings &settings = g_screen_capture_settings;
+
+    settings.m_dump_png = g_command_line_params().get_value_as_bool("vogl_dump_png_screenshots");
+    settings.m_dump_jpeg = g_command_line_params().get_value_as_bool("vogl_dump_jpeg_screenshots");
+    settings.m_jpeg_quality = g_command_line_params().get_value_as_int("vogl_jpeg_quality", 0, 80, 1, 100);
+    settings.m_screenshot_prefix = g_command_line_params().get_value_as_string("vogl_screenshot_prefix", 0, "screenshot");
+    settings.m_backbuffer_hash_file = g_command_line_params().get_value_as_string_or_empty("vogl_dump_backbuffer_hashes");
+    settings.m_hash_backbuffer = g_command_line_params().get_value_as_bool("vogl_hash_backbuffer") || settings.m_backbuffer_hash_file.has_content();
+    settings.m_sum_hashing = g_command_line_params().get_value_as_bool("vogl_sum_hashing");
+
+    if (!settings.is_enabled())
+        return;
+
+    uint32_t num_threads = g_command_line_params().get_value_as_uint("vogl_screenshot_threads", 0, vogl_screen_capture_pipeline::cDefaultNumThreads, 1, 64);
+    uint32_t queue_size = g_command_line_params().get_value_as_uint("vogl_screenshot_queue_size", 0, vogl_screen_capture_pipeline::cDefaultQueueSize, 1, 256);
+
+    if (!get_vogl_screen_capture_pipeline().init(settings, num_threads, queue_size))
+    {
+        vogl_error_printf("%s: Failed initializing screen capture pipeline, screenshots and backbuffer hashes are disabled\n", VOGL_FUNCTION_INFO_CSTR);
+        return;
+    }
+
+    console::message("Screen capture pipeline enabled, %u worker threads, %u frame buffers\n", num_threads, queue_size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// vogl_deinit_screen_capture
+// Waits for all queued screenshots and hashes to be written.
+//----------------------------------------------------------------------------------------------------------------------
+static void vogl_deinit_screen_capture()
+{
+    get_vogl_screen_capture_pipeline().deinit();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool vogl_screen_capture_callback(uint32_t width, uint32_t height, uint32_t pitch, size_t size, GLenum pixel_format, GLenum pixel_type, const void *pImage, void *pOpaque, uint64_t frame_index)
+{
+    vogl_context *pContext = static_cast<vogl_context *>(pOpaque);
+
+    if ((!pContext) || (!width) || (!height))
+    {
+        VOGL_ASSERT_ALWAYS;
+        return false;
+    }
+
+    if ((pixel_format != GL_RGB) || (pixel_type != GL_UNSIGNED_BYTE) || (pitch != width * 3))
+    {
+        VOGL_ASSERT_ALWAYS;
+        return false;
+    }
+
+    // Dropped frames are reported by the pipeline's stats, they aren't a capture failure.
+    get_vogl_screen_capture_pipeline().submit(cast_val_to_uint64(pContext->get_context_handle()), width, height, pitch, size, pImage, frame_index);
+
     return true;
 }
 
@@ -4923,16 +5573,14 @@ static void vogl_tick_screen_capture(vogl_context *pVOGL_context)
     if (!pVOGL_context)
         return;
 
+    if (!get_vogl_screen_capture_pipeline().is_initialized())
+        return;
+
     uint32_t width = pVOGL_context->get_window_width();
     uint32_t height = pVOGL_context->get_window_height();
     if ((!width) || (!height))
         return;
 
-    bool grab_backbuffer = g_command_line_params().get_value_as_bool("vogl_dump_backbuffer_hashes") || g_command_line_params().get_value_as_bool("vogl_hash_backbuffer") ||
-                           g_command_line_params().get_value_as_bool("vogl_dump_jpeg_screenshots") || g_command_line_params().get_value_as_bool("vogl_dump_png_screenshots");
-    if (!grab_backbuffer)
-        return;
-
     vogl_scoped_gl_error_absorber gl_error_absorber(pVOGL_context);
     VOGL_NOTE_UNUSED(gl_error_absorber);
 
@@ -5001,7 +5649,20 @@ static void vogl_end_capture(bool inside_signal_handler)
     if (get_vogl_trace_writer().is_opened())
     {
         dynamic_string filename(get_vogl_trace_writer().get_filename());
-        
+
+        // Write out all queued packets before the trace is closed, anything queued after this is discarded.
+        if (g_async_trace)
+        {
+            get_vogl_async_trace_writer().flush(true);
+            get_vogl_async_trace_writer().dump_stats();
+        }
+
+        if (g_dirty_map_tracking)
+            vogl_dump_dirty_map_stats();
+
+        if (g_gather_statistics)
+            vogl_flush_entrypoint_stats_to_trace_file();
+
         vogl_flush_compilerinfo_to_trace_file();
         vogl_flush_machineinfo_to_trace_file();
         #if VOGL_PLATFORM_SUPPORTS_BTRACE
@@ -5312,6 +5973,9 @@ static void vogl_check_for_capture_trigger_file()
 
         pSnapshot->set_frame_index(0);
 
+        // Throw away anything still queued from before the capture started.
+        get_vogl_async_trace_writer().flush(true);
+
         if (!get_vogl_trace_writer().open(pTrace_filename, NULL, true, false))
         {
             vogl_error_printf("%s: Failed creating trace file \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, pTrace_filename);
@@ -5321,6 +5985,9 @@ static void vogl_check_for_capture_trigger_file()
             return false;
         }
 
+        if (g_gather_statistics)
+            get_vogl_entrypoint_stats().reset();
+
         vogl_archive_blob_manager &trace_archive = *get_vogl_trace_writer().get_trace_archive();
 
         vogl_message_printf("%s: Serializing snapshot data to JSON document\n", VOGL_FUNCTION_INFO_CSTR);
@@ -6347,6 +7014,9 @@ static void vogl_check_for_capture_trigger_file()
 
         pSnapshot->set_frame_index(0);
 
+        // Throw away anything still queued from before the capture started.
+        get_vogl_async_trace_writer().flush(true);
+
         if (!get_vogl_trace_writer().open(pTrace_filename, NULL, true, false))
         {
             vogl_error_printf("%s: Failed creating trace file \"%s\"!\n", VOGL_FUNCTION_INFO_CSTR, pTrace_filename);
@@ -6356,6 +7026,9 @@ static void vogl_check_for_capture_trigger_file()
             return false;
         }
 
+        if (g_gather_statistics)
+            get_vogl_entrypoint_stats().reset();
+
         vogl_archive_blob_manager &trace_archive = *get_vogl_trace_writer().get_trace_archive();
 
         vogl_message_printf("%s: Serializing snapshot data to JSON document\n", VOGL_FUNCTION_INFO_CSTR);
@@ -7509,6 +8182,7 @@ static inline void vogl_named_buffer_data_ext_helper(vogl_context *pContext, vog
     buf_desc.m_map_access = 0;
     buf_desc.m_map_range = 0;
     buf_desc.m_flushed_ranges.resize(0);
+    buf_desc.m_map_shadowed = false;
 }
 
 #define DEF_FUNCTION_CUSTOM_FUNC_EPILOG_glBufferData(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_buffer_data_helper(pContext, trace_serializer, target, size, data, usage);
@@ -7567,15 +8241,18 @@ static inline void vogl_buffer_subdata_helper(vogl_context *pContext, vogl_entry
 
 #define DEF_FUNCTION_CUSTOM_GL_PROLOG_glMapBuffer(exported, category, ret, ret_type_enum, num_params, name, args, params) \
     GLenum orig_access = access;                                                                                          \
-    vogl_map_buffer_gl_prolog_helper(pContext, trace_serializer, target, access);
+    bool track_dirty_ranges = vogl_map_buffer_gl_prolog_helper(pContext, trace_serializer, target, access);
 #define DEF_FUNCTION_CUSTOM_GL_PROLOG_glMapBufferARB(exported, category, ret, ret_type_enum, num_params, name, args, params) \
     GLenum orig_access = access;                                                                                             \
-    vogl_map_buffer_gl_prolog_helper(pContext, trace_serializer, target, access);
-static inline void vogl_map_buffer_gl_prolog_helper(vogl_context *pContext, vogl_entrypoint_serializer &trace_serializer, GLenum target, GLenum &access)
+    bool track_dirty_ranges = vogl_map_buffer_gl_prolog_helper(pContext, trace_serializer, target, access);
+// Returns true if the map's modified ranges should be tracked (the buffer's size is checked once it's mapped).
+static inline bool vogl_map_buffer_gl_prolog_helper(vogl_context *pContext, vogl_entrypoint_serializer &trace_serializer, GLenum target, GLenum &access)
 {
     VOGL_NOTE_UNUSED(target);
     VOGL_NOTE_UNUSED(pContext);
 
+    bool track_dirty_ranges = g_dirty_map_tracking && trace_serializer.is_in_begin() && (access != GL_READ_ONLY);
+
     if (trace_serializer.is_in_begin() || g_dump_gl_buffers_flag)
     {
         if (access == GL_WRITE_ONLY)
@@ -7583,11 +8260,13 @@ static inline void vogl_map_buffer_gl_prolog_helper(vogl_context *pContext, vogl
             access = GL_READ_WRITE;
         }
     }
+
+    return track_dirty_ranges;
 }
 
-#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBuffer(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_gl_epilog_helper(pContext, target, orig_access, result);
-#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBufferARB(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_gl_epilog_helper(pContext, target, orig_access, result);
-static inline void vogl_map_buffer_gl_epilog_helper(vogl_context *pContext, GLenum target, GLenum access, GLvoid *pPtr)
+#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBuffer(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_gl_epilog_helper(pContext, target, orig_access, result, track_dirty_ranges);
+#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBufferARB(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_gl_epilog_helper(pContext, target, orig_access, result, track_dirty_ranges);
+static inline void vogl_map_buffer_gl_epilog_helper(vogl_context *pContext, GLenum target, GLenum access, GLvoid *pPtr, bool track_dirty_ranges)
 {
     if (!pContext)
         return;
@@ -7625,18 +8304,29 @@ static inline void vogl_map_buffer_gl_epilog_helper(vogl_context *pContext, GLen
     buf_desc.m_map_size = actual_buf_size;
     buf_desc.m_map_access = access;
     buf_desc.m_map_range = false;
+
+    vogl_begin_dirty_map_tracking(buf_desc, track_dirty_ranges);
 }
 
 #define DEF_FUNCTION_CUSTOM_GL_PROLOG_glMapBufferRange(exported, category, ret, ret_type_enum, num_params, name, args, params) \
     GLbitfield orig_access = access;                                                                                           \
-    vogl_map_buffer_range_gl_prolog_helper(pContext, trace_serializer, target, offset, length, access);
-static inline void vogl_map_buffer_range_gl_prolog_helper(vogl_context *pContext, vogl_entrypoint_serializer &trace_serializer, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield &access)
+    bool track_dirty_ranges = vogl_map_buffer_range_gl_prolog_helper(pContext, trace_serializer, target, offset, length, access);
+// Returns true if the map's modified ranges should be tracked.
+static inline bool vogl_map_buffer_range_gl_prolog_helper(vogl_context *pContext, vogl_entrypoint_serializer &trace_serializer, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield &access)
 {
-    VOGL_NOTE_UNUSED(length);
     VOGL_NOTE_UNUSED(offset);
     VOGL_NOTE_UNUSED(target);
     VOGL_NOTE_UNUSED(pContext);
 
+    // Explicitly flushed maps already only record what the app flushed.
+    bool track_dirty_ranges = g_dirty_map_tracking && trace_serializer.is_in_begin() && (access & GL_MAP_WRITE_BIT) &&
+                              ((access & GL_MAP_FLUSH_EXPLICIT_BIT) == 0) && (length >= cDirtyMapTrackingMinMapSize);
+    if (track_dirty_ranges)
+    {
+        // Untouched parts of the map are left out of the unmap packet, so the replayer must not invalidate them.
+        trace_serializer.add_key_value(string_hash("dirty_tracking"), true);
+    }
+
     if (trace_serializer.is_in_begin() || g_dump_gl_buffers_flag)
     {
         if (access & GL_MAP_WRITE_BIT)
@@ -7649,10 +8339,12 @@ static inline void vogl_map_buffer_range_gl_prolog_helper(vogl_context *pContext
             access |= GL_MAP_READ_BIT;
         }
     }
+
+    return track_dirty_ranges;
 }
 
-#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBufferRange(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_range_gl_epilog_helper(pContext, target, offset, length, orig_access, result);
-static inline void vogl_map_buffer_range_gl_epilog_helper(vogl_context *pContext, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield &access, GLvoid *pPtr)
+#define DEF_FUNCTION_CUSTOM_GL_EPILOG_glMapBufferRange(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_map_buffer_range_gl_epilog_helper(pContext, target, offset, length, orig_access, result, track_dirty_ranges);
+static inline void vogl_map_buffer_range_gl_epilog_helper(vogl_context *pContext, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield &access, GLvoid *pPtr, bool track_dirty_ranges)
 {
     if (!pContext)
         return;
@@ -7695,6 +8387,8 @@ static inline void vogl_map_buffer_range_gl_epilog_helper(vogl_context *pContext
     buf_desc.m_map_size = length;
     buf_desc.m_map_access = access;
     buf_desc.m_map_range = true;
+
+    vogl_begin_dirty_map_tracking(buf_desc, track_dirty_ranges);
 }
 
 #define DEF_FUNCTION_CUSTOM_FUNC_EPILOG_glFlushMappedBufferRange(exported, category, ret, ret_type_enum, num_params, name, args, params) vogl_flush_mapped_buffer_range(pContext, target, offset, length);
@@ -7816,7 +8510,11 @@ static inline void vogl_unmap_buffer_helper(vogl_context *pContext, vogl_entrypo
                 vogl_log_printf("\n");
             }
 
-            if (trace_serializer.is_in_begin())
+            bool recorded_dirty_ranges = false;
+            if ((buf_desc.m_map_shadowed) && (trace_serializer.is_in_begin()))
+                recorded_dirty_ranges = vogl_serialize_dirty_map_ranges(trace_serializer, buf_desc);
+
+            if ((trace_serializer.is_in_begin()) && (!recorded_dirty_ranges))
             {
                 trace_serializer.add_key_value(0, buf_desc.m_map_ofs);
                 trace_serializer.add_key_value(1, buf_desc.m_map_size);
@@ -7832,6 +8530,7 @@ static inline void vogl_unmap_buffer_helper(vogl_context *pContext, vogl_entrypo
     buf_desc.m_map_size = 0;
     buf_desc.m_map_access = 0;
     buf_desc.m_flushed_ranges.resize(0);
+    buf_desc.m_map_shadowed = false;
 }
 
 //----------------------------------------------------------------------------------------------------------------------